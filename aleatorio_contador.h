@@ -0,0 +1,46 @@
+/*
+ Generador aleatorio basado en contador (estilo SplitMix64)
+
+ El valor numero c de la secuencia de una clave es una funcion pura de (clave,
+ c): no hay estado que avanzar, asi que cualquier hilo puede calcular
+ cualquier tramo de la secuencia y el resultado es el mismo con cualquier
+ numero de hilos y en cualquier orden. Para una matriz el contador es la
+ posicion logica i * columnas + j (no depende del ld).
+
+ La mezcla es la de SplitMix64 (Steele, Lea y Flood): pasa BigCrush con
+ contadores consecutivos y son solo sumas, xor, corrimientos y dos productos
+ de 64 bits, que el compilador vectoriza (AVX-512DQ los tiene nativos).
+*/
+#ifndef ALEATORIO_CONTADOR_H
+#define ALEATORIO_CONTADOR_H
+
+#include <stdint.h>
+
+#define GAMMA_ALEATORIO 0x9e3779b97f4a7c15ULL
+
+static inline uint64_t mezclarAleatorio(uint64_t x){
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+// semillas parecidas (1, 2, 3...) dan claves sin relacion entre si
+static inline uint64_t claveAleatoria(uint64_t semilla){
+	return mezclarAleatorio(semilla + GAMMA_ALEATORIO);
+}
+
+static inline uint64_t aleatorioContador(uint64_t clave, uint64_t contador){
+	return mezclarAleatorio(clave + (contador + 1) * GAMMA_ALEATORIO);
+}
+
+// entero en [0, rango) con los 32 bits altos, sin division (Lemire)
+static inline uint32_t enteroEnRango(uint64_t x, uint32_t rango){
+	return (uint32_t)(((x >> 32) * rango) >> 32);
+}
+
+// double en [0, 1) con 53 bits
+static inline double dobleUnitario(uint64_t x){
+	return (double)(x >> 11) * 0x1.0p-53;
+}
+
+#endif
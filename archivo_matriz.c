@@ -0,0 +1,281 @@
+// archivos binarios de matrices mapeados con mmap (ver archivo_matriz.h)
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "archivo_matriz.h"
+
+const char * nombresTiposArchivo[NUMERO_TIPOS_ARCHIVO] = {"int32", "int64", "float", "double"};
+
+static const size_t tamaniosTiposArchivo[NUMERO_TIPOS_ARCHIVO] = {4, 8, 4, 8};
+
+int tipoArchivoPorNombre(const char * nombre){
+	int t;
+	for(t = 0; t < NUMERO_TIPOS_ARCHIVO; t++){
+		if(strcmp(nombre, nombresTiposArchivo[t]) == 0){
+			return t;
+		}
+	}
+	return -1;
+}
+
+size_t tamanioTipoArchivo(enum tipoArchivoMatriz tipo){
+	return tamaniosTiposArchivo[tipo];
+}
+
+// mezclador de splitmix64: cada bit de la entrada cambia la mitad de la salida
+static inline uint64_t mezclar64(uint64_t x){
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+// suma de las palabras mezcladas con su posicion: no depende del orden en que
+// se recorran, asi cada hilo suma un tramo y el resultado es el mismo con
+// cualquier numero de hilos, pero intercambiar dos palabras si la cambia
+static uint64_t sumaDatos(const void * datos, size_t bytes){
+	const uint64_t * palabras = (const uint64_t *)datos;
+	size_t numero = bytes / sizeof(uint64_t), i;
+	uint64_t suma = 0, resto = 0;
+
+	#pragma omp parallel for schedule(static) reduction(+:suma) if(numero > (1 << 20))
+	for(i = 0; i < numero; i++){
+		suma += mezclar64(palabras[i] ^ mezclar64(i));
+	}
+	// los datos siempre ocupan filas enteras de 64 bytes, pero por si acaso
+	memcpy(&resto, (const char *)datos + numero * sizeof(uint64_t), bytes % sizeof(uint64_t));
+	if(bytes % sizeof(uint64_t) != 0){
+		suma += mezclar64(resto ^ mezclar64(numero));
+	}
+	return mezclar64(suma ^ bytes);
+}
+
+uint64_t sumaArchivoMatriz(const struct archivoMatriz * archivo){
+	const struct cabeceraArchivoMatriz * cabecera = &archivo->cabecera;
+	return sumaDatos(archivo->datos.datos, cabecera->filas * cabecera->ld * cabecera->tamanioElemento);
+}
+
+// desplazamiento + filas * ld * tamanioElemento, los bytes que necesita el
+// archivo; -1 si no entra en 64 bits (una cabecera danada puede pedir cualquier cosa)
+static int bytesTotales(const struct cabeceraArchivoMatriz * cabecera, uint64_t * bytes){
+	uint64_t elementos, bytesDatos;
+	if(__builtin_mul_overflow(cabecera->filas, cabecera->ld, &elementos)
+			|| __builtin_mul_overflow(elementos, (uint64_t)cabecera->tamanioElemento, &bytesDatos)
+			|| __builtin_add_overflow(cabecera->desplazamiento, bytesDatos, bytes)){
+		return -1;
+	}
+	return 0;
+}
+
+static uint64_t desplazamientoDatos(void){
+	uint64_t cabecera = sizeof(struct cabeceraArchivoMatriz);
+	return (cabecera + ALINEACION_ARCHIVO_MATRIZ - 1) / ALINEACION_ARCHIVO_MATRIZ * ALINEACION_ARCHIVO_MATRIZ;
+}
+
+// revisar que la cabecera sea de este formato y que el archivo tenga todos los datos
+static int validarCabecera(const char * ruta, const struct cabeceraArchivoMatriz * cabecera, size_t bytesArchivo){
+	uint64_t bytesNecesarios;
+
+	if(memcmp(cabecera->magia, MAGIA_ARCHIVO_MATRIZ, sizeof(cabecera->magia)) != 0){
+		fprintf(stderr, "%s: no es un archivo de matriz\n", ruta);
+		return -1;
+	}
+	if(cabecera->version != VERSION_ARCHIVO_MATRIZ){
+		fprintf(stderr, "%s: version %u no soportada\n", ruta, cabecera->version);
+		return -1;
+	}
+	if(cabecera->tipo >= NUMERO_TIPOS_ARCHIVO || cabecera->tamanioElemento != tamaniosTiposArchivo[cabecera->tipo]){
+		fprintf(stderr, "%s: tipo de elemento invalido\n", ruta);
+		return -1;
+	}
+	if(cabecera->filas > 0x7fffffff || cabecera->columnas > 0x7fffffff || cabecera->ld > 0x7fffffff
+			|| cabecera->ld < cabecera->columnas){
+		fprintf(stderr, "%s: dimensiones invalidas\n", ruta);
+		return -1;
+	}
+	if(cabecera->alineacion == 0 || cabecera->desplazamiento % cabecera->alineacion != 0
+			|| cabecera->desplazamiento < sizeof(struct cabeceraArchivoMatriz)){
+		fprintf(stderr, "%s: desplazamiento de los datos invalido\n", ruta);
+		return -1;
+	}
+	if(bytesTotales(cabecera, &bytesNecesarios) != 0){
+		fprintf(stderr, "%s: dimensiones invalidas (el tamanio no entra en 64 bits)\n", ruta);
+		return -1;
+	}
+	if(bytesNecesarios > bytesArchivo){
+		fprintf(stderr, "%s: archivo truncado (%zu bytes, se esperaban %llu)\n", ruta, bytesArchivo,
+			(unsigned long long)bytesNecesarios);
+		return -1;
+	}
+	return 0;
+}
+
+static void vistaArchivo(struct archivoMatriz * archivo){
+	const struct cabeceraArchivoMatriz * cabecera = &archivo->cabecera;
+	archivo->datos = envolverMatrizTipada((char *)archivo->mapa + cabecera->desplazamiento, (int)cabecera->filas,
+		(int)cabecera->columnas, (int)cabecera->ld, cabecera->tamanioElemento);
+}
+
+int abrirArchivoMatriz(const char * ruta, int opciones, struct archivoMatriz * archivo){
+	struct stat estado;
+	int proteccion = PROT_READ, banderas = MAP_PRIVATE;
+	uint64_t suma;
+
+	memset(archivo, 0, sizeof(*archivo));
+	archivo->escritura = (opciones & ARCHIVO_ESCRITURA) != 0;
+	archivo->descriptor = open(ruta, archivo->escritura ? O_RDWR : O_RDONLY);
+	if(archivo->descriptor < 0){
+		fprintf(stderr, "%s: %s\n", ruta, strerror(errno));
+		return -1;
+	}
+	if(fstat(archivo->descriptor, &estado) != 0 || (size_t)estado.st_size < sizeof(struct cabeceraArchivoMatriz)){
+		fprintf(stderr, "%s: archivo demasiado corto\n", ruta);
+		close(archivo->descriptor);
+		return -1;
+	}
+	if(archivo->escritura){
+		proteccion |= PROT_WRITE;
+		banderas = MAP_SHARED;
+	}
+	if(opciones & ARCHIVO_PRECARGAR){
+		banderas |= MAP_POPULATE;
+	}
+
+	// un solo mapa para cabecera y datos; la cabecera se copia para no
+	// depender del mapa al leer las dimensiones
+	archivo->bytesMapa = estado.st_size;
+	archivo->mapa = mmap(NULL, archivo->bytesMapa, proteccion, banderas, archivo->descriptor, 0);
+	if(archivo->mapa == MAP_FAILED){
+		fprintf(stderr, "%s: mmap: %s\n", ruta, strerror(errno));
+		close(archivo->descriptor);
+		return -1;
+	}
+	memcpy(&archivo->cabecera, archivo->mapa, sizeof(struct cabeceraArchivoMatriz));
+	if(validarCabecera(ruta, &archivo->cabecera, archivo->bytesMapa) != 0){
+		munmap(archivo->mapa, archivo->bytesMapa);
+		close(archivo->descriptor);
+		return -1;
+	}
+	vistaArchivo(archivo);
+
+	if(opciones & ARCHIVO_VERIFICAR){
+		suma = sumaArchivoMatriz(archivo);
+		if(suma != archivo->cabecera.suma){
+			fprintf(stderr, "%s: suma de verificacion distinta (%016llx, se esperaba %016llx)\n", ruta,
+				(unsigned long long)suma, (unsigned long long)archivo->cabecera.suma);
+			munmap(archivo->mapa, archivo->bytesMapa);
+			close(archivo->descriptor);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// reservar un archivo nuevo con su tamanio final y mapearlo para escribir;
+// los datos quedan en cero (ftruncate), incluido el relleno de las filas
+int crearArchivoMatriz(const char * ruta, int filas, int columnas, enum tipoArchivoMatriz tipo, struct archivoMatriz * archivo){
+	struct cabeceraArchivoMatriz * cabecera = &archivo->cabecera;
+	size_t tamanio = tamaniosTiposArchivo[tipo];
+	uint64_t bytesNecesarios;
+	int error;
+
+	memset(archivo, 0, sizeof(*archivo));
+	memcpy(cabecera->magia, MAGIA_ARCHIVO_MATRIZ, sizeof(cabecera->magia));
+	cabecera->version = VERSION_ARCHIVO_MATRIZ;
+	cabecera->tipo = tipo;
+	cabecera->filas = filas;
+	cabecera->columnas = columnas;
+	cabecera->ld = calcularLdTipada(columnas, tamanio);
+	cabecera->tamanioElemento = tamanio;
+	cabecera->alineacion = ALINEACION_ARCHIVO_MATRIZ;
+	cabecera->desplazamiento = desplazamientoDatos();
+	cabecera->suma = 0;
+
+	if(bytesTotales(cabecera, &bytesNecesarios) != 0){
+		fprintf(stderr, "%s: matriz de %d x %d demasiado grande\n", ruta, filas, columnas);
+		return -1;
+	}
+
+	archivo->escritura = 1;
+	archivo->descriptor = open(ruta, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(archivo->descriptor < 0){
+		fprintf(stderr, "%s: %s\n", ruta, strerror(errno));
+		return -1;
+	}
+	archivo->bytesMapa = bytesNecesarios;
+	if(ftruncate(archivo->descriptor, archivo->bytesMapa) != 0){
+		fprintf(stderr, "%s: no se pudo dimensionar el archivo: %s\n", ruta, strerror(errno));
+		close(archivo->descriptor);
+		unlink(ruta);
+		return -1;
+	}
+	// posix_fallocate reserva los bloques ahora: sin espacio en disco falla
+	// aqui y no con SIGBUS a mitad de la multiplicacion. Si el sistema de
+	// archivos no lo soporta queda el archivo disperso de ftruncate
+	error = posix_fallocate(archivo->descriptor, 0, archivo->bytesMapa);
+	if(error != 0 && error != EOPNOTSUPP && error != EINVAL){
+		fprintf(stderr, "%s: no se pudo reservar el archivo: %s\n", ruta, strerror(error));
+		close(archivo->descriptor);
+		unlink(ruta);
+		return -1;
+	}
+	archivo->mapa = mmap(NULL, archivo->bytesMapa, PROT_READ | PROT_WRITE, MAP_SHARED, archivo->descriptor, 0);
+	if(archivo->mapa == MAP_FAILED){
+		fprintf(stderr, "%s: mmap: %s\n", ruta, strerror(errno));
+		close(archivo->descriptor);
+		unlink(ruta);
+		return -1;
+	}
+	vistaArchivo(archivo);
+	return 0;
+}
+
+// si se abrio para escribir, guardar la suma y la cabecera y bajar todo a disco
+int cerrarArchivoMatriz(struct archivoMatriz * archivo){
+	int resultado = 0;
+
+	if(archivo->mapa == NULL){
+		return 0;
+	}
+	if(archivo->escritura){
+		archivo->cabecera.suma = sumaArchivoMatriz(archivo);
+		memcpy(archivo->mapa, &archivo->cabecera, sizeof(struct cabeceraArchivoMatriz));
+		if(msync(archivo->mapa, archivo->bytesMapa, MS_SYNC) != 0){
+			perror("msync");
+			resultado = -1;
+		}
+	}
+	munmap(archivo->mapa, archivo->bytesMapa);
+	close(archivo->descriptor);
+	archivo->mapa = NULL;
+	return resultado;
+}
+
+struct matriz matrizArchivo(const struct archivoMatriz * archivo){
+	return envolverMatriz((int *)archivo->datos.datos, archivo->datos.filas, archivo->datos.columnas, archivo->datos.ld);
+}
+
+int guardarMatrizArchivo(const char * ruta, const struct matrizTipada * matriz, enum tipoArchivoMatriz tipo){
+	struct archivoMatriz archivo;
+	size_t bytesFila = (size_t)matriz->columnas * matriz->tamanioElemento;
+	int i;
+
+	if(matriz->tamanioElemento != tamaniosTiposArchivo[tipo]){
+		fprintf(stderr, "%s: el tamanio del elemento no coincide con el tipo %s\n", ruta, nombresTiposArchivo[tipo]);
+		return -1;
+	}
+	if(crearArchivoMatriz(ruta, matriz->filas, matriz->columnas, tipo, &archivo) != 0){
+		return -1;
+	}
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < matriz->filas; i++){
+		memcpy(FILA_TIPADA(&archivo.datos, i), FILA_TIPADA(matriz, i), bytesFila);
+	}
+	return cerrarArchivoMatriz(&archivo);
+}
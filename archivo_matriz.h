@@ -0,0 +1,92 @@
+/*
+ Formato binario de matrices para cargar y guardar con mmap
+
+ Un archivo .mat es una cabecera fija seguida de los datos por filas, con el
+ mismo relleno de fila (ld) que usan las matrices en memoria:
+
+ 	bytes 0..63      cabecera (struct cabeceraArchivoMatriz, little endian)
+ 	desplazamiento   filas * ld elementos; desplazamiento es multiplo de la
+ 	                 alineacion (una pagina), asi la primera fila queda
+ 	                 alineada igual que con crearMatriz
+
+ Cargar es solo abrir y mapear: la vista que se entrega apunta dentro del
+ mapa y los kernels leen el archivo directamente (las paginas se traen del
+ disco o de la cache de paginas la primera vez que se tocan). Para escribir
+ un resultado, crearArchivoMatriz reserva el archivo con su tamanio final y
+ lo mapea compartido; el kernel escribe C ahi mismo y cerrarArchivoMatriz
+ calcula la suma de verificacion, la guarda en la cabecera y hace msync.
+
+ La suma es un hash de 64 bits de las palabras de 8 bytes de los datos
+ (incluido el relleno, que se escribe en ceros), mezclada con su posicion y
+ calculada en paralelo. Recorrer los datos cuesta lo mismo que leerlos, asi
+ que abrir no la revisa salvo que se pida ARCHIVO_VERIFICAR.
+
+ Las funciones devuelven 0 o -1 con un mensaje en stderr (archivo que no
+ existe, cabecera invalida, tamanio que no coincide, suma distinta).
+*/
+#ifndef ARCHIVO_MATRIZ_H
+#define ARCHIVO_MATRIZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "matriz.h"
+#include "gemm_tipos.h"
+
+#define MAGIA_ARCHIVO_MATRIZ "MATRIZ\0\1"
+#define VERSION_ARCHIVO_MATRIZ 1
+#define ALINEACION_ARCHIVO_MATRIZ 4096
+
+// opciones de abrirArchivoMatriz
+#define ARCHIVO_LECTURA 0
+#define ARCHIVO_ESCRITURA 1 // mapa compartido: lo que se escriba queda en el archivo
+#define ARCHIVO_VERIFICAR 2 // recalcular la suma al abrir
+#define ARCHIVO_PRECARGAR 4 // MAP_POPULATE: leer todo el archivo al abrir
+
+enum tipoArchivoMatriz{
+	ARCHIVO_INT32 = 0,
+	ARCHIVO_INT64 = 1,
+	ARCHIVO_FLOAT = 2,
+	ARCHIVO_DOUBLE = 3,
+	NUMERO_TIPOS_ARCHIVO
+};
+
+struct cabeceraArchivoMatriz{
+	char magia[8];
+	uint32_t version;
+	uint32_t tipo; // enum tipoArchivoMatriz
+	uint64_t filas;
+	uint64_t columnas;
+	uint64_t ld; // en elementos
+	uint32_t tamanioElemento;
+	uint32_t alineacion;
+	uint64_t desplazamiento; // bytes desde el inicio del archivo hasta los datos
+	uint64_t suma;
+};
+
+struct archivoMatriz{
+	int descriptor;
+	int escritura;
+	void * mapa;
+	size_t bytesMapa;
+	struct cabeceraArchivoMatriz cabecera;
+	struct matrizTipada datos; // vista dentro del mapa
+};
+
+extern const char * nombresTiposArchivo[NUMERO_TIPOS_ARCHIVO];
+
+int tipoArchivoPorNombre(const char * nombre);
+size_t tamanioTipoArchivo(enum tipoArchivoMatriz tipo);
+
+int abrirArchivoMatriz(const char * ruta, int opciones, struct archivoMatriz * archivo);
+int crearArchivoMatriz(const char * ruta, int filas, int columnas, enum tipoArchivoMatriz tipo, struct archivoMatriz * archivo);
+int cerrarArchivoMatriz(struct archivoMatriz * archivo);
+uint64_t sumaArchivoMatriz(const struct archivoMatriz * archivo);
+
+// vista int de un archivo ARCHIVO_INT32, para las funciones de matriz.h
+struct matriz matrizArchivo(const struct archivoMatriz * archivo);
+
+// copiar una matriz en memoria a un archivo nuevo
+int guardarMatrizArchivo(const char * ruta, const struct matrizTipada * matriz, enum tipoArchivoMatriz tipo);
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ Autoajuste de bloques y numero de hilos para esta maquina
+
+ Busca empiricamente, con matrices de N x N:
+
+ 	- mc, kc y nc del motor empaquetado (bloques de i, k y j), por descenso
+ 	  por coordenadas: se prueba cada candidato de un parametro con los otros
+ 	  dos fijos, se queda el mejor y se pasa al siguiente; dos pasadas
+ 	- el numero de hilos de la variante OpenMP (1, 2, 4, ... y los nucleos
+ 	  en linea)
+
+ Cada punto se mide varias veces y se usa el tiempo minimo. El resultado se
+ guarda en el archivo de configuracion_maquina.c con la clave de esta maquina
+ (modelo de CPU y caches); gemm_empaquetado.c lo carga al arrancar.
+
+ Uso: ./autoajuste [-n tamanio] [-t hilos maximos] [-r repeticiones]
+
+ para compilar (o make):
+ gcc -O2 -fopenmp autoajuste.c variantes_multiplicacion.c matriz.c paginas_grandes.c pool_memoria.c gemm_empaquetado.c nucleos_simd.c planificador_azulejos.c openmp_azulejos.c pool_hilos.c pool_procesos.c contadores_hardware.c configuracion_maquina.c strassen.c -lrt
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "matriz.h"
+#include "gemm_empaquetado.h"
+#include "nucleos_simd.h"
+#include "variantes_multiplicacion.h"
+#include "configuracion_maquina.h"
+
+#define PASADAS 2
+
+// mc multiplo de MR y nc multiplo de NR
+static const int candidatosMc[] = {48, 72, 96, 120, 144, 192, 240};
+static const int candidatosKc[] = {128, 192, 256, 384, 512, 768};
+static const int candidatosNc[] = {256, 512, 1024, 2048, 4096, 8192};
+
+double medirGemm(const struct matriz *, const struct matriz *, struct matriz *, int);
+int ajustarParametro(int *, const int *, int, const char *, const struct matriz *, const struct matriz *, struct matriz *, int);
+int ajustarHilos(const struct matriz *, const struct matriz *, struct matriz *, int, int);
+double tiempoWall();
+
+int main(int argc, char *argv[]){
+	int tamanioMatriz = 1024;
+	int maximoHilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int repeticiones = 3;
+	int opcion, pasada;
+	struct identidadMaquina identidad;
+	struct configuracionMaquina configuracion;
+	struct matriz * matrizA, * matrizB, * matrizC;
+	double tiempo;
+
+	while((opcion = getopt(argc, argv, "n:t:r:")) != -1){
+		switch(opcion){
+			case 'n': tamanioMatriz = atoi(optarg); break;
+			case 't': maximoHilos = atoi(optarg); break;
+			case 'r': repeticiones = atoi(optarg); break;
+			default:
+				fprintf(stderr, "uso: %s [-n tamanio] [-t hilos maximos] [-r repeticiones]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(tamanioMatriz < 1 || repeticiones < 1){
+		fprintf(stderr, "tamanio y repeticiones deben ser positivos\n");
+		return 1;
+	}
+	if(maximoHilos < 1){
+		maximoHilos = 1;
+	}
+
+	identificarMaquina(&identidad);
+	printf("maquina: %s (L1d %d KB, L2 %d KB, L3 %d KB), kernels SIMD: %s\n",
+		identidad.modelo, identidad.cacheL1d, identidad.cacheL2, identidad.cacheL3, nucleosActuales->nombre);
+	printf("configuracion inicial: mc %d kc %d nc %d\n",
+		configuracionGemmActual.mc, configuracionGemmActual.kc, configuracionGemmActual.nc);
+
+	srand(time(NULL));
+	matrizA = crearMatriz(tamanioMatriz, tamanioMatriz);
+	matrizB = crearMatriz(tamanioMatriz, tamanioMatriz);
+	matrizC = crearMatriz(tamanioMatriz, tamanioMatriz);
+	inicializarMatricesCuadradas(matrizA, matrizB);
+
+	for(pasada = 0; pasada < PASADAS; pasada++){
+		int cambios = 0;
+		printf("\npasada %d\n", pasada + 1);
+		cambios += ajustarParametro(&configuracionGemmActual.kc, candidatosKc, sizeof(candidatosKc) / sizeof(int), "kc", matrizA, matrizB, matrizC, repeticiones);
+		cambios += ajustarParametro(&configuracionGemmActual.mc, candidatosMc, sizeof(candidatosMc) / sizeof(int), "mc", matrizA, matrizB, matrizC, repeticiones);
+		cambios += ajustarParametro(&configuracionGemmActual.nc, candidatosNc, sizeof(candidatosNc) / sizeof(int), "nc", matrizA, matrizB, matrizC, repeticiones);
+		if(!cambios){
+			break;
+		}
+	}
+	tiempo = medirGemm(matrizA, matrizB, matrizC, repeticiones);
+	printf("\nmejor bloque: mc %d kc %d nc %d (%.6f s, %.2f GOP/s)\n", configuracionGemmActual.mc, configuracionGemmActual.kc,
+		configuracionGemmActual.nc, tiempo, 2.0 * tamanioMatriz * tamanioMatriz * tamanioMatriz / tiempo * 1e-9);
+
+	configuracion.mc = configuracionGemmActual.mc;
+	configuracion.kc = configuracionGemmActual.kc;
+	configuracion.nc = configuracionGemmActual.nc;
+	configuracion.numeroHilos = ajustarHilos(matrizA, matrizB, matrizC, maximoHilos, repeticiones);
+
+	if(guardarConfiguracionMaquina(&configuracion) == 0){
+		printf("configuracion guardada en %s\n", rutaConfiguracionMaquina());
+	}
+
+	liberarMemoriaMatriz(matrizA);
+	liberarMemoriaMatriz(matrizB);
+	liberarMemoriaMatriz(matrizC);
+	return 0;
+}
+
+// tiempo minimo de varias multiplicaciones con la configuracion actual
+double medirGemm(const struct matriz * matrizA, const struct matriz * matrizB, struct matriz * matrizC, int repeticiones){
+	double minimo = 1e30, inicio, tiempo;
+	int r;
+
+	// una corrida de calentamiento
+	multiplicarMatricesEmpaquetada(matrizA, matrizB, matrizC);
+	for(r = 0; r < repeticiones; r++){
+		inicio = tiempoWall();
+		multiplicarMatricesEmpaquetada(matrizA, matrizB, matrizC);
+		tiempo = tiempoWall() - inicio;
+		if(tiempo < minimo){
+			minimo = tiempo;
+		}
+	}
+	return minimo;
+}
+
+// probar cada candidato para *parametro y dejar el mejor; 1 si cambio
+int ajustarParametro(int * parametro, const int * candidatos, int numeroCandidatos, const char * nombre,
+		const struct matriz * matrizA, const struct matriz * matrizB, struct matriz * matrizC, int repeticiones){
+	int original = *parametro, mejor = *parametro, i;
+	double mejorTiempo = 1e30, tiempo;
+
+	for(i = 0; i < numeroCandidatos; i++){
+		*parametro = candidatos[i];
+		tiempo = medirGemm(matrizA, matrizB, matrizC, repeticiones);
+		printf("\t%s %5d: %.6f s\n", nombre, candidatos[i], tiempo);
+		if(tiempo < mejorTiempo){
+			mejorTiempo = tiempo;
+			mejor = candidatos[i];
+		}
+	}
+	*parametro = mejor;
+	return mejor != original;
+}
+
+// numero de hilos con el menor tiempo para la variante OpenMP
+int ajustarHilos(const struct matriz * matrizA, const struct matriz * matrizB, struct matriz * matrizC, int maximoHilos, int repeticiones){
+	const struct variante * variante = buscarVariante("openmp");
+	double mejorTiempo = 1e30, tiempo, inicio, transcurrido;
+	int mejor = 1, hilos, r, ultimo = 0;
+	void * estado;
+
+	printf("\nhilos (variante %s)\n", variante->nombre);
+	for(hilos = 1; ultimo == 0; hilos *= 2){
+		if(hilos >= maximoHilos){
+			hilos = maximoHilos;
+			ultimo = 1;
+		}
+		estado = variante->preparar(matrizA, matrizB, hilos);
+		variante->multiplicar(estado, matrizA, matrizB, matrizC);
+		tiempo = 1e30;
+		for(r = 0; r < repeticiones; r++){
+			inicio = tiempoWall();
+			variante->multiplicar(estado, matrizA, matrizB, matrizC);
+			transcurrido = tiempoWall() - inicio;
+			if(transcurrido < tiempo){
+				tiempo = transcurrido;
+			}
+		}
+		variante->liberar(estado);
+		printf("\t%3d hilos: %.6f s\n", hilos, tiempo);
+		if(tiempo < mejorTiempo){
+			mejorTiempo = tiempo;
+			mejor = hilos;
+		}
+	}
+	printf("mejor numero de hilos: %d\n", mejor);
+	return mejor;
+}
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
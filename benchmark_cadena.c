@@ -0,0 +1,193 @@
+/*
+ Benchmark de cadenas de productos (cadena_matrices.h)
+
+ Para cada cadena mide tres formas de calcular A0 * A1 * ... * An-1:
+
+ 	izquierda  de a pares en el orden escrito, ((A0 A1) A2) ..., con
+ 	           gemmMatriz y un crearMatriz / liberarMemoriaMatriz por intermedio
+ 	optima     multiplicarCadenaMatrices: planifica, reserva el espacio de
+ 	           trabajo y lo libera en cada llamada
+ 	plan       planificarCadena una vez y multiplicarCadena en cada repeticion
+
+ Reporta los parentesis elegidos, las operaciones (2 * m * n * k por
+ producto) de cada orden y cuanto se ahorra, la memoria de los intermedios con
+ y sin reuso, y el tiempo minimo de cada forma. Los tres resultados deben ser
+ identicos: la aritmetica modulo 2^32 es asociativa.
+
+ Sin -d usa unas cadenas de ejemplo: angostas y anchas alternadas, la del
+ libro de Cormen (por 16), cuadradas (todos los ordenes cuestan lo mismo) y
+ una que se achica hacia la derecha.
+
+ Uso: ./benchmark_cadena [-d 1024,32,1024,32,1024] [-t hilos] [-r repeticiones] [-s semilla]
+
+ para compilar (o make):
+ gcc -O2 -fopenmp benchmark_cadena.c -L. -lmatrices -lrt -lm
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "matriz.h"
+#include "gemm.h"
+#include "cadena_matrices.h"
+
+#define MAX_CADENA 32
+#define LARGO_ORDEN 512
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int leerListaEnteros(char * texto, int * valores, int maximo){
+	int cuantos = 0;
+	char * parte = strtok(texto, ",");
+	while(parte != NULL && cuantos < maximo){
+		valores[cuantos++] = atoi(parte);
+		parte = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+// ((A0 A1) A2) ... con un intermedio nuevo por producto
+void multiplicarIzquierda(struct matriz ** matrices, int numero, struct matriz * C){
+	struct matriz * acumulado = matrices[0], * siguiente;
+	int i;
+
+	for(i = 1; i < numero - 1; i++){
+		siguiente = crearMatriz(acumulado->filas, matrices[i]->columnas);
+		gemmMatriz(1, acumulado, matrices[i], 0, siguiente);
+		if(acumulado != matrices[0]){
+			liberarMemoriaMatriz(acumulado);
+		}
+		acumulado = siguiente;
+	}
+	gemmMatriz(1, acumulado, matrices[numero - 1], 0, C);
+	if(acumulado != matrices[0]){
+		liberarMemoriaMatriz(acumulado);
+	}
+}
+
+int iguales(const struct matriz * A, const struct matriz * B){
+	int i;
+	for(i = 0; i < A->filas; i++){
+		if(memcmp(FILA(A, i), FILA(B, i), A->columnas * sizeof(int)) != 0){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void medirCadena(const int * dimensiones, int numero, int hilos, int repeticiones, uint64_t semilla){
+	struct matriz * matrices[MAX_CADENA], * C[3];
+	struct planCadena * plan;
+	char orden[LARGO_ORDEN];
+	double inicio, tiempo, minimo[3] = {0, 0, 0};
+	int i, r;
+
+	plan = planificarCadena(dimensiones, numero, hilos);
+	if(plan == NULL){
+		fprintf(stderr, "la cadena tiene dimensiones no positivas\n");
+		return;
+	}
+	for(i = 0; i < numero; i++){
+		matrices[i] = crearMatriz(dimensiones[i], dimensiones[i + 1]);
+		inicializarMatrizAleatoria(matrices[i], semilla + i, -3, 3);
+	}
+	for(i = 0; i < 3; i++){
+		C[i] = crearMatriz(dimensiones[0], dimensiones[numero]);
+	}
+
+	printf("cadena %d", dimensiones[0]);
+	for(i = 1; i <= numero; i++){
+		printf(" x %d", dimensiones[i]);
+	}
+	escribirOrdenCadena(plan, orden, sizeof(orden));
+	printf("\n  orden optimo: %s (%d niveles)\n", orden, plan->numeroNiveles);
+	printf("  operaciones: izquierda %.4g, optima %.4g, ahorro %.4g (%.1f%%, %.2fx menos)\n", plan->operacionesIzquierda,
+		plan->operacionesOptimas, plan->operacionesIzquierda - plan->operacionesOptimas,
+		100 * (1 - plan->operacionesOptimas / plan->operacionesIzquierda), plan->operacionesIzquierda / plan->operacionesOptimas);
+	printf("  intermedios: %.2f MiB con reuso, %.2f MiB uno por intermedio; paneles %.2f MiB\n",
+		plan->elementosIntermedios * sizeof(int) / 1048576.0, plan->elementosSinReuso * sizeof(int) / 1048576.0,
+		plan->elementosPaneles * sizeof(int) / 1048576.0);
+
+	for(r = 0; r < repeticiones; r++){
+		inicio = tiempoWall();
+		multiplicarIzquierda(matrices, numero, C[0]);
+		tiempo = tiempoWall() - inicio;
+		minimo[0] = r == 0 || tiempo < minimo[0] ? tiempo : minimo[0];
+
+		inicio = tiempoWall();
+		multiplicarCadenaMatrices((const struct matriz * const *)matrices, numero, C[1]);
+		tiempo = tiempoWall() - inicio;
+		minimo[1] = r == 0 || tiempo < minimo[1] ? tiempo : minimo[1];
+
+		inicio = tiempoWall();
+		multiplicarCadena(plan, (const struct matriz * const *)matrices, C[2]);
+		tiempo = tiempoWall() - inicio;
+		minimo[2] = r == 0 || tiempo < minimo[2] ? tiempo : minimo[2];
+	}
+	printf("  %-10s %10.5f s %8.2f GOP/s\n", "izquierda", minimo[0], plan->operacionesIzquierda / minimo[0] * 1e-9);
+	printf("  %-10s %10.5f s %8.2f GOP/s %6.2fx\n", "optima", minimo[1], plan->operacionesOptimas / minimo[1] * 1e-9,
+		minimo[0] / minimo[1]);
+	printf("  %-10s %10.5f s %8.2f GOP/s %6.2fx\n", "plan", minimo[2], plan->operacionesOptimas / minimo[2] * 1e-9,
+		minimo[0] / minimo[2]);
+	printf("  resultados iguales: %s\n\n", iguales(C[0], C[1]) && iguales(C[0], C[2]) ? "si" : "NO");
+	fflush(stdout);
+
+	for(i = 0; i < numero; i++){
+		liberarMemoriaMatriz(matrices[i]);
+	}
+	for(i = 0; i < 3; i++){
+		liberarMemoriaMatriz(C[i]);
+	}
+	liberarPlanCadena(plan);
+}
+
+int main(int argc, char *argv[]){
+	static const int ejemplos[][8] = {
+		{4, 1024, 32, 1024, 32, 1024},
+		{6, 480, 560, 240, 80, 160, 320, 400},
+		{4, 512, 512, 512, 512, 512},
+		{4, 2048, 1024, 256, 64, 16},
+	};
+	int dimensiones[MAX_CADENA + 1];
+	int numero = 0, hilos = 0, repeticiones = 3, opcion, e;
+	uint64_t semilla = 1;
+
+	while((opcion = getopt(argc, argv, "d:t:r:s:")) != -1){
+		switch(opcion){
+			case 'd':
+				numero = leerListaEnteros(optarg, dimensiones, MAX_CADENA + 1) - 1;
+				if(numero < 1){
+					fprintf(stderr, "la cadena necesita al menos dos dimensiones\n");
+					return 1;
+				}
+				break;
+			case 't': hilos = atoi(optarg); break;
+			case 'r': repeticiones = atoi(optarg); break;
+			case 's': semilla = strtoull(optarg, NULL, 10); break;
+			default:
+				fprintf(stderr, "uso: %s [-d dimensiones] [-t hilos] [-r repeticiones] [-s semilla]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(hilos > 0){
+		fijarHilosGemm(hilos);
+	}
+	if(repeticiones < 1){
+		repeticiones = 1;
+	}
+	printf("%d hilos\n\n", hilosGemm());
+	if(numero > 0){
+		medirCadena(dimensiones, numero, hilos, repeticiones, semilla);
+		return 0;
+	}
+	for(e = 0; e < (int)(sizeof(ejemplos) / sizeof(ejemplos[0])); e++){
+		medirCadena(ejemplos[e] + 1, ejemplos[e][0], hilos, repeticiones, semilla);
+	}
+	return 0;
+}
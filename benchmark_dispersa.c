@@ -0,0 +1,238 @@
+/*
+ Benchmark de producto disperso por denso (matriz_dispersa.h) contra denso
+
+ Para cada tamanio y numero de hilos mide los productos densos, que no
+ dependen de la densidad y se miden una vez:
+
+ 	azulejos     el motor OpenMP por azulejos (openmp_azulejos.h, static)
+ 	empaquetada  gemmMatriz, el motor empaquetado de libmatrices
+
+ y para cada densidad de A (B siempre densa):
+
+ 	csr          multiplicarCsr
+ 	bcsr         multiplicarBcsr, bloques de 4 x 4
+
+ Reporta el tiempo minimo, GOP/s utiles (2 * noCeros * N, las operaciones
+ que no son por cero) y el tiempo de convertir A desde densa, que se paga una
+ vez al cargar. La columna elige dice que producto tomaria
+ elegirProductoMatriz con los umbrales actuales. Al final, por tamanio e
+ hilos, la densidad de cruce: donde el mejor disperso deja de ganarle al
+ mejor denso (interpolando entre las dos densidades medidas que la rodean);
+ es lo que conviene poner en MATRIZ_UMBRAL_CSR (o con -g,
+ MATRIZ_UMBRAL_BCSR) en esa maquina.
+
+ Con -g los no ceros vienen en bloques de 4 x 4 completos (con la misma
+ densidad total), el caso en que BCSR le gana a CSR.
+
+ Uso: ./benchmark_dispersa [-n 1024,2048] [-d 0.001,0.01,0.1] [-t 1,4] [-r repeticiones] [-g] [-s semilla]
+
+ para compilar (o make):
+ gcc -O2 -fopenmp benchmark_dispersa.c openmp_azulejos.c -L. -lmatrices -lrt -lm
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+
+#include "matriz.h"
+#include "matriz_dispersa.h"
+#include "openmp_azulejos.h"
+#include "gemm.h"
+#include "verificacion.h"
+#include "aleatorio_contador.h"
+
+#define MAX_LISTA 32
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int leerListaEnteros(char * texto, int * valores, int maximo){
+	int cuantos = 0;
+	char * parte = strtok(texto, ",");
+	while(parte != NULL && cuantos < maximo){
+		valores[cuantos++] = atoi(parte);
+		parte = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+int leerListaDensidades(char * texto, double * valores, int maximo){
+	int cuantos = 0;
+	char * parte = strtok(texto, ",");
+	while(parte != NULL && cuantos < maximo){
+		if(atof(parte) > 0 && atof(parte) <= 1){
+			valores[cuantos++] = atof(parte);
+		}
+		parte = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+// cada elemento (o cada bloque de 4 x 4 con agrupada) es no cero con
+// probabilidad densidad, con valores de 1 a 10
+void generarDispersa(struct matriz * A, double densidad, int agrupada, uint64_t semilla){
+	uint64_t clave = claveAleatoria(semilla);
+	int i, j;
+
+	#pragma omp parallel for schedule(static) private(j)
+	for(i = 0; i < A->filas; i++){
+		for(j = 0; j < A->columnas; j++){
+			uint64_t posicion = agrupada ? (uint64_t)(i / ALTO_BLOQUE_BCSR) * A->columnas + j / ANCHO_BLOQUE_BCSR
+				: (uint64_t)i * A->columnas + j;
+			ELEMENTO(A, i, j) = dobleUnitario(aleatorioContador(clave, posicion)) < densidad ?
+				1 + (int)enteroEnRango(aleatorioContador(clave, posicion + ((uint64_t)1 << 62)), 10) : 0;
+		}
+	}
+}
+
+void mostrar(const char * nombre, int n, int hilos, double densidad, double tiempo, double operaciones, double conversion,
+		const char * elige, int correcto){
+	printf("%-12s %6d %5d %9.4f %10.5f %8.2f ", nombre, n, hilos, densidad, tiempo, operaciones / tiempo * 1e-9);
+	if(conversion >= 0){
+		printf("%12.5f ", conversion);
+	}
+	else{
+		printf("%12s ", "-");
+	}
+	printf("%-8s %s\n", elige, correcto ? "si" : "NO");
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[]){
+	int tamanios[MAX_LISTA] = {1024, 2048}, hilos[MAX_LISTA];
+	double densidades[MAX_LISTA] = {0.001, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.3, 0.5};
+	double tiempoDisperso[MAX_LISTA], densidadReal[MAX_LISTA];
+	int numeroTamanios = 2, numeroHilos = 0, numeroDensidades = 9, repeticiones = 3, agrupada = 0;
+	uint64_t semilla = 1;
+	int nucleos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	struct matriz * A, * B, * C;
+	struct matrizCsr * csr;
+	struct matrizBcsr * bcsr;
+	double inicio, tiempo, minimo[4], conversion[2], mejorDenso, cruce;
+	int opcion, t, h, d, r, n, correcto[4];
+
+	while((opcion = getopt(argc, argv, "n:d:t:r:gs:")) != -1){
+		switch(opcion){
+			case 'n': numeroTamanios = leerListaEnteros(optarg, tamanios, MAX_LISTA); break;
+			case 'd': numeroDensidades = leerListaDensidades(optarg, densidades, MAX_LISTA); break;
+			case 't': numeroHilos = leerListaEnteros(optarg, hilos, MAX_LISTA); break;
+			case 'r': repeticiones = atoi(optarg); break;
+			case 'g': agrupada = 1; break;
+			case 's': semilla = strtoull(optarg, NULL, 10); break;
+			default:
+				fprintf(stderr, "uso: %s [-n tamanios] [-d densidades] [-t hilos] [-r repeticiones] [-g] [-s semilla]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(numeroHilos == 0){
+		hilos[numeroHilos++] = 1;
+		if(nucleos > 1){
+			hilos[numeroHilos++] = nucleos;
+		}
+	}
+	if(repeticiones < 1){
+		repeticiones = 1;
+	}
+	if(numeroDensidades < 1){
+		fprintf(stderr, "no hay densidades entre 0 y 1\n");
+		return 1;
+	}
+
+	printf("no ceros %s, umbrales de eleccion: csr %.4f, bcsr %.4f\n", agrupada ? "en bloques de 4 x 4" : "sueltos",
+		umbralDensidadCsr, umbralDensidadBcsr);
+	printf("%-12s %6s %5s %9s %10s %8s %12s %-8s %s\n", "metodo", "N", "hilos", "densidad", "min (s)", "GOP/s", "convertir (s)",
+		"elige", "correcto");
+	for(t = 0; t < numeroTamanios; t++){
+		n = tamanios[t];
+		A = crearMatriz(n, n);
+		B = crearMatriz(n, n);
+		C = crearMatriz(n, n);
+		inicializarMatrizAleatoria(B, semilla + 1, 1, 10);
+
+		for(h = 0; h < numeroHilos; h++){
+			fijarHilosGemm(hilos[h]);
+			generarDispersa(A, densidades[0], agrupada, semilla);
+
+			// los densos hacen las mismas cuentas con cualquier densidad
+			minimo[0] = minimo[1] = 0;
+			for(r = 0; r < repeticiones; r++){
+				inicio = tiempoWall();
+				multiplicarOpenmpAzulejos(A, B, C, hilos[h], REPARTO_ESTATICO, 0);
+				tiempo = tiempoWall() - inicio;
+				minimo[0] = r == 0 || tiempo < minimo[0] ? tiempo : minimo[0];
+			}
+			correcto[0] = verificarMultiplicacion(A, B, C, REPETICIONES_FREIVALDS, semilla + 2);
+			for(r = 0; r < repeticiones; r++){
+				inicio = tiempoWall();
+				gemmMatriz(1, A, B, 0, C);
+				tiempo = tiempoWall() - inicio;
+				minimo[1] = r == 0 || tiempo < minimo[1] ? tiempo : minimo[1];
+			}
+			correcto[1] = verificarMultiplicacion(A, B, C, REPETICIONES_FREIVALDS, semilla + 2);
+			mostrar("azulejos", n, hilos[h], 1.0, minimo[0], 2.0 * n * n * n, -1, "denso", correcto[0]);
+			mostrar("empaquetada", n, hilos[h], 1.0, minimo[1], 2.0 * n * n * n, -1, "denso", correcto[1]);
+			mejorDenso = minimo[0] < minimo[1] ? minimo[0] : minimo[1];
+
+			for(d = 0; d < numeroDensidades; d++){
+				const char * elige;
+				generarDispersa(A, densidades[d], agrupada, semilla);
+				elige = nombresProductosDispersos[elegirProductoMatriz(A)];
+
+				inicio = tiempoWall();
+				csr = crearCsr(A);
+				conversion[0] = tiempoWall() - inicio;
+				inicio = tiempoWall();
+				bcsr = crearBcsr(A);
+				conversion[1] = tiempoWall() - inicio;
+				densidadReal[d] = (double)csr->noCeros / ((double)n * n);
+
+				minimo[2] = minimo[3] = 0;
+				for(r = 0; r < repeticiones; r++){
+					inicio = tiempoWall();
+					multiplicarCsr(csr, B, C, hilos[h]);
+					tiempo = tiempoWall() - inicio;
+					minimo[2] = r == 0 || tiempo < minimo[2] ? tiempo : minimo[2];
+				}
+				correcto[2] = verificarMultiplicacion(A, B, C, REPETICIONES_FREIVALDS, semilla + 2);
+				for(r = 0; r < repeticiones; r++){
+					inicio = tiempoWall();
+					multiplicarBcsr(bcsr, B, C, hilos[h]);
+					tiempo = tiempoWall() - inicio;
+					minimo[3] = r == 0 || tiempo < minimo[3] ? tiempo : minimo[3];
+				}
+				correcto[3] = verificarMultiplicacion(A, B, C, REPETICIONES_FREIVALDS, semilla + 2);
+				mostrar("csr", n, hilos[h], densidadReal[d], minimo[2], 2.0 * csr->noCeros * n, conversion[0], elige, correcto[2]);
+				mostrar("bcsr", n, hilos[h], densidadReal[d], minimo[3], 2.0 * csr->noCeros * n, conversion[1], elige, correcto[3]);
+				tiempoDisperso[d] = minimo[2] < minimo[3] ? minimo[2] : minimo[3];
+
+				liberarCsr(csr);
+				liberarBcsr(bcsr);
+			}
+
+			// primera densidad medida en que el disperso pierde; el tiempo
+			// disperso crece casi lineal con la densidad
+			for(d = 0; d < numeroDensidades && tiempoDisperso[d] < mejorDenso; d++);
+			if(d == 0){
+				printf("cruce N = %d, %d hilos: el denso gana ya con densidad %.4f\n", n, hilos[h], densidadReal[0]);
+			}
+			else if(d == numeroDensidades){
+				printf("cruce N = %d, %d hilos: el disperso gana hasta densidad %.4f, la mayor medida\n", n, hilos[h], densidadReal[d - 1]);
+			}
+			else{
+				cruce = tiempoDisperso[d] <= tiempoDisperso[d - 1] ? densidadReal[d] : densidadReal[d - 1] + (densidadReal[d] - densidadReal[d - 1])
+					* (mejorDenso - tiempoDisperso[d - 1]) / (tiempoDisperso[d] - tiempoDisperso[d - 1]);
+				printf("cruce N = %d, %d hilos: densidad %.4f (entre %.4f y %.4f)\n", n, hilos[h], cruce, densidadReal[d - 1], densidadReal[d]);
+			}
+		}
+
+		liberarMemoriaMatriz(A);
+		liberarMemoriaMatriz(B);
+		liberarMemoriaMatriz(C);
+	}
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ Benchmark de disposicion en memoria: int ** (un malloc por fila) contra
+ struct matriz (un bloque contiguo alineado a 64 bytes)
+
+ Ambas versiones usan el mismo kernel (B transpuesta, producto punto por fila)
+ para que la unica diferencia sea la disposicion de los datos.
+
+ Uso: ./benchmark_disposicion_matriz [N1 N2 ...]   (por defecto 512 1024 2048 4096)
+
+ para compilar: gcc -O2 benchmark_disposicion_matriz.c matriz.c paginas_grandes.c pool_memoria.c
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "matriz.h"
+
+int ** crearMatrizFilas(int);
+void liberarMemoriaMatrizFilas(int **, int);
+void multiplicarFilas(int **, int **, int **, int);
+void multiplicarContigua(const struct matriz *, const struct matriz *, struct matriz *);
+double tiempoWall();
+
+int main(int argc, char *argv[]){
+	int tamaniosDefecto[] = {512, 1024, 2048, 4096};
+	int numeroTamanios = argc > 1 ? argc - 1 : 4;
+	int t, i, j, tamanioMatriz, errores;
+	double inicio, tiempoFilas, tiempoContigua;
+
+	srand(time(NULL));
+
+	printf("N\tint** (s)\tcontigua (s)\taceleracion\n");
+	for(t = 0; t < numeroTamanios; t++){
+		tamanioMatriz = argc > 1 ? atoi(argv[t + 1]) : tamaniosDefecto[t];
+
+		int ** filasA = crearMatrizFilas(tamanioMatriz);
+		int ** filasBT = crearMatrizFilas(tamanioMatriz);
+		int ** filasC = crearMatrizFilas(tamanioMatriz);
+		struct matriz * matrizA = crearMatriz(tamanioMatriz, tamanioMatriz);
+		struct matriz * matrizBT = crearMatriz(tamanioMatriz, tamanioMatriz);
+		struct matriz * matrizC = crearMatriz(tamanioMatriz, tamanioMatriz);
+
+		// mismos valores en las dos disposiciones
+		inicializarMatricesCuadradas(matrizA, matrizBT);
+		for(i = 0; i < tamanioMatriz; i++){
+			for(j = 0; j < tamanioMatriz; j++){
+				filasA[i][j] = ELEMENTO(matrizA, i, j);
+				filasBT[i][j] = ELEMENTO(matrizBT, i, j);
+			}
+		}
+
+		inicio = tiempoWall();
+		multiplicarFilas(filasA, filasBT, filasC, tamanioMatriz);
+		tiempoFilas = tiempoWall() - inicio;
+
+		inicio = tiempoWall();
+		multiplicarContigua(matrizA, matrizBT, matrizC);
+		tiempoContigua = tiempoWall() - inicio;
+
+		errores = 0;
+		for(i = 0; i < tamanioMatriz; i++){
+			for(j = 0; j < tamanioMatriz; j++){
+				errores += filasC[i][j] != ELEMENTO(matrizC, i, j);
+			}
+		}
+		if(errores){
+			printf("ERROR: %d elementos distintos entre disposiciones\n", errores);
+		}
+
+		printf("%d\t%f\t%f\t%.2fx\n", tamanioMatriz, tiempoFilas, tiempoContigua, tiempoFilas / tiempoContigua);
+
+		liberarMemoriaMatrizFilas(filasA, tamanioMatriz);
+		liberarMemoriaMatrizFilas(filasBT, tamanioMatriz);
+		liberarMemoriaMatrizFilas(filasC, tamanioMatriz);
+		liberarMemoriaMatriz(matrizA);
+		liberarMemoriaMatriz(matrizBT);
+		liberarMemoriaMatriz(matrizC);
+	}
+	return 0;
+}
+
+// disposicion anterior: un malloc por fila
+int ** crearMatrizFilas(int tamanioMatriz){
+	int ** matriz = (int **)malloc(tamanioMatriz * sizeof(int *));
+	int i;
+
+	if(matriz == NULL){
+		perror("No se pudo reservar memoria para los punteros de las filas");
+		exit(1);
+	}
+	for(i = 0; i < tamanioMatriz; i++){
+		matriz[i] = (int *)malloc(tamanioMatriz * sizeof(int));
+		if(matriz[i] == NULL){
+			perror("No se pudo reservar memoria para las filas");
+			exit(1);
+		}
+	}
+	return matriz;
+}
+
+void liberarMemoriaMatrizFilas(int ** matriz, int tamanioMatriz){
+	int i;
+	for(i = 0; i < tamanioMatriz; i++){
+		free(matriz[i]);
+	}
+	free(matriz);
+}
+
+// kernel con B transpuesta sobre int **
+void multiplicarFilas(int ** p_matrizA, int ** p_matrizBT, int ** p_matrizResultado, int tamanioMatriz){
+	int i, j, k, acumulado;
+	for(i = 0; i < tamanioMatriz; i++){
+		for(j = 0; j < tamanioMatriz; j++){
+			acumulado = 0;
+			for(k = 0; k < tamanioMatriz; k++){
+				acumulado += p_matrizA[i][k] * p_matrizBT[j][k];
+			}
+			p_matrizResultado[i][j] = acumulado;
+		}
+	}
+}
+
+// el mismo kernel sobre la matriz contigua
+void multiplicarContigua(const struct matriz * p_matrizA, const struct matriz * p_matrizBT, struct matriz * p_matrizResultado){
+	int i, j, k, acumulado;
+	int tamanioMatriz = p_matrizA->filas;
+	const int * filaA, * filaB;
+	for(i = 0; i < tamanioMatriz; i++){
+		filaA = FILA(p_matrizA, i);
+		for(j = 0; j < tamanioMatriz; j++){
+			filaB = FILA(p_matrizBT, j);
+			acumulado = 0;
+			for(k = 0; k < tamanioMatriz; k++){
+				acumulado += filaA[k] * filaB[k];
+			}
+			ELEMENTO(p_matrizResultado, i, j) = acumulado;
+		}
+	}
+}
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,372 @@
+/*
+ Benchmark de multiplicacion por lotes de matrices pequenias
+
+ Para cada tipo, tamanio (m = n = k) y numero de hilos mide un lote de
+ productos independientes C = A * B de tres formas:
+
+ 	paso        gemmLote*: matrices seguidas con paso fijo
+ 	punteros    gemmLotePunteros*: arreglos de punteros (las matrices estan en
+ 	            el mismo orden, asi solo cambia la forma de pasarlas)
+ 	individual  una llamada a gemm* por producto, como referencia del costo
+ 	            de tratar cada producto por separado
+
+ Reporta el tiempo minimo de las repeticiones, productos por segundo y GOP/s
+ (2 m n k por producto), y verifica unos productos del lote contra el
+ producto ingenuo.
+
+ Uso: ./benchmark_lotes [-l 4,8,16,32,64] [-b productos] [-t 1,4] [-e float,double,int32]
+                        [-w calentamiento] [-r repeticiones] [-o archivo.csv]
+
+ 	-l lados de las matrices (por defecto 4,8,16,32,64)
+ 	-b productos por lote (por defecto unos 4M de elementos por operando, al
+ 	   menos 64)
+ 	-t numeros de hilos (por defecto 1 y los nucleos en linea)
+ 	-e tipos: float, double, int32 (por defecto todos)
+ 	-w corridas de calentamiento (por defecto 1)
+ 	-r repeticiones medidas (por defecto 5)
+ 	-o archivo CSV (por defecto benchmark_lotes.csv)
+
+ para compilar (o make):
+ gcc -O2 -fopenmp benchmark_lotes.c -L. -lmatrices -lrt -lm
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gemm.h"
+#include "nucleos_simd.h"
+
+#define MAX_LISTA 64
+#define ELEMENTOS_POR_OPERANDO (1 << 22)
+#define MUESTRAS_VERIFICACION 8
+
+enum modoLote{ MODO_PASO, MODO_PUNTEROS, MODO_INDIVIDUAL, NUMERO_MODOS };
+
+static const char * nombresModos[NUMERO_MODOS] = {"paso", "punteros", "individual"};
+
+// cada tipo se maneja con void * y estas funciones; lado = m = n = k
+struct tipoLote{
+	const char * nombre;
+	size_t tamanio;
+	void (*lotePaso)(int lado, const void * A, const void * B, void * C, int numero);
+	void (*lotePunteros)(int lado, const void * const * A, const void * const * B, void * const * C, int numero);
+	void (*individual)(int lado, const void * A, const void * B, void * C);
+	void (*inicializar)(void * datos, size_t elementos);
+	double (*leer)(const void * datos, size_t posicion);
+};
+
+static void lotePasoFlotante(int lado, const void * A, const void * B, void * C, int numero){
+	long paso = (long)lado * lado;
+	gemmLoteFlotante(lado, lado, lado, 1.0f, A, lado, paso, B, lado, paso, 0.0f, C, lado, paso, numero);
+}
+
+static void lotePunterosFlotante(int lado, const void * const * A, const void * const * B, void * const * C, int numero){
+	gemmLotePunterosFlotante(lado, lado, lado, 1.0f, (const float * const *)A, lado, (const float * const *)B, lado,
+		0.0f, (float * const *)C, lado, numero);
+}
+
+static void individualFlotante(int lado, const void * A, const void * B, void * C){
+	gemmFlotante(lado, lado, lado, 1.0f, A, lado, B, lado, 0.0f, C, lado);
+}
+
+static void inicializarFlotante(void * datos, size_t elementos){
+	size_t i;
+	for(i = 0; i < elementos; i++){
+		((float *)datos)[i] = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+}
+
+static double leerFlotante(const void * datos, size_t posicion){
+	return ((const float *)datos)[posicion];
+}
+
+static void lotePasoDoble(int lado, const void * A, const void * B, void * C, int numero){
+	long paso = (long)lado * lado;
+	gemmLoteDoble(lado, lado, lado, 1.0, A, lado, paso, B, lado, paso, 0.0, C, lado, paso, numero);
+}
+
+static void lotePunterosDoble(int lado, const void * const * A, const void * const * B, void * const * C, int numero){
+	gemmLotePunterosDoble(lado, lado, lado, 1.0, (const double * const *)A, lado, (const double * const *)B, lado,
+		0.0, (double * const *)C, lado, numero);
+}
+
+static void individualDoble(int lado, const void * A, const void * B, void * C){
+	gemmDoble(lado, lado, lado, 1.0, A, lado, B, lado, 0.0, C, lado);
+}
+
+static void inicializarDoble(void * datos, size_t elementos){
+	size_t i;
+	for(i = 0; i < elementos; i++){
+		((double *)datos)[i] = rand() / (double)RAND_MAX * 2.0 - 1.0;
+	}
+}
+
+static double leerDoble(const void * datos, size_t posicion){
+	return ((const double *)datos)[posicion];
+}
+
+static void lotePasoEntero32(int lado, const void * A, const void * B, void * C, int numero){
+	long paso = (long)lado * lado;
+	gemmLoteEntero32(lado, lado, lado, 1, A, lado, paso, B, lado, paso, 0, C, lado, paso, numero);
+}
+
+static void lotePunterosEntero32(int lado, const void * const * A, const void * const * B, void * const * C, int numero){
+	gemmLotePunterosEntero32(lado, lado, lado, 1, (const int * const *)A, lado, (const int * const *)B, lado,
+		0, (int * const *)C, lado, numero);
+}
+
+static void individualEntero32(int lado, const void * A, const void * B, void * C){
+	gemmEntero32(lado, lado, lado, 1, A, lado, B, lado, 0, C, lado);
+}
+
+// valores chicos: el producto de 64 x 64 no se desborda y se compara exacto
+static void inicializarEntero32(void * datos, size_t elementos){
+	size_t i;
+	for(i = 0; i < elementos; i++){
+		((int *)datos)[i] = rand() % 201 - 100;
+	}
+}
+
+static double leerEntero32(const void * datos, size_t posicion){
+	return ((const int *)datos)[posicion];
+}
+
+static const struct tipoLote tiposLote[] = {
+	{"float", sizeof(float), lotePasoFlotante, lotePunterosFlotante, individualFlotante, inicializarFlotante, leerFlotante},
+	{"double", sizeof(double), lotePasoDoble, lotePunterosDoble, individualDoble, inicializarDoble, leerDoble},
+	{"int32", sizeof(int), lotePasoEntero32, lotePunterosEntero32, individualEntero32, inicializarEntero32, leerEntero32},
+};
+
+#define NUMERO_TIPOS_LOTE (int)(sizeof(tiposLote) / sizeof(tiposLote[0]))
+
+int leerListaEnteros(const char *, int *, int);
+int leerListaTipos(char *, const struct tipoLote **, int);
+double medirModo(const struct tipoLote *, enum modoLote, int, int, void *, void *, void *, int, int);
+int verificarLote(const struct tipoLote *, int, int, const void *, const void *, const void *);
+double tiempoWall();
+
+int main(int argc, char *argv[]){
+	int lados[MAX_LISTA] = {4, 8, 16, 32, 64};
+	int hilos[MAX_LISTA];
+	const struct tipoLote * tipos[MAX_LISTA];
+	int numeroLados = 5, numeroHilos = 0, numeroTipos = 0;
+	int productosPedidos = 0, calentamiento = 1, repeticiones = 5;
+	int nucleos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	const char * nombreArchivo = "benchmark_lotes.csv";
+	int opcion, e, l, h, modo;
+	FILE * archivo;
+
+	while((opcion = getopt(argc, argv, "l:b:t:e:w:r:o:")) != -1){
+		switch(opcion){
+			case 'l': numeroLados = leerListaEnteros(optarg, lados, MAX_LISTA); break;
+			case 'b': productosPedidos = atoi(optarg); break;
+			case 't': numeroHilos = leerListaEnteros(optarg, hilos, MAX_LISTA); break;
+			case 'e': numeroTipos = leerListaTipos(optarg, tipos, MAX_LISTA); break;
+			case 'w': calentamiento = atoi(optarg); break;
+			case 'r': repeticiones = atoi(optarg); break;
+			case 'o': nombreArchivo = optarg; break;
+			default:
+				fprintf(stderr, "uso: %s [-l lados] [-b productos] [-t hilos] [-e tipos] [-w calentamiento] [-r repeticiones] [-o archivo.csv]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(numeroHilos == 0){
+		hilos[numeroHilos++] = 1;
+		if(nucleos > 1){
+			hilos[numeroHilos++] = nucleos;
+		}
+	}
+	if(numeroTipos == 0){
+		for(e = 0; e < NUMERO_TIPOS_LOTE; e++){
+			tipos[numeroTipos++] = &tiposLote[e];
+		}
+	}
+	if(numeroLados <= 0 || repeticiones < 1){
+		fprintf(stderr, "no hay nada que medir\n");
+		return 1;
+	}
+	if(calentamiento < 0){
+		calentamiento = 0;
+	}
+
+	archivo = fopen(nombreArchivo, "w");
+	if(archivo == NULL){
+		perror(nombreArchivo);
+		return 1;
+	}
+	fprintf(archivo, "tipo,modo,isa,lado,productos,hilos,repeticiones,min_s,productos_por_s,gops,correcto\n");
+
+	srand(time(NULL));
+	printf("kernels SIMD: %s, nucleos en linea: %d\n", nucleosActuales->nombre, nucleos);
+	printf("%-7s %-11s %5s %9s %5s %12s %14s %9s %s\n", "tipo", "modo", "lado", "productos", "hilos", "min (s)", "productos/s", "GOP/s", "correcto");
+
+	for(e = 0; e < numeroTipos; e++){
+		for(l = 0; l < numeroLados; l++){
+			int lado = lados[l];
+			size_t elementos = (size_t)lado * lado;
+			int productos = productosPedidos > 0 ? productosPedidos : (int)(ELEMENTOS_POR_OPERANDO / elementos);
+			void * A, * B, * C;
+
+			if(productos < 64){
+				productos = 64;
+			}
+			A = malloc(elementos * productos * tipos[e]->tamanio);
+			B = malloc(elementos * productos * tipos[e]->tamanio);
+			C = malloc(elementos * productos * tipos[e]->tamanio);
+			if(A == NULL || B == NULL || C == NULL){
+				perror("No se pudo reservar memoria para el lote");
+				exit(1);
+			}
+			tipos[e]->inicializar(A, elementos * productos);
+			tipos[e]->inicializar(B, elementos * productos);
+
+			for(h = 0; h < numeroHilos; h++){
+				for(modo = 0; modo < NUMERO_MODOS; modo++){
+					double minimo, operaciones = 2.0 * elementos * lado * productos;
+					int correcto;
+
+					fijarHilosGemm(hilos[h]);
+					memset(C, 0, elementos * productos * tipos[e]->tamanio);
+					minimo = medirModo(tipos[e], (enum modoLote)modo, lado, productos, A, B, C, calentamiento, repeticiones);
+					correcto = verificarLote(tipos[e], lado, productos, A, B, C);
+
+					printf("%-7s %-11s %5d %9d %5d %12.6f %14.0f %9.2f %s\n", tipos[e]->nombre, nombresModos[modo], lado, productos,
+						hilos[h], minimo, productos / minimo, operaciones / minimo * 1e-9, correcto ? "si" : "NO");
+					fprintf(archivo, "%s,%s,%s,%d,%d,%d,%d,%.9f,%.1f,%.4f,%d\n", tipos[e]->nombre, nombresModos[modo], nucleosActuales->nombre,
+						lado, productos, hilos[h], repeticiones, minimo, productos / minimo, operaciones / minimo * 1e-9, correcto);
+					fflush(stdout);
+				}
+			}
+			free(A);
+			free(B);
+			free(C);
+		}
+	}
+	fclose(archivo);
+	printf("\nresultados en %s\n", nombreArchivo);
+	return 0;
+}
+
+// "4,8,16" -> {4, 8, 16}; devuelve cuantos numeros leyo
+int leerListaEnteros(const char * texto, int * lista, int maximo){
+	int cuantos = 0;
+	char * fin;
+	long valor;
+
+	while(*texto != '\0' && cuantos < maximo){
+		valor = strtol(texto, &fin, 10);
+		if(fin == texto){
+			break;
+		}
+		if(valor > 0){
+			lista[cuantos++] = (int)valor;
+		}
+		texto = *fin == ',' ? fin + 1 : fin;
+	}
+	return cuantos;
+}
+
+// "float,int32" -> punteros a tiposLote; avisa de los nombres desconocidos
+int leerListaTipos(char * texto, const struct tipoLote ** lista, int maximo){
+	int cuantos = 0, i;
+	char * nombre = strtok(texto, ",");
+
+	while(nombre != NULL && cuantos < maximo){
+		for(i = 0; i < NUMERO_TIPOS_LOTE; i++){
+			if(strcmp(tiposLote[i].nombre, nombre) == 0){
+				lista[cuantos++] = &tiposLote[i];
+				break;
+			}
+		}
+		if(i == NUMERO_TIPOS_LOTE){
+			fprintf(stderr, "tipo desconocido: %s\n", nombre);
+		}
+		nombre = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+// tiempo minimo de las repeticiones de un lote completo en el modo dado
+double medirModo(const struct tipoLote * tipo, enum modoLote modo, int lado, int productos, void * A, void * B, void * C,
+		int calentamiento, int repeticiones){
+	size_t bytes = (size_t)lado * lado * tipo->tamanio;
+	const void ** punterosA = NULL, ** punterosB = NULL;
+	void ** punterosC = NULL;
+	double minimo = 1e30, inicio, tiempo;
+	int r, b;
+
+	if(modo == MODO_PUNTEROS){
+		punterosA = (const void **)malloc(productos * sizeof(void *));
+		punterosB = (const void **)malloc(productos * sizeof(void *));
+		punterosC = (void **)malloc(productos * sizeof(void *));
+		if(punterosA == NULL || punterosB == NULL || punterosC == NULL){
+			perror("No se pudo reservar memoria para los punteros del lote");
+			exit(1);
+		}
+		for(b = 0; b < productos; b++){
+			punterosA[b] = (const char *)A + b * bytes;
+			punterosB[b] = (const char *)B + b * bytes;
+			punterosC[b] = (char *)C + b * bytes;
+		}
+	}
+
+	for(r = -calentamiento; r < repeticiones; r++){
+		inicio = tiempoWall();
+		switch(modo){
+			case MODO_PASO:
+				tipo->lotePaso(lado, A, B, C, productos);
+				break;
+			case MODO_PUNTEROS:
+				tipo->lotePunteros(lado, punterosA, punterosB, punterosC, productos);
+				break;
+			default:
+				for(b = 0; b < productos; b++){
+					tipo->individual(lado, (const char *)A + b * bytes, (const char *)B + b * bytes, (char *)C + b * bytes);
+				}
+				break;
+		}
+		tiempo = tiempoWall() - inicio;
+		if(r >= 0 && tiempo < minimo){
+			minimo = tiempo;
+		}
+	}
+	free(punterosA);
+	free(punterosB);
+	free(punterosC);
+	return minimo;
+}
+
+// recalcular algunos productos del lote; tolerancia relativa para flotantes
+int verificarLote(const struct tipoLote * tipo, int lado, int productos, const void * A, const void * B, const void * C){
+	size_t elementos = (size_t)lado * lado;
+	int s, b, i, j, p;
+	double suma, magnitud, producto;
+
+	for(s = 0; s < MUESTRAS_VERIFICACION; s++){
+		b = s == 0 ? productos - 1 : rand() % productos;
+		for(i = 0; i < lado; i++){
+			for(j = 0; j < lado; j++){
+				suma = 0.0;
+				magnitud = 0.0;
+				for(p = 0; p < lado; p++){
+					producto = tipo->leer(A, b * elementos + i * lado + p) * tipo->leer(B, b * elementos + p * lado + j);
+					suma += producto;
+					magnitud += producto < 0 ? -producto : producto;
+				}
+				producto = tipo->leer(C, b * elementos + i * lado + j) - suma;
+				if((producto < 0 ? -producto : producto) > 1e-5 * magnitud){
+					return 0;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,624 @@
+/*
+ Benchmark unificado de las variantes de multiplicacion
+
+ Recorre tamanios, numeros de hilos y variantes (variantes_multiplicacion.c).
+ Para cada combinacion hace unas corridas de calentamiento que no se miden y
+ luego varias repeticiones medidas con CLOCK_MONOTONIC. Reporta el tiempo
+ wall minimo, la mediana y el percentil 95, y GOP/s (2 N^3 operaciones
+ enteras) calculado con la mediana. El resultado de cada variante se verifica
+ (verificacion.h): exacto contra el producto ingenuo si N es chico y con
+ Freivalds, en O(N^2), si no.
+
+ Con -e se mide tambien el motor generico por tipo de elemento (gemm_tipos.c):
+ float, double, int32 con acumulador int64 e int64, con los mismos tamanios e
+ hilos, para comparar el rendimiento de cada tipo en la misma maquina. Su
+ resultado se verifica con el Freivalds de su tipo. La columna tipo dice
+ con que tipo corrio cada fila; las variantes del registro son int32 con
+ acumulador int32.
+
+ Con -c se miden contadores de hardware (contadores_hardware.c) durante las
+ repeticiones: IPC y fallos de L1D, LLC y dTLB por cada 1000 instrucciones,
+ por trabajador y en total. Las variantes secuenciales se miden en el hilo que
+ llama; las paralelas, en cada trabajador (hilo de OpenMP, del pool o proceso
+ hijo) mientras hace su parte; strassen, en cada hilo de sus tres regiones
+ paralelas. Si el sistema no permite perf_event_open se avisa y el benchmark
+ sigue sin ellos.
+
+ Con -p se repite todo con las matrices en cada modo de paginas
+ (paginas_grandes.h): normales, thp, 2m, 1g. La columna paginas dice el modo
+ que se obtuvo (si no hay paginas grandes se baja al siguiente) y al empezar
+ cada modo se muestra cuanto de A, B y C quedo de verdad en paginas grandes.
+ Al final se compara cada fila con la del primer modo de la lista: tiempo y,
+ con -c, fallos de dTLB. Con -P las paginas se tocan al crear las matrices,
+ asi los fallos de pagina no caen en la primera repeticion.
+
+ Uso: ./benchmark_multiplicacion [-n 256,512,1024] [-t 1,2,4] [-v ingenua,openmp,...]
+                                 [-e float,double,...] [-w calentamiento] [-r repeticiones]
+                                 [-o prefijo] [-c] [-s semilla] [-f repeticiones]
+                                 [-p normales,thp,2m,1g] [-P]
+
+ 	-n tamanios (por defecto 256,512,1024)
+ 	-t numeros de hilos para las variantes paralelas (por defecto 1, los nucleos en linea
+ 	   y el numero de hilos del autoajuste si es distinto)
+ 	-v variantes (por defecto todas si no se da -e)
+ 	-e tipos del motor generico: float, double, int32_acc64, int64 (por defecto
+ 	   todos si no se da -v)
+ 	-w corridas de calentamiento (por defecto 1)
+ 	-r repeticiones medidas (por defecto 5)
+ 	-o prefijo de los archivos de salida: <prefijo>.csv y <prefijo>.json
+ 	   (por defecto benchmark_multiplicacion)
+ 	-c medir contadores de hardware
+ 	-s semilla de A y B (por defecto la hora); se muestra al empezar, y con la
+ 	   misma semilla las matrices son identicas con cualquier numero de hilos
+ 	-f vectores de Freivalds (por defecto 20: un resultado incorrecto pasa con
+ 	   probabilidad menor que 2^-20); con 0 se compara siempre exacto contra el
+ 	   producto ingenuo, con cualquier N
+ 	-p modos de paginas de las matrices (por defecto el de MATRIZ_PAGINAS, o
+ 	   normales)
+ 	-P prefallar las paginas de las matrices al crearlas (o MATRIZ_PREFALLO=1)
+
+ para compilar (o make):
+ gcc -O2 -fopenmp benchmark_multiplicacion.c variantes_multiplicacion.c matriz.c gemm_empaquetado.c nucleos_simd.c planificador_azulejos.c openmp_azulejos.c pool_hilos.c pool_procesos.c contadores_hardware.c configuracion_maquina.c strassen.c gemm_tipos.c verificacion.c paginas_grandes.c pool_memoria.c -lrt -lm
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "matriz.h"
+#include "gemm_empaquetado.h"
+#include "nucleos_simd.h"
+#include "variantes_multiplicacion.h"
+#include "contadores_hardware.h"
+#include "configuracion_maquina.h"
+#include "gemm_tipos.h"
+#include "verificacion.h"
+#include "paginas_grandes.h"
+#include "pool_memoria.h"
+
+#define MAX_LISTA 64
+
+struct resultado{
+	const char * variante;
+	const char * tipo;
+	int tamanioMatriz;
+	int numeroHilos;
+	int repeticiones;
+	double minimo;
+	double mediana;
+	double percentil95;
+	double gops;
+	int correcto;
+	enum modoPaginas paginas; // las que se obtuvieron para A
+	struct registroContadores * contadores; // NULL si no se midieron
+};
+
+int leerListaEnteros(const char *, int *, int);
+int leerListaVariantes(char *, const struct variante **, int);
+int leerListaTipos(char *, const struct motorTipo **, int);
+int leerListaPaginas(char *, enum modoPaginas *, int);
+void mostrarPaginasGrandes(const struct matriz *);
+void compararPaginas(const struct resultado *, int);
+struct resultado medirVariante(const struct variante *, const struct matriz *, const struct matriz *, struct matriz *, int, int, int, int, int, uint64_t);
+struct resultado medirTipo(const struct motorTipo *, const struct matrizTipada *, const struct matrizTipada *, struct matrizTipada *, int, int, int, int, uint64_t);
+void resumirTiempos(struct resultado *, double *, int, double);
+void mostrarResultado(const struct resultado *);
+int compararDoubles(const void *, const void *);
+void escribirCsv(const char *, const struct resultado *, int);
+void escribirJson(const char *, const struct resultado *, int);
+double tiempoWall();
+
+int main(int argc, char *argv[]){
+	int tamanios[MAX_LISTA] = {256, 512, 1024};
+	int hilos[MAX_LISTA];
+	const struct variante * variantes[MAX_LISTA];
+	const struct motorTipo * tipos[MAX_LISTA];
+	enum modoPaginas modosPaginas[MAX_LISTA];
+	int numeroModosPaginas = 1, prefallar = prefalloMatrices();
+	int numeroTamanios = 3, numeroHilos = 0, numeroVariantes = 0, numeroTipos = 0;
+	int elegirVariantes = 0, elegirTipos = 0;
+	int calentamiento = 1, repeticiones = 5;
+	int medirContadores = 0;
+	int repeticionesFreivalds = REPETICIONES_FREIVALDS;
+	uint64_t semilla = (uint64_t)time(NULL);
+	double inicioInicializacion;
+	const char * prefijo = "benchmark_multiplicacion";
+	int nucleos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	struct resultado * resultados;
+	int numeroResultados = 0;
+	int opcion, t, h, v, p;
+	char archivo[1024];
+	struct configuracionMaquina ajustada;
+
+	modosPaginas[0] = paginasMatrices();
+	while((opcion = getopt(argc, argv, "n:t:v:e:w:r:o:cs:f:p:P")) != -1){
+		switch(opcion){
+			case 'n': numeroTamanios = leerListaEnteros(optarg, tamanios, MAX_LISTA); break;
+			case 't': numeroHilos = leerListaEnteros(optarg, hilos, MAX_LISTA); break;
+			case 'v': numeroVariantes = leerListaVariantes(optarg, variantes, MAX_LISTA); elegirVariantes = 1; break;
+			case 'e': numeroTipos = leerListaTipos(optarg, tipos, MAX_LISTA); elegirTipos = 1; break;
+			case 'w': calentamiento = atoi(optarg); break;
+			case 'r': repeticiones = atoi(optarg); break;
+			case 'o': prefijo = optarg; break;
+			case 'c': medirContadores = 1; break;
+			case 's': semilla = strtoull(optarg, NULL, 10); break;
+			case 'f': repeticionesFreivalds = atoi(optarg); break;
+			case 'p': numeroModosPaginas = leerListaPaginas(optarg, modosPaginas, MAX_LISTA); break;
+			case 'P': prefallar = 1; break;
+			default:
+				fprintf(stderr, "uso: %s [-n tamanios] [-t hilos] [-v variantes] [-e tipos] [-w calentamiento] [-r repeticiones] [-o prefijo] [-c] [-s semilla] [-f repeticiones] [-p modos de paginas] [-P]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(numeroHilos == 0){
+		hilos[numeroHilos++] = 1;
+		if(nucleos > 1){
+			hilos[numeroHilos++] = nucleos;
+		}
+		if(cargarConfiguracionMaquina(&ajustada) == 0 && ajustada.numeroHilos > 1 && ajustada.numeroHilos != nucleos){
+			hilos[numeroHilos++] = ajustada.numeroHilos;
+		}
+	}
+	// sin -v ni -e se mide todo; con solo uno de los dos, solo eso
+	if(!elegirVariantes && !elegirTipos){
+		for(v = 0; v < numeroVariantesMultiplicacion && v < MAX_LISTA; v++){
+			variantes[numeroVariantes++] = &variantesMultiplicacion[v];
+		}
+		for(v = 0; v < numeroMotoresTipo && v < MAX_LISTA; v++){
+			tipos[numeroTipos++] = &motoresTipo[v];
+		}
+	}
+	if(numeroTamanios <= 0 || numeroVariantes + numeroTipos <= 0 || numeroModosPaginas <= 0 || repeticiones < 1){
+		fprintf(stderr, "no hay nada que medir\n");
+		return 1;
+	}
+	if(calentamiento < 0){
+		calentamiento = 0;
+	}
+	if(repeticionesFreivalds < 0){
+		repeticionesFreivalds = 0;
+	}
+
+	resultados = (struct resultado *)malloc((size_t)numeroTamanios * numeroModosPaginas * numeroHilos * (numeroVariantes + numeroTipos) * sizeof(struct resultado));
+	if(resultados == NULL){
+		perror("No se pudo reservar memoria para los resultados");
+		exit(1);
+	}
+
+	if(medirContadores && !contadoresDisponibles()){
+		medirContadores = 0;
+	}
+
+	srand((unsigned int)semilla);
+	printf("kernels SIMD: %s, nucleos en linea: %d, semilla: %llu\n", nucleosActuales->nombre, nucleos, (unsigned long long)semilla);
+	printf("%-12s %-12s %6s %5s %-8s %12s %12s %12s %9s %s\n", "variante", "tipo", "N", "hilos", "paginas", "min (s)", "mediana (s)", "p95 (s)", "GOP/s", "correcto");
+
+	for(t = 0; t < numeroTamanios; t++){
+		for(p = 0; p < numeroModosPaginas; p++){
+			int tamanioMatriz = tamanios[t];
+			struct matriz * matrizA, * matrizB, * matrizC;
+
+			// las matrices de cada modo se crean con el; el prefallo queda fuera de la medicion
+			fijarPaginasMatrices(modosPaginas[p], prefallar);
+			inicioInicializacion = tiempoWall();
+			matrizA = crearMatriz(tamanioMatriz, tamanioMatriz);
+			matrizB = crearMatriz(tamanioMatriz, tamanioMatriz);
+			matrizC = crearMatriz(tamanioMatriz, tamanioMatriz);
+			inicializarMatricesCuadradasSemilla(matrizA, matrizB, semilla);
+			printf("N = %d, paginas %s: A y B creadas e inicializadas en %.4f s", tamanioMatriz,
+				nombresModosPaginas[paginasMatriz(matrizA)], tiempoWall() - inicioInicializacion);
+			mostrarPaginasGrandes(matrizA);
+
+			for(v = 0; v < numeroVariantes; v++){
+				// las variantes secuenciales se miden una sola vez, con 1 hilo
+				int barridoHilos = variantes[v]->paralela ? numeroHilos : 1;
+				for(h = 0; h < barridoHilos; h++){
+					struct resultado * r = &resultados[numeroResultados++];
+					*r = medirVariante(variantes[v], matrizA, matrizB, matrizC, variantes[v]->paralela ? hilos[h] : 1,
+						calentamiento, repeticiones, medirContadores, repeticionesFreivalds, semilla + 2);
+					mostrarResultado(r);
+				}
+			}
+
+			// el motor generico barre los hilos igual que las variantes paralelas
+			for(v = 0; v < numeroTipos; v++){
+				struct matrizTipada * tipadaA = crearMatrizTipada(tamanioMatriz, tamanioMatriz, tipos[v]->tamanioEntrada);
+				struct matrizTipada * tipadaB = crearMatrizTipada(tamanioMatriz, tamanioMatriz, tipos[v]->tamanioEntrada);
+				struct matrizTipada * tipadaC = crearMatrizTipada(tamanioMatriz, tamanioMatriz, tipos[v]->tamanioResultado);
+
+				tipos[v]->inicializar(tipadaA);
+				tipos[v]->inicializar(tipadaB);
+				for(h = 0; h < numeroHilos; h++){
+					struct resultado * r = &resultados[numeroResultados++];
+					*r = medirTipo(tipos[v], tipadaA, tipadaB, tipadaC, hilos[h], calentamiento, repeticiones,
+						repeticionesFreivalds, semilla + 2);
+					mostrarResultado(r);
+				}
+				liberarMatrizTipada(tipadaA);
+				liberarMatrizTipada(tipadaB);
+				liberarMatrizTipada(tipadaC);
+			}
+
+			liberarMemoriaMatriz(matrizA);
+			liberarMemoriaMatriz(matrizB);
+			liberarMemoriaMatriz(matrizC);
+		}
+	}
+	if(numeroModosPaginas > 1){
+		compararPaginas(resultados, numeroResultados);
+	}
+
+	snprintf(archivo, sizeof(archivo), "%s.csv", prefijo);
+	escribirCsv(archivo, resultados, numeroResultados);
+	snprintf(archivo, sizeof(archivo), "%s.json", prefijo);
+	escribirJson(archivo, resultados, numeroResultados);
+	printf("\nresultados en %s.csv y %s.json\n", prefijo, prefijo);
+
+	for(v = 0; v < numeroResultados; v++){
+		free(resultados[v].contadores);
+	}
+	free(resultados);
+	return 0;
+}
+
+// "256,512,1024" -> {256, 512, 1024}; devuelve cuantos numeros leyo
+int leerListaEnteros(const char * texto, int * lista, int maximo){
+	int cuantos = 0;
+	char * fin;
+	long valor;
+
+	while(*texto != '\0' && cuantos < maximo){
+		valor = strtol(texto, &fin, 10);
+		if(fin == texto){
+			break;
+		}
+		if(valor > 0){
+			lista[cuantos++] = (int)valor;
+		}
+		texto = *fin == ',' ? fin + 1 : fin;
+	}
+	return cuantos;
+}
+
+// "ingenua,openmp" -> punteros al registro; avisa de los nombres desconocidos
+int leerListaVariantes(char * texto, const struct variante ** lista, int maximo){
+	int cuantos = 0;
+	char * nombre = strtok(texto, ",");
+	const struct variante * variante;
+
+	while(nombre != NULL && cuantos < maximo){
+		variante = buscarVariante(nombre);
+		if(variante == NULL){
+			fprintf(stderr, "variante desconocida: %s\n", nombre);
+		}
+		else{
+			lista[cuantos++] = variante;
+		}
+		nombre = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+// "float,int64" -> punteros a los motores; avisa de los nombres desconocidos
+int leerListaTipos(char * texto, const struct motorTipo ** lista, int maximo){
+	int cuantos = 0;
+	char * nombre = strtok(texto, ",");
+	const struct motorTipo * motor;
+
+	while(nombre != NULL && cuantos < maximo){
+		motor = buscarMotorTipo(nombre);
+		if(motor == NULL){
+			fprintf(stderr, "tipo desconocido: %s\n", nombre);
+		}
+		else{
+			lista[cuantos++] = motor;
+		}
+		nombre = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+// "normales,thp" -> modos; avisa de los nombres desconocidos
+int leerListaPaginas(char * texto, enum modoPaginas * lista, int maximo){
+	int cuantos = 0;
+	char * nombre = strtok(texto, ",");
+
+	while(nombre != NULL && cuantos < maximo){
+		if(modoPaginasPorNombre(nombre) < 0){
+			fprintf(stderr, "modo de paginas desconocido: %s\n", nombre);
+		}
+		else{
+			lista[cuantos++] = (enum modoPaginas)modoPaginasPorNombre(nombre);
+		}
+		nombre = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+// con thp el kernel puede no dar paginas grandes aunque el madvise funcione:
+// se mira en smaps cuanto del mapeo de la matriz quedo en paginas grandes
+void mostrarPaginasGrandes(const struct matriz * matriz){
+	long long mapeo, grandes = bytesEnPaginasGrandes(matriz->datos, &mapeo);
+
+	if(grandes >= 0 && mapeo > 0){
+		printf(" (%.0f%% de su mapeo en paginas grandes)", 100.0 * grandes / mapeo);
+	}
+	printf("\n");
+}
+
+// cada fila contra la misma variante, tipo, N e hilos con el primer modo de
+// paginas medido: aceleracion y, si hay contadores, fallos de dTLB
+void compararPaginas(const struct resultado * resultados, int numeroResultados){
+	struct lecturaContadores total, totalBase;
+	const struct resultado * base;
+	int i, j;
+
+	printf("\n%-12s %-12s %6s %5s %-8s %-8s %11s %14s %14s %10s\n", "variante", "tipo", "N", "hilos", "paginas", "contra",
+		"aceleracion", "dTLB contra", "dTLB", "reduccion");
+	for(i = 0; i < numeroResultados; i++){
+		base = NULL;
+		for(j = 0; j < i && base == NULL; j++){
+			if(resultados[j].tamanioMatriz == resultados[i].tamanioMatriz && resultados[j].numeroHilos == resultados[i].numeroHilos
+					&& strcmp(resultados[j].variante, resultados[i].variante) == 0 && strcmp(resultados[j].tipo, resultados[i].tipo) == 0){
+				base = &resultados[j];
+			}
+		}
+		if(base == NULL){
+			continue;
+		}
+		printf("%-12s %-12s %6d %5d %-8s %-8s %10.2fx", resultados[i].variante, resultados[i].tipo, resultados[i].tamanioMatriz,
+			resultados[i].numeroHilos, nombresModosPaginas[resultados[i].paginas], nombresModosPaginas[base->paginas],
+			base->mediana / resultados[i].mediana);
+		if(resultados[i].contadores == NULL || base->contadores == NULL){
+			printf(" %14s %14s %10s\n", "-", "-", "-");
+			continue;
+		}
+		total = totalRegistroContadores(resultados[i].contadores);
+		totalBase = totalRegistroContadores(base->contadores);
+		if(!total.disponibles[CONTADOR_FALLOS_DTLB] || !totalBase.disponibles[CONTADOR_FALLOS_DTLB] || totalBase.valores[CONTADOR_FALLOS_DTLB] == 0){
+			printf(" %14s %14s %10s\n", "-", "-", "-");
+			continue;
+		}
+		printf(" %14llu %14llu %9.1f%%\n", totalBase.valores[CONTADOR_FALLOS_DTLB], total.valores[CONTADOR_FALLOS_DTLB],
+			100.0 * (1.0 - (double)total.valores[CONTADOR_FALLOS_DTLB] / totalBase.valores[CONTADOR_FALLOS_DTLB]));
+	}
+}
+
+void mostrarResultado(const struct resultado * r){
+	printf("%-12s %-12s %6d %5d %-8s %12.6f %12.6f %12.6f %9.2f %s\n", r->variante, r->tipo, r->tamanioMatriz, r->numeroHilos,
+		nombresModosPaginas[r->paginas], r->minimo, r->mediana, r->percentil95, r->gops, r->correcto ? "si" : "NO");
+	if(r->contadores != NULL){
+		mostrarRegistroContadores(r->contadores);
+	}
+	fflush(stdout);
+}
+
+// calentar, medir las repeticiones, verificar el ultimo resultado y resumir
+// los tiempos; con repeticionesFreivalds = 0 la verificacion es exacta
+struct resultado medirVariante(const struct variante * variante, const struct matriz * matrizA, const struct matriz * matrizB,
+		struct matriz * matrizC, int numeroHilos, int calentamiento, int repeticiones, int medirContadores,
+		int repeticionesFreivalds, uint64_t semillaVerificacion){
+	struct resultado resultado;
+	double * tiempos = (double *)malloc(repeticiones * sizeof(double));
+	double inicio;
+	void * estado;
+	struct registroContadores * registro = NULL;
+	struct grupoContadores grupo;
+	int r;
+
+	if(tiempos == NULL){
+		perror("No se pudo reservar memoria para los tiempos");
+		exit(1);
+	}
+
+	estado = variante->preparar(matrizA, matrizB, numeroHilos);
+	for(r = 0; r < calentamiento; r++){
+		variante->multiplicar(estado, matrizA, matrizB, matrizC);
+	}
+
+	// los contadores solo cubren las repeticiones medidas, no el calentamiento
+	if(medirContadores){
+		registro = (struct registroContadores *)malloc(sizeof(struct registroContadores));
+		if(registro == NULL){
+			perror("No se pudo reservar memoria para los contadores");
+			exit(1);
+		}
+		reiniciarRegistroContadores(registro, numeroHilos);
+		if(variante->paralela){
+			medirContadoresVariantes(registro);
+		}
+	}
+	for(r = 0; r < repeticiones; r++){
+		int medirAqui = registro != NULL && !variante->paralela && abrirContadores(&grupo, 0) == 0;
+		if(medirAqui){
+			iniciarContadores(&grupo);
+		}
+		inicio = tiempoWall();
+		variante->multiplicar(estado, matrizA, matrizB, matrizC);
+		tiempos[r] = tiempoWall() - inicio;
+		if(medirAqui){
+			detenerContadores(&grupo, &registro->trabajadores[0]);
+			cerrarContadores(&grupo);
+		}
+	}
+	medirContadoresVariantes(NULL);
+	variante->liberar(estado);
+
+	resultado.correcto = repeticionesFreivalds == 0 ? verificarExacta(matrizA, matrizB, matrizC) :
+		verificarMultiplicacion(matrizA, matrizB, matrizC, repeticionesFreivalds, semillaVerificacion);
+
+	resultado.variante = variante->nombre;
+	resultado.tipo = "int32";
+	resultado.paginas = (enum modoPaginas)paginasMatriz(matrizA);
+	resultado.tamanioMatriz = matrizA->filas;
+	resultado.numeroHilos = numeroHilos;
+	resultado.contadores = registro;
+	resumirTiempos(&resultado, tiempos, repeticiones, 2.0 * matrizA->filas * matrizA->columnas * matrizB->columnas);
+	free(tiempos);
+	return resultado;
+}
+
+// como medirVariante pero con el motor generico de un tipo; sin contadores
+// y siempre con Freivalds
+struct resultado medirTipo(const struct motorTipo * motor, const struct matrizTipada * matrizA, const struct matrizTipada * matrizB,
+		struct matrizTipada * matrizC, int numeroHilos, int calentamiento, int repeticiones,
+		int repeticionesFreivalds, uint64_t semillaVerificacion){
+	struct resultado resultado;
+	double * tiempos = (double *)malloc(repeticiones * sizeof(double));
+	double inicio;
+	int r;
+
+	if(tiempos == NULL){
+		perror("No se pudo reservar memoria para los tiempos");
+		exit(1);
+	}
+	for(r = 0; r < calentamiento; r++){
+		motor->multiplicar(matrizA, matrizB, matrizC, numeroHilos);
+	}
+	for(r = 0; r < repeticiones; r++){
+		inicio = tiempoWall();
+		motor->multiplicar(matrizA, matrizB, matrizC, numeroHilos);
+		tiempos[r] = tiempoWall() - inicio;
+	}
+
+	resultado.variante = "empaquetada";
+	resultado.tipo = motor->nombre;
+	resultado.paginas = (enum modoPaginas)MODO_MARCA(matrizA->propietaria);
+	resultado.tamanioMatriz = matrizA->filas;
+	resultado.numeroHilos = numeroHilos;
+	resultado.contadores = NULL;
+	resultado.correcto = motor->freivalds(matrizA, matrizB, matrizC,
+		repeticionesFreivalds > 0 ? repeticionesFreivalds : REPETICIONES_FREIVALDS, semillaVerificacion);
+	resumirTiempos(&resultado, tiempos, repeticiones, 2.0 * matrizA->filas * matrizA->columnas * matrizB->columnas);
+	free(tiempos);
+	return resultado;
+}
+
+// minimo, mediana, percentil 95 y GOP/s (con la mediana) de las repeticiones
+void resumirTiempos(struct resultado * resultado, double * tiempos, int repeticiones, double operaciones){
+	int indice95;
+
+	qsort(tiempos, repeticiones, sizeof(double), compararDoubles);
+	// percentil 95 por rango mas cercano
+	indice95 = (95 * repeticiones + 99) / 100 - 1;
+
+	resultado->repeticiones = repeticiones;
+	resultado->minimo = tiempos[0];
+	resultado->mediana = repeticiones % 2 ? tiempos[repeticiones / 2] : (tiempos[repeticiones / 2 - 1] + tiempos[repeticiones / 2]) / 2;
+	resultado->percentil95 = tiempos[indice95 < 0 ? 0 : indice95];
+	resultado->gops = resultado->mediana > 0 ? operaciones / resultado->mediana * 1e-9 : 0.0;
+}
+
+int compararDoubles(const void * a, const void * b){
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+// valor derivado de los contadores; vacio (CSV) o null (JSON) si no hay dato
+static void escribirMetrica(FILE * archivo, double valor, const char * vacio){
+	if(valor < 0){
+		fprintf(archivo, "%s", vacio);
+	}
+	else{
+		fprintf(archivo, "%.4f", valor);
+	}
+}
+
+void escribirCsv(const char * nombreArchivo, const struct resultado * resultados, int numeroResultados){
+	FILE * archivo = fopen(nombreArchivo, "w");
+	struct lecturaContadores total;
+	int i;
+
+	if(archivo == NULL){
+		perror(nombreArchivo);
+		return;
+	}
+	fprintf(archivo, "variante,tipo,isa,n,hilos,paginas,repeticiones,min_s,mediana_s,p95_s,gops,correcto,ciclos,instrucciones,ipc,l1d_mpki,llc_mpki,dtlb_mpki\n");
+	for(i = 0; i < numeroResultados; i++){
+		fprintf(archivo, "%s,%s,%s,%d,%d,%s,%d,%.9f,%.9f,%.9f,%.4f,%d,", resultados[i].variante, resultados[i].tipo, nucleosActuales->nombre,
+			resultados[i].tamanioMatriz, resultados[i].numeroHilos, nombresModosPaginas[resultados[i].paginas], resultados[i].repeticiones,
+			resultados[i].minimo, resultados[i].mediana, resultados[i].percentil95, resultados[i].gops, resultados[i].correcto);
+		if(resultados[i].contadores == NULL){
+			fprintf(archivo, ",,,,,\n");
+			continue;
+		}
+		total = totalRegistroContadores(resultados[i].contadores);
+		fprintf(archivo, "%llu,%llu,", total.valores[CONTADOR_CICLOS], total.valores[CONTADOR_INSTRUCCIONES]);
+		escribirMetrica(archivo, ipcContadores(&total), "");
+		fprintf(archivo, ",");
+		escribirMetrica(archivo, fallosPorMilInstrucciones(&total, CONTADOR_FALLOS_L1D), "");
+		fprintf(archivo, ",");
+		escribirMetrica(archivo, fallosPorMilInstrucciones(&total, CONTADOR_FALLOS_LLC), "");
+		fprintf(archivo, ",");
+		escribirMetrica(archivo, fallosPorMilInstrucciones(&total, CONTADOR_FALLOS_DTLB), "");
+		fprintf(archivo, "\n");
+	}
+	fclose(archivo);
+}
+
+// objeto JSON con los valores crudos y las metricas de una lectura
+static void escribirLecturaJson(FILE * archivo, const struct lecturaContadores * lectura){
+	int c;
+	fprintf(archivo, "{");
+	for(c = 0; c < NUMERO_CONTADORES; c++){
+		if(lectura->disponibles[c]){
+			fprintf(archivo, "\"%s\": %llu, ", nombresContadores[c], lectura->valores[c]);
+		}
+		else{
+			fprintf(archivo, "\"%s\": null, ", nombresContadores[c]);
+		}
+	}
+	fprintf(archivo, "\"ipc\": ");
+	escribirMetrica(archivo, ipcContadores(lectura), "null");
+	fprintf(archivo, ", \"l1d_mpki\": ");
+	escribirMetrica(archivo, fallosPorMilInstrucciones(lectura, CONTADOR_FALLOS_L1D), "null");
+	fprintf(archivo, ", \"llc_mpki\": ");
+	escribirMetrica(archivo, fallosPorMilInstrucciones(lectura, CONTADOR_FALLOS_LLC), "null");
+	fprintf(archivo, ", \"dtlb_mpki\": ");
+	escribirMetrica(archivo, fallosPorMilInstrucciones(lectura, CONTADOR_FALLOS_DTLB), "null");
+	fprintf(archivo, "}");
+}
+
+void escribirJson(const char * nombreArchivo, const struct resultado * resultados, int numeroResultados){
+	FILE * archivo = fopen(nombreArchivo, "w");
+	struct lecturaContadores total;
+	int i, t;
+
+	if(archivo == NULL){
+		perror(nombreArchivo);
+		return;
+	}
+	fprintf(archivo, "{\n  \"isa\": \"%s\",\n  \"nucleos\": %ld,\n  \"resultados\": [\n", nucleosActuales->nombre, sysconf(_SC_NPROCESSORS_ONLN));
+	for(i = 0; i < numeroResultados; i++){
+		fprintf(archivo, "    {\"variante\": \"%s\", \"tipo\": \"%s\", \"n\": %d, \"hilos\": %d, \"paginas\": \"%s\", \"repeticiones\": %d, "
+			"\"min_s\": %.9f, \"mediana_s\": %.9f, \"p95_s\": %.9f, \"gops\": %.4f, \"correcto\": %s, \"contadores\": ",
+			resultados[i].variante, resultados[i].tipo, resultados[i].tamanioMatriz, resultados[i].numeroHilos,
+			nombresModosPaginas[resultados[i].paginas], resultados[i].repeticiones,
+			resultados[i].minimo, resultados[i].mediana, resultados[i].percentil95, resultados[i].gops,
+			resultados[i].correcto ? "true" : "false");
+		if(resultados[i].contadores == NULL){
+			fprintf(archivo, "null");
+		}
+		else{
+			total = totalRegistroContadores(resultados[i].contadores);
+			fprintf(archivo, "{\"total\": ");
+			escribirLecturaJson(archivo, &total);
+			fprintf(archivo, ", \"por_trabajador\": [");
+			for(t = 0; t < resultados[i].contadores->numeroTrabajadores; t++){
+				escribirLecturaJson(archivo, &resultados[i].contadores->trabajadores[t]);
+				fprintf(archivo, "%s", t + 1 < resultados[i].contadores->numeroTrabajadores ? ", " : "");
+			}
+			fprintf(archivo, "]}");
+		}
+		fprintf(archivo, "}%s\n", i + 1 < numeroResultados ? "," : "");
+	}
+	fprintf(archivo, "  ]\n}\n");
+	fclose(archivo);
+}
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
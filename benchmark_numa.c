@@ -0,0 +1,180 @@
+/*
+ Benchmark de ubicacion NUMA de las matrices
+
+ Para cada tamanio, numero de hilos y politica de numa_matriz.h reserva A, B
+ y C con esa politica, las inicializa (en paralelo por tramos de filas, o en
+ un hilo con un_hilo) y mide C = A * B con gemmEmpaquetada. Ademas del tiempo
+ reporta el trafico estimado de un producto: bytes que cada hilo lee o
+ escribe en su propio nodo y en otros, segun donde quedo cada pagina.
+
+ Uso: ./benchmark_numa [-n 2048] [-t 1,4] [-p un_hilo,primer_toque,por_filas,intercalada]
+                       [-r repeticiones] [-o archivo.csv]
+
+ Los hilos tienen que quedarse en su CPU para que la ubicacion tenga sentido:
+ 	OMP_PROC_BIND=close OMP_PLACES=cores ./benchmark_numa
+ En una maquina de un solo nodo, MATRIZ_NUMA_FALSO=2 simula dos nodos (el
+ tiempo no cambia, pero el reporte de trafico muestra el efecto de cada
+ politica).
+
+ para compilar (o make):
+ gcc -O2 -fopenmp benchmark_numa.c -L. -lmatrices -lrt -lm
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "numa_matriz.h"
+#include "gemm_empaquetado.h"
+
+#define MAX_LISTA 16
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int leerListaEnteros(char * texto, int * valores, int maximo){
+	int cuantos = 0;
+	char * parte = strtok(texto, ",");
+	while(parte != NULL && cuantos < maximo){
+		valores[cuantos++] = atoi(parte);
+		parte = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+int leerListaPoliticas(char * texto, int * politicas, int maximo){
+	int cuantas = 0, politica;
+	char * parte = strtok(texto, ",");
+	while(parte != NULL && cuantas < maximo){
+		politica = politicaNumaPorNombre(parte);
+		if(politica < 0){
+			fprintf(stderr, "politica desconocida: %s\n", parte);
+			exit(1);
+		}
+		politicas[cuantas++] = politica;
+		parte = strtok(NULL, ",");
+	}
+	return cuantas;
+}
+
+// suma de C para comparar el resultado entre politicas
+unsigned long long sumaMatriz(const struct matriz * matriz){
+	unsigned long long suma = 0;
+	int i, j;
+	for(i = 0; i < matriz->filas; i++){
+		for(j = 0; j < matriz->columnas; j++){
+			suma = suma * 31 + (unsigned int)ELEMENTO(matriz, i, j);
+		}
+	}
+	return suma;
+}
+
+int main(int argc, char *argv[]){
+	const struct topologiaNuma * topologia = topologiaNuma();
+	int tamanios[MAX_LISTA] = {2048}, hilos[MAX_LISTA], politicas[MAX_LISTA];
+	int numeroTamanios = 1, numeroHilos = 0, numeroPoliticas = 0, repeticiones = 3;
+	int nucleos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	const char * nombreArchivo = "benchmark_numa.csv";
+	struct matrizNuma * A, * B, * C;
+	struct traficoNuma trafico;
+	unsigned long long suma, sumaReferencia = 0;
+	double inicio, tiempo, minimo, total;
+	int opcion, t, h, p, r, n, correcto;
+	FILE * archivo;
+
+	while((opcion = getopt(argc, argv, "n:t:p:r:o:")) != -1){
+		switch(opcion){
+			case 'n': numeroTamanios = leerListaEnteros(optarg, tamanios, MAX_LISTA); break;
+			case 't': numeroHilos = leerListaEnteros(optarg, hilos, MAX_LISTA); break;
+			case 'p': numeroPoliticas = leerListaPoliticas(optarg, politicas, MAX_LISTA); break;
+			case 'r': repeticiones = atoi(optarg); break;
+			case 'o': nombreArchivo = optarg; break;
+			default:
+				fprintf(stderr, "uso: %s [-n tamanios] [-t hilos] [-p politicas] [-r repeticiones] [-o archivo.csv]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(numeroHilos == 0){
+		hilos[numeroHilos++] = 1;
+		if(nucleos > 1){
+			hilos[numeroHilos++] = nucleos;
+		}
+	}
+	if(numeroPoliticas == 0){
+		for(p = 0; p < NUMERO_POLITICAS_NUMA; p++){
+			politicas[numeroPoliticas++] = p;
+		}
+	}
+	if(repeticiones < 1){
+		repeticiones = 1;
+	}
+	if(getenv("OMP_PROC_BIND") == NULL && !topologia->falsa && topologia->nodos > 1){
+		fprintf(stderr, "aviso: sin OMP_PROC_BIND los hilos pueden migrar de nodo y el primer toque pierde sentido\n");
+	}
+
+	archivo = fopen(nombreArchivo, "w");
+	if(archivo == NULL){
+		perror(nombreArchivo);
+		return 1;
+	}
+	fprintf(archivo, "politica,n,hilos,nodos,topologia,min_s,gops,bytes_locales,bytes_remotos,porcentaje_remoto,correcto\n");
+	printf("%d nodo(s)%s\n", topologia->nodos, topologia->falsa ? " (topologia falsa, MATRIZ_NUMA_FALSO)" : "");
+	printf("%-13s %6s %5s %10s %8s %12s %12s %8s  %s\n", "politica", "n", "hilos", "min_s", "GOP/s", "MB locales", "MB remotos",
+		"% remoto", "paginas por nodo");
+
+	for(t = 0; t < numeroTamanios; t++){
+		n = tamanios[t];
+		for(h = 0; h < numeroHilos; h++){
+			for(p = 0; p < numeroPoliticas; p++){
+				A = crearMatrizNuma(n, n, politicas[p], hilos[h]);
+				B = crearMatrizNuma(n, n, politicas[p], hilos[h]);
+				C = crearMatrizNuma(n, n, politicas[p], hilos[h]);
+				inicializarMatrizNuma(A, 1, 1, hilos[h]);
+				inicializarMatrizNuma(B, 1, 2, hilos[h]);
+				inicializarMatrizNuma(C, 0, 0, hilos[h]);
+
+				minimo = 0;
+				for(r = 0; r <= repeticiones; r++){
+					inicio = tiempoWall();
+					gemmEmpaquetada(1, &A->matriz, &B->matriz, 0, &C->matriz, hilos[h]);
+					tiempo = tiempoWall() - inicio;
+					// la primera corrida es de calentamiento
+					if(r == 1 || (r > 1 && tiempo < minimo)){
+						minimo = tiempo;
+					}
+				}
+
+				// las politicas solo cambian donde estan las paginas, no el resultado
+				suma = sumaMatriz(&C->matriz);
+				if(p == 0){
+					sumaReferencia = suma;
+				}
+				correcto = suma == sumaReferencia;
+
+				traficoNumaGemm(A, B, C, hilos[h], &trafico);
+				total = trafico.bytesLocales + trafico.bytesRemotos;
+				printf("%-13s %6d %5d %10.4f %8.2f %12.1f %12.1f %7.1f%% ", nombresPoliticasNuma[politicas[p]], n, hilos[h], minimo,
+					2.0 * n * n * n / minimo * 1e-9, trafico.bytesLocales / 1e6, trafico.bytesRemotos / 1e6,
+					total > 0 ? 100.0 * trafico.bytesRemotos / total : 0.0);
+				for(r = 0; r < topologia->nodos; r++){
+					printf(" %.0f", trafico.paginasPorNodo[r]);
+				}
+				printf("%s\n", correcto ? "" : "  RESULTADO DISTINTO");
+				fprintf(archivo, "%s,%d,%d,%d,%s,%.9f,%.4f,%.0f,%.0f,%.2f,%d\n", nombresPoliticasNuma[politicas[p]], n, hilos[h],
+					topologia->nodos, topologia->falsa ? "falsa" : "real", minimo, 2.0 * n * n * n / minimo * 1e-9,
+					trafico.bytesLocales, trafico.bytesRemotos, total > 0 ? 100.0 * trafico.bytesRemotos / total : 0.0, correcto);
+
+				liberarMatrizNuma(A);
+				liberarMatrizNuma(B);
+				liberarMatrizNuma(C);
+			}
+		}
+	}
+	fclose(archivo);
+	printf("resultados en %s\n", nombreArchivo);
+	return 0;
+}
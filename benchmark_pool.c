@@ -0,0 +1,147 @@
+/*
+ Benchmark del pool de memoria (pool_memoria.h)
+
+ Simula un proceso que multiplica miles de veces: en cada iteracion crea A
+ (M x K), B (K x N) y C con formas tomadas al azar de la lista de tamanios,
+ llena A y B, calcula C = A * B con gemmMatriz (que pide sus paneles en cada
+ llamada), transpone C con transponerMatriz (otra matriz si no es cuadrada)
+ y libera todo. Lo mismo se corre sin pool y con pool, con las mismas formas
+ y los mismos datos.
+
+ Con -t varios trabajadores hacen iteraciones a la vez (cada uno con gemm en
+ un hilo), asi el pool se usa desde varios hilos al mismo tiempo.
+
+ Reporta tiempo, productos por segundo, GOP/s, fallos de pagina menores
+ (getrusage) y, con pool, aciertos y picos de bytes en uso y reservados.
+ Cada 64 iteraciones se verifica C con Freivalds.
+
+ Uso: ./benchmark_pool [-n 64,128,256,512] [-i iteraciones] [-t trabajadores] [-s semilla]
+
+ para compilar (o make):
+ gcc -O2 -fopenmp benchmark_pool.c -L. -lmatrices -lrt -lm -lpthread
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "matriz.h"
+#include "gemm.h"
+#include "verificacion.h"
+#include "pool_memoria.h"
+#include "aleatorio_contador.h"
+
+#define MAX_LISTA 32
+#define CADA_VERIFICACION 64
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int leerListaEnteros(char * texto, int * valores, int maximo){
+	int cuantos = 0;
+	char * parte = strtok(texto, ",");
+	while(parte != NULL && cuantos < maximo){
+		valores[cuantos++] = atoi(parte);
+		parte = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+long fallosPagina(){
+	struct rusage uso;
+	getrusage(RUSAGE_SELF, &uso);
+	return uso.ru_minflt;
+}
+
+// las formas de la iteracion dependen solo de la semilla y del numero de iteracion
+void formaIteracion(uint64_t clave, long iteracion, const int * tamanios, int numeroTamanios, int * m, int * k, int * n){
+	*m = tamanios[enteroEnRango(aleatorioContador(clave, 3 * iteracion), numeroTamanios)];
+	*k = tamanios[enteroEnRango(aleatorioContador(clave, 3 * iteracion + 1), numeroTamanios)];
+	*n = tamanios[enteroEnRango(aleatorioContador(clave, 3 * iteracion + 2), numeroTamanios)];
+}
+
+// devuelve las operaciones hechas; fallidas cuenta las verificaciones que no pasan
+double correr(const int * tamanios, int numeroTamanios, long iteraciones, int trabajadores, uint64_t semilla, long * fallidas){
+	uint64_t clave = claveAleatoria(semilla);
+	double operaciones = 0;
+	long i, malas = 0;
+
+	#pragma omp parallel for num_threads(trabajadores) schedule(dynamic, 1) reduction(+:operaciones, malas)
+	for(i = 0; i < iteraciones; i++){
+		struct matriz * A, * B, * C;
+		int m, k, n;
+
+		formaIteracion(clave, i, tamanios, numeroTamanios, &m, &k, &n);
+		A = crearMatriz(m, k);
+		B = crearMatriz(k, n);
+		C = crearMatriz(m, n);
+		inicializarMatrizAleatoria(A, semilla + 2 * i, -9, 9);
+		inicializarMatrizAleatoria(B, semilla + 2 * i + 1, -9, 9);
+		gemmMatriz(1, A, B, 0, C);
+		if(i % CADA_VERIFICACION == 0 && !verificarMultiplicacion(A, B, C, REPETICIONES_FREIVALDS, semilla + i)){
+			malas++;
+		}
+		C = transponerMatriz(C);
+		operaciones += 2.0 * m * n * k;
+		liberarMemoriaMatriz(A);
+		liberarMemoriaMatriz(B);
+		liberarMemoriaMatriz(C);
+	}
+	*fallidas = malas;
+	return operaciones;
+}
+
+int main(int argc, char *argv[]){
+	int tamanios[MAX_LISTA] = {64, 96, 128, 200, 256, 384, 512};
+	int numeroTamanios = 7, trabajadores = 1, opcion, conPool;
+	long iteraciones = 2000, fallidas, fallos;
+	uint64_t semilla = 1;
+	double inicio, tiempo, operaciones, tiempoSinPool = 0;
+
+	while((opcion = getopt(argc, argv, "n:i:t:s:")) != -1){
+		switch(opcion){
+			case 'n': numeroTamanios = leerListaEnteros(optarg, tamanios, MAX_LISTA); break;
+			case 'i': iteraciones = atol(optarg); break;
+			case 't': trabajadores = atoi(optarg); break;
+			case 's': semilla = strtoull(optarg, NULL, 10); break;
+			default:
+				fprintf(stderr, "uso: %s [-n tamanios] [-i iteraciones] [-t trabajadores] [-s semilla]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(numeroTamanios < 1 || trabajadores < 1 || iteraciones < 1){
+		fprintf(stderr, "hacen falta tamanios, trabajadores e iteraciones positivos\n");
+		return 1;
+	}
+	// con varios trabajadores cada producto va en un hilo
+	if(trabajadores > 1){
+		fijarHilosGemm(1);
+	}
+
+	printf("%ld iteraciones, %d trabajadores, gemm con %d hilos, limite del pool %.0f MiB\n", iteraciones, trabajadores,
+		hilosGemm(), limitePoolMemoria / 1048576.0);
+	printf("%-8s %10s %12s %8s %14s %8s %s\n", "pool", "tiempo (s)", "productos/s", "GOP/s", "fallos pagina", "mejora", "correcto");
+	for(conPool = 0; conPool <= 1; conPool++){
+		activarPoolMemoria(conPool);
+		reiniciarEstadisticasPoolMemoria();
+		fallos = fallosPagina();
+		inicio = tiempoWall();
+		operaciones = correr(tamanios, numeroTamanios, iteraciones, trabajadores, semilla, &fallidas);
+		tiempo = tiempoWall() - inicio;
+		fallos = fallosPagina() - fallos;
+		if(!conPool){
+			tiempoSinPool = tiempo;
+		}
+		printf("%-8s %10.4f %12.1f %8.2f %14ld %7.2fx %s\n", conPool ? "si" : "no", tiempo, iteraciones / tiempo,
+			operaciones / tiempo * 1e-9, fallos, tiempoSinPool / tiempo, fallidas == 0 ? "si" : "NO");
+		fflush(stdout);
+	}
+	mostrarEstadisticasPoolMemoria();
+	activarPoolMemoria(0);
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ Benchmark de transposicion de matrices
+
+ Para cada tamanio y numero de hilos mide:
+
+ 	ingenua    el bucle de antes: destino[i][j] = origen[j][i], que lee origen
+ 	           por columnas y falla en cache en casi cada elemento
+ 	bloques    transponerMatrizEn: bloques de 64 x 64 en paralelo con
+ 	           azulejos de 8 x 8 en registros
+ 	en_sitio   transponerMatrizEnSitio sobre la misma matriz
+ 	memcpy     copiar los mismos bytes con memcpy (en tramos, uno por hilo):
+ 	           el techo de ancho de banda para algo que lee y escribe todo una vez
+
+ y reporta GB/s contando lectura y escritura (2 * N * N * 4 bytes). Cada
+ transposicion se compara con la ingenua.
+
+ Uso: ./benchmark_transposicion [-n 1024,4096,8192] [-t 1,4] [-r repeticiones]
+
+ para compilar (o make):
+ gcc -O2 -fopenmp benchmark_transposicion.c -L. -lmatrices -lrt -lm
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+
+#include "matriz.h"
+
+#define MAX_LISTA 16
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int leerListaEnteros(char * texto, int * valores, int maximo){
+	int cuantos = 0;
+	char * parte = strtok(texto, ",");
+	while(parte != NULL && cuantos < maximo){
+		valores[cuantos++] = atoi(parte);
+		parte = strtok(NULL, ",");
+	}
+	return cuantos;
+}
+
+void transponerIngenua(const struct matriz * origen, struct matriz * destino){
+	int i, j;
+	for(i = 0; i < destino->filas; i++){
+		for(j = 0; j < destino->columnas; j++){
+			ELEMENTO(destino, i, j) = ELEMENTO(origen, j, i);
+		}
+	}
+}
+
+void copiarParalelo(const struct matriz * origen, struct matriz * destino){
+	size_t bytes = (size_t)origen->filas * origen->ld * sizeof(int);
+	#pragma omp parallel
+	{
+		size_t hilo = omp_get_thread_num(), total = omp_get_num_threads();
+		size_t inicio = bytes * hilo / total, fin = bytes * (hilo + 1) / total;
+		memcpy((char *)destino->datos + inicio, (const char *)origen->datos + inicio, fin - inicio);
+	}
+}
+
+int iguales(const struct matriz * a, const struct matriz * b){
+	int i;
+	for(i = 0; i < a->filas; i++){
+		if(memcmp(FILA(a, i), FILA(b, i), (size_t)a->columnas * sizeof(int)) != 0){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void mostrar(const char * nombre, int n, int hilos, double tiempo, int correcto){
+	printf("%-9s %6d %5d %10.5f %8.2f %s\n", nombre, n, hilos, tiempo, 2.0 * n * n * sizeof(int) / tiempo * 1e-9,
+		correcto ? "si" : "NO");
+}
+
+int main(int argc, char *argv[]){
+	int tamanios[MAX_LISTA] = {1024, 4096, 8192}, hilos[MAX_LISTA];
+	int numeroTamanios = 3, numeroHilos = 0, repeticiones = 5;
+	int nucleos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	struct matriz * origen, * destino, * referencia, * enSitio;
+	double inicio, minimo[4], tiempo;
+	int opcion, t, h, r, n, correctoSitio;
+
+	while((opcion = getopt(argc, argv, "n:t:r:")) != -1){
+		switch(opcion){
+			case 'n': numeroTamanios = leerListaEnteros(optarg, tamanios, MAX_LISTA); break;
+			case 't': numeroHilos = leerListaEnteros(optarg, hilos, MAX_LISTA); break;
+			case 'r': repeticiones = atoi(optarg); break;
+			default:
+				fprintf(stderr, "uso: %s [-n tamanios] [-t hilos] [-r repeticiones]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(numeroHilos == 0){
+		hilos[numeroHilos++] = 1;
+		if(nucleos > 1){
+			hilos[numeroHilos++] = nucleos;
+		}
+	}
+	if(repeticiones < 1){
+		repeticiones = 1;
+	}
+
+	printf("%-9s %6s %5s %10s %8s %s\n", "metodo", "N", "hilos", "min (s)", "GB/s", "correcto");
+	for(t = 0; t < numeroTamanios; t++){
+		n = tamanios[t];
+		origen = crearMatriz(n, n);
+		destino = crearMatriz(n, n);
+		referencia = crearMatriz(n, n);
+		enSitio = crearMatriz(n, n);
+		inicializarMatrizAleatoria(origen, 1, -1000000, 1000000);
+
+		// la ingenua no depende de los hilos: una vez por tamanio
+		minimo[0] = 0;
+		for(r = 0; r < repeticiones; r++){
+			inicio = tiempoWall();
+			transponerIngenua(origen, referencia);
+			tiempo = tiempoWall() - inicio;
+			minimo[0] = r == 0 || tiempo < minimo[0] ? tiempo : minimo[0];
+		}
+		mostrar("ingenua", n, 1, minimo[0], 1);
+
+		for(h = 0; h < numeroHilos; h++){
+			omp_set_num_threads(hilos[h]);
+			minimo[1] = minimo[2] = minimo[3] = 0;
+			correctoSitio = 1;
+			for(r = 0; r < repeticiones; r++){
+				inicio = tiempoWall();
+				transponerMatrizEn(origen, destino);
+				tiempo = tiempoWall() - inicio;
+				minimo[1] = r == 0 || tiempo < minimo[1] ? tiempo : minimo[1];
+
+				// en sitio sobre una copia de origen, que queda transpuesta
+				copiarParalelo(origen, enSitio);
+				inicio = tiempoWall();
+				transponerMatrizEnSitio(enSitio);
+				tiempo = tiempoWall() - inicio;
+				minimo[2] = r == 0 || tiempo < minimo[2] ? tiempo : minimo[2];
+				correctoSitio = correctoSitio && iguales(enSitio, referencia);
+
+				inicio = tiempoWall();
+				copiarParalelo(origen, enSitio);
+				tiempo = tiempoWall() - inicio;
+				minimo[3] = r == 0 || tiempo < minimo[3] ? tiempo : minimo[3];
+			}
+			mostrar("bloques", n, hilos[h], minimo[1], iguales(destino, referencia));
+			mostrar("en_sitio", n, hilos[h], minimo[2], correctoSitio);
+			mostrar("memcpy", n, hilos[h], minimo[3], 1);
+		}
+
+		liberarMemoriaMatriz(origen);
+		liberarMemoriaMatriz(destino);
+		liberarMemoriaMatriz(referencia);
+		liberarMemoriaMatriz(enSitio);
+	}
+	return 0;
+}
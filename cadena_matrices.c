@@ -0,0 +1,401 @@
+// cadenas de productos con parentesis optimos y un espacio de trabajo fijo
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <omp.h>
+
+#include "cadena_matrices.h"
+#include "gemm.h"
+#include "gemm_empaquetado.h"
+#include "pool_memoria.h"
+
+static void * reservar(size_t bytes){
+	void * bloque = malloc(bytes > 0 ? bytes : 1);
+	if(bloque == NULL){
+		perror("No se pudo reservar memoria para el plan de la cadena");
+		exit(1);
+	}
+	return bloque;
+}
+
+static size_t maximo(size_t a, size_t b){
+	return a > b ? a : b;
+}
+
+// 2 * m * n * k del producto de las matrices primera .. ultima partido en corte
+static double operacionesProducto(const int * dimensiones, int primera, int corte, int ultima){
+	return 2.0 * dimensiones[primera] * dimensiones[corte + 1] * dimensiones[ultima + 1];
+}
+
+// enteros del resultado de un producto (el del ultimo va a C)
+static size_t elementosResultado(const struct planCadena * plan, const struct productoCadena * producto){
+	if(producto == &plan->productos[plan->numero - 2]){
+		return 0;
+	}
+	return (size_t)plan->dimensiones[producto->primera] * calcularLd(plan->dimensiones[producto->ultima + 1]);
+}
+
+// programacion dinamica clasica: costo[i][j] es el minimo de operaciones para
+// A_i .. A_j y corte[i][j] el k de (A_i .. A_k)(A_k+1 .. A_j)
+static void ordenOptimo(const int * dimensiones, int numero, int * corte){
+	double * costo = (double *)reservar((size_t)numero * numero * sizeof(double));
+	int i, j, k, largo;
+
+	for(i = 0; i < numero; i++){
+		costo[(size_t)i * numero + i] = 0;
+	}
+	for(largo = 2; largo <= numero; largo++){
+		for(i = 0; i + largo - 1 < numero; i++){
+			j = i + largo - 1;
+			costo[(size_t)i * numero + j] = -1;
+			for(k = i; k < j; k++){
+				double total = costo[(size_t)i * numero + k] + costo[(size_t)(k + 1) * numero + j]
+					+ operacionesProducto(dimensiones, i, k, j);
+				if(costo[(size_t)i * numero + j] < 0 || total < costo[(size_t)i * numero + j]){
+					costo[(size_t)i * numero + j] = total;
+					corte[(size_t)i * numero + j] = k;
+				}
+			}
+		}
+	}
+	free(costo);
+}
+
+// arma el arbol en postorden; devuelve el producto de primera .. ultima, o -1
+// si es una sola matriz
+static int armarProductos(struct planCadena * plan, const int * corte, int primera, int ultima, int * siguiente){
+	struct productoCadena * producto;
+	int k, izquierdo, derecho;
+
+	if(primera == ultima){
+		return -1;
+	}
+	k = corte[(size_t)primera * plan->numero + ultima];
+	izquierdo = armarProductos(plan, corte, primera, k, siguiente);
+	derecho = armarProductos(plan, corte, k + 1, ultima, siguiente);
+	producto = &plan->productos[*siguiente];
+	producto->primera = primera;
+	producto->ultima = ultima;
+	producto->izquierdo = izquierdo;
+	producto->derecho = derecho;
+	producto->nivel = 1 + (izquierdo < 0 ? 0 : plan->productos[izquierdo].nivel);
+	if(derecho >= 0 && plan->productos[derecho].nivel >= producto->nivel){
+		producto->nivel = plan->productos[derecho].nivel + 1;
+	}
+	producto->operaciones = operacionesProducto(plan->dimensiones, primera, k, ultima);
+	return (*siguiente)++;
+}
+
+/*
+ Lugar de los intermedios. tramo[p] es lo que ocupa el subarbol de p, su
+ resultado incluido. El resultado de p solo no puede pisar los de sus dos
+ operandos, que lee; lo que hay debajo de ellos ya se consumio cuando p
+ corre. Con el resultado al principio del tramo:
+
+ 	[relleno][operando cercano, resultado al final][otro, resultado al principio]
+
+ y lo de mas abajo del operando cercano cae sobre el resultado de p. El
+ relleno es lo justo para que el resultado de p no llegue al del operando
+ cercano; como cercano se toma el que tiene mas tramo sobrante. Con el
+ resultado al final es el espejo. Los dos operandos quedan en tramos
+ distintos porque pueden correr a la vez.
+*/
+static size_t medirTramo(const struct planCadena * plan, int p, size_t * tramo){
+	const struct productoCadena * producto = &plan->productos[p];
+	size_t resultado = elementosResultado(plan, producto);
+	size_t tramoIzquierdo = 0, tramoDerecho = 0, sobraIzquierdo = 0, sobraDerecho = 0, sobra;
+
+	if(producto->izquierdo >= 0){
+		tramoIzquierdo = medirTramo(plan, producto->izquierdo, tramo);
+		sobraIzquierdo = tramoIzquierdo - elementosResultado(plan, &plan->productos[producto->izquierdo]);
+	}
+	if(producto->derecho >= 0){
+		tramoDerecho = medirTramo(plan, producto->derecho, tramo);
+		sobraDerecho = tramoDerecho - elementosResultado(plan, &plan->productos[producto->derecho]);
+	}
+	sobra = maximo(sobraIzquierdo, sobraDerecho);
+	tramo[p] = (resultado > sobra ? resultado - sobra : 0) + tramoIzquierdo + tramoDerecho;
+	return tramo[p];
+}
+
+static void colocarTramo(struct planCadena * plan, int p, const size_t * tramo, size_t inicio, int alFinal){
+	struct productoCadena * producto = &plan->productos[p];
+	size_t resultado = elementosResultado(plan, producto);
+	int cercano = producto->izquierdo, otro = producto->derecho;
+	size_t tramoCercano, tramoOtro, sobra;
+
+	// el cercano es el de mas tramo sobrante (un operando que es matriz de
+	// entrada tiene tramo 0)
+	if(otro >= 0 && (cercano < 0 || tramo[otro] - elementosResultado(plan, &plan->productos[otro])
+			> tramo[cercano] - elementosResultado(plan, &plan->productos[cercano]))){
+		cercano = producto->derecho;
+		otro = producto->izquierdo;
+	}
+	tramoCercano = cercano >= 0 ? tramo[cercano] : 0;
+	tramoOtro = otro >= 0 ? tramo[otro] : 0;
+	sobra = cercano >= 0 ? tramoCercano - elementosResultado(plan, &plan->productos[cercano]) : 0;
+
+	producto->desplazamiento = alFinal ? inicio + tramo[p] - resultado : inicio;
+	if(!alFinal){
+		inicio += resultado > sobra ? resultado - sobra : 0;
+		if(cercano >= 0){
+			colocarTramo(plan, cercano, tramo, inicio, 1);
+		}
+		if(otro >= 0){
+			colocarTramo(plan, otro, tramo, inicio + tramoCercano, 0);
+		}
+	}
+	else{
+		if(otro >= 0){
+			colocarTramo(plan, otro, tramo, inicio, 1);
+		}
+		if(cercano >= 0){
+			colocarTramo(plan, cercano, tramo, inicio + tramoOtro, 0);
+		}
+	}
+}
+
+// los productos de un nivel se reparten uno por hilo si son varios y o
+// alcanzan para todos los hilos o son chicos
+static int repartirNivel(const struct planCadena * plan, int nivel){
+	int inicio = plan->inicioNivel[nivel], fin = plan->inicioNivel[nivel + 1], p;
+	double operaciones = 0;
+
+	if(fin - inicio < 2 || plan->numeroHilos < 2){
+		return 0;
+	}
+	for(p = inicio; p < fin; p++){
+		operaciones += plan->productos[p].operaciones;
+	}
+	return fin - inicio >= plan->numeroHilos || operaciones / (fin - inicio) < OPERACIONES_PRODUCTO_CHICO_CADENA;
+}
+
+// paneles de un nivel: por hilo si se reparte, o los de un producto con todos
+// los hilos (de a uno, se reusan)
+static size_t panelesNivel(const struct planCadena * plan, int nivel, size_t * porHilo){
+	const int * d = plan->dimensiones;
+	int p, reparte = repartirNivel(plan, nivel);
+	size_t elementos = 0;
+
+	for(p = plan->inicioNivel[nivel]; p < plan->inicioNivel[nivel + 1]; p++){
+		const struct productoCadena * producto = &plan->productos[p];
+		int m = d[producto->primera], n = d[producto->ultima + 1];
+		int k = d[(producto->izquierdo >= 0 ? plan->productos[producto->izquierdo].ultima : producto->primera) + 1];
+		elementos = maximo(elementos, reparte ? elementosPanelesEmpaquetada(m, k, n)
+			: elementosPanelesEmpaquetadaHilos(m, k, n, plan->numeroHilos));
+	}
+	// cada panel de hilo empieza alineado a 64 bytes
+	elementos = (elementos + 15) / 16 * 16;
+	*porHilo = elementos;
+	if(reparte){
+		int hilos = plan->inicioNivel[nivel + 1] - plan->inicioNivel[nivel];
+		return elementos * (hilos < plan->numeroHilos ? hilos : plan->numeroHilos);
+	}
+	return elementos;
+}
+
+struct planCadena * planificarCadena(const int * dimensiones, int numero, int numeroHilos){
+	struct planCadena * plan;
+	struct productoCadena * ordenados;
+	int * corte, * nuevo, * viejo;
+	size_t * tramo;
+	size_t porHilo;
+	int i, p, siguiente = 0;
+
+	if(numero < 1){
+		return NULL;
+	}
+	for(i = 0; i <= numero; i++){
+		if(dimensiones[i] < 1){
+			return NULL;
+		}
+	}
+	plan = (struct planCadena *)reservar(sizeof(struct planCadena));
+	memset(plan, 0, sizeof(struct planCadena));
+	plan->numero = numero;
+	plan->numeroHilos = numeroHilos > 0 ? numeroHilos : hilosGemm();
+	plan->dimensiones = (int *)reservar((numero + 1) * sizeof(int));
+	memcpy(plan->dimensiones, dimensiones, (numero + 1) * sizeof(int));
+	plan->productos = (struct productoCadena *)reservar(numero * sizeof(struct productoCadena));
+	for(i = 1; i < numero; i++){
+		plan->operacionesIzquierda += operacionesProducto(dimensiones, 0, i - 1, i);
+	}
+
+	if(numero > 1){
+		corte = (int *)reservar((size_t)numero * numero * sizeof(int));
+		ordenOptimo(dimensiones, numero, corte);
+		armarProductos(plan, corte, 0, numero - 1, &siguiente);
+		free(corte);
+
+		// el ultimo en postorden es la raiz: medir y colocar antes de reordenar
+		tramo = (size_t *)reservar(numero * sizeof(size_t));
+		plan->elementosIntermedios = medirTramo(plan, numero - 2, tramo);
+		colocarTramo(plan, numero - 2, tramo, 0, 0);
+		free(tramo);
+
+		// por nivel y, dentro del nivel, los mas caros primero
+		plan->numeroNiveles = plan->productos[numero - 2].nivel;
+		ordenados = (struct productoCadena *)reservar(numero * sizeof(struct productoCadena));
+		nuevo = (int *)reservar(numero * sizeof(int));
+		viejo = (int *)reservar(numero * sizeof(int));
+		plan->inicioNivel = (int *)reservar((plan->numeroNiveles + 1) * sizeof(int));
+		siguiente = 0;
+		for(i = 1; i <= plan->numeroNiveles; i++){
+			plan->inicioNivel[i - 1] = siguiente;
+			for(p = 0; p < numero - 1; p++){
+				if(plan->productos[p].nivel == i){
+					int q = siguiente++;
+					while(q > plan->inicioNivel[i - 1] && ordenados[q - 1].operaciones < plan->productos[p].operaciones){
+						ordenados[q] = ordenados[q - 1];
+						nuevo[q] = nuevo[q - 1];
+						q--;
+					}
+					ordenados[q] = plan->productos[p];
+					nuevo[q] = p;
+				}
+			}
+		}
+		plan->inicioNivel[plan->numeroNiveles] = siguiente;
+		// nuevo[q] es el indice viejo del producto q; los operandos pasan a los nuevos
+		for(p = 0; p < numero - 1; p++){
+			viejo[nuevo[p]] = p;
+		}
+		for(i = 0; i < numero - 1; i++){
+			plan->operacionesOptimas += ordenados[i].operaciones;
+			if(ordenados[i].izquierdo >= 0){
+				ordenados[i].izquierdo = viejo[ordenados[i].izquierdo];
+			}
+			if(ordenados[i].derecho >= 0){
+				ordenados[i].derecho = viejo[ordenados[i].derecho];
+			}
+		}
+		free(plan->productos);
+		free(nuevo);
+		free(viejo);
+		plan->productos = ordenados;
+
+		for(i = 0; i < numero - 2; i++){
+			plan->elementosSinReuso += elementosResultado(plan, &plan->productos[i]);
+		}
+		for(i = 0; i < plan->numeroNiveles; i++){
+			plan->elementosPaneles = maximo(plan->elementosPaneles, panelesNivel(plan, i, &porHilo));
+		}
+	}
+
+	plan->elementosEspacio = plan->elementosIntermedios + plan->elementosPaneles;
+	plan->espacio = (int *)tomarBloque(plan->elementosEspacio * sizeof(int), 1, &plan->marca);
+	return plan;
+}
+
+void liberarPlanCadena(struct planCadena * plan){
+	if(plan == NULL){
+		return;
+	}
+	devolverBloque(plan->espacio, plan->elementosEspacio * sizeof(int), plan->marca);
+	free(plan->dimensiones);
+	free(plan->productos);
+	free(plan->inicioNivel);
+	free(plan);
+}
+
+// el resultado del producto p dentro del espacio de trabajo
+static struct matriz intermedio(const struct planCadena * plan, int p){
+	const struct productoCadena * producto = &plan->productos[p];
+	int filas = plan->dimensiones[producto->primera], columnas = plan->dimensiones[producto->ultima + 1];
+	return envolverMatriz(plan->espacio + producto->desplazamiento, filas, columnas, calcularLd(columnas));
+}
+
+static void ejecutarProducto(const struct planCadena * plan, int p, const struct matriz * const * matrices, struct matriz * C,
+		int * paneles, int numeroHilos){
+	const struct productoCadena * producto = &plan->productos[p];
+	struct matriz izquierdo, derecho, resultado;
+
+	izquierdo = producto->izquierdo >= 0 ? intermedio(plan, producto->izquierdo) : *matrices[producto->primera];
+	derecho = producto->derecho >= 0 ? intermedio(plan, producto->derecho) : *matrices[producto->ultima];
+	resultado = p == plan->numero - 2 ? *C : intermedio(plan, p);
+	multiplicarMatricesEmpaquetadaConPanelesHilos(&izquierdo, &derecho, &resultado, paneles, numeroHilos);
+}
+
+int multiplicarCadena(const struct planCadena * plan, const struct matriz * const * matrices, struct matriz * C){
+	int * paneles = plan->espacio + plan->elementosIntermedios;
+	size_t porHilo;
+	int i, nivel, p;
+
+	for(i = 0; i < plan->numero; i++){
+		if(matrices[i]->filas != plan->dimensiones[i] || matrices[i]->columnas != plan->dimensiones[i + 1]){
+			return -1;
+		}
+	}
+	if(C->filas != plan->dimensiones[0] || C->columnas != plan->dimensiones[plan->numero]){
+		return -1;
+	}
+	if(plan->numero == 1){
+		for(i = 0; i < C->filas; i++){
+			memcpy(FILA(C, i), FILA(matrices[0], i), C->columnas * sizeof(int));
+		}
+		return 0;
+	}
+
+	for(nivel = 0; nivel < plan->numeroNiveles; nivel++){
+		int inicio = plan->inicioNivel[nivel], fin = plan->inicioNivel[nivel + 1];
+		panelesNivel(plan, nivel, &porHilo);
+		if(repartirNivel(plan, nivel)){
+			#pragma omp parallel for num_threads(fin - inicio < plan->numeroHilos ? fin - inicio : plan->numeroHilos) schedule(dynamic, 1)
+			for(p = inicio; p < fin; p++){
+				ejecutarProducto(plan, p, matrices, C, paneles + omp_get_thread_num() * porHilo, 1);
+			}
+		}
+		else{
+			for(p = inicio; p < fin; p++){
+				ejecutarProducto(plan, p, matrices, C, paneles, plan->numeroHilos);
+			}
+		}
+	}
+	return 0;
+}
+
+int multiplicarCadenaMatrices(const struct matriz * const * matrices, int numero, struct matriz * C){
+	struct planCadena * plan;
+	int * dimensiones, i, resultado;
+
+	if(numero < 1){
+		return -1;
+	}
+	dimensiones = (int *)reservar((numero + 1) * sizeof(int));
+	for(i = 0; i < numero; i++){
+		dimensiones[i] = matrices[i]->filas;
+	}
+	dimensiones[numero] = matrices[numero - 1]->columnas;
+	plan = planificarCadena(dimensiones, numero, 0);
+	free(dimensiones);
+	if(plan == NULL){
+		return -1;
+	}
+	resultado = multiplicarCadena(plan, matrices, C);
+	liberarPlanCadena(plan);
+	return resultado;
+}
+
+static size_t escribirProducto(const struct planCadena * plan, int primera, int ultima, int p, char * texto, size_t largo, size_t usado){
+	const struct productoCadena * producto;
+	int k;
+
+	if(primera == ultima){
+		return usado + snprintf(texto + (usado < largo ? usado : largo), usado < largo ? largo - usado : 0, "A%d", primera);
+	}
+	producto = &plan->productos[p];
+	k = producto->izquierdo >= 0 ? plan->productos[producto->izquierdo].ultima : producto->primera;
+	usado += snprintf(texto + (usado < largo ? usado : largo), usado < largo ? largo - usado : 0, "(");
+	usado = escribirProducto(plan, primera, k, producto->izquierdo, texto, largo, usado);
+	usado += snprintf(texto + (usado < largo ? usado : largo), usado < largo ? largo - usado : 0, " ");
+	usado = escribirProducto(plan, k + 1, ultima, producto->derecho, texto, largo, usado);
+	return usado + snprintf(texto + (usado < largo ? usado : largo), usado < largo ? largo - usado : 0, ")");
+}
+
+void escribirOrdenCadena(const struct planCadena * plan, char * texto, size_t largo){
+	if(largo == 0){
+		return;
+	}
+	texto[0] = '\0';
+	escribirProducto(plan, 0, plan->numero - 1, plan->numero - 2, texto, largo, 0);
+}
@@ -0,0 +1,82 @@
+/*
+ Cadenas de productos A0 * A1 * ... * An-1 con el orden optimo
+
+ El producto es asociativo pero el costo no: con A de 1000 x 20, B de
+ 20 x 1000 y C de 1000 x 20, (A B) C hace 2 * 10^7 + 2 * 10^7 = 4 * 10^7
+ multiplicaciones y A (B C) solo 4 * 10^5 + 4 * 10^5 = 8 * 10^5, unas 50
+ veces menos. planificarCadena busca los parentesis que
+ minimizan las operaciones con programacion dinamica (O(n^3) sobre las
+ dimensiones, sin tocar los datos) y arma el plan de ejecucion:
+
+ 	- los productos se agrupan por niveles: un producto va un nivel por
+ 	  encima del mas alto de sus dos operandos, asi los de un mismo nivel son
+ 	  independientes. Si un nivel tiene varios productos chicos (o al menos
+ 	  tantos como hilos) se reparten entre los hilos, uno por hilo; si no,
+ 	  se hacen de a uno con todos los hilos (gemm_empaquetado.h)
+ 	- los resultados intermedios y los paneles de los productos viven en un
+ 	  unico espacio de trabajo reservado al planificar (en paginas grandes si
+ 	  paginas_grandes.h lo pide, del pool de pool_memoria.h si esta activo);
+ 	  multiplicarCadena no reserva nada y el mismo plan sirve para todas
+ 	  las cadenas con esas dimensiones
+ 	- los intermedios se reusan: cada producto escribe sobre el lugar de los
+ 	  intermedios que ya se consumieron (los de sus nietos), alternando el
+ 	  resultado al principio y al final de su tramo del espacio. Una cadena
+ 	  evaluada de izquierda a derecha usa dos buffers en vez de n - 2
+
+ El plan guarda las operaciones (2 * m * n * k por producto) del orden
+ optimo y de evaluar de izquierda a derecha, ((A0 A1) A2) ..., que es lo que
+ hace multiplicar de a pares en el orden escrito.
+
+ Solo int32, como gemmMatriz: el resultado es exacto modulo 2^32 y no
+ depende del orden.
+*/
+#ifndef CADENA_MATRICES_H
+#define CADENA_MATRICES_H
+
+#include <stddef.h>
+
+#include "matriz.h"
+
+// promedio de operaciones por debajo del cual los productos de un nivel se
+// reparten entre los hilos aunque sean menos que los hilos
+#define OPERACIONES_PRODUCTO_CHICO_CADENA (1 << 25)
+
+struct productoCadena{
+	int primera; // matrices primera .. ultima de la cadena
+	int ultima;
+	int izquierdo; // producto que da el operando, o -1 si es la matriz primera
+	int derecho; // o -1 si es la matriz ultima
+	int nivel;
+	size_t desplazamiento; // del resultado en el espacio de trabajo (el ultimo va a C)
+	double operaciones;
+};
+
+struct planCadena{
+	int numero; // matrices
+	int * dimensiones; // numero + 1: la matriz i es dimensiones[i] x dimensiones[i + 1]
+	int numeroHilos;
+	struct productoCadena * productos; // numero - 1, por nivel; el ultimo da C
+	int numeroNiveles;
+	int * inicioNivel; // numeroNiveles + 1
+	double operacionesOptimas;
+	double operacionesIzquierda;
+	size_t elementosIntermedios; // con reuso
+	size_t elementosSinReuso; // un buffer por intermedio
+	size_t elementosPaneles;
+	int * espacio;
+	size_t elementosEspacio;
+	int marca; // del espacio, de pool_memoria.h
+};
+
+// NULL si hay menos de una matriz o alguna dimension no es positiva;
+// numeroHilos <= 0 usa hilosGemm()
+struct planCadena * planificarCadena(const int * dimensiones, int numero, int numeroHilos);
+void liberarPlanCadena(struct planCadena *);
+// C = A0 * ... * An-1; -1 si las formas no son las del plan (no toca C)
+int multiplicarCadena(const struct planCadena *, const struct matriz * const * matrices, struct matriz * C);
+// planificar, multiplicar y liberar
+int multiplicarCadenaMatrices(const struct matriz * const * matrices, int numero, struct matriz * C);
+// los parentesis del plan, p. ej. "((A0 A1) (A2 A3))"; recorta si no entra
+void escribirOrdenCadena(const struct planCadena *, char * texto, size_t largo);
+
+#endif
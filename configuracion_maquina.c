@@ -0,0 +1,196 @@
+// archivo de cache con la configuracion ajustada de cada maquina
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "configuracion_maquina.h"
+
+#define LARGO_LINEA 512
+#define MAX_LINEAS_CACHE 256
+
+// tamanio en KB de un nivel de cache; primero sysconf y, si no lo sabe, sysfs
+static int tamanioCache(int nombreSysconf, int indiceSysfs){
+	long bytes = sysconf(nombreSysconf);
+	char ruta[128];
+	FILE * archivo;
+	int kb = 0;
+	char unidad = 'K';
+
+	if(bytes > 0){
+		return (int)(bytes / 1024);
+	}
+	snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu0/cache/index%d/size", indiceSysfs);
+	archivo = fopen(ruta, "r");
+	if(archivo == NULL){
+		return 0;
+	}
+	if(fscanf(archivo, "%d%c", &kb, &unidad) < 1){
+		kb = 0;
+	}
+	fclose(archivo);
+	return unidad == 'M' ? kb * 1024 : kb;
+}
+
+// modelo de CPU y tamanios de cache de esta maquina
+void identificarMaquina(struct identidadMaquina * identidad){
+	FILE * archivo = fopen("/proc/cpuinfo", "r");
+	char linea[LARGO_LINEA];
+	char * valor;
+	size_t largo;
+
+	strcpy(identidad->modelo, "desconocido");
+	if(archivo != NULL){
+		while(fgets(linea, sizeof(linea), archivo) != NULL){
+			if(strncmp(linea, "model name", 10) == 0 && (valor = strchr(linea, ':')) != NULL){
+				valor++;
+				while(*valor == ' ' || *valor == '\t'){
+					valor++;
+				}
+				largo = strcspn(valor, "\n|");
+				if(largo >= LARGO_MODELO_CPU){
+					largo = LARGO_MODELO_CPU - 1;
+				}
+				memcpy(identidad->modelo, valor, largo);
+				identidad->modelo[largo] = '\0';
+				break;
+			}
+		}
+		fclose(archivo);
+	}
+	// index0 suele ser L1d, index1 L1i, index2 L2 e index3 L3
+	identidad->cacheL1d = tamanioCache(_SC_LEVEL1_DCACHE_SIZE, 0);
+	identidad->cacheL2 = tamanioCache(_SC_LEVEL2_CACHE_SIZE, 2);
+	identidad->cacheL3 = tamanioCache(_SC_LEVEL3_CACHE_SIZE, 3);
+}
+
+// NULL si la carga esta desactivada o no hay donde guardar
+const char * rutaConfiguracionMaquina(void){
+	static char ruta[1024];
+	const char * variable = getenv("MATRIZ_AUTOAJUSTE");
+
+	if(variable != NULL && variable[0] != '\0'){
+		return strcmp(variable, "no") == 0 ? NULL : variable;
+	}
+	if((variable = getenv("XDG_CACHE_HOME")) != NULL && variable[0] != '\0'){
+		snprintf(ruta, sizeof(ruta), "%s/matrices_autoajuste.txt", variable);
+		return ruta;
+	}
+	if((variable = getenv("HOME")) != NULL && variable[0] != '\0'){
+		snprintf(ruta, sizeof(ruta), "%s/.cache/matrices_autoajuste.txt", variable);
+		return ruta;
+	}
+	return NULL;
+}
+
+// clave de la maquina: todo lo que va antes de los valores ajustados
+static void claveMaquina(const struct identidadMaquina * identidad, char * clave, size_t largo){
+	snprintf(clave, largo, "%s|%d|%d|%d|", identidad->modelo, identidad->cacheL1d, identidad->cacheL2, identidad->cacheL3);
+}
+
+// 0 si el archivo tiene una linea para esta maquina, -1 si no
+int cargarConfiguracionMaquina(struct configuracionMaquina * configuracion){
+	const char * ruta = rutaConfiguracionMaquina();
+	struct identidadMaquina identidad;
+	struct configuracionMaquina leida;
+	char clave[LARGO_LINEA], linea[LARGO_LINEA];
+	size_t largoClave;
+	FILE * archivo;
+	int encontrada = -1;
+
+	if(ruta == NULL || (archivo = fopen(ruta, "r")) == NULL){
+		return -1;
+	}
+	identificarMaquina(&identidad);
+	claveMaquina(&identidad, clave, sizeof(clave));
+	largoClave = strlen(clave);
+
+	while(fgets(linea, sizeof(linea), archivo) != NULL){
+		if(strncmp(linea, clave, largoClave) == 0
+				&& sscanf(linea + largoClave, "%d|%d|%d|%d", &leida.mc, &leida.kc, &leida.nc, &leida.numeroHilos) == 4){
+			*configuracion = leida;
+			encontrada = 0;
+		}
+	}
+	fclose(archivo);
+	return encontrada;
+}
+
+// crear el directorio que contiene ruta (p. ej. ~/.cache) si no existe
+static void crearDirectorioPadre(const char * ruta){
+	char directorio[1024];
+	char * barra;
+
+	snprintf(directorio, sizeof(directorio), "%s", ruta);
+	barra = strrchr(directorio, '/');
+	if(barra != NULL && barra != directorio){
+		*barra = '\0';
+		mkdir(directorio, 0755);
+	}
+}
+
+// reemplazar (o agregar) la linea de esta maquina y dejar las de las demas.
+// Se escribe un temporal al lado (ruta.tmpXXXXXX) y se renombra encima: otro
+// proceso que lea el archivo, o un corte a mitad de la escritura, ve el
+// archivo viejo o el nuevo, nunca uno a medias
+int guardarConfiguracionMaquina(const struct configuracionMaquina * configuracion){
+	const char * ruta = rutaConfiguracionMaquina();
+	struct identidadMaquina identidad;
+	char clave[LARGO_LINEA], linea[LARGO_LINEA], temporal[1024];
+	char * lineas[MAX_LINEAS_CACHE];
+	int numeroLineas = 0, i, descriptor, error;
+	size_t largoClave;
+	FILE * archivo;
+
+	if(ruta == NULL){
+		fprintf(stderr, "no hay ruta para el archivo de autoajuste (definir MATRIZ_AUTOAJUSTE)\n");
+		return -1;
+	}
+	identificarMaquina(&identidad);
+	claveMaquina(&identidad, clave, sizeof(clave));
+	largoClave = strlen(clave);
+
+	archivo = fopen(ruta, "r");
+	if(archivo != NULL){
+		while(fgets(linea, sizeof(linea), archivo) != NULL && numeroLineas < MAX_LINEAS_CACHE){
+			if(strncmp(linea, clave, largoClave) != 0){
+				lineas[numeroLineas++] = strdup(linea);
+			}
+		}
+		fclose(archivo);
+	}
+
+	crearDirectorioPadre(ruta);
+	snprintf(temporal, sizeof(temporal), "%s.tmpXXXXXX", ruta);
+	descriptor = mkstemp(temporal);
+	archivo = descriptor == -1 ? NULL : fdopen(descriptor, "w");
+	if(archivo == NULL){
+		perror(temporal);
+		if(descriptor != -1){
+			close(descriptor);
+			unlink(temporal);
+		}
+		for(i = 0; i < numeroLineas; i++){
+			free(lineas[i]);
+		}
+		return -1;
+	}
+	// mkstemp lo crea con 0600; el cache se comparte como cualquier archivo
+	fchmod(descriptor, 0644);
+	for(i = 0; i < numeroLineas; i++){
+		fputs(lineas[i], archivo);
+		free(lineas[i]);
+	}
+	fprintf(archivo, "%s%d|%d|%d|%d\n", clave, configuracion->mc, configuracion->kc, configuracion->nc, configuracion->numeroHilos);
+
+	// a disco antes del rename, si no un corte puede dejar el nombre nuevo vacio
+	error = fflush(archivo) != 0 || fsync(descriptor) != 0;
+	error = fclose(archivo) != 0 || error;
+	if(error || rename(temporal, ruta) != 0){
+		perror(temporal);
+		unlink(temporal);
+		return -1;
+	}
+	return 0;
+}
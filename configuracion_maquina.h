@@ -0,0 +1,44 @@
+/*
+ Configuracion ajustada por maquina
+
+ El programa autoajuste busca en el equipo actual los tamanios de bloque del
+ motor empaquetado (mc, kc, nc: bloques de i, k y j) y el numero de hilos de
+ las variantes paralelas, y guarda el resultado en un archivo de cache de
+ texto con una linea por maquina:
+
+ 	modelo de CPU|L1d|L2|L3|mc|kc|nc|hilos
+
+ La clave es el modelo (model name de /proc/cpuinfo) junto con los tamanios
+ de cache en KB, asi el mismo archivo puede compartirse entre equipos de
+ distintas generaciones. Al arrancar, gemm_empaquetado.c carga la linea de
+ esta maquina (si existe) en lugar de los valores fijos.
+
+ Ruta del archivo: MATRIZ_AUTOAJUSTE si esta definida, si no
+ $XDG_CACHE_HOME/matrices_autoajuste.txt o ~/.cache/matrices_autoajuste.txt.
+ MATRIZ_AUTOAJUSTE=no desactiva la carga.
+*/
+#ifndef CONFIGURACION_MAQUINA_H
+#define CONFIGURACION_MAQUINA_H
+
+#define LARGO_MODELO_CPU 128
+
+struct identidadMaquina{
+	char modelo[LARGO_MODELO_CPU];
+	int cacheL1d; // KB
+	int cacheL2;
+	int cacheL3;
+};
+
+struct configuracionMaquina{
+	int mc;
+	int kc;
+	int nc;
+	int numeroHilos; // 0 si no se ajusto
+};
+
+void identificarMaquina(struct identidadMaquina *);
+const char * rutaConfiguracionMaquina(void);
+int cargarConfiguracionMaquina(struct configuracionMaquina *);
+int guardarConfiguracionMaquina(const struct configuracionMaquina *);
+
+#endif
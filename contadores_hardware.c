@@ -0,0 +1,264 @@
+// contadores de hardware por hilo o proceso con perf_event_open
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "contadores_hardware.h"
+
+const char * nombresContadores[NUMERO_CONTADORES] = {
+	"ciclos", "instrucciones", "fallos_l1d", "fallos_llc", "fallos_dtlb"
+};
+
+// 0 sin probar, 1 disponibles, -1 bloqueados (ya se aviso); acceso atomico
+// porque lo consultan todos los trabajadores
+static int estadoContadores = 0;
+
+static long perfEventOpen(struct perf_event_attr * atributos, pid_t pid, int cpu, int grupo, unsigned long banderas){
+	return syscall(SYS_perf_event_open, atributos, pid, cpu, grupo, banderas);
+}
+
+static unsigned long long configuracionCache(int cache, int operacion, int resultado){
+	return (unsigned long long)cache | ((unsigned long long)operacion << 8) | ((unsigned long long)resultado << 16);
+}
+
+static void describirEvento(enum contador contador, struct perf_event_attr * atributos){
+	memset(atributos, 0, sizeof(struct perf_event_attr));
+	atributos->size = sizeof(struct perf_event_attr);
+	atributos->exclude_kernel = 1;
+	atributos->exclude_hv = 1;
+	atributos->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	switch(contador){
+		case CONTADOR_CICLOS:
+			atributos->type = PERF_TYPE_HARDWARE;
+			atributos->config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case CONTADOR_INSTRUCCIONES:
+			atributos->type = PERF_TYPE_HARDWARE;
+			atributos->config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case CONTADOR_FALLOS_L1D:
+			atributos->type = PERF_TYPE_HW_CACHE;
+			atributos->config = configuracionCache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+			break;
+		case CONTADOR_FALLOS_LLC:
+			atributos->type = PERF_TYPE_HW_CACHE;
+			atributos->config = configuracionCache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+			break;
+		case CONTADOR_FALLOS_DTLB:
+			atributos->type = PERF_TYPE_HW_CACHE;
+			atributos->config = configuracionCache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+			break;
+		default:
+			break;
+	}
+}
+
+// explicar una sola vez por que no hay contadores
+static void avisarSinContadores(int error){
+	FILE * archivo;
+	int paranoid = -100;
+
+	if(__atomic_exchange_n(&estadoContadores, -1, __ATOMIC_ACQ_REL) == -1){
+		return;
+	}
+	archivo = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+	if(archivo != NULL){
+		if(fscanf(archivo, "%d", &paranoid) != 1){
+			paranoid = -100;
+		}
+		fclose(archivo);
+	}
+	if(paranoid != -100){
+		fprintf(stderr, "contadores de hardware no disponibles (%s, perf_event_paranoid = %d); se continua sin contadores\n", strerror(error), paranoid);
+	}
+	else{
+		fprintf(stderr, "contadores de hardware no disponibles (%s); se continua sin contadores\n", strerror(error));
+	}
+}
+
+// abrir el grupo para el hilo que llama (pid 0) o para otro proceso/hilo;
+// 0 si al menos el lider (ciclos) se pudo abrir, -1 si no hay contadores
+int abrirContadores(struct grupoContadores * grupo, pid_t pid){
+	struct perf_event_attr atributos;
+	int c, lider;
+
+	grupo->abiertos = 0;
+	for(c = 0; c < NUMERO_CONTADORES; c++){
+		grupo->descriptores[c] = -1;
+		grupo->posiciones[c] = -1;
+	}
+	if(__atomic_load_n(&estadoContadores, __ATOMIC_ACQUIRE) == -1){
+		return -1;
+	}
+
+	describirEvento(CONTADOR_CICLOS, &atributos);
+	atributos.disabled = 1;
+	lider = (int)perfEventOpen(&atributos, pid, -1, -1, 0);
+	if(lider == -1){
+		avisarSinContadores(errno);
+		return -1;
+	}
+	__atomic_store_n(&estadoContadores, 1, __ATOMIC_RELEASE);
+	grupo->descriptores[CONTADOR_CICLOS] = lider;
+	grupo->posiciones[CONTADOR_CICLOS] = grupo->abiertos++;
+
+	// los demas siguen al lider: se habilitan y deshabilitan con el
+	for(c = CONTADOR_CICLOS + 1; c < NUMERO_CONTADORES; c++){
+		describirEvento((enum contador)c, &atributos);
+		grupo->descriptores[c] = (int)perfEventOpen(&atributos, pid, -1, lider, 0);
+		if(grupo->descriptores[c] != -1){
+			grupo->posiciones[c] = grupo->abiertos++;
+		}
+	}
+	return 0;
+}
+
+void iniciarContadores(struct grupoContadores * grupo){
+	int lider = grupo->descriptores[CONTADOR_CICLOS];
+	if(lider == -1){
+		return;
+	}
+	ioctl(lider, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(lider, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+// detener el grupo y sumar lo medido (escalado si hubo multiplexado) en acumulado
+void detenerContadores(struct grupoContadores * grupo, struct lecturaContadores * acumulado){
+	int lider = grupo->descriptores[CONTADOR_CICLOS];
+	// nr, time_enabled, time_running, valores
+	unsigned long long buffer[3 + NUMERO_CONTADORES];
+	double escala;
+	int c;
+
+	if(lider == -1){
+		return;
+	}
+	ioctl(lider, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	if(read(lider, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(unsigned long long))){
+		return;
+	}
+	// time_running = 0: el grupo nunca entro en la PMU
+	if(buffer[2] == 0){
+		return;
+	}
+	escala = (double)buffer[1] / buffer[2];
+	for(c = 0; c < NUMERO_CONTADORES; c++){
+		if(grupo->posiciones[c] >= 0 && (unsigned long long)grupo->posiciones[c] < buffer[0]){
+			acumulado->valores[c] += (unsigned long long)(buffer[3 + grupo->posiciones[c]] * escala);
+			acumulado->disponibles[c] = 1;
+		}
+	}
+	acumulado->mediciones++;
+}
+
+void cerrarContadores(struct grupoContadores * grupo){
+	int c;
+	// primero los seguidores, al final el lider
+	for(c = NUMERO_CONTADORES - 1; c >= 0; c--){
+		if(grupo->descriptores[c] != -1){
+			close(grupo->descriptores[c]);
+			grupo->descriptores[c] = -1;
+		}
+	}
+	grupo->abiertos = 0;
+}
+
+// probar una vez si se pueden abrir contadores en este sistema
+int contadoresDisponibles(void){
+	struct grupoContadores grupo;
+	if(__atomic_load_n(&estadoContadores, __ATOMIC_ACQUIRE) == 0 && abrirContadores(&grupo, 0) == 0){
+		cerrarContadores(&grupo);
+	}
+	return __atomic_load_n(&estadoContadores, __ATOMIC_ACQUIRE) == 1;
+}
+
+void reiniciarLecturaContadores(struct lecturaContadores * lectura){
+	memset(lectura, 0, sizeof(struct lecturaContadores));
+}
+
+void sumarLecturaContadores(struct lecturaContadores * destino, const struct lecturaContadores * origen){
+	int c;
+	for(c = 0; c < NUMERO_CONTADORES; c++){
+		destino->valores[c] += origen->valores[c];
+		destino->disponibles[c] |= origen->disponibles[c];
+	}
+	destino->mediciones += origen->mediciones;
+}
+
+// -1 si falta alguno de los dos contadores
+double ipcContadores(const struct lecturaContadores * lectura){
+	if(!lectura->disponibles[CONTADOR_CICLOS] || !lectura->disponibles[CONTADOR_INSTRUCCIONES] || lectura->valores[CONTADOR_CICLOS] == 0){
+		return -1.0;
+	}
+	return (double)lectura->valores[CONTADOR_INSTRUCCIONES] / lectura->valores[CONTADOR_CICLOS];
+}
+
+// fallos por cada 1000 instrucciones (MPKI); -1 si no hay datos
+double fallosPorMilInstrucciones(const struct lecturaContadores * lectura, enum contador contador){
+	if(!lectura->disponibles[contador] || !lectura->disponibles[CONTADOR_INSTRUCCIONES] || lectura->valores[CONTADOR_INSTRUCCIONES] == 0){
+		return -1.0;
+	}
+	return 1000.0 * lectura->valores[contador] / lectura->valores[CONTADOR_INSTRUCCIONES];
+}
+
+static void mostrarValor(const char * nombre, double valor){
+	if(valor < 0){
+		printf(" %s n/d", nombre);
+	}
+	else{
+		printf(" %s %.3f", nombre, valor);
+	}
+}
+
+void mostrarLecturaContadores(const char * etiqueta, const struct lecturaContadores * lectura){
+	printf("%s:", etiqueta);
+	if(lectura->mediciones == 0){
+		printf(" sin contadores\n");
+		return;
+	}
+	printf(" ciclos %llu instrucciones %llu", lectura->valores[CONTADOR_CICLOS], lectura->valores[CONTADOR_INSTRUCCIONES]);
+	mostrarValor("IPC", ipcContadores(lectura));
+	mostrarValor("L1D MPKI", fallosPorMilInstrucciones(lectura, CONTADOR_FALLOS_L1D));
+	mostrarValor("LLC MPKI", fallosPorMilInstrucciones(lectura, CONTADOR_FALLOS_LLC));
+	mostrarValor("dTLB MPKI", fallosPorMilInstrucciones(lectura, CONTADOR_FALLOS_DTLB));
+	printf("\n");
+}
+
+void reiniciarRegistroContadores(struct registroContadores * registro, int numeroTrabajadores){
+	int t;
+	registro->numeroTrabajadores = numeroTrabajadores > MAX_TRABAJADORES_CONTADORES ? MAX_TRABAJADORES_CONTADORES : numeroTrabajadores;
+	for(t = 0; t < MAX_TRABAJADORES_CONTADORES; t++){
+		reiniciarLecturaContadores(&registro->trabajadores[t]);
+	}
+}
+
+struct lecturaContadores totalRegistroContadores(const struct registroContadores * registro){
+	struct lecturaContadores total;
+	int t;
+	reiniciarLecturaContadores(&total);
+	for(t = 0; t < registro->numeroTrabajadores; t++){
+		sumarLecturaContadores(&total, &registro->trabajadores[t]);
+	}
+	return total;
+}
+
+// una linea por trabajador y el total
+void mostrarRegistroContadores(const struct registroContadores * registro){
+	struct lecturaContadores total = totalRegistroContadores(registro);
+	char etiqueta[64];
+	int t;
+
+	if(registro->numeroTrabajadores > 1){
+		for(t = 0; t < registro->numeroTrabajadores; t++){
+			snprintf(etiqueta, sizeof(etiqueta), "\ttrabajador %d", t);
+			mostrarLecturaContadores(etiqueta, &registro->trabajadores[t]);
+		}
+	}
+	mostrarLecturaContadores("\ttotal", &total);
+}
@@ -0,0 +1,73 @@
+/*
+ Contadores de hardware con perf_event_open
+
+ Cada grupo mide, para un hilo o un proceso, ciclos, instrucciones, fallos de
+ L1D, fallos de LLC y fallos de dTLB. Los cinco eventos se abren como un grupo
+ (el lider es el de ciclos) para que se programen juntos y las proporciones
+ entre ellos tengan sentido; si el kernel multiplexa, los valores se escalan
+ con time_enabled / time_running.
+
+ Solo se mide espacio de usuario (exclude_kernel), que es lo que permite
+ perf_event_paranoid = 2. Si el kernel no deja abrir los contadores (paranoid
+ mas alto, contenedor sin PMU, etc.) abrirContadores devuelve -1, se avisa una
+ sola vez con el motivo y los programas siguen sin contadores. Un evento
+ suelto que no exista en la CPU se marca como no disponible y el resto del
+ grupo se sigue usando.
+
+ Para medir hilos de un pool, cada trabajador abre su grupo (pid 0) y acumula
+ en su propia casilla de un registroContadores; para procesos hijos se puede
+ abrir el grupo desde el padre con el pid del hijo.
+*/
+#ifndef CONTADORES_HARDWARE_H
+#define CONTADORES_HARDWARE_H
+
+#include <sys/types.h>
+
+enum contador{
+	CONTADOR_CICLOS,
+	CONTADOR_INSTRUCCIONES,
+	CONTADOR_FALLOS_L1D,
+	CONTADOR_FALLOS_LLC,
+	CONTADOR_FALLOS_DTLB,
+	NUMERO_CONTADORES
+};
+
+#define MAX_TRABAJADORES_CONTADORES 256
+
+struct grupoContadores{
+	int descriptores[NUMERO_CONTADORES]; // -1 si el evento no se pudo abrir
+	int posiciones[NUMERO_CONTADORES]; // posicion del evento en la lectura del grupo
+	int abiertos;
+};
+
+struct lecturaContadores{
+	unsigned long long valores[NUMERO_CONTADORES];
+	int disponibles[NUMERO_CONTADORES];
+	int mediciones; // cuantas veces se acumulo en esta lectura
+};
+
+// una lectura por trabajador; cada trabajador solo escribe en la suya
+struct registroContadores{
+	int numeroTrabajadores;
+	struct lecturaContadores trabajadores[MAX_TRABAJADORES_CONTADORES];
+};
+
+extern const char * nombresContadores[NUMERO_CONTADORES];
+
+int contadoresDisponibles(void);
+int abrirContadores(struct grupoContadores *, pid_t pid);
+void iniciarContadores(struct grupoContadores *);
+void detenerContadores(struct grupoContadores *, struct lecturaContadores * acumulado);
+void cerrarContadores(struct grupoContadores *);
+
+void reiniciarLecturaContadores(struct lecturaContadores *);
+void sumarLecturaContadores(struct lecturaContadores * destino, const struct lecturaContadores * origen);
+double ipcContadores(const struct lecturaContadores *);
+double fallosPorMilInstrucciones(const struct lecturaContadores *, enum contador);
+void mostrarLecturaContadores(const char * etiqueta, const struct lecturaContadores *);
+
+void reiniciarRegistroContadores(struct registroContadores *, int numeroTrabajadores);
+struct lecturaContadores totalRegistroContadores(const struct registroContadores *);
+void mostrarRegistroContadores(const struct registroContadores *);
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ Ganchos por hilo para los motores con regiones paralelas propias
+
+ Los motores que abren sus propias regiones de OpenMP (openmp_azulejos.h,
+ strassen.h) llaman, en cada hilo de cada region, a entrar al empezar y a
+ salir cuando ese hilo termino su parte, con el numero de hilo de OpenMP.
+ Asi quien llama puede medir a cada trabajador (contadores_hardware.h) sin
+ que el motor sepa de contadores. Con NULL no se llama a nada.
+*/
+#ifndef GANCHOS_HILOS_H
+#define GANCHOS_HILOS_H
+
+#include <omp.h>
+
+struct ganchosHilos{
+	void (*entrar)(int hilo, void * contexto);
+	void (*salir)(int hilo, void * contexto);
+	void * contexto;
+};
+
+static inline void entrarGanchoHilo(const struct ganchosHilos * ganchos){
+	if(ganchos != NULL){
+		ganchos->entrar(omp_get_thread_num(), ganchos->contexto);
+	}
+}
+
+static inline void salirGanchoHilo(const struct ganchosHilos * ganchos){
+	if(ganchos != NULL){
+		ganchos->salir(omp_get_thread_num(), ganchos->contexto);
+	}
+}
+
+#endif
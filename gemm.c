@@ -0,0 +1,79 @@
+// API de libmatrices sobre los motores empaquetados
+#include <stdlib.h>
+#include <omp.h>
+
+#include "gemm.h"
+#include "gemm_empaquetado.h"
+#include "gemm_tipos.h"
+
+// 0 = usar omp_get_max_threads() en cada llamada
+static int hilosFijados = 0;
+
+void fijarHilosGemm(int numeroHilos){
+	hilosFijados = numeroHilos > 0 ? numeroHilos : 0;
+}
+
+int hilosGemm(void){
+	return hilosFijados > 0 ? hilosFijados : omp_get_max_threads();
+}
+
+// formas no negativas y cada ld alcanza para sus columnas
+static int dimensionesValidas(int m, int n, int k, int lda, int ldb, int ldc){
+	if(m < 0 || n < 0 || k < 0){
+		return 0;
+	}
+	return lda >= k && ldb >= n && ldc >= n;
+}
+
+// A, B y C como matrices tipadas sin copiar y despacho al motor del tipo
+static int gemmTipada(const char * tipo, int m, int n, int k, const void * alfa, const void * A, int lda,
+		const void * B, int ldb, const void * beta, void * C, int ldc){
+	const struct motorTipo * motor = buscarMotorTipo(tipo);
+	struct matrizTipada vistaA, vistaB, vistaC;
+
+	if(motor == NULL || !dimensionesValidas(m, n, k, lda, ldb, ldc)){
+		return -1;
+	}
+	vistaA = envolverMatrizTipada((void *)A, m, k, lda, motor->tamanioEntrada);
+	vistaB = envolverMatrizTipada((void *)B, k, n, ldb, motor->tamanioEntrada);
+	vistaC = envolverMatrizTipada(C, m, n, ldc, motor->tamanioResultado);
+	motor->gemm(alfa, &vistaA, &vistaB, beta, &vistaC, hilosGemm());
+	return 0;
+}
+
+int gemmEntero32(int m, int n, int k, int alfa, const int * A, int lda, const int * B, int ldb, int beta, int * C, int ldc){
+	struct matriz vistaA, vistaB, vistaC;
+
+	if(!dimensionesValidas(m, n, k, lda, ldb, ldc)){
+		return -1;
+	}
+	vistaA = envolverMatriz((int *)A, m, k, lda);
+	vistaB = envolverMatriz((int *)B, k, n, ldb);
+	vistaC = envolverMatriz(C, m, n, ldc);
+	gemmEmpaquetada(alfa, &vistaA, &vistaB, beta, &vistaC, hilosGemm());
+	return 0;
+}
+
+int gemmEntero32Acumulado64(int m, int n, int k, int64_t alfa, const int32_t * A, int lda, const int32_t * B, int ldb,
+		int64_t beta, int64_t * C, int ldc){
+	return gemmTipada("int32_acc64", m, n, k, &alfa, A, lda, B, ldb, &beta, C, ldc);
+}
+
+int gemmEntero64(int m, int n, int k, int64_t alfa, const int64_t * A, int lda, const int64_t * B, int ldb, int64_t beta, int64_t * C, int ldc){
+	return gemmTipada("int64", m, n, k, &alfa, A, lda, B, ldb, &beta, C, ldc);
+}
+
+int gemmFlotante(int m, int n, int k, float alfa, const float * A, int lda, const float * B, int ldb, float beta, float * C, int ldc){
+	return gemmTipada("float", m, n, k, &alfa, A, lda, B, ldb, &beta, C, ldc);
+}
+
+int gemmDoble(int m, int n, int k, double alfa, const double * A, int lda, const double * B, int ldb, double beta, double * C, int ldc){
+	return gemmTipada("double", m, n, k, &alfa, A, lda, B, ldb, &beta, C, ldc);
+}
+
+int gemmMatriz(int alfa, const struct matriz * A, const struct matriz * B, int beta, struct matriz * C){
+	if(A->columnas != B->filas || C->filas != A->filas || C->columnas != B->columnas){
+		return -1;
+	}
+	return gemmEntero32(A->filas, B->columnas, A->columnas, alfa, A->datos, A->ld, B->datos, B->ld, beta, C->datos, C->ld);
+}
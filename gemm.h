@@ -0,0 +1,73 @@
+/*
+ libmatrices: API de multiplicacion de matrices para usar desde otros programas
+
+ 	C = alfa * A * B + beta * C
+
+ con A de M x K, B de K x N y C de M x N, todas por filas. Como en BLAS, cada
+ matriz se pasa como puntero a su primer elemento mas su dimension principal
+ (ld: distancia en elementos entre el inicio de dos filas, ld >= columnas).
+ Para multiplicar bloques de un buffer mas grande sin copiar basta apuntar al
+ primer elemento del bloque y pasar el ld del buffer; gemmMatriz hace lo mismo
+ con las vistas de matriz.h (vistaMatriz, envolverMatriz).
+
+ 	- beta = 0: C no se lee, puede tener basura o NaN
+ 	- beta = 1 y alfa = 1: C += A * B
+ 	- K = 0 o alfa = 0: solo C = beta * C
+
+ Los enteros de 32 bits se desbordan modulo 2^32 como el producto clasico;
+ gemmEntero32Acumulado64 recibe A y B int32 y acumula y guarda C en int64.
+ Los productos usan los motores empaquetados de gemm_empaquetado.c (int) y
+ gemm_tipos.c (los demas tipos) con los kernels SIMD de la CPU.
+
+ Todas devuelven 0, o -1 si las dimensiones no son validas (negativas, ld
+ menor que las columnas o formas que no encajan); en ese caso no tocan C.
+
+ Hilos: por defecto omp_get_max_threads() (OMP_NUM_THREADS); fijarHilosGemm
+ lo cambia para las llamadas siguientes de todo el proceso.
+
+ para compilar la biblioteca (libmatrices.a y libmatrices.so): make
+ para usarla: gcc programa.c -I. -L. -lmatrices -fopenmp -lm
+*/
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stdint.h>
+
+#include "matriz.h"
+
+int gemmEntero32(int m, int n, int k, int alfa, const int * A, int lda, const int * B, int ldb, int beta, int * C, int ldc);
+int gemmEntero32Acumulado64(int m, int n, int k, int64_t alfa, const int32_t * A, int lda, const int32_t * B, int ldb,
+	int64_t beta, int64_t * C, int ldc);
+int gemmEntero64(int m, int n, int k, int64_t alfa, const int64_t * A, int lda, const int64_t * B, int ldb, int64_t beta, int64_t * C, int ldc);
+int gemmFlotante(int m, int n, int k, float alfa, const float * A, int lda, const float * B, int ldb, float beta, float * C, int ldc);
+int gemmDoble(int m, int n, int k, double alfa, const double * A, int lda, const double * B, int ldb, double beta, double * C, int ldc);
+
+/*
+ Lotes de matrices pequenias (pensado para 4 x 4 a 64 x 64): numero productos
+ independientes con la misma forma, m, n, k, alfa y beta. Las matrices se dan
+ con un paso fijo (la matriz b de A empieza en A + b * pasoA, en elementos;
+ paso 0 repite la misma matriz) o con arreglos de punteros. El lote se
+ reparte entre los hilos en una sola region paralela y cada hilo recorre su
+ tramo con un kernel especializado para m = n = k = 4, 8, 16, 32 o 64 (el
+ resto usa uno generico).
+*/
+int gemmLoteFlotante(int m, int n, int k, float alfa, const float * A, int lda, long pasoA, const float * B, int ldb, long pasoB,
+	float beta, float * C, int ldc, long pasoC, int numero);
+int gemmLoteDoble(int m, int n, int k, double alfa, const double * A, int lda, long pasoA, const double * B, int ldb, long pasoB,
+	double beta, double * C, int ldc, long pasoC, int numero);
+int gemmLoteEntero32(int m, int n, int k, int alfa, const int * A, int lda, long pasoA, const int * B, int ldb, long pasoB,
+	int beta, int * C, int ldc, long pasoC, int numero);
+int gemmLotePunterosFlotante(int m, int n, int k, float alfa, const float * const * A, int lda, const float * const * B, int ldb,
+	float beta, float * const * C, int ldc, int numero);
+int gemmLotePunterosDoble(int m, int n, int k, double alfa, const double * const * A, int lda, const double * const * B, int ldb,
+	double beta, double * const * C, int ldc, int numero);
+int gemmLotePunterosEntero32(int m, int n, int k, int alfa, const int * const * A, int lda, const int * const * B, int ldb,
+	int beta, int * const * C, int ldc, int numero);
+
+// igual que gemmEntero32 con matrices o vistas de matriz.h
+int gemmMatriz(int alfa, const struct matriz * A, const struct matriz * B, int beta, struct matriz * C);
+
+void fijarHilosGemm(int numeroHilos);
+int hilosGemm(void);
+
+#endif
@@ -0,0 +1,240 @@
+// motor de multiplicacion con paneles empaquetados y micro-kernel en registros
+#include <stdlib.h>
+#include <stdio.h>
+#include <omp.h>
+
+#include "gemm_empaquetado.h"
+#include "configuracion_maquina.h"
+#include "pool_memoria.h"
+
+// valores por defecto: el bloque de A (MC x KC) cabe en L2 y el
+// micro-panel de B (KC x NR) en L1
+struct configuracionGemm configuracionGemmActual = {96, 256, 4096};
+
+// si el programa autoajuste ya midio esta maquina, usar sus bloques
+__attribute__((constructor))
+static void cargarConfiguracionGemm(void){
+	struct configuracionMaquina configuracion;
+
+	if(cargarConfiguracionMaquina(&configuracion) != 0){
+		return;
+	}
+	if(configuracion.mc > 0 && configuracion.mc % MR == 0 && configuracion.kc > 0
+			&& configuracion.nc > 0 && configuracion.nc % NR == 0){
+		configuracionGemmActual.mc = configuracion.mc;
+		configuracionGemmActual.kc = configuracion.kc;
+		configuracionGemmActual.nc = configuracion.nc;
+	}
+}
+
+static int minimo(int a, int b){
+	return a < b ? a : b;
+}
+
+// copiar el bloque mc x kc de A que empieza en (fila, columna) en micro-paneles
+// de MR filas: para cada k se guardan los MR elementos de la columna seguidos.
+// alfa multiplica a cada elemento al copiarlo (en unsigned: modulo 2^32 da lo
+// mismo que multiplicar el producto)
+static void empaquetarAEscalado(const struct matriz * p_matrizA, int fila, int columna, int mc, int kc, int alfa, int * panelA){
+	int i, k, ir, mr;
+	const int * filaA;
+
+	for(ir = 0; ir < mc; ir += MR){
+		mr = minimo(MR, mc - ir);
+		for(i = 0; i < mr; i++){
+			filaA = FILA(p_matrizA, fila + ir + i) + columna;
+			if(alfa == 1){
+				for(k = 0; k < kc; k++){
+					panelA[k * MR + i] = filaA[k];
+				}
+			}
+			else{
+				for(k = 0; k < kc; k++){
+					panelA[k * MR + i] = (int)((unsigned int)alfa * (unsigned int)filaA[k]);
+				}
+			}
+		}
+		// relleno de ceros para el ultimo micro-panel incompleto
+		for(i = mr; i < MR; i++){
+			for(k = 0; k < kc; k++){
+				panelA[k * MR + i] = 0;
+			}
+		}
+		panelA += MR * kc;
+	}
+}
+
+void empaquetarA(const struct matriz * p_matrizA, int fila, int columna, int mc, int kc, int * panelA){
+	empaquetarAEscalado(p_matrizA, fila, columna, mc, kc, 1, panelA);
+}
+
+// copiar el bloque kc x nc de B que empieza en (fila, columna) en micro-paneles
+// de NR columnas: para cada k se guardan los NR elementos de la fila seguidos
+void empaquetarB(const struct matriz * p_matrizB, int fila, int columna, int kc, int nc, int * panelB){
+	int j, k, jr, nr;
+	const int * filaB;
+
+	for(jr = 0; jr < nc; jr += NR){
+		nr = minimo(NR, nc - jr);
+		for(k = 0; k < kc; k++){
+			filaB = FILA(p_matrizB, fila + k) + columna + jr;
+			for(j = 0; j < nr; j++){
+				panelB[k * NR + j] = filaB[j];
+			}
+			for(j = nr; j < NR; j++){
+				panelB[k * NR + j] = 0;
+			}
+		}
+		panelB += NR * kc;
+	}
+}
+
+// recorrer un bloque empaquetado de A contra un panel empaquetado de B
+static void macroKernel(int mc, int nc, int kc, const int * panelA, const int * panelB, int * c, int ldc, int acumular){
+	int ir, jr;
+	funcionMicroKernel microKernel = nucleosActuales->microKernel;
+
+	for(jr = 0; jr < nc; jr += NR){
+		for(ir = 0; ir < mc; ir += MR){
+			microKernel(kc, panelA + (size_t)ir * kc, panelB + (size_t)jr * kc,
+				c + (size_t)ir * ldc + jr, ldc, minimo(MR, mc - ir), minimo(NR, nc - jr), acumular);
+		}
+	}
+}
+
+// enteros que ocupan los paneles de A y B para un producto de M x K por K x N;
+// cada panel se redondea a MR/NR completos por el relleno de ceros y el de A
+// a multiplo de 16 enteros para que el de B quede alineado
+static size_t elementosPanelA(int m, int k){
+	size_t elementos = (size_t)(minimo(configuracionGemmActual.mc, m) + MR) * minimo(configuracionGemmActual.kc, k);
+	return (elementos + 15) / 16 * 16;
+}
+
+size_t elementosPanelesEmpaquetada(int m, int k, int n){
+	return elementosPanelA(m, k) + (size_t)(minimo(configuracionGemmActual.nc, n) + NR) * minimo(configuracionGemmActual.kc, k);
+}
+
+// filas [inicio, fin) que calcula el hilo de numeroHilos: los bloques de mc
+// filas se reparten en tramos contiguos, uno por hilo
+void tramoFilasEmpaquetada(int m, int numeroHilos, int hilo, int * inicio, int * fin){
+	int mc = configuracionGemmActual.mc;
+	long bloques = (m + mc - 1) / mc;
+
+	*inicio = (int)(bloques * hilo / numeroHilos) * mc;
+	*fin = minimo((int)(bloques * (hilo + 1) / numeroHilos) * mc, m);
+	if(*inicio > m){
+		*inicio = m;
+	}
+}
+
+// C = beta * C fila por fila; con beta = 0 no se lee C (puede tener basura)
+static void escalarMatriz(struct matriz * C, int beta){
+	int i, j;
+	int * fila;
+
+	if(beta == 0){
+		ponerCerosMatriz(C);
+		return;
+	}
+	for(i = 0; i < C->filas; i++){
+		fila = FILA(C, i);
+		for(j = 0; j < C->columnas; j++){
+			fila[j] = (int)((unsigned int)beta * (unsigned int)fila[j]);
+		}
+	}
+}
+
+// C = alfa * A * B + beta * C con los tres niveles de bloques; A es M x K y B
+// es K x N. Los bloques de A de cada panel de B se reparten entre numeroHilos
+// hilos de OpenMP; paneles tiene numeroHilos paneles de A seguidos del de B
+static void gemmEmpaquetadaConPaneles(int alfa, const struct matriz * p_matrizA, const struct matriz * p_matrizB, int beta,
+		struct matriz * p_matrizResultado, int * paneles, int numeroHilos){
+	int m = p_matrizA->filas;
+	int k = p_matrizA->columnas;
+	int n = p_matrizB->columnas;
+	int mcMax = configuracionGemmActual.mc;
+	int kcMax = configuracionGemmActual.kc;
+	int ncMax = configuracionGemmActual.nc;
+	size_t elementosA = elementosPanelA(m, k);
+	int * panelB = paneles + numeroHilos * elementosA;
+	int jc, pc, ic, kc, nc;
+	// con beta = 1 el primer panel de k ya suma sobre C; si no, C se escala antes
+	int sumarSobreC = beta != 0;
+
+	if(k == 0 || alfa == 0){
+		if(beta != 1){
+			escalarMatriz(p_matrizResultado, beta);
+		}
+		return;
+	}
+	if(beta != 0 && beta != 1){
+		escalarMatriz(p_matrizResultado, beta);
+	}
+
+	for(jc = 0; jc < n; jc += ncMax){
+		nc = minimo(ncMax, n - jc);
+		for(pc = 0; pc < k; pc += kcMax){
+			kc = minimo(kcMax, k - pc);
+			empaquetarB(p_matrizB, pc, jc, kc, nc, panelB);
+
+			// cada hilo siempre recibe el mismo tramo de filas (tramoFilasEmpaquetada),
+			// asi sus filas de A y C quedan en su cache y, con primer toque, en su nodo
+			#pragma omp parallel num_threads(numeroHilos) private(ic) if(numeroHilos > 1)
+			{
+				int * panelA = paneles + omp_get_thread_num() * elementosA;
+				int inicio, fin, mc;
+
+				tramoFilasEmpaquetada(m, omp_get_num_threads(), omp_get_thread_num(), &inicio, &fin);
+				for(ic = inicio; ic < fin; ic += mcMax){
+					mc = minimo(mcMax, fin - ic);
+					empaquetarAEscalado(p_matrizA, ic, pc, mc, kc, alfa, panelA);
+					macroKernel(mc, nc, kc, panelA, panelB, &ELEMENTO(p_matrizResultado, ic, jc),
+						p_matrizResultado->ld, pc > 0 || sumarSobreC);
+				}
+			}
+		}
+	}
+}
+
+// C = A * B en secuencial; paneles debe tener elementosPanelesEmpaquetada(M, K, N)
+// enteros alineados
+void multiplicarMatricesEmpaquetadaConPaneles(const struct matriz * p_matrizA, const struct matriz * p_matrizB, struct matriz * p_matrizResultado, int * paneles){
+	gemmEmpaquetadaConPaneles(1, p_matrizA, p_matrizB, 0, p_matrizResultado, paneles, 1);
+}
+
+// enteros de paneles para numeroHilos hilos: un panel de A por hilo y el de B
+size_t elementosPanelesEmpaquetadaHilos(int m, int k, int n, int numeroHilos){
+	return (size_t)(numeroHilos > 1 ? numeroHilos - 1 : 0) * elementosPanelA(m, k) + elementosPanelesEmpaquetada(m, k, n);
+}
+
+// C = A * B con numeroHilos hilos y paneles de quien llama, con
+// elementosPanelesEmpaquetadaHilos(M, K, N, numeroHilos) enteros alineados
+void multiplicarMatricesEmpaquetadaConPanelesHilos(const struct matriz * p_matrizA, const struct matriz * p_matrizB,
+		struct matriz * p_matrizResultado, int * paneles, int numeroHilos){
+	gemmEmpaquetadaConPaneles(1, p_matrizA, p_matrizB, 0, p_matrizResultado, paneles, numeroHilos < 1 ? 1 : numeroHilos);
+}
+
+// C = A * B reservando los paneles en cada llamada
+void multiplicarMatricesEmpaquetada(const struct matriz * p_matrizA, const struct matriz * p_matrizB, struct matriz * p_matrizResultado){
+	gemmEmpaquetada(1, p_matrizA, p_matrizB, 0, p_matrizResultado, 1);
+}
+
+// C = alfa * A * B + beta * C con numeroHilos hilos, reservando los paneles
+void gemmEmpaquetada(int alfa, const struct matriz * p_matrizA, const struct matriz * p_matrizB, int beta, struct matriz * p_matrizResultado, int numeroHilos){
+	int m = p_matrizA->filas, k = p_matrizA->columnas, n = p_matrizB->columnas;
+	size_t elementos;
+	int * paneles, marca;
+
+	if(numeroHilos < 1){
+		numeroHilos = 1;
+	}
+	if(k == 0 || alfa == 0){
+		gemmEmpaquetadaConPaneles(alfa, p_matrizA, p_matrizB, beta, p_matrizResultado, NULL, numeroHilos);
+		return;
+	}
+	// del pool de memoria si esta activo: cada llamada pide los mismos paneles
+	elementos = elementosPanelesEmpaquetadaHilos(m, k, n, numeroHilos);
+	paneles = (int *)tomarBloque(elementos * sizeof(int), 0, &marca);
+	gemmEmpaquetadaConPaneles(alfa, p_matrizA, p_matrizB, beta, p_matrizResultado, paneles, numeroHilos);
+	devolverBloque(paneles, elementos * sizeof(int), marca);
+}
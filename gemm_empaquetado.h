@@ -0,0 +1,52 @@
+/*
+ Motor de multiplicacion con paneles empaquetados (estilo GotoBLAS)
+
+ C = A * B se calcula con tres niveles de bloques:
+
+ 	- jc recorre C en paneles de NC columnas (panel de B en cache L3)
+ 	- pc recorre la dimension k en pasos de KC (panel de B empaquetado)
+ 	- ic recorre C en bloques de MC filas (bloque de A empaquetado en L2)
+
+ Dentro de cada bloque, el micro-kernel calcula un azulejo de MR x NR de C
+ que se mantiene en registros durante todo el recorrido de k. A y B se copian
+ a paneles contiguos en el orden exacto en que el micro-kernel los lee, con
+ relleno de ceros en los bordes, asi el micro-kernel nunca revisa limites.
+ El micro-kernel es el de nucleos_simd.c elegido al arrancar (AVX-512, AVX2,
+ SSE4.1 o escalar).
+
+ B se usa en su forma original (no hace falta transponerla antes).
+
+ gemmEmpaquetada calcula C = alfa * A * B + beta * C para A de M x K y B de
+ K x N (o vistas dentro de matrices mas grandes): alfa se aplica al empaquetar
+ A, C se escala por beta antes de empezar y los micro-kernels suman sobre C.
+ Con varios hilos, cada uno empaqueta y multiplica bloques de A distintos
+ contra el mismo panel de B; los bloques se reparten en tramos contiguos de
+ filas (tramoFilasEmpaquetada), siempre los mismos para cada hilo, para que
+ quien inicializa las matrices pueda tocar primero las filas de cada hilo.
+*/
+#ifndef GEMM_EMPAQUETADO_H
+#define GEMM_EMPAQUETADO_H
+
+#include "matriz.h"
+#include "nucleos_simd.h"
+
+struct configuracionGemm{
+	int mc; // filas de A por bloque (multiplo de MR)
+	int kc; // profundidad de los paneles
+	int nc; // columnas de B por panel (multiplo de NR)
+};
+
+extern struct configuracionGemm configuracionGemmActual;
+
+void multiplicarMatricesEmpaquetada(const struct matriz *, const struct matriz *, struct matriz *);
+void gemmEmpaquetada(int alfa, const struct matriz *, const struct matriz *, int beta, struct matriz *, int numeroHilos);
+size_t elementosPanelesEmpaquetada(int m, int k, int n);
+void multiplicarMatricesEmpaquetadaConPaneles(const struct matriz *, const struct matriz *, struct matriz *, int * paneles);
+size_t elementosPanelesEmpaquetadaHilos(int m, int k, int n, int numeroHilos);
+void multiplicarMatricesEmpaquetadaConPanelesHilos(const struct matriz *, const struct matriz *, struct matriz *, int * paneles,
+	int numeroHilos);
+void tramoFilasEmpaquetada(int m, int numeroHilos, int hilo, int * inicio, int * fin);
+void empaquetarA(const struct matriz *, int fila, int columna, int mc, int kc, int * panelA);
+void empaquetarB(const struct matriz *, int fila, int columna, int kc, int nc, int * panelB);
+
+#endif
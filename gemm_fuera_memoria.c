@@ -0,0 +1,399 @@
+// multiplicacion por azulejos leidos del disco con doble buffer (ver gemm_fuera_memoria.h)
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "gemm_fuera_memoria.h"
+#include "gemm.h"
+
+// profundidad minima de un paso: menos que el kc de los kernels empaquetados
+// desperdicia el empaquetado de C en cada paso
+#define PROFUNDIDAD_MINIMA 256
+#define MULTIPLO_AZULEJO 64
+
+// estados de los buffers de C
+#define C_LIBRE 0
+#define C_EN_USO 1
+#define C_POR_ESCRIBIR 2
+
+struct bufferPaso{
+	void * A;
+	void * B;
+	int lleno;
+};
+
+struct bufferC{
+	void * datos;
+	int estado;
+	int fila; // esquina del azulejo en C
+	int columna;
+	int filas;
+	int columnas;
+};
+
+struct tuberiaFuera{
+	const struct archivoMatriz * A;
+	const struct archivoMatriz * B;
+	const struct archivoMatriz * C;
+	struct azulejosFueraDeMemoria azulejos;
+	size_t tamanio;
+	int ldA, ldB, ldC; // de los buffers
+	int pasosProfundidad, azulejosColumnas;
+	long totalPasos;
+
+	struct bufferPaso pasos[2];
+	struct bufferC c[2];
+	int error;
+	int fin;
+	pthread_mutex_t candado;
+	pthread_cond_t cambio;
+
+	struct estadisticasFueraDeMemoria * estadisticas;
+};
+
+static double tiempoActual(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static size_t bytesAzulejos(int filas, int columnas, int profundidad, size_t tamanio){
+	size_t bloqueA = (size_t)filas * calcularLdTipada(profundidad, tamanio);
+	size_t bloqueB = (size_t)profundidad * calcularLdTipada(columnas, tamanio);
+	size_t bloqueC = (size_t)filas * calcularLdTipada(columnas, tamanio);
+	return 2 * (bloqueA + bloqueB + bloqueC) * tamanio;
+}
+
+static int minimo(int a, int b){
+	return a < b ? a : b;
+}
+
+// primero el lado mas grande de los azulejos de C que entra con la
+// profundidad minima (es lo que reduce las lecturas), despues la profundidad
+// que alcance con lo que sobra (menos pasos y menos llamadas a pread)
+struct azulejosFueraDeMemoria elegirAzulejosFueraDeMemoria(int m, int n, int k, size_t tamanioElemento, size_t presupuesto){
+	struct azulejosFueraDeMemoria azulejos = {0, 0, 0};
+	int lado, profundidad, mayor = m > n ? m : n;
+	int profundidadBase = minimo(k, PROFUNDIDAD_MINIMA);
+
+	if(profundidadBase < 1){
+		profundidadBase = 1;
+	}
+	for(lado = (mayor + MULTIPLO_AZULEJO - 1) / MULTIPLO_AZULEJO * MULTIPLO_AZULEJO; lado >= MULTIPLO_AZULEJO; lado -= MULTIPLO_AZULEJO){
+		if(bytesAzulejos(minimo(lado, m), minimo(lado, n), profundidadBase, tamanioElemento) <= presupuesto){
+			break;
+		}
+	}
+	if(lado < MULTIPLO_AZULEJO){
+		return azulejos;
+	}
+	azulejos.filas = minimo(lado, m);
+	azulejos.columnas = minimo(lado, n);
+	azulejos.profundidad = profundidadBase;
+	for(profundidad = (k + MULTIPLO_AZULEJO - 1) / MULTIPLO_AZULEJO * MULTIPLO_AZULEJO; profundidad > profundidadBase; profundidad -= MULTIPLO_AZULEJO){
+		if(bytesAzulejos(azulejos.filas, azulejos.columnas, minimo(profundidad, k), tamanioElemento) <= presupuesto){
+			azulejos.profundidad = minimo(profundidad, k);
+			break;
+		}
+	}
+	return azulejos;
+}
+
+// pread/pwrite pueden transferir menos de lo pedido
+static int leerCompleto(int descriptor, void * destino, size_t bytes, off_t posicion){
+	ssize_t leidos;
+	while(bytes > 0){
+		leidos = pread(descriptor, destino, bytes, posicion);
+		if(leidos < 0 && errno == EINTR){
+			continue;
+		}
+		if(leidos <= 0){
+			return -1;
+		}
+		destino = (char *)destino + leidos;
+		bytes -= leidos;
+		posicion += leidos;
+	}
+	return 0;
+}
+
+static int escribirCompleto(int descriptor, const void * origen, size_t bytes, off_t posicion){
+	ssize_t escritos;
+	while(bytes > 0){
+		escritos = pwrite(descriptor, origen, bytes, posicion);
+		if(escritos < 0 && errno == EINTR){
+			continue;
+		}
+		if(escritos <= 0){
+			return -1;
+		}
+		origen = (const char *)origen + escritos;
+		bytes -= escritos;
+		posicion += escritos;
+	}
+	return 0;
+}
+
+static off_t posicionElemento(const struct archivoMatriz * archivo, int fila, int columna){
+	return (off_t)(archivo->cabecera.desplazamiento + ((uint64_t)fila * archivo->cabecera.ld + columna) * archivo->cabecera.tamanioElemento);
+}
+
+// bloque de filas x columnas del archivo en un buffer con dimension principal
+// ld; si el bloque son filas enteras con el mismo relleno, un solo pread
+static int leerBloque(const struct archivoMatriz * archivo, int fila, int columna, int filas, int columnas, void * destino, int ld){
+	size_t tamanio = archivo->cabecera.tamanioElemento;
+	int i;
+
+	if(columna == 0 && columnas == archivo->datos.columnas && (uint64_t)ld == archivo->cabecera.ld){
+		return leerCompleto(archivo->descriptor, destino, (size_t)filas * ld * tamanio, posicionElemento(archivo, fila, 0));
+	}
+	for(i = 0; i < filas; i++){
+		if(leerCompleto(archivo->descriptor, (char *)destino + (size_t)i * ld * tamanio, (size_t)columnas * tamanio,
+				posicionElemento(archivo, fila + i, columna)) != 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int escribirBloque(const struct archivoMatriz * archivo, int fila, int columna, int filas, int columnas, const void * origen, int ld){
+	size_t tamanio = archivo->cabecera.tamanioElemento;
+	int i;
+
+	for(i = 0; i < filas; i++){
+		if(escribirCompleto(archivo->descriptor, (const char *)origen + (size_t)i * ld * tamanio, (size_t)columnas * tamanio,
+				posicionElemento(archivo, fila + i, columna)) != 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// esquina y tamanio del paso: los pasos recorren la profundidad de un azulejo
+// de C, despues los azulejos de una fila de C y despues las filas
+static void ubicarPaso(const struct tuberiaFuera * tuberia, long paso, int * fila, int * columna, int * profundidad,
+		int * filas, int * columnas, int * profundidades){
+	const struct azulejosFueraDeMemoria * azulejos = &tuberia->azulejos;
+	long resto = paso / tuberia->pasosProfundidad;
+
+	*profundidad = (int)(paso % tuberia->pasosProfundidad) * azulejos->profundidad;
+	*columna = (int)(resto % tuberia->azulejosColumnas) * azulejos->columnas;
+	*fila = (int)(resto / tuberia->azulejosColumnas) * azulejos->filas;
+	*filas = minimo(azulejos->filas, tuberia->A->datos.filas - *fila);
+	*columnas = minimo(azulejos->columnas, tuberia->B->datos.columnas - *columna);
+	*profundidades = minimo(azulejos->profundidad, tuberia->A->datos.columnas - *profundidad);
+}
+
+// hilo de E/S: escribe los azulejos de C terminados en cuanto aparecen y
+// mientras tanto adelanta la lectura del siguiente paso al buffer libre
+static void * hiloEntradaSalida(void * parametro){
+	struct tuberiaFuera * tuberia = (struct tuberiaFuera *)parametro;
+	struct estadisticasFueraDeMemoria * estadisticas = tuberia->estadisticas;
+	struct bufferPaso * buffer;
+	struct bufferC * c;
+	long siguiente = 0;
+	int fila, columna, profundidad, filas, columnas, profundidades, i, resultado;
+	double inicio;
+
+	pthread_mutex_lock(&tuberia->candado);
+	while(1){
+		c = NULL;
+		while(!tuberia->error){
+			for(i = 0; i < 2 && c == NULL; i++){
+				if(tuberia->c[i].estado == C_POR_ESCRIBIR){
+					c = &tuberia->c[i];
+				}
+			}
+			if(c != NULL || (siguiente < tuberia->totalPasos && !tuberia->pasos[siguiente % 2].lleno)
+					|| (siguiente >= tuberia->totalPasos && tuberia->fin)){
+				break;
+			}
+			pthread_cond_wait(&tuberia->cambio, &tuberia->candado);
+		}
+		if(tuberia->error || (c == NULL && siguiente >= tuberia->totalPasos)){
+			break;
+		}
+		pthread_mutex_unlock(&tuberia->candado);
+
+		inicio = tiempoActual();
+		if(c != NULL){
+			resultado = escribirBloque(tuberia->C, c->fila, c->columna, c->filas, c->columnas, c->datos, tuberia->ldC);
+			estadisticas->tiempoEscritura += tiempoActual() - inicio;
+			estadisticas->bytesEscritos += (double)c->filas * c->columnas * tuberia->tamanio;
+		}
+		else{
+			buffer = &tuberia->pasos[siguiente % 2];
+			ubicarPaso(tuberia, siguiente, &fila, &columna, &profundidad, &filas, &columnas, &profundidades);
+			resultado = leerBloque(tuberia->A, fila, profundidad, filas, profundidades, buffer->A, tuberia->ldA);
+			if(resultado == 0){
+				resultado = leerBloque(tuberia->B, profundidad, columna, profundidades, columnas, buffer->B, tuberia->ldB);
+			}
+			estadisticas->tiempoLectura += tiempoActual() - inicio;
+			estadisticas->bytesLeidos += ((double)filas + columnas) * profundidades * tuberia->tamanio;
+		}
+
+		pthread_mutex_lock(&tuberia->candado);
+		if(resultado != 0){
+			perror("gemmFueraDeMemoria: error de E/S");
+			tuberia->error = 1;
+		}
+		else if(c != NULL){
+			c->estado = C_LIBRE;
+		}
+		else{
+			tuberia->pasos[siguiente % 2].lleno = 1;
+			siguiente++;
+		}
+		pthread_cond_broadcast(&tuberia->cambio);
+	}
+	pthread_mutex_unlock(&tuberia->candado);
+	return NULL;
+}
+
+// producto de un paso con el gemm del tipo; acumular = 0 en el primer paso
+// de cada azulejo para no leer C
+static void multiplicarPaso(enum tipoArchivoMatriz tipo, int m, int n, int k, const void * A, int lda, const void * B, int ldb,
+		int acumular, void * C, int ldc){
+	switch(tipo){
+		case ARCHIVO_INT32: gemmEntero32(m, n, k, 1, A, lda, B, ldb, acumular, C, ldc); break;
+		case ARCHIVO_INT64: gemmEntero64(m, n, k, 1, A, lda, B, ldb, acumular, C, ldc); break;
+		case ARCHIVO_FLOAT: gemmFlotante(m, n, k, 1, A, lda, B, ldb, acumular, C, ldc); break;
+		case ARCHIVO_DOUBLE: gemmDoble(m, n, k, 1, A, lda, B, ldb, acumular, C, ldc); break;
+		default: break;
+	}
+}
+
+static void * reservarBuffer(size_t bytes){
+	void * bloque = NULL;
+	if(posix_memalign(&bloque, ALINEACION_MATRIZ, bytes > 0 ? bytes : ALINEACION_MATRIZ) != 0){
+		perror("No se pudo reservar memoria para los buffers fuera de memoria");
+		exit(1);
+	}
+	return bloque;
+}
+
+int gemmFueraDeMemoria(const struct archivoMatriz * A, const struct archivoMatriz * B, struct archivoMatriz * C,
+		size_t presupuesto, struct estadisticasFueraDeMemoria * estadisticas){
+	struct estadisticasFueraDeMemoria propias;
+	struct tuberiaFuera tuberia;
+	struct bufferC * c;
+	pthread_t hilo;
+	int m = A->datos.filas, n = B->datos.columnas, k = A->datos.columnas;
+	int fila, columna, profundidad, filas, columnas, profundidades, actual = 0, i, rc;
+	long paso;
+	double inicio = tiempoActual(), instante;
+
+	if(estadisticas == NULL){
+		estadisticas = &propias;
+	}
+	memset(estadisticas, 0, sizeof(*estadisticas));
+	if(A->cabecera.tipo != B->cabecera.tipo || A->cabecera.tipo != C->cabecera.tipo
+			|| B->datos.filas != k || C->datos.filas != m || C->datos.columnas != n){
+		fprintf(stderr, "gemmFueraDeMemoria: las formas o los tipos de A, B y C no encajan\n");
+		return -1;
+	}
+	// crearArchivoMatriz deja C en cero, que ya es el producto con k = 0
+	if(m == 0 || n == 0 || k == 0){
+		return 0;
+	}
+
+	memset(&tuberia, 0, sizeof(tuberia));
+	tuberia.A = A;
+	tuberia.B = B;
+	tuberia.C = C;
+	tuberia.tamanio = A->cabecera.tamanioElemento;
+	tuberia.azulejos = elegirAzulejosFueraDeMemoria(m, n, k, tuberia.tamanio, presupuesto);
+	if(tuberia.azulejos.filas == 0){
+		fprintf(stderr, "gemmFueraDeMemoria: el presupuesto de %zu bytes no alcanza para un azulejo\n", presupuesto);
+		return -1;
+	}
+	tuberia.ldA = calcularLdTipada(tuberia.azulejos.profundidad, tuberia.tamanio);
+	tuberia.ldB = calcularLdTipada(tuberia.azulejos.columnas, tuberia.tamanio);
+	tuberia.ldC = tuberia.ldB;
+	tuberia.pasosProfundidad = (k + tuberia.azulejos.profundidad - 1) / tuberia.azulejos.profundidad;
+	tuberia.azulejosColumnas = (n + tuberia.azulejos.columnas - 1) / tuberia.azulejos.columnas;
+	tuberia.totalPasos = (long)(m + tuberia.azulejos.filas - 1) / tuberia.azulejos.filas * tuberia.azulejosColumnas * tuberia.pasosProfundidad;
+	tuberia.estadisticas = estadisticas;
+	for(i = 0; i < 2; i++){
+		tuberia.pasos[i].A = reservarBuffer((size_t)tuberia.azulejos.filas * tuberia.ldA * tuberia.tamanio);
+		tuberia.pasos[i].B = reservarBuffer((size_t)tuberia.azulejos.profundidad * tuberia.ldB * tuberia.tamanio);
+		tuberia.c[i].datos = reservarBuffer((size_t)tuberia.azulejos.filas * tuberia.ldC * tuberia.tamanio);
+	}
+	estadisticas->azulejos = tuberia.azulejos;
+	estadisticas->bytesReservados = bytesAzulejos(tuberia.azulejos.filas, tuberia.azulejos.columnas, tuberia.azulejos.profundidad, tuberia.tamanio);
+	estadisticas->pasos = tuberia.totalPasos;
+	pthread_mutex_init(&tuberia.candado, NULL);
+	pthread_cond_init(&tuberia.cambio, NULL);
+
+	rc = pthread_create(&hilo, NULL, hiloEntradaSalida, &tuberia);
+	if(rc != 0){
+		fprintf(stderr, "No se pudo crear el hilo de E/S: %s\n", strerror(rc));
+		exit(1);
+	}
+
+	for(paso = 0; paso < tuberia.totalPasos; paso++){
+		ubicarPaso(&tuberia, paso, &fila, &columna, &profundidad, &filas, &columnas, &profundidades);
+		c = &tuberia.c[actual];
+
+		instante = tiempoActual();
+		pthread_mutex_lock(&tuberia.candado);
+		if(profundidad == 0){
+			while(c->estado != C_LIBRE && !tuberia.error){
+				pthread_cond_wait(&tuberia.cambio, &tuberia.candado);
+			}
+			c->estado = C_EN_USO;
+			c->fila = fila;
+			c->columna = columna;
+			c->filas = filas;
+			c->columnas = columnas;
+		}
+		while(!tuberia.pasos[paso % 2].lleno && !tuberia.error){
+			pthread_cond_wait(&tuberia.cambio, &tuberia.candado);
+		}
+		pthread_mutex_unlock(&tuberia.candado);
+		estadisticas->tiempoEspera += tiempoActual() - instante;
+		if(tuberia.error){
+			break;
+		}
+
+		instante = tiempoActual();
+		multiplicarPaso(A->cabecera.tipo, filas, columnas, profundidades, tuberia.pasos[paso % 2].A, tuberia.ldA,
+			tuberia.pasos[paso % 2].B, tuberia.ldB, profundidad > 0, c->datos, tuberia.ldC);
+		estadisticas->tiempoCalculo += tiempoActual() - instante;
+
+		pthread_mutex_lock(&tuberia.candado);
+		tuberia.pasos[paso % 2].lleno = 0;
+		if(profundidad + profundidades == k){
+			c->estado = C_POR_ESCRIBIR;
+			actual ^= 1;
+		}
+		pthread_cond_broadcast(&tuberia.cambio);
+		pthread_mutex_unlock(&tuberia.candado);
+	}
+
+	// esperar que se escriban los ultimos azulejos
+	instante = tiempoActual();
+	pthread_mutex_lock(&tuberia.candado);
+	while((tuberia.c[0].estado == C_POR_ESCRIBIR || tuberia.c[1].estado == C_POR_ESCRIBIR) && !tuberia.error){
+		pthread_cond_wait(&tuberia.cambio, &tuberia.candado);
+	}
+	tuberia.fin = 1;
+	pthread_cond_broadcast(&tuberia.cambio);
+	pthread_mutex_unlock(&tuberia.candado);
+	pthread_join(hilo, NULL);
+	estadisticas->tiempoEspera += tiempoActual() - instante;
+
+	pthread_mutex_destroy(&tuberia.candado);
+	pthread_cond_destroy(&tuberia.cambio);
+	for(i = 0; i < 2; i++){
+		free(tuberia.pasos[i].A);
+		free(tuberia.pasos[i].B);
+		free(tuberia.c[i].datos);
+	}
+	estadisticas->tiempoTotal = tiempoActual() - inicio;
+	return tuberia.error ? -1 : 0;
+}
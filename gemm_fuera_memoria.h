@@ -0,0 +1,63 @@
+/*
+ Multiplicacion fuera de memoria: C = A * B con A, B y C en archivos .mat
+ (archivo_matriz.h) que no tienen que caber en RAM
+
+ C se recorre por azulejos de filasAzulejo x columnasAzulejo y la dimension
+ comun por tramos de profundidad: cada paso lee el bloque de A y el de B de
+ ese tramo y los acumula en el azulejo de C con gemm. Un hilo de E/S lee con
+ pread el paso siguiente en el otro de dos buffers mientras se calcula el
+ actual (doble buffer) y escribe con pwrite los azulejos de C terminados,
+ que tambien tienen dos buffers para no esperar la escritura.
+
+ Todo lo que se reserva entra en el presupuesto de memoria:
+
+ 	2 * (filas * profundidad + profundidad * columnas) + 2 * filas * columnas
+
+ elementos (mas los paneles de empaquetado de gemm, unos pocos MB). Lo que
+ se lee del disco es A una vez por cada columna de azulejos de C y B una vez
+ por cada fila de azulejos, asi que conviene que los azulejos de C sean lo mas
+ grandes posible y la profundidad solo la necesaria para que gemm rinda:
+ elegirAzulejosFueraDeMemoria reparte el presupuesto con ese criterio.
+
+ Los archivos se abren con abrirArchivoMatriz / crearArchivoMatriz como
+ siempre (el mapa no se toca, solo el descriptor); cerrar C calcula su suma
+ de verificacion.
+*/
+#ifndef GEMM_FUERA_MEMORIA_H
+#define GEMM_FUERA_MEMORIA_H
+
+#include <stddef.h>
+
+#include "archivo_matriz.h"
+
+// presupuesto por defecto si no se indica otro
+#define PRESUPUESTO_FUERA_MEMORIA ((size_t)256 << 20)
+
+struct azulejosFueraDeMemoria{
+	int filas; // de A y de C
+	int columnas; // de B y de C
+	int profundidad; // columnas de A y filas de B
+};
+
+struct estadisticasFueraDeMemoria{
+	struct azulejosFueraDeMemoria azulejos;
+	size_t bytesReservados;
+	long pasos;
+	double bytesLeidos;
+	double bytesEscritos;
+	double tiempoLectura; // hilo de E/S dentro de pread
+	double tiempoEscritura; // hilo de E/S dentro de pwrite
+	double tiempoCalculo; // hilo que multiplica dentro de gemm
+	double tiempoEspera; // hilo que multiplica esperando datos o un buffer de C
+	double tiempoTotal;
+};
+
+struct azulejosFueraDeMemoria elegirAzulejosFueraDeMemoria(int m, int n, int k, size_t tamanioElemento, size_t presupuesto);
+
+// A y B abiertos para leer, C creado con crearArchivoMatriz y del mismo tipo;
+// devuelve 0, o -1 si las formas no encajan, el presupuesto no alcanza o
+// falla la E/S. estadisticas puede ser NULL
+int gemmFueraDeMemoria(const struct archivoMatriz * A, const struct archivoMatriz * B, struct archivoMatriz * C,
+	size_t presupuesto, struct estadisticasFueraDeMemoria * estadisticas);
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ Plantilla de la multiplicacion por lotes para un tipo de elemento
+
+ No es un header normal: gemm_lotes.c la incluye una vez por tipo despues de
+ definir TIPO y SUFIJO, y la plantilla los borra al final. ACUMULADOR es el
+ tipo en que se hacen las cuentas; si no se define es TIPO. Para int es
+ unsigned int: el desborde da el mismo resultado modulo 2^32 que los demas
+ motores enteros (gemm_empaquetado.c) sin comportamiento indefinido.
+
+ Para cada tamanio de ladosLote y cada ISA se genera un kernel que recorre un
+ tramo del lote con m = n = k constantes: el producto se inlinea con esos
+ valores, asi el compilador desenrolla los bucles y vectoriza la fila de C con
+ los registros de esa ISA. Las formas que no estan en ladosLote usan el kernel
+ generico de la misma ISA.
+*/
+
+#define CON_SUFIJO(nombre) UNIR(nombre, SUFIJO)
+
+#ifndef ACUMULADOR
+#define ACUMULADOR TIPO
+#endif
+
+typedef void (*CON_SUFIJO(kernelLote))(const struct loteMatrices * lote, TIPO alfa, TIPO beta, int inicio, int fin);
+
+static inline const TIPO * CON_SUFIJO(matrizLoteA)(const struct loteMatrices * lote, int b){
+	return lote->punterosA != NULL ? (const TIPO *)lote->punterosA[b] : (const TIPO *)lote->A + b * lote->pasoA;
+}
+
+static inline const TIPO * CON_SUFIJO(matrizLoteB)(const struct loteMatrices * lote, int b){
+	return lote->punterosB != NULL ? (const TIPO *)lote->punterosB[b] : (const TIPO *)lote->B + b * lote->pasoB;
+}
+
+static inline TIPO * CON_SUFIJO(matrizLoteC)(const struct loteMatrices * lote, int b){
+	return lote->punterosC != NULL ? (TIPO *)lote->punterosC[b] : (TIPO *)lote->C + b * lote->pasoC;
+}
+
+// C = alfa * A * B + beta * C para un elemento del lote, fila por fila: la
+// fila de C (hasta LADO_MAXIMO_LOTE columnas) se acumula en un arreglo local
+// que con n constante queda en registros
+static inline __attribute__((always_inline)) void CON_SUFIJO(productoPequeno)(int m, int n, int k, TIPO alfa,
+		const TIPO * A, int lda, const TIPO * B, int ldb, TIPO beta, TIPO * C, int ldc){
+	ACUMULADOR fila[LADO_MAXIMO_LOTE];
+	const TIPO * filaB;
+	TIPO * filaC;
+	ACUMULADOR a;
+	int i, j, p, j0, ancho;
+
+	for(j0 = 0; j0 < n; j0 += LADO_MAXIMO_LOTE){
+		ancho = n - j0 < LADO_MAXIMO_LOTE ? n - j0 : LADO_MAXIMO_LOTE;
+		for(i = 0; i < m; i++){
+			for(j = 0; j < ancho; j++){
+				fila[j] = 0;
+			}
+			for(p = 0; p < k; p++){
+				a = (ACUMULADOR)A[(size_t)i * lda + p];
+				filaB = B + (size_t)p * ldb + j0;
+				for(j = 0; j < ancho; j++){
+					fila[j] += a * (ACUMULADOR)filaB[j];
+				}
+			}
+			filaC = C + (size_t)i * ldc + j0;
+			if(beta == 0){
+				for(j = 0; j < ancho; j++){
+					filaC[j] = (TIPO)((ACUMULADOR)alfa * fila[j]);
+				}
+			}
+			else{
+				for(j = 0; j < ancho; j++){
+					filaC[j] = (TIPO)((ACUMULADOR)alfa * fila[j] + (ACUMULADOR)beta * (ACUMULADOR)filaC[j]);
+				}
+			}
+		}
+	}
+}
+
+#define KERNEL_LOTE(lado, isa, objetivo) \
+objetivo static void CON_SUFIJO(UNIR(lote##lado, isa))(const struct loteMatrices * lote, TIPO alfa, TIPO beta, int inicio, int fin){ \
+	int b; \
+	for(b = inicio; b < fin; b++){ \
+		CON_SUFIJO(productoPequeno)(lado, lado, lado, alfa, CON_SUFIJO(matrizLoteA)(lote, b), lote->lda, \
+			CON_SUFIJO(matrizLoteB)(lote, b), lote->ldb, beta, CON_SUFIJO(matrizLoteC)(lote, b), lote->ldc); \
+	} \
+}
+
+#define KERNEL_LOTE_GENERICO(isa, objetivo) \
+objetivo static void CON_SUFIJO(UNIR(loteGenerico, isa))(const struct loteMatrices * lote, TIPO alfa, TIPO beta, int inicio, int fin){ \
+	int b; \
+	for(b = inicio; b < fin; b++){ \
+		CON_SUFIJO(productoPequeno)(lote->m, lote->n, lote->k, alfa, CON_SUFIJO(matrizLoteA)(lote, b), lote->lda, \
+			CON_SUFIJO(matrizLoteB)(lote, b), lote->ldb, beta, CON_SUFIJO(matrizLoteC)(lote, b), lote->ldc); \
+	} \
+}
+
+#define KERNELS_LOTE(isa, objetivo) \
+	KERNEL_LOTE(4, isa, objetivo) \
+	KERNEL_LOTE(8, isa, objetivo) \
+	KERNEL_LOTE(16, isa, objetivo) \
+	KERNEL_LOTE(32, isa, objetivo) \
+	KERNEL_LOTE(64, isa, objetivo) \
+	KERNEL_LOTE_GENERICO(isa, objetivo)
+
+KERNELS_LOTE(Base, )
+KERNELS_LOTE(Avx2, __attribute__((target("avx2,fma"))))
+KERNELS_LOTE(Avx512, __attribute__((target("avx512f,avx512dq"))))
+
+// [nivelIsaTipos()][posicion en ladosLote, o NUMERO_LADOS_LOTE para el generico]
+static const CON_SUFIJO(kernelLote) CON_SUFIJO(kernelsLote)[3][NUMERO_LADOS_LOTE + 1] = {
+	{CON_SUFIJO(lote4Base), CON_SUFIJO(lote8Base), CON_SUFIJO(lote16Base), CON_SUFIJO(lote32Base), CON_SUFIJO(lote64Base), CON_SUFIJO(loteGenericoBase)},
+	{CON_SUFIJO(lote4Avx2), CON_SUFIJO(lote8Avx2), CON_SUFIJO(lote16Avx2), CON_SUFIJO(lote32Avx2), CON_SUFIJO(lote64Avx2), CON_SUFIJO(loteGenericoAvx2)},
+	{CON_SUFIJO(lote4Avx512), CON_SUFIJO(lote8Avx512), CON_SUFIJO(lote16Avx512), CON_SUFIJO(lote32Avx512), CON_SUFIJO(lote64Avx512), CON_SUFIJO(loteGenericoAvx512)},
+};
+
+// repartir el lote en tramos contiguos, uno por hilo, en una sola region
+// paralela; los lotes con poco trabajo se hacen en el hilo que llama
+static void CON_SUFIJO(ejecutarLote)(const struct loteMatrices * lote, TIPO alfa, TIPO beta){
+	CON_SUFIJO(kernelLote) kernel = CON_SUFIJO(kernelsLote)[nivelIsaTipos()][posicionLadoLote(lote)];
+	int numeroHilos = hilosLote(lote);
+
+	if(numeroHilos == 1){
+		kernel(lote, alfa, beta, 0, lote->numero);
+		return;
+	}
+	#pragma omp parallel num_threads(numeroHilos)
+	{
+		long hilo = omp_get_thread_num(), total = omp_get_num_threads();
+		kernel(lote, alfa, beta, (int)(lote->numero * hilo / total), (int)(lote->numero * (hilo + 1) / total));
+	}
+}
+
+#undef KERNEL_LOTE
+#undef KERNEL_LOTE_GENERICO
+#undef KERNELS_LOTE
+#undef CON_SUFIJO
+#undef TIPO
+#undef SUFIJO
+#undef ACUMULADOR
@@ -0,0 +1,146 @@
+// multiplicacion por lotes de matrices pequenias (API en gemm.h)
+#include <stdlib.h>
+#include <omp.h>
+
+#include "gemm.h"
+#include "gemm_tipos.h"
+
+#define UNIR(a, b) UNIR_(a, b)
+#define UNIR_(a, b) a##b
+
+// columnas de C que se acumulan a la vez en un arreglo local
+#define LADO_MAXIMO_LOTE 64
+#define NUMERO_LADOS_LOTE 5
+
+// por debajo de estas multiplicaciones-suma en total el lote no se reparte
+#define TRABAJO_MINIMO_PARALELO 65536.0
+
+// tamanios con kernel propio (m = n = k)
+static const int ladosLote[NUMERO_LADOS_LOTE] = {4, 8, 16, 32, 64};
+
+// un lote con paso fijo (A, B, C y pasos en elementos) o con arreglos de punteros
+struct loteMatrices{
+	int m, n, k, lda, ldb, ldc, numero;
+	const void * A;
+	const void * B;
+	void * C;
+	long pasoA, pasoB, pasoC;
+	const void * const * punterosA; // NULL para lotes con paso
+	const void * const * punterosB;
+	void * const * punterosC;
+};
+
+static int posicionLadoLote(const struct loteMatrices * lote){
+	int i;
+	if(lote->m == lote->n && lote->n == lote->k){
+		for(i = 0; i < NUMERO_LADOS_LOTE; i++){
+			if(ladosLote[i] == lote->m){
+				return i;
+			}
+		}
+	}
+	return NUMERO_LADOS_LOTE;
+}
+
+static int hilosLote(const struct loteMatrices * lote){
+	int numeroHilos = hilosGemm();
+	if((double)lote->numero * lote->m * lote->n * lote->k < TRABAJO_MINIMO_PARALELO){
+		return 1;
+	}
+	return numeroHilos < lote->numero ? numeroHilos : lote->numero;
+}
+
+#define TIPO float
+#define SUFIJO Flotante
+#include "gemm_lote_plantilla.h"
+
+#define TIPO double
+#define SUFIJO Doble
+#include "gemm_lote_plantilla.h"
+
+#define TIPO int
+#define SUFIJO Entero32
+#define ACUMULADOR unsigned int
+#include "gemm_lote_plantilla.h"
+
+static int loteValido(int m, int n, int k, int lda, int ldb, int ldc, int numero){
+	return m >= 0 && n >= 0 && k >= 0 && numero >= 0 && lda >= k && ldb >= n && ldc >= n;
+}
+
+static struct loteMatrices loteConPaso(int m, int n, int k, const void * A, int lda, long pasoA, const void * B, int ldb, long pasoB,
+		void * C, int ldc, long pasoC, int numero){
+	struct loteMatrices lote = {m, n, k, lda, ldb, ldc, numero, A, B, C, pasoA, pasoB, pasoC, NULL, NULL, NULL};
+	return lote;
+}
+
+static struct loteMatrices loteConPunteros(int m, int n, int k, const void * const * A, int lda, const void * const * B, int ldb,
+		void * const * C, int ldc, int numero){
+	struct loteMatrices lote = {m, n, k, lda, ldb, ldc, numero, NULL, NULL, NULL, 0, 0, 0, A, B, C};
+	return lote;
+}
+
+int gemmLoteFlotante(int m, int n, int k, float alfa, const float * A, int lda, long pasoA, const float * B, int ldb, long pasoB,
+		float beta, float * C, int ldc, long pasoC, int numero){
+	struct loteMatrices lote;
+	if(!loteValido(m, n, k, lda, ldb, ldc, numero)){
+		return -1;
+	}
+	lote = loteConPaso(m, n, k, A, lda, pasoA, B, ldb, pasoB, C, ldc, pasoC, numero);
+	ejecutarLoteFlotante(&lote, alfa, beta);
+	return 0;
+}
+
+int gemmLoteDoble(int m, int n, int k, double alfa, const double * A, int lda, long pasoA, const double * B, int ldb, long pasoB,
+		double beta, double * C, int ldc, long pasoC, int numero){
+	struct loteMatrices lote;
+	if(!loteValido(m, n, k, lda, ldb, ldc, numero)){
+		return -1;
+	}
+	lote = loteConPaso(m, n, k, A, lda, pasoA, B, ldb, pasoB, C, ldc, pasoC, numero);
+	ejecutarLoteDoble(&lote, alfa, beta);
+	return 0;
+}
+
+int gemmLoteEntero32(int m, int n, int k, int alfa, const int * A, int lda, long pasoA, const int * B, int ldb, long pasoB,
+		int beta, int * C, int ldc, long pasoC, int numero){
+	struct loteMatrices lote;
+	if(!loteValido(m, n, k, lda, ldb, ldc, numero)){
+		return -1;
+	}
+	lote = loteConPaso(m, n, k, A, lda, pasoA, B, ldb, pasoB, C, ldc, pasoC, numero);
+	ejecutarLoteEntero32(&lote, alfa, beta);
+	return 0;
+}
+
+int gemmLotePunterosFlotante(int m, int n, int k, float alfa, const float * const * A, int lda, const float * const * B, int ldb,
+		float beta, float * const * C, int ldc, int numero){
+	struct loteMatrices lote;
+	if(!loteValido(m, n, k, lda, ldb, ldc, numero) || (numero > 0 && (A == NULL || B == NULL || C == NULL))){
+		return -1;
+	}
+	lote = loteConPunteros(m, n, k, (const void * const *)A, lda, (const void * const *)B, ldb, (void * const *)C, ldc, numero);
+	ejecutarLoteFlotante(&lote, alfa, beta);
+	return 0;
+}
+
+int gemmLotePunterosDoble(int m, int n, int k, double alfa, const double * const * A, int lda, const double * const * B, int ldb,
+		double beta, double * const * C, int ldc, int numero){
+	struct loteMatrices lote;
+	if(!loteValido(m, n, k, lda, ldb, ldc, numero) || (numero > 0 && (A == NULL || B == NULL || C == NULL))){
+		return -1;
+	}
+	lote = loteConPunteros(m, n, k, (const void * const *)A, lda, (const void * const *)B, ldb, (void * const *)C, ldc, numero);
+	ejecutarLoteDoble(&lote, alfa, beta);
+	return 0;
+}
+
+int gemmLotePunterosEntero32(int m, int n, int k, int alfa, const int * const * A, int lda, const int * const * B, int ldb,
+		int beta, int * const * C, int ldc, int numero){
+	struct loteMatrices lote;
+	if(!loteValido(m, n, k, lda, ldb, ldc, numero) || (numero > 0 && (A == NULL || B == NULL || C == NULL))){
+		return -1;
+	}
+	lote = loteConPunteros(m, n, k, (const void * const *)A, lda, (const void * const *)B, ldb, (void * const *)C, ldc, numero);
+	ejecutarLoteEntero32(&lote, alfa, beta);
+	return 0;
+}
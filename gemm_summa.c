@@ -0,0 +1,279 @@
+// SUMMA sobre MPI: malla de procesos, matrices por bloques y producto por paneles
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gemm_summa.h"
+#include "gemm.h"
+#include "aleatorio_contador.h"
+
+// tramos de filas del bloque de C entre dos MPI_Testall cuando se solapa
+#define TRAMOS_CALCULO_SUMMA 8
+
+static int minimo(int a, int b){
+	return a < b ? a : b;
+}
+
+static void * reservarSumma(size_t bytes){
+	// + 1: los bloques vacios no deben devolver NULL
+	void * memoria = malloc(bytes + 1);
+	if(memoria == NULL){
+		perror("No se pudo reservar memoria para SUMMA");
+		exit(1);
+	}
+	return memoria;
+}
+
+int crearMallaSumma(MPI_Comm comunicador, int filasMalla, struct mallaSumma * malla){
+	int dimensiones[2] = {filasMalla, 0}, periodos[2] = {0, 0}, coordenadas[2];
+	int quedaFila[2] = {0, 1}, quedaColumna[2] = {1, 0};
+
+	MPI_Comm_size(comunicador, &malla->procesos);
+	if(filasMalla < 0 || filasMalla > malla->procesos || (filasMalla > 0 && malla->procesos % filasMalla != 0)){
+		return -1;
+	}
+	MPI_Dims_create(malla->procesos, 2, dimensiones);
+	MPI_Cart_create(comunicador, 2, dimensiones, periodos, 1, &malla->malla);
+	MPI_Comm_rank(malla->malla, &malla->rango);
+	MPI_Cart_coords(malla->malla, malla->rango, 2, coordenadas);
+	// en el comunicador de fila el rango es la columna, y al reves
+	MPI_Cart_sub(malla->malla, quedaFila, &malla->fila);
+	MPI_Cart_sub(malla->malla, quedaColumna, &malla->columna);
+
+	malla->filasMalla = dimensiones[0];
+	malla->columnasMalla = dimensiones[1];
+	malla->miFila = coordenadas[0];
+	malla->miColumna = coordenadas[1];
+	return 0;
+}
+
+void liberarMallaSumma(struct mallaSumma * malla){
+	MPI_Comm_free(&malla->fila);
+	MPI_Comm_free(&malla->columna);
+	MPI_Comm_free(&malla->malla);
+}
+
+void tramoSumma(int n, int partes, int parte, int * inicio, int * cantidad){
+	*inicio = (int)((long)n * parte / partes);
+	*cantidad = (int)((long)n * (parte + 1) / partes) - *inicio;
+}
+
+// parte de tramoSumma que contiene el indice x
+static int duenioSumma(int n, int partes, int x){
+	int parte = (int)((long)x * partes / n), inicio, cantidad;
+
+	// la division redondea; se corrige mirando los tramos vecinos
+	tramoSumma(n, partes, parte, &inicio, &cantidad);
+	while(x < inicio){
+		tramoSumma(n, partes, --parte, &inicio, &cantidad);
+	}
+	while(x >= inicio + cantidad){
+		tramoSumma(n, partes, ++parte, &inicio, &cantidad);
+	}
+	return parte;
+}
+
+struct matrizDistribuida * crearMatrizDistribuida(const struct mallaSumma * malla, int filas, int columnas){
+	struct matrizDistribuida * matriz = (struct matrizDistribuida *)reservarSumma(sizeof(struct matrizDistribuida));
+	int filasLocales, columnasLocales;
+
+	tramoSumma(filas, malla->filasMalla, malla->miFila, &matriz->filaInicio, &filasLocales);
+	tramoSumma(columnas, malla->columnasMalla, malla->miColumna, &matriz->columnaInicio, &columnasLocales);
+	matriz->filas = filas;
+	matriz->columnas = columnas;
+	matriz->local = crearMatriz(filasLocales, columnasLocales);
+	return matriz;
+}
+
+void liberarMatrizDistribuida(struct matrizDistribuida * matriz){
+	liberarMemoriaMatriz(matriz->local);
+	free(matriz);
+}
+
+void inicializarMatrizDistribuida(struct matrizDistribuida * matriz, uint64_t semilla, int minimo, int maximo){
+	uint64_t clave = claveAleatoria(semilla);
+	int i;
+
+	// contador de la posicion global, como inicializarMatrizAleatoria
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < matriz->local->filas; i++){
+		llenarAleatorio(FILA(matriz->local, i), matriz->local->columnas, clave,
+			(uint64_t)(matriz->filaInicio + i) * matriz->columnas + matriz->columnaInicio, minimo, maximo);
+	}
+}
+
+// un paso de SUMMA: las columnas [k, k + ancho) de A y las mismas filas de B
+struct pasoSumma{
+	int k;
+	int ancho;
+	int raizA; // columna de la malla con esas columnas de A
+	int raizB; // fila de la malla con esas filas de B
+};
+
+// el duenio copia su parte del panel en el buffer y se difunde por la fila
+// (A) o la columna (B) de la malla; con solicitudes != NULL sin bloquear
+static void difundirPaneles(const struct mallaSumma * malla, const struct matrizDistribuida * A, const struct matrizDistribuida * B,
+		const struct pasoSumma * paso, int * panelA, int * panelB, MPI_Request * solicitudes){
+	int filasA = A->local->filas, columnasB = B->local->columnas, i;
+
+	if(malla->miColumna == paso->raizA){
+		for(i = 0; i < filasA; i++){
+			memcpy(panelA + (size_t)i * paso->ancho, FILA(A->local, i) + paso->k - A->columnaInicio, (size_t)paso->ancho * sizeof(int));
+		}
+	}
+	if(malla->miFila == paso->raizB){
+		for(i = 0; i < paso->ancho; i++){
+			memcpy(panelB + (size_t)i * columnasB, FILA(B->local, paso->k - B->filaInicio + i), (size_t)columnasB * sizeof(int));
+		}
+	}
+	if(solicitudes != NULL){
+		MPI_Ibcast(panelA, filasA * paso->ancho, MPI_INT, paso->raizA, malla->fila, &solicitudes[0]);
+		MPI_Ibcast(panelB, paso->ancho * columnasB, MPI_INT, paso->raizB, malla->columna, &solicitudes[1]);
+	}
+	else{
+		MPI_Bcast(panelA, filasA * paso->ancho, MPI_INT, paso->raizA, malla->fila);
+		MPI_Bcast(panelB, paso->ancho * columnasB, MPI_INT, paso->raizB, malla->columna);
+	}
+}
+
+int gemmSumma(const struct mallaSumma * malla, const struct matrizDistribuida * A, const struct matrizDistribuida * B,
+		struct matrizDistribuida * C, int anchoPanel, int solapar, struct estadisticasSumma * estadisticas){
+	int m = C->local->filas, n = C->local->columnas, k = A->columnas;
+	int numeroPasos = 0, s, t, inicio, cantidad;
+	struct pasoSumma * pasos;
+	int * panelesA[2], * panelesB[2];
+	MPI_Request solicitudes[2][2];
+	double marca;
+
+	if(A->filas != C->filas || B->columnas != C->columnas || B->filas != k || anchoPanel < 1){
+		return -1;
+	}
+	memset(estadisticas, 0, sizeof(struct estadisticasSumma));
+	if(k == 0){
+		ponerCerosMatriz(C->local);
+		return 0;
+	}
+
+	// pasos: cortar K cada anchoPanel y en cada limite entre duenios de A o de B
+	pasos = (struct pasoSumma *)reservarSumma(((size_t)k / anchoPanel + malla->filasMalla + malla->columnasMalla + 1) * sizeof(struct pasoSumma));
+	for(inicio = 0; inicio < k; inicio += pasos[numeroPasos - 1].ancho){
+		struct pasoSumma * paso = &pasos[numeroPasos++];
+		int finA, finB;
+		paso->k = inicio;
+		paso->raizA = duenioSumma(k, malla->columnasMalla, inicio);
+		paso->raizB = duenioSumma(k, malla->filasMalla, inicio);
+		tramoSumma(k, malla->columnasMalla, paso->raizA, &finA, &cantidad);
+		finA += cantidad;
+		tramoSumma(k, malla->filasMalla, paso->raizB, &finB, &cantidad);
+		finB += cantidad;
+		paso->ancho = minimo(minimo(anchoPanel, k - inicio), minimo(finA, finB) - inicio);
+	}
+
+	for(s = 0; s < 2; s++){
+		panelesA[s] = (int *)reservarSumma((size_t)m * anchoPanel * sizeof(int));
+		panelesB[s] = (int *)reservarSumma((size_t)anchoPanel * n * sizeof(int));
+	}
+
+	if(solapar){
+		difundirPaneles(malla, A, B, &pasos[0], panelesA[0], panelesB[0], solicitudes[0]);
+	}
+	for(s = 0; s < numeroPasos; s++){
+		int actual = s % 2, siguiente = (s + 1) % 2, alto;
+		const struct pasoSumma * paso = &pasos[s];
+
+		marca = MPI_Wtime();
+		if(solapar){
+			// las difusiones del paso siguiente avanzan mientras se multiplica este
+			if(s + 1 < numeroPasos){
+				difundirPaneles(malla, A, B, &pasos[s + 1], panelesA[siguiente], panelesB[siguiente], solicitudes[siguiente]);
+			}
+			MPI_Waitall(2, solicitudes[actual], MPI_STATUSES_IGNORE);
+		}
+		else{
+			difundirPaneles(malla, A, B, paso, panelesA[actual], panelesB[actual], NULL);
+		}
+		estadisticas->tiempoEspera += MPI_Wtime() - marca;
+		estadisticas->bytesRecibidos += (malla->miColumna != paso->raizA ? (double)m * paso->ancho * sizeof(int) : 0)
+			+ (malla->miFila != paso->raizB ? (double)paso->ancho * n * sizeof(int) : 0);
+
+		alto = solapar ? (m + TRAMOS_CALCULO_SUMMA - 1) / TRAMOS_CALCULO_SUMMA : m;
+		for(t = 0; t < m; t += alto){
+			int bandera;
+			marca = MPI_Wtime();
+			gemmEntero32(minimo(alto, m - t), n, paso->ancho, 1, panelesA[actual] + (size_t)t * paso->ancho, paso->ancho,
+				panelesB[actual], n, s > 0, FILA(C->local, t), C->local->ld);
+			estadisticas->tiempoCalculo += MPI_Wtime() - marca;
+			if(solapar && s + 1 < numeroPasos){
+				MPI_Testall(2, solicitudes[siguiente], &bandera, MPI_STATUSES_IGNORE);
+			}
+		}
+	}
+	estadisticas->pasos = numeroPasos;
+
+	for(s = 0; s < 2; s++){
+		free(panelesA[s]);
+		free(panelesB[s]);
+	}
+	free(pasos);
+	return 0;
+}
+
+// parcial[t][filaInicio + i] = sum_j M[i][j] * v[t][columnaInicio + j]; los
+// vectores y el resultado tienen la longitud global
+static void productoVectoresDistribuido(const struct matrizDistribuida * M, const uint32_t * vectores, int longitud,
+		int cuantos, uint32_t * parcial, int longitudParcial){
+	int i;
+
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < M->local->filas; i++){
+		const uint32_t * fila = (const uint32_t *)FILA(M->local, i);
+		int t, j;
+		for(t = 0; t < cuantos; t++){
+			const uint32_t * v = vectores + (size_t)t * longitud + M->columnaInicio;
+			uint32_t suma = 0;
+			#pragma omp simd reduction(+:suma)
+			for(j = 0; j < M->local->columnas; j++){
+				suma += fila[j] * v[j];
+			}
+			parcial[(size_t)t * longitudParcial + M->filaInicio + i] = suma;
+		}
+	}
+}
+
+int verificarSumma(const struct mallaSumma * malla, const struct matrizDistribuida * A, const struct matrizDistribuida * B,
+		const struct matrizDistribuida * C, int repeticiones, uint64_t semilla){
+	int m = C->filas, n = C->columnas, k = A->columnas;
+	uint64_t clave = claveAleatoria(semilla);
+	uint32_t * r, * x, * yz;
+	size_t t;
+	int correcto = 1;
+
+	if(repeticiones < 1){
+		repeticiones = 1;
+	}
+	// todos generan los mismos r; x, y y z se suman entre todos los procesos
+	r = (uint32_t *)reservarSumma((size_t)repeticiones * n * sizeof(uint32_t));
+	x = (uint32_t *)reservarSumma((size_t)repeticiones * k * sizeof(uint32_t));
+	yz = (uint32_t *)reservarSumma((size_t)repeticiones * m * 2 * sizeof(uint32_t));
+	for(t = 0; t < (size_t)repeticiones * n; t++){
+		r[t] = (uint32_t)aleatorioContador(clave, t);
+	}
+	memset(x, 0, (size_t)repeticiones * k * sizeof(uint32_t));
+	memset(yz, 0, (size_t)repeticiones * m * 2 * sizeof(uint32_t));
+
+	// x = B r; cada fila de B se reparte entre una fila de la malla
+	productoVectoresDistribuido(B, r, n, repeticiones, x, k);
+	MPI_Allreduce(MPI_IN_PLACE, x, repeticiones * k, MPI_UINT32_T, MPI_SUM, malla->malla);
+	// y = A x en la primera mitad, z = C r en la segunda
+	productoVectoresDistribuido(A, x, k, repeticiones, yz, m);
+	productoVectoresDistribuido(C, r, n, repeticiones, yz + (size_t)repeticiones * m, m);
+	MPI_Allreduce(MPI_IN_PLACE, yz, repeticiones * m * 2, MPI_UINT32_T, MPI_SUM, malla->malla);
+	for(t = 0; t < (size_t)repeticiones * m && correcto; t++){
+		correcto = yz[t] == yz[(size_t)repeticiones * m + t];
+	}
+
+	free(r);
+	free(x);
+	free(yz);
+	return correcto;
+}
@@ -0,0 +1,85 @@
+/*
+ Multiplicacion distribuida con SUMMA sobre MPI
+
+ Los procesos forman una malla de filasMalla x columnasMalla (MPI_Dims_create
+ si no se da). A, B y C se reparten en bloques: el proceso (i, j) guarda las
+ filas del tramo i y las columnas del tramo j de cada matriz (tramoSumma), asi
+ que ninguno tiene la matriz entera y el tamanio maximo crece con los nodos.
+
+ SUMMA (van de Geijn y Watts) recorre la dimension K en paneles: en cada paso
+ la columna de procesos duenia del panel de A lo difunde por su fila de la
+ malla, la fila duenia del panel de B lo difunde por su columna, y cada
+ proceso suma el producto de los dos paneles a su bloque de C con gemmEntero32
+ (motor empaquetado, con los hilos de fijarHilosGemm). Un panel nunca cruza
+ el limite entre dos duenios, asi que cada paso tiene una sola raiz.
+
+ Solapamiento: los paneles van en dos buffers. Antes de multiplicar el paso s
+ se lanzan con MPI_Ibcast las difusiones del paso s + 1, y el bloque de C se
+ multiplica por tramos de filas llamando a MPI_Testall entre uno y otro para
+ que MPI avance la comunicacion mientras se calcula. Sin solapar se usa
+ MPI_Bcast y se espera cada panel antes de multiplicarlo, para comparar.
+
+ verificarSumma es el Freivalds de verificacion.h repartido: cada proceso
+ multiplica sus bloques por los vectores y los productos parciales se suman
+ con MPI_Allreduce (aritmetica modular de 32 bits, como gemmEntero32).
+
+ Se compila con mpicc (make mpi) y se prueba en una sola maquina:
+ mpirun -np 4 --oversubscribe ./multiplicacion_summa -n 2048
+*/
+#ifndef GEMM_SUMMA_H
+#define GEMM_SUMMA_H
+
+#include <stdint.h>
+#include <mpi.h>
+
+#include "matriz.h"
+
+struct mallaSumma{
+	MPI_Comm malla; // comunicador cartesiano de filasMalla x columnasMalla
+	MPI_Comm fila; // procesos de mi fila de la malla
+	MPI_Comm columna; // procesos de mi columna de la malla
+	int filasMalla;
+	int columnasMalla;
+	int miFila;
+	int miColumna;
+	int rango;
+	int procesos;
+};
+
+struct matrizDistribuida{
+	struct matriz * local; // bloque de este proceso
+	int filas; // globales
+	int columnas;
+	int filaInicio; // posicion del bloque local en la matriz global
+	int columnaInicio;
+};
+
+struct estadisticasSumma{
+	int pasos;
+	double tiempoCalculo; // en gemmEntero32
+	double tiempoEspera; // esperando paneles (MPI_Wait o MPI_Bcast)
+	double bytesRecibidos; // paneles de otros procesos
+};
+
+// filasMalla = 0: la elige MPI_Dims_create; devuelve -1 si no divide a los procesos
+int crearMallaSumma(MPI_Comm comunicador, int filasMalla, struct mallaSumma *);
+void liberarMallaSumma(struct mallaSumma *);
+
+// parte p de n repartido en partes casi iguales
+void tramoSumma(int n, int partes, int parte, int * inicio, int * cantidad);
+
+struct matrizDistribuida * crearMatrizDistribuida(const struct mallaSumma *, int filas, int columnas);
+void liberarMatrizDistribuida(struct matrizDistribuida *);
+// los mismos valores que inicializarMatrizAleatoria sobre la matriz global
+void inicializarMatrizDistribuida(struct matrizDistribuida *, uint64_t semilla, int minimo, int maximo);
+
+// C = A * B; anchoPanel columnas de A (filas de B) por paso. Devuelve -1 si
+// las formas no encajan. Todos los procesos de la malla tienen que llamarla
+int gemmSumma(const struct mallaSumma *, const struct matrizDistribuida * A, const struct matrizDistribuida * B,
+	struct matrizDistribuida * C, int anchoPanel, int solapar, struct estadisticasSumma *);
+
+// 1 en todos los procesos si C = A * B segun repeticiones vectores de Freivalds
+int verificarSumma(const struct mallaSumma *, const struct matrizDistribuida * A, const struct matrizDistribuida * B,
+	const struct matrizDistribuida * C, int repeticiones, uint64_t semilla);
+
+#endif
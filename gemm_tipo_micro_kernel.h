@@ -0,0 +1,86 @@
+/*
+ Plantilla del micro-kernel de un tipo para una ISA
+
+ gemm_tipo_plantilla.h la incluye una vez por ISA con NOMBRE_KERNEL,
+ BYTES_VECTOR (ancho de los registros) y OBJETIVO (atributo target) definidos.
+ Cada fila del azulejo de C (NR_TIPO acumuladores, una linea de cache) vive en
+ VECTORES_FILA registros; en cada paso de k se carga una fila del panel de B,
+ se ensancha al tipo del acumulador si hace falta y se suma a[i] * b a cada
+ fila. Al final el azulejo se multiplica por alfa y se guarda o se suma en C.
+*/
+
+#define VECTORES_FILA (ALINEACION_MATRIZ / BYTES_VECTOR)
+#define VECTOR_ACUMULADOR CON_SUFIJO(UNIR(NOMBRE_KERNEL, Acumulador))
+#define VECTOR_ENTRADA CON_SUFIJO(UNIR(NOMBRE_KERNEL, Entrada))
+
+typedef ACUMULADOR VECTOR_ACUMULADOR __attribute__((vector_size(BYTES_VECTOR)));
+typedef TIPO VECTOR_ENTRADA __attribute__((vector_size(BYTES_VECTOR / sizeof(ACUMULADOR) * sizeof(TIPO))));
+
+OBJETIVO
+static void CON_SUFIJO(NOMBRE_KERNEL)(int kc, const TIPO * panelA, const TIPO * panelB, ACUMULADOR alfa, ACUMULADOR * c, int ldc, int mr, int nr, int acumular){
+	VECTOR_ACUMULADOR acumulador[MR_TIPOS][VECTORES_FILA], b[VECTORES_FILA], fila;
+	ACUMULADOR azulejo[MR_TIPOS * NR_TIPO] __attribute__((aligned(ALINEACION_MATRIZ)));
+	ACUMULADOR a;
+	int i, j, k, v;
+
+	for(i = 0; i < MR_TIPOS; i++){
+		for(v = 0; v < VECTORES_FILA; v++){
+			acumulador[i][v] = (VECTOR_ACUMULADOR){0};
+		}
+	}
+	for(k = 0; k < kc; k++){
+		#pragma GCC unroll 4
+		for(v = 0; v < VECTORES_FILA; v++){
+			b[v] = __builtin_convertvector(((const VECTOR_ENTRADA *)(panelB + (size_t)k * NR_TIPO))[v], VECTOR_ACUMULADOR);
+		}
+		#pragma GCC unroll 6
+		for(i = 0; i < MR_TIPOS; i++){
+			a = panelA[(size_t)k * MR_TIPOS + i];
+			#pragma GCC unroll 4
+			for(v = 0; v < VECTORES_FILA; v++){
+				acumulador[i][v] += a * b[v];
+			}
+		}
+	}
+
+	if(alfa != 1){
+		for(i = 0; i < MR_TIPOS; i++){
+			for(v = 0; v < VECTORES_FILA; v++){
+				acumulador[i][v] *= alfa;
+			}
+		}
+	}
+
+	if(mr == MR_TIPOS && nr == NR_TIPO){
+		// azulejo completo: filas enteras sin pasar por memoria temporal
+		for(i = 0; i < MR_TIPOS; i++){
+			for(v = 0; v < VECTORES_FILA; v++){
+				ACUMULADOR * destino = c + (size_t)i * ldc + v * (BYTES_VECTOR / sizeof(ACUMULADOR));
+				if(acumular){
+					memcpy(&fila, destino, sizeof(fila));
+					acumulador[i][v] += fila;
+				}
+				memcpy(destino, &acumulador[i][v], sizeof(fila));
+			}
+		}
+		return;
+	}
+	memcpy(azulejo, acumulador, sizeof(azulejo));
+	for(i = 0; i < mr; i++){
+		for(j = 0; j < nr; j++){
+			if(acumular){
+				c[(size_t)i * ldc + j] += azulejo[i * NR_TIPO + j];
+			}
+			else{
+				c[(size_t)i * ldc + j] = azulejo[i * NR_TIPO + j];
+			}
+		}
+	}
+}
+
+#undef VECTORES_FILA
+#undef VECTOR_ACUMULADOR
+#undef VECTOR_ENTRADA
+#undef NOMBRE_KERNEL
+#undef BYTES_VECTOR
+#undef OBJETIVO
@@ -0,0 +1,305 @@
+/*
+ Plantilla del motor empaquetado para un tipo de elemento
+
+ No es un header normal: gemm_tipos.c la incluye una vez por tipo despues de
+ definir
+
+ 	TIPO         elemento de A y B
+ 	ACUMULADOR   elemento de C y de los acumuladores del micro-kernel
+ 	REFERENCIA   tipo con que verificar calcula los elementos de muestra
+ 	SUFIJO       se pega al nombre de cada funcion (multiplicarFloat, ...)
+ 	EPSILON      error relativo por suma en verificar (0 para enteros)
+ 	VALOR_ALEATORIO  valor para inicializar a partir de 64 bits aleatorios
+ 	FREIVALDS    tipo de los vectores de freivalds: uint64_t (modular, como
+ 	             desbordan los enteros) o double
+ 	VALOR_FREIVALDS  elemento del vector aleatorio de freivalds
+
+ y la plantilla los borra al final.
+*/
+
+#define CON_SUFIJO(nombre) UNIR(nombre, SUFIJO)
+
+// elementos del acumulador en una linea de cache: ancho del azulejo
+#define NR_TIPO ((int)(ALINEACION_MATRIZ / sizeof(ACUMULADOR)))
+
+
+// copiar el bloque mc x kc de A en micro-paneles de MR_TIPOS filas
+static void CON_SUFIJO(empaquetarA)(const struct matrizTipada * A, int fila, int columna, int mc, int kc, TIPO * panel){
+	int i, k, ir, mr;
+	const TIPO * filaA;
+
+	for(ir = 0; ir < mc; ir += MR_TIPOS){
+		mr = minimo(MR_TIPOS, mc - ir);
+		for(i = 0; i < mr; i++){
+			filaA = (const TIPO *)FILA_TIPADA(A, fila + ir + i) + columna;
+			for(k = 0; k < kc; k++){
+				panel[k * MR_TIPOS + i] = filaA[k];
+			}
+		}
+		for(i = mr; i < MR_TIPOS; i++){
+			for(k = 0; k < kc; k++){
+				panel[k * MR_TIPOS + i] = 0;
+			}
+		}
+		panel += MR_TIPOS * kc;
+	}
+}
+
+// copiar el bloque kc x nc de B en micro-paneles de NR_TIPO columnas
+static void CON_SUFIJO(empaquetarB)(const struct matrizTipada * B, int fila, int columna, int kc, int nc, TIPO * panel){
+	int j, k, jr, nr;
+	const TIPO * filaB;
+
+	for(jr = 0; jr < nc; jr += NR_TIPO){
+		nr = minimo(NR_TIPO, nc - jr);
+		for(k = 0; k < kc; k++){
+			filaB = (const TIPO *)FILA_TIPADA(B, fila + k) + columna + jr;
+			for(j = 0; j < nr; j++){
+				panel[k * NR_TIPO + j] = filaB[j];
+			}
+			for(j = nr; j < NR_TIPO; j++){
+				panel[k * NR_TIPO + j] = 0;
+			}
+		}
+		panel += NR_TIPO * kc;
+	}
+}
+
+// un micro-kernel por ISA, cada uno con vectores del ancho de sus registros
+#define NOMBRE_KERNEL microKernelBase
+#define BYTES_VECTOR 16
+#define OBJETIVO
+#include "gemm_tipo_micro_kernel.h"
+
+#define NOMBRE_KERNEL microKernelAvx2
+#define BYTES_VECTOR 32
+#define OBJETIVO __attribute__((target("avx2,fma")))
+#include "gemm_tipo_micro_kernel.h"
+
+#define NOMBRE_KERNEL microKernelAvx512
+#define BYTES_VECTOR 64
+#define OBJETIVO __attribute__((target("avx512f,avx512dq")))
+#include "gemm_tipo_micro_kernel.h"
+
+// C = beta * C; con beta = 0 no se lee C
+static void CON_SUFIJO(escalar)(struct matrizTipada * C, ACUMULADOR beta){
+	int i, j;
+	ACUMULADOR * fila;
+
+	for(i = 0; i < C->filas; i++){
+		fila = (ACUMULADOR *)FILA_TIPADA(C, i);
+		if(beta == 0){
+			memset(fila, 0, (size_t)C->columnas * sizeof(ACUMULADOR));
+			continue;
+		}
+		for(j = 0; j < C->columnas; j++){
+			fila[j] *= beta;
+		}
+	}
+}
+
+// C = alfa * A * B + beta * C (alfa y beta apuntan a un ACUMULADOR); el panel
+// de B se comparte y cada hilo empaqueta sus bloques de A
+static void CON_SUFIJO(gemm)(const void * pAlfa, const struct matrizTipada * A, const struct matrizTipada * B, const void * pBeta,
+		struct matrizTipada * C, int numeroHilos){
+	void (*microKernel)(int, const TIPO *, const TIPO *, ACUMULADOR, ACUMULADOR *, int, int, int, int);
+	ACUMULADOR alfa = *(const ACUMULADOR *)pAlfa, beta = *(const ACUMULADOR *)pBeta;
+	int m = A->filas, k = A->columnas, n = B->columnas;
+	int mcMax, kcMax, ncMax, jc, pc, ic, marcaPaneles;
+	int sumarSobreC = beta != 0;
+	size_t elementosA, elementosB;
+	TIPO * paneles;
+
+	if(k == 0 || alfa == 0){
+		if(beta != 1){
+			CON_SUFIJO(escalar)(C, beta);
+		}
+		return;
+	}
+	if(beta != 0 && beta != 1){
+		CON_SUFIJO(escalar)(C, beta);
+	}
+	if(numeroHilos < 1){
+		numeroHilos = 1;
+	}
+	switch(nivelIsaTipos()){
+		case 2: microKernel = CON_SUFIJO(microKernelAvx512); break;
+		case 1: microKernel = CON_SUFIJO(microKernelAvx2); break;
+		default: microKernel = CON_SUFIJO(microKernelBase); break;
+	}
+
+	bloquesTipos(sizeof(TIPO), NR_TIPO, m, k, n, &mcMax, &kcMax, &ncMax);
+	elementosA = alinearElementos((size_t)(mcMax + MR_TIPOS) * kcMax, sizeof(TIPO));
+	elementosB = alinearElementos((size_t)(ncMax + NR_TIPO) * kcMax, sizeof(TIPO));
+	paneles = (TIPO *)tomarBloque((elementosB + numeroHilos * elementosA) * sizeof(TIPO), 0, &marcaPaneles);
+
+	for(jc = 0; jc < n; jc += ncMax){
+		int nc = minimo(ncMax, n - jc);
+		for(pc = 0; pc < k; pc += kcMax){
+			int kc = minimo(kcMax, k - pc);
+			CON_SUFIJO(empaquetarB)(B, pc, jc, kc, nc, paneles);
+
+			#pragma omp parallel for num_threads(numeroHilos) schedule(dynamic, 1) if(numeroHilos > 1)
+			for(ic = 0; ic < m; ic += mcMax){
+				TIPO * panelA = paneles + elementosB + omp_get_thread_num() * elementosA;
+				int mc = minimo(mcMax, m - ic);
+				int ir, jr;
+
+				CON_SUFIJO(empaquetarA)(A, ic, pc, mc, kc, panelA);
+				for(jr = 0; jr < nc; jr += NR_TIPO){
+					for(ir = 0; ir < mc; ir += MR_TIPOS){
+						microKernel(kc, panelA + (size_t)ir * kc, paneles + (size_t)jr * kc, alfa,
+							(ACUMULADOR *)FILA_TIPADA(C, ic + ir) + jc + jr, C->ld,
+							minimo(MR_TIPOS, mc - ir), minimo(NR_TIPO, nc - jr), pc > 0 || sumarSobreC);
+					}
+				}
+			}
+		}
+	}
+	devolverBloque(paneles, (elementosB + numeroHilos * elementosA) * sizeof(TIPO), marcaPaneles);
+}
+
+// C = A * B
+static void CON_SUFIJO(multiplicar)(const struct matrizTipada * A, const struct matrizTipada * B, struct matrizTipada * C, int numeroHilos){
+	ACUMULADOR uno = 1, cero = 0;
+	CON_SUFIJO(gemm)(&uno, A, B, &cero, C, numeroHilos);
+}
+
+// en paralelo con el generador por contador; la semilla sale de rand() como
+// en inicializarMatricesCuadradas
+static void CON_SUFIJO(inicializar)(struct matrizTipada * matriz){
+	uint64_t clave = claveAleatoria(((uint64_t)rand() << 31) ^ (uint64_t)rand());
+	int i;
+
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < matriz->filas; i++){
+		TIPO * fila = (TIPO *)FILA_TIPADA(matriz, i);
+		uint64_t contador = (uint64_t)i * matriz->columnas;
+		int j;
+		for(j = 0; j < matriz->columnas; j++){
+			fila[j] = VALOR_ALEATORIO(aleatorioContador(clave, contador + j));
+		}
+	}
+}
+
+// recalcular muestras elementos de C al azar; los enteros deben coincidir
+// exactamente y los flotantes dentro de k * EPSILON * sum |a * b|
+static int CON_SUFIJO(verificar)(const struct matrizTipada * A, const struct matrizTipada * B, const struct matrizTipada * C, int muestras){
+	int s, i, j, p;
+	REFERENCIA suma;
+	double magnitud, diferencia;
+	TIPO a, b;
+
+	if(C->filas == 0 || C->columnas == 0){
+		return 1;
+	}
+	for(s = 0; s < muestras; s++){
+		i = rand() % C->filas;
+		j = rand() % C->columnas;
+		suma = 0;
+		magnitud = 0.0;
+		for(p = 0; p < A->columnas; p++){
+			a = ((const TIPO *)FILA_TIPADA(A, i))[p];
+			b = ((const TIPO *)FILA_TIPADA(B, p))[j];
+			suma += (REFERENCIA)a * b;
+			magnitud += fabs((double)a * b);
+		}
+		diferencia = fabs((double)(suma - (REFERENCIA)((const ACUMULADOR *)FILA_TIPADA(C, i))[j]));
+		if(diferencia > EPSILON * A->columnas * magnitud){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// Freivalds (verificacion.h): compara C r con A (B r) para repeticiones
+// vectores r, leyendo cada fila una vez para todos; los enteros deben
+// coincidir exactamente y los flotantes dentro de (k + n) * EPSILON *
+// (|A| (|B| r)), la cota del error de C mas el de las dos sumas (r >= 0)
+__attribute__((target_clones("arch=skylake-avx512", "avx2", "default")))
+static int CON_SUFIJO(freivalds)(const struct matrizTipada * A, const struct matrizTipada * B, const struct matrizTipada * C,
+		int repeticiones, uint64_t semilla){
+	int m = C->filas, n = C->columnas, k = A->columnas;
+	uint64_t clave = claveAleatoria(semilla);
+	FREIVALDS * r, * x;
+	double * magnitudX;
+	int i, p, fallos = 0;
+	size_t t, j;
+
+	if(A->filas != m || B->filas != k || B->columnas != n){
+		return 0;
+	}
+	if(repeticiones < 1){
+		repeticiones = 1;
+	}
+	r = (FREIVALDS *)malloc(((size_t)repeticiones * n + 1) * sizeof(FREIVALDS));
+	x = (FREIVALDS *)malloc(((size_t)repeticiones * k + 1) * sizeof(FREIVALDS));
+	magnitudX = (double *)malloc(((size_t)repeticiones * k + 1) * sizeof(double));
+	if(r == NULL || x == NULL || magnitudX == NULL){
+		perror("No se pudo reservar memoria para la verificacion");
+		exit(1);
+	}
+	for(t = 0; t < (size_t)repeticiones * n; t++){
+		r[t] = VALOR_FREIVALDS(aleatorioContador(clave, t));
+	}
+
+	// x = B r
+	#pragma omp parallel for schedule(static) private(t, j)
+	for(p = 0; p < k; p++){
+		const TIPO * filaB = (const TIPO *)FILA_TIPADA(B, p);
+		for(t = 0; t < (size_t)repeticiones; t++){
+			const FREIVALDS * v = r + t * n;
+			FREIVALDS suma = 0;
+			double magnitud = 0;
+			#pragma omp simd reduction(+:suma, magnitud)
+			for(j = 0; j < (size_t)n; j++){
+				suma += (FREIVALDS)filaB[j] * v[j];
+				if(EPSILON > 0){
+					magnitud += fabs((double)filaB[j]) * (double)v[j];
+				}
+			}
+			x[t * k + p] = suma;
+			magnitudX[t * k + p] = magnitud;
+		}
+	}
+	// A x contra C r
+	#pragma omp parallel for schedule(static) private(p, t, j) reduction(+:fallos)
+	for(i = 0; i < m; i++){
+		const TIPO * filaA = (const TIPO *)FILA_TIPADA(A, i);
+		const ACUMULADOR * filaC = (const ACUMULADOR *)FILA_TIPADA(C, i);
+		for(t = 0; t < (size_t)repeticiones; t++){
+			FREIVALDS ax = 0, cr = 0;
+			double magnitud = 0;
+			#pragma omp simd reduction(+:ax, magnitud)
+			for(p = 0; p < k; p++){
+				ax += (FREIVALDS)filaA[p] * x[t * k + p];
+				if(EPSILON > 0){
+					magnitud += fabs((double)filaA[p]) * magnitudX[t * k + p];
+				}
+			}
+			#pragma omp simd reduction(+:cr)
+			for(j = 0; j < (size_t)n; j++){
+				cr += (FREIVALDS)filaC[j] * r[t * n + j];
+			}
+			// con !(<=) un NaN en C tambien falla
+			if(ax != cr && !(fabs((double)(ax - cr)) <= (double)EPSILON * (k + n) * magnitud)){
+				fallos++;
+			}
+		}
+	}
+	free(r);
+	free(x);
+	free(magnitudX);
+	return fallos == 0;
+}
+
+#undef NR_TIPO
+#undef CON_SUFIJO
+#undef TIPO
+#undef ACUMULADOR
+#undef REFERENCIA
+#undef SUFIJO
+#undef EPSILON
+#undef VALOR_ALEATORIO
+#undef FREIVALDS
+#undef VALOR_FREIVALDS
@@ -0,0 +1,171 @@
+// motor empaquetado generico: float, double, int32 con acumulador int64 e int64
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <float.h>
+#include <math.h>
+#include <omp.h>
+
+#include "gemm_tipos.h"
+#include "aleatorio_contador.h"
+#include "gemm_empaquetado.h"
+#include "paginas_grandes.h"
+#include "pool_memoria.h"
+#include "nucleos_simd.h"
+
+#define UNIR(a, b) UNIR_(a, b)
+#define UNIR_(a, b) a##b
+
+// valores de hasta 2^19 en modulo: los productos caben en 2^38 y la suma de
+// millones de ellos sigue lejos de desbordar un int64; x es un valor de
+// aleatorioContador
+#define ENTERO_ALEATORIO(x) ((int64_t)enteroEnRango(x, 1 << 20) - (1 << 19))
+#define FLOTANTE_ALEATORIO(x) (dobleUnitario(x) * 2.0 - 1.0)
+
+static int minimo(int a, int b){
+	return a < b ? a : b;
+}
+
+// 2 = AVX-512, 1 = AVX2, 0 = base; sigue la eleccion de nucleos_simd.c (y
+// MATRIZ_ISA), y el de AVX-512 pide ademas AVX-512DQ por los productos int64
+int nivelIsaTipos(void){
+	if(strcmp(nucleosActuales->nombre, "avx512") == 0){
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512dq") ? 2 : 1;
+	}
+	return strcmp(nucleosActuales->nombre, "avx2") == 0;
+}
+
+// bloques del motor int adaptados al tipo: kc se escala para que el bloque de
+// A ocupe los mismos bytes, mc y nc se redondean al azulejo y nada excede la
+// matriz
+static void bloquesTipos(size_t tamanio, int nr, int m, int k, int n, int * mc, int * kc, int * nc){
+	*kc = (int)(configuracionGemmActual.kc * sizeof(int) / tamanio);
+	*kc = minimo(*kc > 0 ? *kc : 1, k);
+	*mc = minimo(configuracionGemmActual.mc, m);
+	*mc = (*mc + MR_TIPOS - 1) / MR_TIPOS * MR_TIPOS;
+	*nc = minimo(configuracionGemmActual.nc, n);
+	*nc = (*nc + nr - 1) / nr * nr;
+}
+
+// redondear un numero de elementos a lineas de cache completas
+static size_t alinearElementos(size_t elementos, size_t tamanio){
+	size_t porLinea = ALINEACION_MATRIZ / tamanio;
+	return (elementos + porLinea - 1) / porLinea * porLinea;
+}
+
+#define TIPO float
+#define ACUMULADOR float
+#define REFERENCIA double
+#define SUFIJO Float
+#define EPSILON FLT_EPSILON
+#define VALOR_ALEATORIO(x) (float)FLOTANTE_ALEATORIO(x)
+#define FREIVALDS double
+#define VALOR_FREIVALDS(x) dobleUnitario(x)
+#include "gemm_tipo_plantilla.h"
+
+#define TIPO double
+#define ACUMULADOR double
+#define REFERENCIA double
+#define SUFIJO Double
+#define EPSILON DBL_EPSILON
+#define VALOR_ALEATORIO(x) FLOTANTE_ALEATORIO(x)
+#define FREIVALDS double
+#define VALOR_FREIVALDS(x) dobleUnitario(x)
+#include "gemm_tipo_plantilla.h"
+
+#define TIPO int32_t
+#define ACUMULADOR int64_t
+#define REFERENCIA int64_t
+#define SUFIJO Int32
+#define EPSILON 0
+#define VALOR_ALEATORIO(x) ENTERO_ALEATORIO(x)
+#define FREIVALDS uint64_t
+#define VALOR_FREIVALDS(x) (x)
+#include "gemm_tipo_plantilla.h"
+
+#define TIPO int64_t
+#define ACUMULADOR int64_t
+#define REFERENCIA int64_t
+#define SUFIJO Int64
+#define EPSILON 0
+#define VALOR_ALEATORIO(x) ENTERO_ALEATORIO(x)
+#define FREIVALDS uint64_t
+#define VALOR_FREIVALDS(x) (x)
+#include "gemm_tipo_plantilla.h"
+
+const struct motorTipo motoresTipo[] = {
+	{"float", sizeof(float), sizeof(float), multiplicarFloat, gemmFloat, inicializarFloat, verificarFloat, freivaldsFloat},
+	{"double", sizeof(double), sizeof(double), multiplicarDouble, gemmDouble, inicializarDouble, verificarDouble, freivaldsDouble},
+	{"int32_acc64", sizeof(int32_t), sizeof(int64_t), multiplicarInt32, gemmInt32, inicializarInt32, verificarInt32, freivaldsInt32},
+	{"int64", sizeof(int64_t), sizeof(int64_t), multiplicarInt64, gemmInt64, inicializarInt64, verificarInt64, freivaldsInt64},
+};
+
+const int numeroMotoresTipo = sizeof(motoresTipo) / sizeof(motoresTipo[0]);
+
+// NULL si no hay un tipo con ese nombre
+const struct motorTipo * buscarMotorTipo(const char * nombre){
+	int i;
+	for(i = 0; i < numeroMotoresTipo; i++){
+		if(strcmp(motoresTipo[i].nombre, nombre) == 0){
+			return &motoresTipo[i];
+		}
+	}
+	return NULL;
+}
+
+// redondear el numero de columnas a una linea de cache de elementos del tamanio dado
+int calcularLdTipada(int columnas, size_t tamanioElemento){
+	int porLinea = (int)(ALINEACION_MATRIZ / tamanioElemento);
+	return (columnas + porLinea - 1) / porLinea * porLinea;
+}
+
+struct matrizTipada * crearMatrizTipada(int filas, int columnas, size_t tamanioElemento){
+	struct matrizTipada * matriz = (struct matrizTipada *)malloc(sizeof(struct matrizTipada));
+	size_t bytes;
+
+	if(matriz == NULL){
+		perror("No se pudo reservar memoria para la matriz");
+		exit(1);
+	}
+	matriz->filas = filas;
+	matriz->columnas = columnas;
+	matriz->ld = calcularLdTipada(columnas, tamanioElemento);
+	matriz->tamanioElemento = tamanioElemento;
+	bytes = (size_t)filas * matriz->ld * tamanioElemento;
+	matriz->datos = tomarBloque(bytes, 1, &matriz->propietaria);
+	return matriz;
+}
+
+// submatriz de filas x columnas que empieza en (fila, columna), sin copiar
+struct matrizTipada vistaMatrizTipada(const struct matrizTipada * matriz, int fila, int columna, int filas, int columnas){
+	struct matrizTipada vista = *matriz;
+	vista.datos = (char *)FILA_TIPADA(matriz, fila) + (size_t)columna * matriz->tamanioElemento;
+	vista.filas = filas;
+	vista.columnas = columnas;
+	vista.propietaria = 0;
+	return vista;
+}
+
+// ver un bloque de memoria ajeno como matriz tipada
+struct matrizTipada envolverMatrizTipada(void * datos, int filas, int columnas, int ld, size_t tamanioElemento){
+	struct matrizTipada vista;
+	vista.datos = datos;
+	vista.filas = filas;
+	vista.columnas = columnas;
+	vista.ld = ld;
+	vista.tamanioElemento = tamanioElemento;
+	vista.propietaria = 0;
+	return vista;
+}
+
+void liberarMatrizTipada(struct matrizTipada * matriz){
+	if(matriz == NULL){
+		return;
+	}
+	if(matriz->propietaria){
+		devolverBloque(matriz->datos, (size_t)matriz->filas * matriz->ld * matriz->tamanioElemento, matriz->propietaria);
+	}
+	free(matriz);
+}
@@ -0,0 +1,76 @@
+/*
+ Motor empaquetado generico por tipo de elemento
+
+ El motor de gemm_empaquetado.c trabaja solo con int y acumula en int, asi que
+ el acumulado se desborda con N grande o valores grandes y no sirve para datos
+ de punto flotante. Este motor repite el mismo esquema (paneles de A y B
+ empaquetados, micro-kernel de MR_TIPOS x NR en registros) para cada tipo:
+
+ 	float        A, B y C float
+ 	double       A, B y C double
+ 	int32_acc64  A y B int32, C int64: cada producto se ensancha antes de sumar
+ 	int64        A, B y C int64
+
+ El codigo de cada tipo sale de gemm_tipo_plantilla.h, que gemm_tipos.c
+ incluye una vez por tipo. El micro-kernel usa vectores de 64 bytes del
+ acumulador (extensiones vectoriales de GCC) y se compila para AVX-512, AVX2
+ y la base x86-64; se elige al llamar segun los kernels de nucleos_simd.c,
+ asi que MATRIZ_ISA tambien fija el de este motor.
+
+ Igual que gemmEmpaquetada, gemm calcula C = alfa * A * B + beta * C con A de
+ M x K y B de K x N; alfa se aplica a cada azulejo antes de guardarlo en C.
+
+ El tipo se elige en tiempo de ejecucion por nombre (buscarMotorTipo) y todas
+ las funciones reciben matrices tipadas: datos sin tipo mas el tamanio del
+ elemento, con las filas alineadas a ALINEACION_MATRIZ.
+*/
+#ifndef GEMM_TIPOS_H
+#define GEMM_TIPOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "matriz.h"
+
+// filas del azulejo de C en registros; NR es una linea de cache del acumulador
+#define MR_TIPOS 6
+
+struct matrizTipada{
+	void * datos;
+	int filas;
+	int columnas;
+	int ld; // en elementos
+	size_t tamanioElemento;
+	int propietaria; // como en struct matriz: marca de pool_memoria.h, 0 en las vistas
+};
+
+#define FILA_TIPADA(m, i) ((void *)((char *)(m)->datos + (size_t)(i) * (m)->ld * (m)->tamanioElemento))
+
+struct motorTipo{
+	const char * nombre;
+	size_t tamanioEntrada; // elementos de A y B
+	size_t tamanioResultado; // elementos de C
+	void (*multiplicar)(const struct matrizTipada * A, const struct matrizTipada * B, struct matrizTipada * C, int numeroHilos);
+	// C = alfa * A * B + beta * C; alfa y beta apuntan a un valor del tipo de C
+	void (*gemm)(const void * alfa, const struct matrizTipada * A, const struct matrizTipada * B, const void * beta,
+		struct matrizTipada * C, int numeroHilos);
+	void (*inicializar)(struct matrizTipada *); // valores aleatorios que no desbordan el acumulador
+	int (*verificar)(const struct matrizTipada * A, const struct matrizTipada * B, const struct matrizTipada * C, int muestras);
+	// Freivalds con repeticiones vectores aleatorios (verificacion.h)
+	int (*freivalds)(const struct matrizTipada * A, const struct matrizTipada * B, const struct matrizTipada * C,
+		int repeticiones, uint64_t semilla);
+};
+
+extern const struct motorTipo motoresTipo[];
+extern const int numeroMotoresTipo;
+
+const struct motorTipo * buscarMotorTipo(const char * nombre);
+int nivelIsaTipos(void); // version de los kernels generados: 2 AVX-512, 1 AVX2, 0 base
+
+int calcularLdTipada(int columnas, size_t tamanioElemento);
+struct matrizTipada * crearMatrizTipada(int filas, int columnas, size_t tamanioElemento);
+struct matrizTipada vistaMatrizTipada(const struct matrizTipada *, int fila, int columna, int filas, int columnas);
+struct matrizTipada envolverMatrizTipada(void * datos, int filas, int columnas, int ld, size_t tamanioElemento);
+void liberarMatrizTipada(struct matrizTipada *);
+
+#endif
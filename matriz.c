@@ -0,0 +1,339 @@
+// matriz contigua y alineada, compartida por todas las variantes
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <immintrin.h>
+
+#include "matriz.h"
+#include "aleatorio_contador.h"
+#include "paginas_grandes.h"
+#include "pool_memoria.h"
+
+// lado de los bloques de la transposicion: dos bloques de 64 x 64 int (32 KB)
+// caben en L1/L2 junto con las lineas que se estan escribiendo
+#define LADO_TRANSPOSICION 64
+// por debajo de esto (elementos) los hilos cuestan mas de lo que ahorran
+#define UMBRAL_TRANSPOSICION_PARALELA (256 * 256)
+
+static int minimo(int a, int b){
+	return a < b ? a : b;
+}
+
+// redondear el numero de columnas a un multiplo de la linea de cache
+int calcularLd(int columnas){
+	int enterosPorLinea = ALINEACION_MATRIZ / sizeof(int);
+	return (columnas + enterosPorLinea - 1) / enterosPorLinea * enterosPorLinea;
+}
+
+// bytes que ocupa una matriz con su relleno de fila
+size_t bytesMatriz(int filas, int columnas){
+	return (size_t)filas * calcularLd(columnas) * sizeof(int);
+}
+
+// crear una matriz en un solo bloque alineado (en paginas grandes si se
+// pidieron, del pool de memoria si esta activo)
+struct matriz * crearMatriz(int filas, int columnas){
+	struct matriz * matriz = (struct matriz *)malloc(sizeof(struct matriz));
+
+	if(matriz == NULL){
+		perror("No se pudo reservar memoria para la matriz");
+		exit(1);
+	}
+
+	matriz->datos = (int *)tomarBloque(bytesMatriz(filas, columnas), 1, &matriz->propietaria);
+	matriz->filas = filas;
+	matriz->columnas = columnas;
+	matriz->ld = calcularLd(columnas);
+	return matriz;
+}
+
+// liberar una matriz creada con crearMatriz
+void liberarMemoriaMatriz(struct matriz * matriz){
+	if(matriz == NULL){
+		return;
+	}
+	if(matriz->propietaria){
+		devolverBloque(matriz->datos, bytesMatriz(matriz->filas, matriz->columnas), matriz->propietaria);
+	}
+	free(matriz);
+}
+
+int paginasMatriz(const struct matriz * matriz){
+	return matriz->propietaria ? MODO_MARCA(matriz->propietaria) : -1;
+}
+
+// submatriz de filas x columnas que empieza en (fila, columna), sin copiar
+struct matriz vistaMatriz(const struct matriz * matriz, int fila, int columna, int filas, int columnas){
+	struct matriz vista;
+	vista.datos = matriz->datos + (size_t)fila * matriz->ld + columna;
+	vista.filas = filas;
+	vista.columnas = columnas;
+	vista.ld = matriz->ld;
+	vista.propietaria = 0;
+	return vista;
+}
+
+// ver un bloque de memoria ajeno (p. ej. memoria compartida) como matriz
+struct matriz envolverMatriz(int * datos, int filas, int columnas, int ld){
+	struct matriz vista;
+	vista.datos = datos;
+	vista.filas = filas;
+	vista.columnas = columnas;
+	vista.ld = ld;
+	vista.propietaria = 0;
+	return vista;
+}
+
+// llenar de 0s una matriz (o una vista) fila por fila
+void ponerCerosMatriz(struct matriz * matriz){
+	int i;
+	if(matriz->ld == matriz->columnas || matriz->propietaria){
+		memset(matriz->datos, 0, (size_t)matriz->filas * matriz->ld * sizeof(int));
+		return;
+	}
+	for(i = 0; i < matriz->filas; i++){
+		memset(FILA(matriz, i), 0, matriz->columnas * sizeof(int));
+	}
+}
+
+// copiar el bloque de 8 x 8 que empieza en o (filas de ldo) transpuesto en d
+// (filas de ldd); con AVX2 son 8 registros y 24 shuffles
+__attribute__((target("avx2")))
+static void transponer8x8Avx2(const int * o, int ldo, int * d, int ldd){
+	__m256i r0 = _mm256_loadu_si256((const __m256i *)(o + 0 * (size_t)ldo));
+	__m256i r1 = _mm256_loadu_si256((const __m256i *)(o + 1 * (size_t)ldo));
+	__m256i r2 = _mm256_loadu_si256((const __m256i *)(o + 2 * (size_t)ldo));
+	__m256i r3 = _mm256_loadu_si256((const __m256i *)(o + 3 * (size_t)ldo));
+	__m256i r4 = _mm256_loadu_si256((const __m256i *)(o + 4 * (size_t)ldo));
+	__m256i r5 = _mm256_loadu_si256((const __m256i *)(o + 5 * (size_t)ldo));
+	__m256i r6 = _mm256_loadu_si256((const __m256i *)(o + 6 * (size_t)ldo));
+	__m256i r7 = _mm256_loadu_si256((const __m256i *)(o + 7 * (size_t)ldo));
+	__m256i t0, t1, t2, t3, t4, t5, t6, t7;
+
+	// pares de filas intercalados de a 32 bits, despues de a 64 y al final
+	// se cruzan las mitades de 128 bits
+	t0 = _mm256_unpacklo_epi32(r0, r1);
+	t1 = _mm256_unpackhi_epi32(r0, r1);
+	t2 = _mm256_unpacklo_epi32(r2, r3);
+	t3 = _mm256_unpackhi_epi32(r2, r3);
+	t4 = _mm256_unpacklo_epi32(r4, r5);
+	t5 = _mm256_unpackhi_epi32(r4, r5);
+	t6 = _mm256_unpacklo_epi32(r6, r7);
+	t7 = _mm256_unpackhi_epi32(r6, r7);
+	r0 = _mm256_unpacklo_epi64(t0, t2);
+	r1 = _mm256_unpackhi_epi64(t0, t2);
+	r2 = _mm256_unpacklo_epi64(t1, t3);
+	r3 = _mm256_unpackhi_epi64(t1, t3);
+	r4 = _mm256_unpacklo_epi64(t4, t6);
+	r5 = _mm256_unpackhi_epi64(t4, t6);
+	r6 = _mm256_unpacklo_epi64(t5, t7);
+	r7 = _mm256_unpackhi_epi64(t5, t7);
+	_mm256_storeu_si256((__m256i *)(d + 0 * (size_t)ldd), _mm256_permute2x128_si256(r0, r4, 0x20));
+	_mm256_storeu_si256((__m256i *)(d + 1 * (size_t)ldd), _mm256_permute2x128_si256(r1, r5, 0x20));
+	_mm256_storeu_si256((__m256i *)(d + 2 * (size_t)ldd), _mm256_permute2x128_si256(r2, r6, 0x20));
+	_mm256_storeu_si256((__m256i *)(d + 3 * (size_t)ldd), _mm256_permute2x128_si256(r3, r7, 0x20));
+	_mm256_storeu_si256((__m256i *)(d + 4 * (size_t)ldd), _mm256_permute2x128_si256(r0, r4, 0x31));
+	_mm256_storeu_si256((__m256i *)(d + 5 * (size_t)ldd), _mm256_permute2x128_si256(r1, r5, 0x31));
+	_mm256_storeu_si256((__m256i *)(d + 6 * (size_t)ldd), _mm256_permute2x128_si256(r2, r6, 0x31));
+	_mm256_storeu_si256((__m256i *)(d + 7 * (size_t)ldd), _mm256_permute2x128_si256(r3, r7, 0x31));
+}
+
+// lo mismo sin SIMD; o y d no pueden solaparse
+static void transponer8x8Escalar(const int * o, int ldo, int * d, int ldd){
+	int i, j;
+	for(i = 0; i < 8; i++){
+		for(j = 0; j < 8; j++){
+			d[(size_t)j * ldd + i] = o[(size_t)i * ldo + j];
+		}
+	}
+}
+
+typedef void (*transponer8x8)(const int *, int, int *, int);
+
+static transponer8x8 transponerElegido = transponer8x8Escalar;
+
+// AVX2 si la CPU lo tiene, salvo que MATRIZ_ISA pida escalar o sse41: la
+// misma variable que elige los kernels de nucleos_simd.h, leida aqui porque
+// matriz.c se enlaza tambien sin nucleos_simd.c
+__attribute__((constructor))
+static void leerIsaTransposicion(void){
+	const char * forzado = getenv("MATRIZ_ISA");
+
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")){
+		transponerElegido = transponer8x8Avx2;
+	}
+	if(forzado != NULL && (strcmp(forzado, "escalar") == 0 || strcmp(forzado, "sse41") == 0)){
+		transponerElegido = transponer8x8Escalar;
+	}
+}
+
+// bloque de filas x columnas (hasta LADO_TRANSPOSICION) de o transpuesto en d:
+// las partes de 8 x 8 con el kernel y los bordes elemento por elemento
+static void transponerBloque(transponer8x8 kernel, const int * o, int ldo, int * d, int ldd, int filas, int columnas){
+	int i, j, filasCompletas = filas & ~7, columnasCompletas = columnas & ~7;
+
+	// de a 16 filas de o: los dos azulejos de 8 x 8 seguidos completan una
+	// linea de 64 bytes de cada fila de d antes de pasar a la siguiente
+	for(i = 0; i + 16 <= filasCompletas; i += 16){
+		for(j = 0; j < columnasCompletas; j += 8){
+			kernel(o + (size_t)i * ldo + j, ldo, d + (size_t)j * ldd + i, ldd);
+			kernel(o + (size_t)(i + 8) * ldo + j, ldo, d + (size_t)j * ldd + i + 8, ldd);
+		}
+	}
+	for(; i < filasCompletas; i += 8){
+		for(j = 0; j < columnasCompletas; j += 8){
+			kernel(o + (size_t)i * ldo + j, ldo, d + (size_t)j * ldd + i, ldd);
+		}
+	}
+	for(i = 0; i < filas; i++){
+		for(j = i < filasCompletas ? columnasCompletas : 0; j < columnas; j++){
+			d[(size_t)j * ldd + i] = o[(size_t)i * ldo + j];
+		}
+	}
+}
+
+// escribir la transpuesta de origen en destino (columnas x filas), sin liberar
+// nada, por bloques de LADO_TRANSPOSICION x LADO_TRANSPOSICION:
+// origen se lee por filas dentro de cada bloque y el bloque transpuesto cabe
+// en L1, asi que ni la lectura ni la escritura saltan de linea en cada
+// elemento. Cada hilo recorre franjas de filas del origen, que asi se lee en
+// orden y el prefetcher la sigue
+void transponerMatrizEn(const struct matriz * origen, struct matriz * destino){
+	transponer8x8 kernel = transponerElegido;
+	int bi, bj;
+
+	#pragma omp parallel for schedule(static) private(bi) if((size_t)destino->filas * destino->columnas > UMBRAL_TRANSPOSICION_PARALELA)
+	for(bj = 0; bj < destino->columnas; bj += LADO_TRANSPOSICION){
+		for(bi = 0; bi < destino->filas; bi += LADO_TRANSPOSICION){
+			// bloque (bi, bj) del destino = bloque (bj, bi) del origen transpuesto
+			transponerBloque(kernel, &ELEMENTO(origen, bj, bi), origen->ld, &ELEMENTO(destino, bi, bj), destino->ld,
+				minimo(LADO_TRANSPOSICION, destino->columnas - bj), minimo(LADO_TRANSPOSICION, destino->filas - bi));
+		}
+	}
+}
+
+// intercambiar el bloque (bi, bj) con el (bj, bi) transponiendo los dos; en
+// la diagonal (bi == bj) se transpone el bloque sobre si mismo. Cada bloque de
+// 8 x 8 se copia a la pila antes de escribir encima
+static void intercambiarBloques(transponer8x8 kernel, struct matriz * matriz, int bi, int bj){
+	int alto = minimo(LADO_TRANSPOSICION, matriz->filas - bi), ancho = minimo(LADO_TRANSPOSICION, matriz->filas - bj);
+	int p[64] __attribute__((aligned(32))), q[64] __attribute__((aligned(32)));
+	int i, j, t;
+	int * a, * b;
+
+	for(i = 0; i < alto; i += 8){
+		for(j = bi == bj ? i : 0; j < ancho; j += 8){
+			a = &ELEMENTO(matriz, bi + i, bj + j);
+			b = &ELEMENTO(matriz, bj + j, bi + i);
+			if(i + 8 <= alto && j + 8 <= ancho){
+				// p = a^T y q = b^T, despues cada uno en el lugar del otro
+				kernel(a, matriz->ld, p, 8);
+				kernel(b, matriz->ld, q, 8);
+				for(t = 0; t < 8; t++){
+					memcpy(b + (size_t)t * matriz->ld, p + t * 8, 8 * sizeof(int));
+					memcpy(a + (size_t)t * matriz->ld, q + t * 8, 8 * sizeof(int));
+				}
+			}
+			else{
+				// borde: intercambio elemento por elemento, solo los que estan por
+				// encima de la diagonal para no deshacer el intercambio
+				int filas = minimo(8, alto - i), columnas = minimo(8, ancho - j), x, y;
+				for(x = 0; x < filas; x++){
+					for(y = 0; y < columnas; y++){
+						if(bj + j + y <= bi + i + x){
+							continue;
+						}
+						t = a[(size_t)x * matriz->ld + y];
+						a[(size_t)x * matriz->ld + y] = b[(size_t)y * matriz->ld + x];
+						b[(size_t)y * matriz->ld + x] = t;
+					}
+				}
+			}
+		}
+	}
+}
+
+// transponer una matriz cuadrada sin memoria extra: los pares de bloques por
+// encima y por debajo de la diagonal se intercambian; las filas de bloques
+// tienen cada vez menos pares, asi que se reparten de a una (dynamic)
+void transponerMatrizEnSitio(struct matriz * matriz){
+	transponer8x8 kernel = transponerElegido;
+	int bi, bj;
+
+	#pragma omp parallel for schedule(dynamic, 1) private(bj) if((size_t)matriz->filas * matriz->filas > UMBRAL_TRANSPOSICION_PARALELA)
+	for(bi = 0; bi < matriz->filas; bi += LADO_TRANSPOSICION){
+		for(bj = bi; bj < matriz->filas; bj += LADO_TRANSPOSICION){
+			intercambiarBloques(kernel, matriz, bi, bj);
+		}
+	}
+}
+
+// transponer matriz; las cuadradas se transponen en el mismo bloque y se
+// devuelve la misma matriz, las demas se copian a una nueva y se libera la original
+struct matriz * transponerMatriz(struct matriz * matriz){
+	struct matriz * matrizResultado;
+
+	if(matriz->filas == matriz->columnas){
+		transponerMatrizEnSitio(matriz);
+		return matriz;
+	}
+	matrizResultado = crearMatriz(matriz->columnas, matriz->filas);
+	transponerMatrizEn(matriz, matrizResultado);
+	liberarMemoriaMatriz(matriz);
+	return matrizResultado;
+}
+
+// elementos enteros de [minimo, maximo] con los contadores primerContador,
+// primerContador + 1, ...; el bucle no depende de elementos anteriores y se
+// compila para AVX-512 (con los productos de 64 bits de DQ), AVX2 y la base;
+// la version se elige al cargar el programa
+__attribute__((target_clones("arch=skylake-avx512", "avx2", "default")))
+void llenarAleatorio(int * destino, int elementos, uint64_t clave, uint64_t primerContador, int minimo, int maximo){
+	uint32_t rango = (uint32_t)((int64_t)maximo - minimo + 1);
+	uint64_t base = clave + (primerContador + 1) * GAMMA_ALEATORIO;
+	int j;
+
+	#pragma omp simd
+	for(j = 0; j < elementos; j++){
+		destino[j] = minimo + (int)enteroEnRango(mezclarAleatorio(base + (uint64_t)j * GAMMA_ALEATORIO), rango);
+	}
+}
+
+// el elemento (i, j) es el numero i * columnas + j de la secuencia de la
+// semilla: la misma matriz con cualquier numero de hilos
+void inicializarMatrizAleatoria(struct matriz * matriz, uint64_t semilla, int minimo, int maximo){
+	uint64_t clave = claveAleatoria(semilla);
+	int i;
+
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < matriz->filas; i++){
+		llenarAleatorio(FILA(matriz, i), matriz->columnas, clave, (uint64_t)i * matriz->columnas, minimo, maximo);
+	}
+}
+
+// A y B con valores de 1 a 10 a partir de una semilla (B usa semilla + 1)
+void inicializarMatricesCuadradasSemilla(struct matriz * p_matrizA, struct matriz * p_matrizB, uint64_t semilla){
+	inicializarMatrizAleatoria(p_matrizA, semilla, 1, 10);
+	inicializarMatrizAleatoria(p_matrizB, semilla + 1, 1, 10);
+}
+
+// inicializar matrices cuadradas con numeros int random; la semilla sale de
+// rand(), asi srand sigue decidiendo que matrices se generan
+void inicializarMatricesCuadradas(struct matriz * p_matrizA, struct matriz * p_matrizB){
+	uint64_t semilla = ((uint64_t)rand() << 31) ^ (uint64_t)rand();
+	inicializarMatricesCuadradasSemilla(p_matrizA, p_matrizB, semilla);
+}
+
+// mostrar el contenido de una matriz
+void mostrarMatriz(const struct matriz * p_matriz){
+	int i, j;
+	for(i = 0; i < p_matriz->filas; i++){
+		for(j = 0; j < p_matriz->columnas; j++){
+			printf("%d ", ELEMENTO(p_matriz, i, j));
+		}
+		printf("\n");
+	}
+	printf("\n\n");
+}
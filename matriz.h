@@ -0,0 +1,66 @@
+/*
+ Matriz contigua y alineada
+
+ Reemplaza el int ** de crearMatriz (un malloc por fila) por un unico bloque
+ alineado a 64 bytes. Cada fila empieza en un limite de linea de cache porque
+ la dimension principal (ld) se redondea a un multiplo de 16 enteros.
+
+ Las vistas (vistaMatriz, envolverMatriz) no son duenas de la memoria:
+ apuntan dentro de otra matriz o de un bloque ajeno (p. ej. memoria compartida)
+ y liberarMemoriaMatriz no libera sus datos.
+
+ inicializarMatricesCuadradas llena A y B en paralelo con un generador basado
+ en contador (aleatorio_contador.h): cada elemento depende solo de la semilla
+ y de su posicion, asi que la misma semilla da las mismas matrices con
+ cualquier numero de hilos y todas las variantes se pueden comparar.
+
+ La transposicion va por bloques de 64 x 64 repartidos entre hilos, con
+ azulejos de 8 x 8 transpuestos en registros AVX2 (si la CPU lo tiene y
+ MATRIZ_ISA no pide escalar o sse41); las matrices cuadradas se transponen
+ en su propio bloque, sin reservar otra.
+
+ crearMatriz reserva en paginas grandes si asi lo pide paginas_grandes.h
+ (MATRIZ_PAGINAS o fijarPaginasMatrices) y toca las paginas al crearla si se
+ pidio prefallo. Con el pool de pool_memoria.h activo (MATRIZ_POOL=1) los
+ datos salen de el y liberarMemoriaMatriz los devuelve.
+*/
+#ifndef MATRIZ_H
+#define MATRIZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ALINEACION_MATRIZ 64
+
+struct matriz{
+	int * datos;
+	int filas;
+	int columnas;
+	int ld; // dimension principal: distancia en elementos entre dos filas
+	int propietaria; // marca de pool_memoria.h (1 + modoPaginas, mas BLOQUE_DEL_POOL) si es de crearMatriz, 0 en las vistas
+};
+
+// acceso al elemento (i, j) y al inicio de la fila i
+#define ELEMENTO(m, i, j) ((m)->datos[(size_t)(i) * (m)->ld + (j)])
+#define FILA(m, i) ((m)->datos + (size_t)(i) * (m)->ld)
+
+int calcularLd(int columnas);
+size_t bytesMatriz(int filas, int columnas);
+struct matriz * crearMatriz(int filas, int columnas);
+void liberarMemoriaMatriz(struct matriz *);
+int paginasMatriz(const struct matriz *); // enum modoPaginas de sus datos, -1 en las vistas
+struct matriz vistaMatriz(const struct matriz *, int fila, int columna, int filas, int columnas);
+struct matriz envolverMatriz(int * datos, int filas, int columnas, int ld);
+void ponerCerosMatriz(struct matriz *);
+void transponerMatrizEn(const struct matriz * origen, struct matriz * destino);
+void transponerMatrizEnSitio(struct matriz *); // solo cuadradas
+struct matriz * transponerMatriz(struct matriz *);
+void inicializarMatricesCuadradas(struct matriz *, struct matriz *);
+
+// inicializacion paralela y reproducible con el generador de aleatorio_contador.h
+void llenarAleatorio(int * destino, int elementos, uint64_t clave, uint64_t primerContador, int minimo, int maximo);
+void inicializarMatrizAleatoria(struct matriz *, uint64_t semilla, int minimo, int maximo);
+void inicializarMatricesCuadradasSemilla(struct matriz *, struct matriz *, uint64_t semilla);
+void mostrarMatriz(const struct matriz *);
+
+#endif
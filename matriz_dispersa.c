@@ -0,0 +1,365 @@
+// CSR y CSR por bloques por matrices densas, con eleccion por densidad
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <omp.h>
+
+#include "matriz_dispersa.h"
+#include "aleatorio_contador.h"
+
+#define ELEMENTOS_BLOQUE_BCSR (ALTO_BLOQUE_BCSR * ANCHO_BLOQUE_BCSR)
+
+double umbralDensidadCsr = UMBRAL_DENSIDAD_CSR;
+double umbralDensidadBcsr = UMBRAL_DENSIDAD_BCSR;
+
+const char * nombresProductosDispersos[NUMERO_PRODUCTOS_DISPERSOS] = {"denso", "csr", "bcsr"};
+
+__attribute__((constructor))
+static void leerUmbralesDispersa(void){
+	const char * umbral = getenv("MATRIZ_UMBRAL_CSR");
+	if(umbral != NULL && atof(umbral) > 0){
+		umbralDensidadCsr = atof(umbral);
+	}
+	umbral = getenv("MATRIZ_UMBRAL_BCSR");
+	if(umbral != NULL && atof(umbral) > 0){
+		umbralDensidadBcsr = atof(umbral);
+	}
+}
+
+static int minimo(int a, int b){
+	return a < b ? a : b;
+}
+
+static void * reservarDispersa(size_t bytes){
+	void * bloque = malloc(bytes > 0 ? bytes : 1);
+	if(bloque == NULL){
+		perror("No se pudo reservar memoria para la matriz dispersa");
+		exit(1);
+	}
+	return bloque;
+}
+
+// fraccion de no ceros del bloque de ALTO_BLOQUE_BCSR x ANCHO_BLOQUE_BCSR
+// que contiene a (i, j); los bloques del borde cuentan solo lo que existe
+static double ocupacionBloque(const struct matriz * matriz, int i, int j){
+	int fila = i / ALTO_BLOQUE_BCSR * ALTO_BLOQUE_BCSR, columna = j / ANCHO_BLOQUE_BCSR * ANCHO_BLOQUE_BCSR;
+	int fin = minimo(fila + ALTO_BLOQUE_BCSR, matriz->filas), finColumna = minimo(columna + ANCHO_BLOQUE_BCSR, matriz->columnas);
+	int noCeros = 0, x, y;
+
+	for(x = fila; x < fin; x++){
+		for(y = columna; y < finColumna; y++){
+			noCeros += ELEMENTO(matriz, x, y) != 0;
+		}
+	}
+	return (double)noCeros / ((fin - fila) * (finColumna - columna));
+}
+
+void sondearDensidad(const struct matriz * matriz, int muestras, uint64_t semilla, struct sondeoDensidad * sondeo){
+	double total = (double)matriz->filas * matriz->columnas, ocupacion = 0;
+	uint64_t clave = claveAleatoria(semilla);
+	long noCeros = 0;
+	int i, j, s;
+
+	sondeo->densidad = sondeo->ocupacionBloques = 0;
+	if(total == 0){
+		return;
+	}
+	if(muestras >= total){
+		#pragma omp parallel for schedule(static) private(j) reduction(+ : noCeros, ocupacion)
+		for(i = 0; i < matriz->filas; i++){
+			for(j = 0; j < matriz->columnas; j++){
+				if(ELEMENTO(matriz, i, j) != 0){
+					noCeros++;
+					ocupacion += ocupacionBloque(matriz, i, j);
+				}
+			}
+		}
+		sondeo->densidad = noCeros / total;
+	}
+	else{
+		// posiciones independientes: la densidad tiene error de sqrt(d (1 - d) / muestras)
+		for(s = 0; s < muestras; s++){
+			i = (int)enteroEnRango(aleatorioContador(clave, 2 * (uint64_t)s), (uint32_t)matriz->filas);
+			j = (int)enteroEnRango(aleatorioContador(clave, 2 * (uint64_t)s + 1), (uint32_t)matriz->columnas);
+			if(ELEMENTO(matriz, i, j) != 0){
+				noCeros++;
+				ocupacion += ocupacionBloque(matriz, i, j);
+			}
+		}
+		sondeo->densidad = (double)noCeros / muestras;
+	}
+	sondeo->ocupacionBloques = noCeros > 0 ? ocupacion / noCeros : 0;
+}
+
+enum productoDisperso elegirProductoDisperso(const struct sondeoDensidad * sondeo){
+	if(sondeo->ocupacionBloques >= OCUPACION_MINIMA_BCSR && sondeo->densidad < umbralDensidadBcsr){
+		return PRODUCTO_BCSR;
+	}
+	return sondeo->densidad < umbralDensidadCsr ? PRODUCTO_CSR : PRODUCTO_DENSO;
+}
+
+enum productoDisperso elegirProductoMatriz(const struct matriz * matriz){
+	struct sondeoDensidad sondeo;
+	sondearDensidad(matriz, MUESTRAS_DENSIDAD, 1, &sondeo);
+	return elegirProductoDisperso(&sondeo);
+}
+
+// inicio[i] = suma de cuenta[0 .. i - 1]; cuenta esta en inicio[1 .. n]
+static long sumarPrefijos(long * inicio, int n){
+	int i;
+	inicio[0] = 0;
+	for(i = 0; i < n; i++){
+		inicio[i + 1] += inicio[i];
+	}
+	return inicio[n];
+}
+
+struct matrizCsr * crearCsr(const struct matriz * matriz){
+	struct matrizCsr * csr = (struct matrizCsr *)reservarDispersa(sizeof(struct matrizCsr));
+	int i, j;
+
+	csr->filas = matriz->filas;
+	csr->columnas = matriz->columnas;
+	csr->inicioFila = (long *)reservarDispersa(((size_t)matriz->filas + 1) * sizeof(long));
+
+	// dos pasadas: contar los no ceros de cada fila y despues copiarlos a su lugar
+	#pragma omp parallel for schedule(static) private(j)
+	for(i = 0; i < matriz->filas; i++){
+		const int * fila = FILA(matriz, i);
+		long cuenta = 0;
+		for(j = 0; j < matriz->columnas; j++){
+			cuenta += fila[j] != 0;
+		}
+		csr->inicioFila[i + 1] = cuenta;
+	}
+	csr->noCeros = sumarPrefijos(csr->inicioFila, matriz->filas);
+	csr->indiceColumna = (int *)reservarDispersa((size_t)csr->noCeros * sizeof(int));
+	csr->valores = (int *)reservarDispersa((size_t)csr->noCeros * sizeof(int));
+
+	#pragma omp parallel for schedule(static) private(j)
+	for(i = 0; i < matriz->filas; i++){
+		const int * fila = FILA(matriz, i);
+		long p = csr->inicioFila[i];
+		for(j = 0; j < matriz->columnas; j++){
+			if(fila[j] != 0){
+				csr->indiceColumna[p] = j;
+				csr->valores[p] = fila[j];
+				p++;
+			}
+		}
+	}
+	return csr;
+}
+
+void liberarCsr(struct matrizCsr * csr){
+	if(csr == NULL){
+		return;
+	}
+	free(csr->inicioFila);
+	free(csr->indiceColumna);
+	free(csr->valores);
+	free(csr);
+}
+
+// 1 si el bloque (ib, jb) tiene algun no cero
+static int bloqueOcupado(const struct matriz * matriz, int ib, int jb){
+	int fila = ib * ALTO_BLOQUE_BCSR, columna = jb * ANCHO_BLOQUE_BCSR;
+	int fin = minimo(fila + ALTO_BLOQUE_BCSR, matriz->filas), finColumna = minimo(columna + ANCHO_BLOQUE_BCSR, matriz->columnas);
+	int i, j;
+
+	for(i = fila; i < fin; i++){
+		for(j = columna; j < finColumna; j++){
+			if(ELEMENTO(matriz, i, j) != 0){
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+struct matrizBcsr * crearBcsr(const struct matriz * matriz){
+	struct matrizBcsr * bcsr = (struct matrizBcsr *)reservarDispersa(sizeof(struct matrizBcsr));
+	int columnasBloques = (matriz->columnas + ANCHO_BLOQUE_BCSR - 1) / ANCHO_BLOQUE_BCSR;
+	long noCeros = 0;
+	int ib, jb, i, j;
+
+	bcsr->filas = matriz->filas;
+	bcsr->columnas = matriz->columnas;
+	bcsr->filasBloques = (matriz->filas + ALTO_BLOQUE_BCSR - 1) / ALTO_BLOQUE_BCSR;
+	bcsr->inicioFilaBloques = (long *)reservarDispersa(((size_t)bcsr->filasBloques + 1) * sizeof(long));
+
+	#pragma omp parallel for schedule(static) private(jb)
+	for(ib = 0; ib < bcsr->filasBloques; ib++){
+		long cuenta = 0;
+		for(jb = 0; jb < columnasBloques; jb++){
+			cuenta += bloqueOcupado(matriz, ib, jb);
+		}
+		bcsr->inicioFilaBloques[ib + 1] = cuenta;
+	}
+	bcsr->bloques = sumarPrefijos(bcsr->inicioFilaBloques, bcsr->filasBloques);
+	bcsr->columnaBloque = (int *)reservarDispersa((size_t)bcsr->bloques * sizeof(int));
+	// los bloques del borde quedan rellenos con ceros
+	bcsr->valores = (int *)calloc((size_t)bcsr->bloques * ELEMENTOS_BLOQUE_BCSR + 1, sizeof(int));
+	if(bcsr->valores == NULL){
+		perror("No se pudo reservar memoria para la matriz dispersa");
+		exit(1);
+	}
+
+	#pragma omp parallel for schedule(static) private(jb, i, j) reduction(+ : noCeros)
+	for(ib = 0; ib < bcsr->filasBloques; ib++){
+		long p = bcsr->inicioFilaBloques[ib];
+		int fila = ib * ALTO_BLOQUE_BCSR;
+		for(jb = 0; jb < columnasBloques; jb++){
+			int * v;
+			if(!bloqueOcupado(matriz, ib, jb)){
+				continue;
+			}
+			v = bcsr->valores + p * ELEMENTOS_BLOQUE_BCSR;
+			bcsr->columnaBloque[p] = jb;
+			for(i = 0; i < minimo(ALTO_BLOQUE_BCSR, matriz->filas - fila); i++){
+				for(j = 0; j < minimo(ANCHO_BLOQUE_BCSR, matriz->columnas - jb * ANCHO_BLOQUE_BCSR); j++){
+					v[i * ANCHO_BLOQUE_BCSR + j] = ELEMENTO(matriz, fila + i, jb * ANCHO_BLOQUE_BCSR + j);
+					noCeros += v[i * ANCHO_BLOQUE_BCSR + j] != 0;
+				}
+			}
+			p++;
+		}
+	}
+	bcsr->noCeros = noCeros;
+	return bcsr;
+}
+
+void liberarBcsr(struct matrizBcsr * bcsr){
+	if(bcsr == NULL){
+		return;
+	}
+	free(bcsr->inicioFilaBloques);
+	free(bcsr->columnaBloque);
+	free(bcsr->valores);
+	free(bcsr);
+}
+
+double rellenoBcsr(const struct matrizBcsr * bcsr){
+	if(bcsr->noCeros == 0){
+		return 0.0;
+	}
+	return (double)(bcsr->bloques * ELEMENTOS_BLOQUE_BCSR - bcsr->noCeros) / bcsr->noCeros;
+}
+
+// primera fila del tramo parte de partes cuando el costo de las filas
+// [0, i) es inicio[i] + i: tramos con los mismos no ceros mas filas
+static int inicioTramo(const long * inicio, int filas, int partes, int parte){
+	long objetivo = (inicio[filas] + filas) * parte / partes;
+	int bajo = 0, alto = filas, medio;
+
+	while(bajo < alto){
+		medio = bajo + (alto - bajo) / 2;
+		if(inicio[medio] + medio < objetivo){
+			bajo = medio + 1;
+		}
+		else{
+			alto = medio;
+		}
+	}
+	return bajo;
+}
+
+__attribute__((target_clones("arch=skylake-avx512", "avx2", "default")))
+static void multiplicarFilasCsr(const struct matrizCsr * A, const struct matriz * B, struct matriz * C, int desde, int hasta){
+	int i, j, jc, ancho;
+	long p, inicio, fin;
+
+	for(i = desde; i < hasta; i++){
+		inicio = A->inicioFila[i];
+		fin = A->inicioFila[i + 1];
+		for(jc = 0; jc < B->columnas; jc += ANCHO_FRANJA_DISPERSA){
+			int * c = FILA(C, i) + jc;
+			ancho = minimo(ANCHO_FRANJA_DISPERSA, B->columnas - jc);
+			memset(c, 0, (size_t)ancho * sizeof(int));
+			for(p = inicio; p + 4 <= fin; p += 4){
+				const int * b0 = FILA(B, A->indiceColumna[p]) + jc, * b1 = FILA(B, A->indiceColumna[p + 1]) + jc;
+				const int * b2 = FILA(B, A->indiceColumna[p + 2]) + jc, * b3 = FILA(B, A->indiceColumna[p + 3]) + jc;
+				int a0 = A->valores[p], a1 = A->valores[p + 1], a2 = A->valores[p + 2], a3 = A->valores[p + 3];
+				#pragma omp simd
+				for(j = 0; j < ancho; j++){
+					c[j] += a0 * b0[j] + a1 * b1[j] + a2 * b2[j] + a3 * b3[j];
+				}
+			}
+			for(; p < fin; p++){
+				const int * b = FILA(B, A->indiceColumna[p]) + jc;
+				int a = A->valores[p];
+				#pragma omp simd
+				for(j = 0; j < ancho; j++){
+					c[j] += a * b[j];
+				}
+			}
+		}
+	}
+}
+
+void multiplicarCsr(const struct matrizCsr * A, const struct matriz * B, struct matriz * C, int numeroHilos){
+	if(numeroHilos <= 0){
+		numeroHilos = omp_get_max_threads();
+	}
+	#pragma omp parallel num_threads(numeroHilos)
+	{
+		int hilo = omp_get_thread_num(), hilos = omp_get_num_threads();
+		multiplicarFilasCsr(A, B, C, inicioTramo(A->inicioFila, A->filas, hilos, hilo), inicioTramo(A->inicioFila, A->filas, hilos, hilo + 1));
+	}
+}
+
+// cada fila de B se carga una vez para las cuatro filas del bloque; las sumas
+// van en s y se copian a C al final de la franja (el ultimo bloque puede
+// tener menos filas)
+__attribute__((target_clones("arch=skylake-avx512", "avx2", "default")))
+static void multiplicarFilasBcsr(const struct matrizBcsr * A, const struct matriz * B, struct matriz * C, int desde, int hasta){
+	int s[ALTO_BLOQUE_BCSR][ANCHO_FRANJA_DISPERSA] __attribute__((aligned(64)));
+	int ib, r, j, jc, ancho, alto, fila, k;
+	long p;
+
+	for(ib = desde; ib < hasta; ib++){
+		fila = ib * ALTO_BLOQUE_BCSR;
+		alto = minimo(ALTO_BLOQUE_BCSR, A->filas - fila);
+		for(jc = 0; jc < B->columnas; jc += ANCHO_FRANJA_DISPERSA){
+			ancho = minimo(ANCHO_FRANJA_DISPERSA, B->columnas - jc);
+			for(r = 0; r < ALTO_BLOQUE_BCSR; r++){
+				memset(s[r], 0, (size_t)ancho * sizeof(int));
+			}
+			for(p = A->inicioFilaBloques[ib]; p < A->inicioFilaBloques[ib + 1]; p++){
+				const int * v = A->valores + p * ELEMENTOS_BLOQUE_BCSR;
+				const int * b[ANCHO_BLOQUE_BCSR];
+				int v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3], v4 = v[4], v5 = v[5], v6 = v[6], v7 = v[7];
+				int v8 = v[8], v9 = v[9], v10 = v[10], v11 = v[11], v12 = v[12], v13 = v[13], v14 = v[14], v15 = v[15];
+				// las columnas de relleno del ultimo bloque tienen coeficiente 0:
+				// apuntan a una fila valida de B
+				for(k = 0; k < ANCHO_BLOQUE_BCSR; k++){
+					int filaB = A->columnaBloque[p] * ANCHO_BLOQUE_BCSR + k;
+					b[k] = FILA(B, filaB < B->filas ? filaB : B->filas - 1) + jc;
+				}
+				#pragma omp simd aligned(s : 64)
+				for(j = 0; j < ancho; j++){
+					int b0 = b[0][j], b1 = b[1][j], b2 = b[2][j], b3 = b[3][j];
+					s[0][j] += v0 * b0 + v1 * b1 + v2 * b2 + v3 * b3;
+					s[1][j] += v4 * b0 + v5 * b1 + v6 * b2 + v7 * b3;
+					s[2][j] += v8 * b0 + v9 * b1 + v10 * b2 + v11 * b3;
+					s[3][j] += v12 * b0 + v13 * b1 + v14 * b2 + v15 * b3;
+				}
+			}
+			for(r = 0; r < alto; r++){
+				memcpy(FILA(C, fila + r) + jc, s[r], (size_t)ancho * sizeof(int));
+			}
+		}
+	}
+}
+
+void multiplicarBcsr(const struct matrizBcsr * A, const struct matriz * B, struct matriz * C, int numeroHilos){
+	if(numeroHilos <= 0){
+		numeroHilos = omp_get_max_threads();
+	}
+	#pragma omp parallel num_threads(numeroHilos)
+	{
+		int hilo = omp_get_thread_num(), hilos = omp_get_num_threads();
+		multiplicarFilasBcsr(A, B, C, inicioTramo(A->inicioFilaBloques, A->filasBloques, hilos, hilo),
+			inicioTramo(A->inicioFilaBloques, A->filasBloques, hilos, hilo + 1));
+	}
+}
@@ -0,0 +1,106 @@
+/*
+ Matrices dispersas (CSR y CSR por bloques) por matrices densas
+
+ Con A casi toda en ceros el producto denso hace igual las N^3 sumas. En CSR
+ A guarda solo sus no ceros, fila por fila: inicioFila[i] .. inicioFila[i + 1]
+ son las posiciones de la fila i en indiceColumna y valores. El producto
+ C = A * B (SpMM, B y C densas de matriz.h) recorre cada fila de C sumando
+ a * (fila k de B) por cada no cero a = A(i, k): 2 * noCeros * N operaciones.
+
+ 	- las filas se reparten entre los hilos por tramos del mismo costo
+ 	  (no ceros mas uno por fila), no de la misma cantidad de filas, porque
+ 	  los no ceros pueden estar amontonados en unas pocas filas
+ 	- las columnas van en franjas de ANCHO_FRANJA_DISPERSA para que la franja
+ 	  de la fila de C quede en L1 mientras pasan las filas de B
+ 	- cuatro no ceros por pasada: cada elemento de C se carga y se guarda una
+ 	  vez por cada cuatro filas de B
+
+ BCSR guarda bloques densos de ALTO_BLOQUE_BCSR x ANCHO_BLOQUE_BCSR con al
+ menos un no cero (rellenos con ceros). Cada fila de B que se carga se usa
+ para cuatro filas de C, lo que conviene cuando los no ceros vienen
+ agrupados (matrices por bandas o bloques) y no cuando estan sueltos.
+
+ Eleccion: sondearDensidad mira MUESTRAS_DENSIDAD posiciones al azar (sin
+ recorrer la matriz) y estima la densidad y, de los no ceros que encuentra,
+ que fraccion de su bloque de 4 x 4 esta ocupada. elegirProductoDisperso
+ usa BCSR si los bloques estan al menos a medio llenar y la densidad es menor
+ que umbralDensidadBcsr, CSR si es menor que umbralDensidadCsr y el producto
+ denso si no. Los umbrales por defecto salen de benchmark_dispersa con N =
+ 1024 y 2048 en una maquina con AVX2 (cruce de CSR con no ceros sueltos entre
+ 0.24 y 0.35; BCSR con bloques llenos sigue ganando con 0.5), un poco por
+ debajo para no perder cuando se equivocan. Solo valen para matrices de ese
+ orden: con matrices chicas el producto denso rinde menos y el cruce sube
+ (con N = 301 queda cerca de 0.5), asi que ahi los umbrales se quedan cortos.
+ MATRIZ_UMBRAL_CSR y MATRIZ_UMBRAL_BCSR los cambian; benchmark_dispersa da
+ los valores para cada tamanio y maquina.
+
+ Solo int32, como las variantes: los productos desbordan modulo 2^32 igual
+ que el producto denso.
+*/
+#ifndef MATRIZ_DISPERSA_H
+#define MATRIZ_DISPERSA_H
+
+#include <stdint.h>
+
+#include "matriz.h"
+
+#define ALTO_BLOQUE_BCSR 4
+#define ANCHO_BLOQUE_BCSR 4
+#define ANCHO_FRANJA_DISPERSA 1024
+#define MUESTRAS_DENSIDAD 4096
+#define UMBRAL_DENSIDAD_CSR 0.2 // medidos con N = 1024 y 2048
+#define UMBRAL_DENSIDAD_BCSR 0.4
+#define OCUPACION_MINIMA_BCSR 0.5
+
+enum productoDisperso{
+	PRODUCTO_DENSO,
+	PRODUCTO_CSR,
+	PRODUCTO_BCSR,
+	NUMERO_PRODUCTOS_DISPERSOS
+};
+
+struct sondeoDensidad{
+	double densidad; // fraccion de no ceros
+	double ocupacionBloques; // fraccion media de no ceros en el bloque de un no cero
+};
+
+struct matrizCsr{
+	int filas;
+	int columnas;
+	long noCeros;
+	long * inicioFila; // filas + 1
+	int * indiceColumna; // noCeros
+	int * valores; // noCeros
+};
+
+struct matrizBcsr{
+	int filas;
+	int columnas;
+	int filasBloques; // filas / ALTO_BLOQUE_BCSR redondeado hacia arriba
+	long bloques;
+	long noCeros; // de A, sin el relleno de los bloques
+	long * inicioFilaBloques; // filasBloques + 1
+	int * columnaBloque; // columna del bloque, en bloques
+	int * valores; // bloques * ALTO_BLOQUE_BCSR * ANCHO_BLOQUE_BCSR, cada bloque por filas
+};
+
+extern double umbralDensidadCsr;
+extern double umbralDensidadBcsr;
+extern const char * nombresProductosDispersos[NUMERO_PRODUCTOS_DISPERSOS];
+
+// con muestras >= filas * columnas se recorre toda la matriz
+void sondearDensidad(const struct matriz *, int muestras, uint64_t semilla, struct sondeoDensidad *);
+enum productoDisperso elegirProductoDisperso(const struct sondeoDensidad *);
+enum productoDisperso elegirProductoMatriz(const struct matriz *); // sondeo con MUESTRAS_DENSIDAD
+
+struct matrizCsr * crearCsr(const struct matriz *);
+void liberarCsr(struct matrizCsr *);
+struct matrizBcsr * crearBcsr(const struct matriz *);
+void liberarBcsr(struct matrizBcsr *);
+double rellenoBcsr(const struct matrizBcsr *); // ceros guardados por cada no cero
+
+// C = A * B; numeroHilos <= 0 usa omp_get_max_threads()
+void multiplicarCsr(const struct matrizCsr * A, const struct matriz * B, struct matriz * C, int numeroHilos);
+void multiplicarBcsr(const struct matrizBcsr * A, const struct matriz * B, struct matriz * C, int numeroHilos);
+
+#endif
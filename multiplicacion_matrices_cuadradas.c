@@ -3,18 +3,24 @@
 #include <stdio.h>
 #include <time.h>
 
-void InicializarMatricesCuadradas(int ***, int ***, int);
-int ** MultiplicarMatricesCuadradas(int ***, int ***, int);
-void MostrarMatriz(int***, int);
+#include "matriz.h"
+#include "verificacion.h"
+
+// para compilar: gcc multiplicacion_matrices_cuadradas.c matriz.c paginas_grandes.c pool_memoria.c verificacion.c -lm
+// uso: ./a.out [tamanio] [-f vectores de Freivalds, 0 para comparar exacto]
+
+struct matriz * MultiplicarMatricesCuadradas(const struct matriz *, const struct matriz *);
 
 
 int main(int argc, char *argv[]){
 	srand(time(NULL));
 	
 	int tamanioMatriz;
-	int ** p_matrizA;
-	int ** p_matrizB;
-	int ** p_matrizResultado;
+	int repeticionesFreivalds = leerOpcionVerificacion(&argc, argv);
+	int correcto = 1;
+	struct matriz * p_matrizA;
+	struct matriz * p_matrizB;
+	struct matriz * p_matrizResultado;
 	clock_t tiempo_inicio, tiempo_final;
 	double tiempo_transcurrido;
 	// NOTA: no se puede hacer esto
@@ -34,67 +40,47 @@ int main(int argc, char *argv[]){
 		tamanioMatriz = atoi(argv[1]);
 	}
 	
-	InicializarMatricesCuadradas(&p_matrizA, &p_matrizB, tamanioMatriz);
+	p_matrizA = crearMatriz(tamanioMatriz, tamanioMatriz);
+	p_matrizB = crearMatriz(tamanioMatriz, tamanioMatriz);
+	inicializarMatricesCuadradas(p_matrizA, p_matrizB);
 	
 	
-	//MostrarMatriz(&p_matrizA, tamanioMatriz);
-	//MostrarMatriz(&p_matrizB, tamanioMatriz);
+	//mostrarMatriz(p_matrizA);
+	//mostrarMatriz(p_matrizB);
 	tiempo_inicio = clock();
-	p_matrizResultado = MultiplicarMatricesCuadradas(&p_matrizA, &p_matrizB, tamanioMatriz);
+	p_matrizResultado = MultiplicarMatricesCuadradas(p_matrizA, p_matrizB);
 	tiempo_final = clock();
 	tiempo_transcurrido = (double)(tiempo_final - tiempo_inicio) / CLOCKS_PER_SEC;
 	printf("\ntiempo transcurrido multiplicacion_matrices:	%f\n", tiempo_transcurrido);
-	//MostrarMatriz(&p_matrizResultado, tamanioMatriz);
+	//mostrarMatriz(p_matrizResultado);
+	if(repeticionesFreivalds >= 0){
+		correcto = mostrarVerificacion(p_matrizA, p_matrizB, p_matrizResultado, repeticionesFreivalds);
+	}
 	
-	system("pause");
-	return 0;
-}
-
-
-// inicializar matrices cuadradas con numeros int random 
-void InicializarMatricesCuadradas(int *** p_matrizA, int *** p_matrizB, int tamanioMatriz){
-	int i, j, numeroA, numeroB;
-	* p_matrizA = (int **)malloc(tamanioMatriz * sizeof(int *));
-	* p_matrizB = (int **)malloc(tamanioMatriz * sizeof(int *));
+	liberarMemoriaMatriz(p_matrizA);
+	liberarMemoriaMatriz(p_matrizB);
+	liberarMemoriaMatriz(p_matrizResultado);
 	
-	for(i = 0; i < tamanioMatriz; i++){
-		(* p_matrizA)[i] = (int *)malloc(tamanioMatriz * sizeof(int));
-		(* p_matrizB)[i] = (int *)malloc(tamanioMatriz * sizeof(int));
-		for(j = 0; j < tamanioMatriz; j++){
-			numeroA = rand() % 10 + 1;
-			numeroB = rand() % 10 + 1;
-			(* p_matrizA)[i][j] = numeroA;
-			(* p_matrizB)[i][j] = numeroB;
-		}
-	}
+	return correcto ? 0 : 1;
 }
 
+
 // multiplicar las matrices cuadradas y generar una matriz resultado tambien cuadrada
-int ** MultiplicarMatricesCuadradas(int *** p_matrizA, int *** p_matrizB, int tamanioMatriz){
+struct matriz * MultiplicarMatricesCuadradas(const struct matriz * p_matrizA, const struct matriz * p_matrizB){
 	int i, j, k, acumulado;
-	int ** p_matrizResultado = (int **)malloc(tamanioMatriz * sizeof(int *));
+	int tamanioMatriz = p_matrizA->filas;
+	struct matriz * p_matrizResultado = crearMatriz(tamanioMatriz, tamanioMatriz);
+	const int * filaA;
 	
 	for(i = 0; i < tamanioMatriz; i++){ // este bucle recorre las filas de la matriz multiplicando
-		p_matrizResultado[i] = (int *)malloc(tamanioMatriz * sizeof(int));
+		filaA = FILA(p_matrizA, i);
 		for(j = 0; j < tamanioMatriz; j++){ // este bucle recorre los elementos de la fila
 			acumulado = 0;
 			for(k = 0; k < tamanioMatriz; k++){ // este bucle recorre los elementos de la columna
-				acumulado += (* p_matrizA)[i][k] * (* p_matrizB)[k][j];
+				acumulado += filaA[k] * ELEMENTO(p_matrizB, k, j);
 			}
-			p_matrizResultado[i][j] = acumulado;
+			ELEMENTO(p_matrizResultado, i, j) = acumulado;
 		}
 	}
 	return p_matrizResultado;
 }
-
-// mostrar el contenido de una matriz cuadrada
-void MostrarMatriz(int *** p_matriz, int tamanioMatriz){
-	int i, j;
-	for(i = 0; i < tamanioMatriz; i++){
-		for(j = 0; j < tamanioMatriz; j++){
-			printf("%d ", (* p_matriz)[i][j]);
-		}
-		printf("\n");
-	}
-	printf("\n\n");
-}
@@ -1,190 +1,139 @@
-/* MEMORIA COMPARTIDA */
-#include <sys/mman.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-
+/*
+Pool de procesos
+
+Antes se hacia un solo fork por multiplicacion (NUM_PROCESSES fijo en 2, con
+el ultimo proceso cargando el residuo de filas) y se creaba la memoria
+compartida cada vez. Ahora pool_procesos.c crea el segmento una vez, hace
+fork de N trabajadores que se reutilizan en todas las repeticiones y reparte
+la matriz resultado en azulejos 2D que los procesos toman de una cola sin
+candados en la memoria compartida.
+*/
 #include <stdio.h>
 #include <stdlib.h>
-
-/* PARA FORK */
-#include <sys/types.h>
 #include <unistd.h>
 
-/* PARA TERMINAR EL PROCESO HIJO */
-#include <sys/wait.h>
-
 // tandom number generation
 #include <sys/times.h>
 #include <time.h>
 
-#define SHM_2DARRAY "array_shrmem1"
-#define NUM_PROCESSES 2
+#include "matriz.h"
+#include "planificador_azulejos.h"
+#include "pool_procesos.h"
+#include "verificacion.h"
+
+// para compilar: gcc multiplicacion_matrices_cuadradas_fork.c matriz.c paginas_grandes.c pool_memoria.c pool_procesos.c planificador_azulejos.c verificacion.c -pthread -lrt -lm
+// uso: ./a.out [tamanio] [numero de procesos] [repeticiones] [-f vectores de Freivalds, 0 para comparar exacto]
 
-void InicializarMatricesCuadradas(int ** p_matrizA, int tamanioMatriz);
-void MultiplicarMatricesCuadradas(int ** p_matrizA, int tamanioMatriz,int limiteInf, int limiteSup);
-void MostrarMatriz(int ** p_matriz, int tamanioMatriz, int posInicio);
+void MultiplicarMatricesCuadradas(const struct azulejo * azulejo, void * contexto);
 void MostrarContenidoBloqueMemoria(int ** p_matriz, int dimensiones);
-//void DefinirIntervalos(int * lista_intervalos, int tamanioMatriz);
-int * DefinirIntervalos(int tamanioMatriz);
-int crearSHM();
-void asignarMemoriaSHM(int fd_array, int tamanioBloqueMemoria);
 
 
 int main(int argc, char *argv[]){
 	srand(time(NULL));
 	int tamanioMatriz;
+	// por defecto un proceso por nucleo
+	int numeroProcesos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int repeticiones = 1;
+	int repeticionesFreivalds = leerOpcionVerificacion(&argc, argv);
+	int correcto = 1;
+	int r;
 	struct tms start_times, end_times;
 	clock_t start_clock, end_clock;
+	struct timespec begin, end;
+	struct matriz matrizA, matrizB;
+	struct pool_procesos * pool;
 	
-	if (argc != 2){
+	if (argc < 2){
 		printf("No se paso un tamanio de matriz. Se fijara uno por defecto\n\n");
 		tamanioMatriz = 4;
 	}
 	
-	if (argc == 2){
+	if (argc >= 2){
 		printf("argumento en argv[1]:	%s\n", argv[1]);
 		tamanioMatriz = atoi(argv[1]);
 	}
-	
-	int numMatrices = 3;
-	int dimensiones = tamanioMatriz * tamanioMatriz;
-	int bloqueTotalMem = (dimensiones * sizeof(int)) * numMatrices;
-	int *matriz2d;
-	int fd_2darray;
-	clock_t tiempo_inicio, tiempo_final;
-	double tiempo_transcurrido;
-
-	
-	int * intervalos = DefinirIntervalos(tamanioMatriz);
-	int i;
-	for(i = 0; i < NUM_PROCESSES; i++){
-		printf("%d, ", intervalos[i]);
+	if (argc >= 3){
+		numeroProcesos = atoi(argv[2]);
+	}
+	if (argc >= 4){
+		repeticiones = atoi(argv[3]);
 	}
-	printf("\n\n");
-	
 	
-	fd_2darray = crearSHM();
-	asignarMemoriaSHM(fd_2darray, bloqueTotalMem);
-	matriz2d = mmap(NULL, bloqueTotalMem,PROT_READ | PROT_WRITE, MAP_SHARED, fd_2darray, 0);
+	// la memoria compartida se crea una sola vez, antes de hacer fork
+	pool = crearPoolProcesos(numeroProcesos, tamanioMatriz, MultiplicarMatricesCuadradas);
 
-	InicializarMatricesCuadradas(&matriz2d, tamanioMatriz);
+	// vistas de A y B sobre el segmento compartido
+	matrizA = matrizPoolProcesos(pool, MATRIZ_A, tamanioMatriz);
+	matrizB = matrizPoolProcesos(pool, MATRIZ_B, tamanioMatriz);
+	inicializarMatricesCuadradas(&matrizA, &matrizB);
 
-	//MostrarMatriz(&matriz2d, tamanioMatriz, 0);
-	//MostrarMatriz(&matriz2d, tamanioMatriz, dimensiones);
+	//mostrarMatriz(&matrizA);
+	//mostrarMatriz(&matrizB);
 	
-	//MostrarContenidoBloqueMemoria(&matriz2d, dimensiones * numMatrices);
 	start_clock = times(&start_times);
 	if (start_clock == (clock_t)-1) {
 	        perror("times error");
 	        exit(EXIT_FAILURE);
 	}
 	
-	
-	pid_t p;
-	p = fork();
-	
-	if(p < 0){
-		perror("fork failed");
-		exit(1);
-	}
-	
-	// proceso hijo; p es igual a 0
-	else if(p == 0){
-
-		tiempo_inicio = clock();
-		MultiplicarMatricesCuadradas(&matriz2d, tamanioMatriz, intervalos[0], intervalos[1] + intervalos[0]);
-		tiempo_final = clock();
-		tiempo_transcurrido = (double)(tiempo_final - tiempo_inicio) / CLOCKS_PER_SEC;
-		printf("\ntiempo transcurrido proceso hijo:	%f\n", tiempo_transcurrido);
-		//MostrarMatriz(&matriz2d, tamanioMatriz, dimensiones * 2);
-		
-		end_clock = times(&end_times);
-		if (end_clock == (clock_t)-1) {
-			perror("times error in child");
+	for(r = 0; r < repeticiones; r++){
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		if(multiplicarPoolProcesos(pool, tamanioMatriz) != 0){
+			fprintf(stderr, "la multiplicacion no se completo\n");
+			destruirPoolProcesos(pool);
 			exit(EXIT_FAILURE);
 		}
-		
-		// Calcular e imprimir el tiempo de CPU del hijo
-		long clk_tck = sysconf(_SC_CLK_TCK);
-		printf("Child CPU time: user=%.2f s, system=%.2f s\n",
-			(double)(end_times.tms_utime - start_times.tms_utime) / clk_tck,
-			(double)(end_times.tms_stime - start_times.tms_stime) / clk_tck);	
-		exit(EXIT_SUCCESS);
-		
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		printf("repeticion %d: tiempo WALL %f s\n", r,
+			(end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) * 1e-9);
 	}
-	
-	// proceso padre; p es mayor que 0
-	else{	
-		tiempo_inicio = clock();
-		MultiplicarMatricesCuadradas(&matriz2d, tamanioMatriz, 0, intervalos[0]);
-		tiempo_final = clock();
-		
-		tiempo_transcurrido = (double)(tiempo_final - tiempo_inicio) / CLOCKS_PER_SEC;
-		printf("\ntiempo transcurrido proceso padre:	%f\n", tiempo_transcurrido);
-	
-		// tambien puede usarse waitpid()
-		wait(NULL); // hay que usar algun tipo de pausa para esperar a que el proceso hijo termine antes que el padre
-		
-		if (end_clock == (clock_t)-1) {
-			perror("times error in parent");
-			exit(EXIT_FAILURE);
-		}
-		
-		 // Calcular e imprimir el tiempo de CPU del padre
-		long clk_tck = sysconf(_SC_CLK_TCK);
-		printf("Parent CPU time: user=%.2f s, system=%.2f s\n",
-			(double)(end_times.tms_utime - start_times.tms_utime) / clk_tck,
-			(double)(end_times.tms_stime - start_times.tms_stime) / clk_tck);
+	mostrarEstadisticasPoolProcesos(pool);
 
-		//MostrarMatriz(&matriz2d, tamanioMatriz, dimensiones * 2);
-
-		close(fd_2darray);
-		munmap(matriz2d, bloqueTotalMem);
-	
-		shm_unlink(SHM_2DARRAY);		
+	//struct matriz matrizResultado = matrizPoolProcesos(pool, MATRIZ_RESULTADO, tamanioMatriz);
+	//mostrarMatriz(&matrizResultado);
 
+	// C sigue en el segmento compartido hasta destruir el pool
+	if(repeticionesFreivalds >= 0){
+		struct matriz matrizResultado = matrizPoolProcesos(pool, MATRIZ_RESULTADO, tamanioMatriz);
+		correcto = mostrarVerificacion(&matrizA, &matrizB, &matrizResultado, repeticionesFreivalds);
 	}
 
-	// sin estas instrucciones se puede presentar un error de segmentacion al volver a abrir el programa
-	//close(fd_2darray);
-	//munmap(matriz2d, bloqueTotalMem);
-	
-	//shm_unlink(SHM_2DARRAY);
-	return 0;	
-}
+	// al destruir el pool se recogen los hijos y su tiempo de CPU queda en tms_cutime
+	destruirPoolProcesos(pool);
 
-// Inicializar matrices cuadradas --> llena dos matrices con numeros aleatorios
-void InicializarMatricesCuadradas(int ** p_matrizA, int tamanioMatriz){
-	int i, numeroA, numeroB;
-	int limit = tamanioMatriz * tamanioMatriz;
-	for(i = 0; i < limit; i++){
-		numeroA = rand() % 10 + 1;
-		numeroB = rand() % 10 + 1;
-		(* p_matrizA)[i] = numeroA;
-		(* p_matrizA)[i + limit] = numeroB;
+	end_clock = times(&end_times);
+	if (end_clock == (clock_t)-1) {
+		perror("times error");
+		exit(EXIT_FAILURE);
 	}
+	
+	long clk_tck = sysconf(_SC_CLK_TCK);
+	printf("Children CPU time: user=%.2f s, system=%.2f s\n",
+		(double)(end_times.tms_cutime - start_times.tms_cutime) / clk_tck,
+		(double)(end_times.tms_cstime - start_times.tms_cstime) / clk_tck);
+	printf("Parent CPU time: user=%.2f s, system=%.2f s\n",
+		(double)(end_times.tms_utime - start_times.tms_utime) / clk_tck,
+		(double)(end_times.tms_stime - start_times.tms_stime) / clk_tck);
+	return correcto ? 0 : 1;
 }
 
 // multiplicar las matrices cuadradas y generar una matriz resultado tambien cuadrada¨
-void MultiplicarMatricesCuadradas(int ** p_matrizA, int tamanioMatriz,int limiteInf, int limiteSup){
-	int i, j, k, dimensiones, acumulado;
-	dimensiones = tamanioMatriz * tamanioMatriz;
-	//struct timespec start_ts, end_ts;
-	//clockid_t threadClockId;
-	
-	//pthread_getcpuclockid(pthread_self(), &threadClockId);
-	//clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start_ts);
-	//clock_gettime(threadClockId, &start_ts);	
-	
-	for(i = limiteInf; i < limiteSup; i++){
-	//for(i = 0; i < tamanioMatriz; i++){ // este bucle recorre las filas de la matriz multiplicando
-		for(j = 0; j < tamanioMatriz; j++){ // este bucle recorre los elementos de la fila
+// (solo el azulejo que le toca al proceso)
+void MultiplicarMatricesCuadradas(const struct azulejo * azulejo, void * contexto){
+	struct matriz * vistas = (struct matriz *)contexto;
+	const struct matriz * p_matrizA = &vistas[MATRIZ_A];
+	const struct matriz * p_matrizB = &vistas[MATRIZ_B];
+	struct matriz * p_matrizResultado = &vistas[MATRIZ_RESULTADO];
+	int i, j, k, acumulado;
+	int tamanioMatriz = p_matrizA->filas;
+	
+	for(i = azulejo->fila; i < azulejo->fila + azulejo->filas; i++){ // este bucle recorre las filas del azulejo
+		for(j = azulejo->columna; j < azulejo->columna + azulejo->columnas; j++){ // este bucle recorre los elementos de la fila
 			acumulado = 0;
 			for(k = 0; k < tamanioMatriz; k++){ // este bucle recorre los elementos de la columna
-				//(* p_matrizA)[i][k] * (* p_matrizB)[k][j];
-				acumulado += (* p_matrizA)[i * tamanioMatriz + k] * (* p_matrizA)[(k * tamanioMatriz + j) + dimensiones];
+				acumulado += ELEMENTO(p_matrizA, i, k) * ELEMENTO(p_matrizB, k, j);
 			}
-			(* p_matrizA)[(i * tamanioMatriz + j) + (dimensiones * 2)] = acumulado;
+			ELEMENTO(p_matrizResultado, i, j) = acumulado;
 		}
 	}
 	//clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end_ts);
@@ -195,70 +144,6 @@ void MultiplicarMatricesCuadradas(int ** p_matrizA, int tamanioMatriz,int limite
 	//printf("Thread CPU time: %f seconds\n", elapsed_time);
 }
 
-int crearSHM(){
-	int fd_2darray = shm_open(SHM_2DARRAY, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
-	if(fd_2darray == -1){
-		perror("Error: No se pudo crear el espacio de memoria compartida");
-		shm_unlink(SHM_2DARRAY);
-	   	exit(1);
-	}
-	
-	return fd_2darray;
-}
-
-void asignarMemoriaSHM(int fd_array, int tamanioBloqueMemoria){
-		
-	if(-1 == ftruncate(fd_array, tamanioBloqueMemoria) ){
-		//printf("Error shared memory cannot be resized \n");
-		perror("Error: No se pudo crear el espacio de memoria compartida");
-		close(fd_array);
-		shm_unlink(SHM_2DARRAY);
-		exit(1);
-	}
-}
-
-// definir intervalos de procesos --> fijo a 4 intervalos, por ahora
-int * DefinirIntervalos(int tamanioMatriz){
-//void DefinirIntervalos(int * lista_intervalos, int tamanioMatriz){
-	int * lista_intervalos = (int *)malloc(sizeof(int) * NUM_PROCESSES);
-	int modulo = tamanioMatriz % NUM_PROCESSES;
-	int cociente = tamanioMatriz / NUM_PROCESSES;
-	
-	// falta el caso en el que el tamaño de la matriz es menor que el numero de hilos
-	// pero por ahora no importa
-	if(cociente != 0){
-		for(int i = 0; i < NUM_PROCESSES; i++){
-			if(i < NUM_PROCESSES - 1){
-				lista_intervalos[i] = cociente;
-			}
-			
-			if(i == NUM_PROCESSES - 1){
-				lista_intervalos[i] = cociente + modulo;
-			}
-		}
-	}
-	
-	if(cociente == 0){
-		for(int i = 0; i < NUM_PROCESSES; i++){
-			lista_intervalos[i] = cociente;
-		}
-	}
-	return lista_intervalos;
-}
-
-
-
-void MostrarMatriz(int ** p_matriz, int tamanioMatriz, int posInicio){
-	int i, j;
-	for(i = 0; i < tamanioMatriz; i++){ // rows
-		for(j = 0; j < tamanioMatriz; j++){ // columns
-			printf("%d ", (* p_matriz)[(i * tamanioMatriz + j) + posInicio]);
-		}
-		printf("\n");
-	}
-	printf("\n\n");
-}
-
 void MostrarContenidoBloqueMemoria(int ** p_matriz, int dimensiones){
 	int i;
 	for(i = 0; i < dimensiones; i++){
@@ -1,44 +1,52 @@
 /*
-Regla para dividir el tamanio de la matriz por el numero de hilos
+Reparto del trabajo entre hilos
 
-Ejemplo: si tengo tamanio 100 de matriz y 4 hilos, cada hilo hara 25 filas
+Antes se dividian las filas en NUM_THREADS tramos iguales y el ultimo hilo se
+quedaba con todo el residuo (100 filas y 12 hilos: 11 hilos con 8 filas y uno
+con 12), y no funcionaba con matrices mas pequenias que el numero de hilos.
 
-Si tengo tamanio 100 de matriz y 12 hilos, entonces
-
-100 / 12 = 8, residuo = 4
-
-entonces, se puede tener 11 hilos que hagan 8 filas y un hilo que haga 8 + 4 = 12
+Ahora la matriz resultado se divide en azulejos 2D (planificador_azulejos.c).
+Cada hilo empieza con un tramo de azulejos en su propia cola y, cuando la
+termina, roba azulejos de las colas de los hilos que van mas lentos.
 */
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
 #include <pthread.h>
-#define NUM_THREADS 2
+
+#include "matriz.h"
+#include "pool_hilos.h"
+#include "planificador_azulejos.h"
+#include "verificacion.h"
+
+// para compilar: gcc -pthread multiplicacion_matrices_cuadradas_hilos.c matriz.c paginas_grandes.c pool_memoria.c pool_hilos.c planificador_azulejos.c verificacion.c -lm
+// uso: ./a.out [tamanio] [numero de hilos] [repeticiones] [-f vectores de Freivalds, 0 para comparar exacto]
+
+#define NUM_THREADS 2 // numero de hilos por defecto
 
 struct datos_hilo{
-	int limite_inferior;
-	int limite_superior;
 	int tamanioMatriz;
-	int *** matrizResultado;
-	int *** matrizA;
-	int *** matrizB;
+	struct matriz * matrizResultado;
+	struct matriz * matrizA;
+	struct matriz * matrizB;
+	struct planificador * planificador;
 };
 
-struct datos_hilo arreglo_datos_hilo[NUM_THREADS];
-
-void InicializarMatricesCuadradas(int ***, int ***, int);
-void MostrarMatriz(int***, int);
-void *MultiplicarMatricesCuadradas(void *);
-void DefinirIntervalos(int **, int);
+void MultiplicarMatricesCuadradas(void *);
+void MultiplicarAzulejo(const struct azulejo *, void *);
 
 int main(int argc, char *argv[]){
 	srand(time(NULL));
 	
 	int tamanioMatriz;
-	int ** p_matrizA;
-	int ** p_matrizB;
-	int ** p_matrizResultado;
-	clock_t tiempo_inicio, tiempo_final;
+	int numeroHilos = NUM_THREADS;
+	int repeticiones = 1;
+	int repeticionesFreivalds = leerOpcionVerificacion(&argc, argv);
+	int correcto = 1;
+	struct matriz * p_matrizA;
+	struct matriz * p_matrizB;
+	struct matriz * p_matrizResultado;
+	struct timespec begin, end;
 	double tiempo_transcurrido;
 	// NOTA: no se puede hacer esto
 	// int ** p_matrizA, p_matrizB, p_matrizResultado;
@@ -46,111 +54,94 @@ int main(int argc, char *argv[]){
 	// supuestamente, se deberia hacer
 	// int ** p_matrizA, ** p_matrizB, ** p_matrizResultado;
 	
-	if (argc != 2){
+	if (argc < 2){
 		printf("No se paso un tamaÃ±o de matriz. Se fijara uno por defecto\n\n");
 		tamanioMatriz = 56;
 	}
 	
-	if (argc == 2){
+	if (argc >= 2){
 		printf("argumento en argv[1]:	%s\n", argv[1]);
 		//tamanio_matriz = (int)&argv[1];
 		tamanioMatriz = atoi(argv[1]);
 	}
 	
-	InicializarMatricesCuadradas(&p_matrizA, &p_matrizB, tamanioMatriz);
-	
-	p_matrizResultado = (int **)malloc(tamanioMatriz * sizeof(int *));
-	pthread_t hilos[NUM_THREADS];
-	int *lista_intervalos;
-	
-	DefinirIntervalos(&lista_intervalos, tamanioMatriz);
-	
-	int limite_superior = lista_intervalos[0];
-	int limite_inferior = 0;
-	int rc;
-	int i;
-	long t;
-	tiempo_inicio = clock();
-	for(i = 0; i < NUM_THREADS; i++){
-		printf("\nLimite inferior: %d		Limite superior: %d\n", limite_inferior, limite_superior);
-		arreglo_datos_hilo[i].limite_inferior = limite_inferior;
-		arreglo_datos_hilo[i].limite_superior = limite_superior;
-		arreglo_datos_hilo[i].tamanioMatriz = tamanioMatriz;
-		arreglo_datos_hilo[i].matrizA = &p_matrizA;
-		arreglo_datos_hilo[i].matrizB = &p_matrizB;
-		arreglo_datos_hilo[i].matrizResultado = &p_matrizResultado;
-		//tiempo_inicio = clock();
-		rc = pthread_create(&hilos[i], NULL, MultiplicarMatricesCuadradas, (void *) &arreglo_datos_hilo[i]);
-		if(rc){
-			printf("ERROR; return code from pthread_create() is %d\n", rc);
-			exit(-1);
-		}
-		
-		if(i + 1 < NUM_THREADS){
-			limite_inferior = limite_superior;
-			limite_superior = limite_superior + lista_intervalos[i + 1];
-		}
-		pthread_join(hilos[i], NULL);
+	// el numero de hilos y las repeticiones se fijan en tiempo de ejecucion
+	if (argc >= 3){
+		numeroHilos = atoi(argv[2]);
+	}
+	if (argc >= 4){
+		repeticiones = atoi(argv[3]);
 	}
-	tiempo_final = clock();
-	tiempo_transcurrido = (double)(tiempo_final - tiempo_inicio) / CLOCKS_PER_SEC;
-	printf("\ntiempo transcurrido multiplicacion_matrices:	%f\n", tiempo_transcurrido);
-	//MostrarMatriz(&p_matrizA, tamanioMatriz);
-	//MostrarMatriz(&p_matrizB, tamanioMatriz);
 	
-	//MostrarMatriz(&p_matrizResultado, tamanioMatriz);
+	p_matrizA = crearMatriz(tamanioMatriz, tamanioMatriz);
+	p_matrizB = crearMatriz(tamanioMatriz, tamanioMatriz);
+	inicializarMatricesCuadradas(p_matrizA, p_matrizB);
 	
-	system("pause");
-	pthread_exit(NULL);
-}
-
-
-// inicializar matrices cuadradas con numeros int random 
-void InicializarMatricesCuadradas(int *** p_matrizA, int *** p_matrizB, int tamanioMatriz){
-	int i, j, numeroA, numeroB;
-	* p_matrizA = (int **)malloc(tamanioMatriz * sizeof(int *));
-	* p_matrizB = (int **)malloc(tamanioMatriz * sizeof(int *));
-	
-	for(i = 0; i < tamanioMatriz; i++){
-		(* p_matrizA)[i] = (int *)malloc(tamanioMatriz * sizeof(int));
-		(* p_matrizB)[i] = (int *)malloc(tamanioMatriz * sizeof(int));
-		for(j = 0; j < tamanioMatriz; j++){
-			numeroA = rand() % 10 + 1;
-			numeroB = rand() % 10 + 1;
-			(* p_matrizA)[i][j] = numeroA;
-			(* p_matrizB)[i][j] = numeroB;
+	p_matrizResultado = crearMatriz(tamanioMatriz, tamanioMatriz);
+	
+	// los hilos se crean una sola vez y se reutilizan en todas las repeticiones
+	struct pool_hilos * pool = crearPoolHilos(numeroHilos);
+	numeroHilos = pool->numeroHilos;
+	
+	// division de la matriz resultado en azulejos, con una cola por hilo
+	int altoAzulejo, anchoAzulejo;
+	elegirTamanioAzulejo(tamanioMatriz, tamanioMatriz, numeroHilos, &altoAzulejo, &anchoAzulejo);
+	struct planificador * planificador = crearPlanificador(tamanioMatriz, tamanioMatriz, altoAzulejo, anchoAzulejo, numeroHilos);
+	printf("\nazulejos de %d x %d para %d hilos\n", altoAzulejo, anchoAzulejo, numeroHilos);
+	
+	struct datos_hilo datos_operacion;
+	datos_operacion.tamanioMatriz = tamanioMatriz;
+	datos_operacion.matrizA = p_matrizA;
+	datos_operacion.matrizB = p_matrizB;
+	datos_operacion.matrizResultado = p_matrizResultado;
+	datos_operacion.planificador = planificador;
+	int i, r;
+	
+	for(r = 0; r < repeticiones; r++){
+		// tiempo wall: clock() sumaria el tiempo de cpu de todos los hilos
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		reiniciarPlanificador(planificador);
+		for(i = 0; i < numeroHilos; i++){
+			encolarTarea(pool, MultiplicarMatricesCuadradas, (void *) &datos_operacion);
 		}
+		// todas las tareas corren en paralelo; se espera al final
+		esperarPoolHilos(pool);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		tiempo_transcurrido = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) * 1e-9;
+		printf("\ntiempo transcurrido multiplicacion_matrices:	%f\n", tiempo_transcurrido);
+	}
+	mostrarEstadisticasPlanificador(planificador);
+	mostrarEstadisticasPool(pool);
+	if(repeticionesFreivalds >= 0){
+		correcto = mostrarVerificacion(p_matrizA, p_matrizB, p_matrizResultado, repeticionesFreivalds);
 	}
+	//mostrarMatriz(p_matrizA);
+	//mostrarMatriz(p_matrizB);
+	
+	//mostrarMatriz(p_matrizResultado);
+	
+	destruirPoolHilos(pool);
+	destruirPlanificador(planificador);
+	liberarMemoriaMatriz(p_matrizA);
+	liberarMemoriaMatriz(p_matrizB);
+	liberarMemoriaMatriz(p_matrizResultado);
+	
+	return correcto ? 0 : 1;
 }
 
-void *MultiplicarMatricesCuadradas(void *parametros_hilo){
-	int i, j, k, acumulado, limite_inferior, limite_superior, tamanioMatriz;
-	int *** p_matrizResultado, *** p_matrizA, *** p_matrizB;
+
+// tarea de cada hilo del pool: tomar y robar azulejos hasta que no quede ninguno
+void MultiplicarMatricesCuadradas(void *parametros_hilo){
 	struct datos_hilo * datos_operacion;
 	struct timespec start_ts, end_ts;
 	clockid_t threadClockId;
 	
 	datos_operacion = (struct datos_hilo *) parametros_hilo;
-	tamanioMatriz = datos_operacion->tamanioMatriz;
-	limite_inferior = datos_operacion->limite_inferior;
-	limite_superior = datos_operacion->limite_superior;
-	p_matrizA = datos_operacion->matrizA;
-	p_matrizB = datos_operacion->matrizB;
-	p_matrizResultado = datos_operacion->matrizResultado;
 	
 	pthread_getcpuclockid(pthread_self(), &threadClockId);
 	//clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start_ts);
 	clock_gettime(threadClockId, &start_ts);
-	for(i = limite_inferior; i < limite_superior; i++){ // este bucle recorre las filas de la matriz multiplicando
-		(* p_matrizResultado)[i] = (int *)malloc(tamanioMatriz * sizeof(int));
-		for(j = 0; j < tamanioMatriz; j++){ // este bucle recorre los elementos de la fila
-			acumulado = 0;
-			for(k = 0; k < tamanioMatriz; k++){ // este bucle recorre los elementos de la columna
-				acumulado += (* p_matrizA)[i][k] * (* p_matrizB)[k][j];
-			}
-			(* p_matrizResultado)[i][j] = acumulado;
-		}
-	}
+	trabajarPlanificador(datos_operacion->planificador, indiceHiloActual(), MultiplicarAzulejo, datos_operacion);
 	//clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end_ts);
 	clock_gettime(threadClockId, &end_ts);
 
@@ -159,41 +150,24 @@ void *MultiplicarMatricesCuadradas(void *parametros_hilo){
 	printf("Thread CPU time: %f seconds\n", elapsed_time);
 }
 
-// mostrar el contenido de una matriz cuadrada
-void MostrarMatriz(int *** p_matriz, int tamanioMatriz){
-	int i, j;
-	for(i = 0; i < tamanioMatriz; i++){
-		for(j = 0; j < tamanioMatriz; j++){
-			printf("%d ", (* p_matriz)[i][j]);
-		}
-		printf("\n");
-	}
-	printf("\n\n");
-}
-
-void DefinirIntervalos(int ** lista_intervalos, int tamanioMatriz){
-	(* lista_intervalos) = (int *)malloc(sizeof(int) * NUM_THREADS);
-	int modulo = tamanioMatriz % NUM_THREADS;
-	int cociente = tamanioMatriz / NUM_THREADS;
-	
-	// falta el caso en el que el tamaño de la matriz es menor que el numero de hilos
-	// pero por ahora no importa
-	if(cociente != 0){
-		for(int i = 0; i < NUM_THREADS; i++){
-			if(i < NUM_THREADS - 1){
-				(* lista_intervalos)[i] = cociente;
-			}
-			
-			if(i == NUM_THREADS - 1){
-				(* lista_intervalos)[i] = cociente + modulo;
-			}
-		}
-	}
+// multiplicar un azulejo de la matriz resultado
+void MultiplicarAzulejo(const struct azulejo * azulejo, void * contexto){
+	int i, j, k, acumulado, tamanioMatriz;
+	struct datos_hilo * datos_operacion = (struct datos_hilo *) contexto;
+	struct matriz * p_matrizResultado, * p_matrizA, * p_matrizB;
 	
-	if(cociente == 0){
-		for(int i = 0; i < NUM_THREADS; i++){
-			(* lista_intervalos)[i] = cociente;
+	tamanioMatriz = datos_operacion->tamanioMatriz;
+	p_matrizA = datos_operacion->matrizA;
+	p_matrizB = datos_operacion->matrizB;
+	p_matrizResultado = datos_operacion->matrizResultado;
+	
+	for(i = azulejo->fila; i < azulejo->fila + azulejo->filas; i++){ // este bucle recorre las filas del azulejo
+		for(j = azulejo->columna; j < azulejo->columna + azulejo->columnas; j++){ // este bucle recorre los elementos de la fila
+			acumulado = 0;
+			for(k = 0; k < tamanioMatriz; k++){ // este bucle recorre los elementos de la columna
+				acumulado += ELEMENTO(p_matrizA, i, k) * ELEMENTO(p_matrizB, k, j);
+			}
+			ELEMENTO(p_matrizResultado, i, j) = acumulado;
 		}
 	}
-	//return &lista_intervalos;
 }
@@ -0,0 +1,113 @@
+/*
+ Multiplicacion distribuida con SUMMA (gemm_summa.h)
+
+ Cada proceso genera solo su bloque de A y B (los mismos valores que
+ inicializarMatricesCuadradasSemilla daria a las matrices enteras), y se mide
+ gemmSumma difundiendo los paneles con MPI_Bcast (cada panel se espera antes
+ de multiplicarlo) y con MPI_Ibcast (el panel siguiente viaja mientras se
+ multiplica el actual). El tiempo de cada repeticion es el del proceso mas
+ lento; se reporta el minimo, GOP/s, y el maximo entre procesos del tiempo de
+ calculo, de la espera por paneles y de los bytes recibidos. El resultado se
+ verifica con verificarSumma.
+
+ Uso: mpirun -np P ./multiplicacion_summa [-n N] [-b ancho] [-g filas] [-t hilos]
+                                          [-r repeticiones] [-s semilla] [-f vectores]
+
+ 	-n lado de las matrices (por defecto 2048)
+ 	-b columnas de A por paso de SUMMA (por defecto 256)
+ 	-g filas de la malla de procesos (por defecto las elige MPI_Dims_create)
+ 	-t hilos de OpenMP por proceso (por defecto OMP_NUM_THREADS)
+ 	-r repeticiones medidas (por defecto 3)
+ 	-s semilla de A y B (por defecto 1)
+ 	-f vectores de Freivalds (por defecto 20)
+
+ En una sola maquina, con mas procesos que nucleos:
+ mpirun -np 4 --oversubscribe ./multiplicacion_summa -n 2048 -t 1
+ (como root hace falta ademas --allow-run-as-root)
+
+ para compilar (o make mpi):
+ mpicc -O2 -fopenmp multiplicacion_summa.c gemm_summa.c -L. -lmatrices -lrt -lm
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <mpi.h>
+
+#include "gemm_summa.h"
+#include "gemm.h"
+#include "verificacion.h"
+
+int main(int argc, char *argv[]){
+	int lado = 2048, anchoPanel = 256, filasMalla = 0, hilos = 0, repeticiones = 3, vectores = REPETICIONES_FREIVALDS;
+	uint64_t semilla = 1;
+	struct mallaSumma malla;
+	struct matrizDistribuida * A, * B, * C;
+	struct estadisticasSumma estadisticas;
+	int opcion, solapar, r, nivel, correcto, error = 0;
+	double inicio, tiempo, minimo, local[3], peor[3];
+
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &nivel);
+	while((opcion = getopt(argc, argv, "n:b:g:t:r:s:f:")) != -1){
+		switch(opcion){
+			case 'n': lado = atoi(optarg); break;
+			case 'b': anchoPanel = atoi(optarg); break;
+			case 'g': filasMalla = atoi(optarg); break;
+			case 't': hilos = atoi(optarg); break;
+			case 'r': repeticiones = atoi(optarg); break;
+			case 's': semilla = strtoull(optarg, NULL, 10); break;
+			case 'f': vectores = atoi(optarg); break;
+			default: error = 1; break;
+		}
+	}
+	if(error || lado < 1 || anchoPanel < 1 || repeticiones < 1 || crearMallaSumma(MPI_COMM_WORLD, filasMalla, &malla) != 0){
+		fprintf(stderr, "uso: mpirun -np P %s [-n N] [-b ancho] [-g filas (divisor de P)] [-t hilos] [-r repeticiones] [-s semilla] [-f vectores]\n", argv[0]);
+		MPI_Finalize();
+		return 1;
+	}
+	if(hilos > 0){
+		fijarHilosGemm(hilos);
+	}
+
+	A = crearMatrizDistribuida(&malla, lado, lado);
+	B = crearMatrizDistribuida(&malla, lado, lado);
+	C = crearMatrizDistribuida(&malla, lado, lado);
+	inicializarMatrizDistribuida(A, semilla, 1, 10);
+	inicializarMatrizDistribuida(B, semilla + 1, 1, 10);
+
+	if(malla.rango == 0){
+		printf("N = %d, malla de %d x %d procesos, bloques de hasta %d x %d, paneles de %d, %d hilos por proceso\n",
+			lado, malla.filasMalla, malla.columnasMalla,
+			(lado + malla.filasMalla - 1) / malla.filasMalla, (lado + malla.columnasMalla - 1) / malla.columnasMalla, anchoPanel, hilosGemm());
+		printf("%-8s %10s %9s %12s %12s %12s %s\n", "difusion", "min (s)", "GOP/s", "calculo (s)", "espera (s)", "MiB recib.", "correcto");
+	}
+	for(solapar = 0; solapar < 2; solapar++){
+		minimo = 0;
+		for(r = 0; r < repeticiones; r++){
+			MPI_Barrier(malla.malla);
+			inicio = MPI_Wtime();
+			gemmSumma(&malla, A, B, C, anchoPanel, solapar, &estadisticas);
+			tiempo = MPI_Wtime() - inicio;
+			MPI_Allreduce(MPI_IN_PLACE, &tiempo, 1, MPI_DOUBLE, MPI_MAX, malla.malla);
+			if(r == 0 || tiempo < minimo){
+				minimo = tiempo;
+				local[0] = estadisticas.tiempoEspera;
+				local[1] = estadisticas.tiempoCalculo;
+				local[2] = estadisticas.bytesRecibidos;
+			}
+		}
+		// maximos entre los procesos, de la repeticion mas rapida
+		MPI_Reduce(local, peor, 3, MPI_DOUBLE, MPI_MAX, 0, malla.malla);
+		correcto = verificarSumma(&malla, A, B, C, vectores, semilla + 2);
+		if(malla.rango == 0){
+			printf("%-8s %10.5f %9.2f %12.5f %12.5f %12.1f %s\n", solapar ? "ibcast" : "bcast", minimo, 2.0 * lado * lado * lado / minimo * 1e-9,
+				peor[1], peor[0], peor[2] / 1048576.0, correcto ? "si" : "NO");
+		}
+	}
+
+	liberarMatrizDistribuida(A);
+	liberarMatrizDistribuida(B);
+	liberarMatrizDistribuida(C);
+	liberarMallaSumma(&malla);
+	MPI_Finalize();
+	return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ Multiplicar matrices guardadas en archivos .mat (formato de archivo_matriz.h)
+
+ A y B se mapean de solo lectura y se pasan tal cual a gemm: no hay lectura
+ ni copia previa, los kernels empaquetan directamente desde el mapa. C se
+ crea con su tamanio final y se mapea compartida, asi el producto se escribe
+ en el archivo; al cerrar se guarda la suma de verificacion.
+
+ Uso:
+ 	./multiplicar_archivos -g N [-e tipo] [-s semilla] salida.mat
+ 		genera una matriz N x N aleatoria (tipo int32, int64, float o double)
+ 	./multiplicar_archivos [-t hilos] [-v] [-p] [-m MiB] [-f vectores] [-D] A.mat B.mat C.mat
+ 		C = A * B; -v revisa la suma de A y B al abrir, -p precarga los
+ 		mapas (MAP_POPULATE) para separar el tiempo de disco del de calculo,
+ 		-m multiplica fuera de memoria (gemm_fuera_memoria.h) leyendo
+ 		azulejos del disco sin usar mas de MiB megabytes de buffers
+ 	./multiplicar_archivos -c archivo.mat
+ 		revisa la suma de verificacion de un archivo
+
+ Con int32 (y sin -m) se sondea la densidad de A al cargarla
+ (matriz_dispersa.h): si conviene se convierte a CSR o BCSR y se multiplica
+ dispersa por densa; -D fuerza siempre el producto denso.
+
+ Reporta el tiempo de abrir (cargar), multiplicar y cerrar (guardar C), y
+ verifica C con Freivalds (verificacion.h): -f cambia el numero de vectores
+ (por defecto 20, un C incorrecto pasa con probabilidad menor que 2^-20).
+
+ para compilar (o make):
+ gcc -O2 -fopenmp multiplicar_archivos.c -L. -lmatrices -lrt -lm
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "archivo_matriz.h"
+#include "aleatorio_contador.h"
+#include "gemm.h"
+#include "gemm_fuera_memoria.h"
+#include "gemm_tipos.h"
+#include "matriz_dispersa.h"
+#include "verificacion.h"
+
+double tiempoWall(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// valores de 1 a 10 como inicializarMatricesCuadradas; con int32 la misma
+// matriz que inicializarMatrizAleatoria con la misma semilla
+static int generarArchivo(const char * ruta, int lado, enum tipoArchivoMatriz tipo, uint64_t semilla){
+	struct archivoMatriz archivo;
+	uint64_t clave = claveAleatoria(semilla);
+	double inicio = tiempoWall();
+	int i;
+
+	if(crearArchivoMatriz(ruta, lado, lado, tipo, &archivo) != 0){
+		return -1;
+	}
+	// el elemento (i, j) es el numero i * lado + j de la secuencia de la semilla
+	#pragma omp parallel for schedule(static)
+	for(i = 0; i < lado; i++){
+		void * fila = FILA_TIPADA(&archivo.datos, i);
+		int j, valor;
+		if(tipo == ARCHIVO_INT32){
+			llenarAleatorio((int *)fila, lado, clave, (uint64_t)i * lado, 1, 10);
+			continue;
+		}
+		for(j = 0; j < lado; j++){
+			valor = (int)enteroEnRango(aleatorioContador(clave, (uint64_t)i * lado + j), 10) + 1;
+			switch(tipo){
+				case ARCHIVO_INT64: ((int64_t *)fila)[j] = valor; break;
+				case ARCHIVO_FLOAT: ((float *)fila)[j] = valor; break;
+				case ARCHIVO_DOUBLE: ((double *)fila)[j] = valor; break;
+				default: break;
+			}
+		}
+	}
+	if(cerrarArchivoMatriz(&archivo) != 0){
+		return -1;
+	}
+	printf("%s: %d x %d %s en %.3f s\n", ruta, lado, lado, nombresTiposArchivo[tipo], tiempoWall() - inicio);
+	return 0;
+}
+
+// C = A * B con Freivalds (verificacion.h); int32 con la aritmetica modular de
+// gemmEntero32 y exacta si el producto es chico, los demas con el motor de su tipo
+static int verificarProducto(const struct archivoMatriz * A, const struct archivoMatriz * B, const struct archivoMatriz * C,
+		int repeticiones, uint64_t semilla){
+	struct matriz a, b, c;
+
+	if(C->cabecera.tipo == ARCHIVO_INT32){
+		a = matrizArchivo(A);
+		b = matrizArchivo(B);
+		c = matrizArchivo(C);
+		return verificarMultiplicacion(&a, &b, &c, repeticiones, semilla);
+	}
+	return buscarMotorTipo(nombresTiposArchivo[C->cabecera.tipo])->freivalds(&A->datos, &B->datos, &C->datos, repeticiones, semilla);
+}
+
+static int multiplicarArchivos(const struct archivoMatriz * A, const struct archivoMatriz * B, struct archivoMatriz * C){
+	int m = A->datos.filas, n = B->datos.columnas, k = A->datos.columnas;
+	int lda = A->datos.ld, ldb = B->datos.ld, ldc = C->datos.ld;
+
+	switch(C->cabecera.tipo){
+		case ARCHIVO_INT32:
+			return gemmEntero32(m, n, k, 1, A->datos.datos, lda, B->datos.datos, ldb, 0, C->datos.datos, ldc);
+		case ARCHIVO_INT64:
+			return gemmEntero64(m, n, k, 1, A->datos.datos, lda, B->datos.datos, ldb, 0, C->datos.datos, ldc);
+		case ARCHIVO_FLOAT:
+			return gemmFlotante(m, n, k, 1, A->datos.datos, lda, B->datos.datos, ldb, 0, C->datos.datos, ldc);
+		case ARCHIVO_DOUBLE:
+			return gemmDoble(m, n, k, 1, A->datos.datos, lda, B->datos.datos, ldb, 0, C->datos.datos, ldc);
+		default:
+			return -1;
+	}
+}
+
+int main(int argc, char *argv[]){
+	struct archivoMatriz A, B, C;
+	struct estadisticasFueraDeMemoria fuera;
+	size_t presupuesto = 0;
+	int lado = 0, hilos = 0, opciones = ARCHIVO_LECTURA, comprobar = 0;
+	int tipo = ARCHIVO_INT32, opcion, correcto, repeticiones = REPETICIONES_FREIVALDS, soloDenso = 0;
+	uint64_t semilla = 1;
+	double inicio, tiempoCarga, tiempoConversion = 0, tiempoProducto, tiempoGuardado, tiempoVerificacion;
+	enum productoDisperso producto = PRODUCTO_DENSO;
+	struct sondeoDensidad sondeo;
+	struct matrizCsr * csr = NULL;
+	struct matrizBcsr * bcsr = NULL;
+	struct matriz a, b, c;
+
+	while((opcion = getopt(argc, argv, "g:e:s:t:vpcm:f:D")) != -1){
+		switch(opcion){
+			case 'g': lado = atoi(optarg); break;
+			case 'e':
+				tipo = tipoArchivoPorNombre(optarg);
+				if(tipo < 0){
+					fprintf(stderr, "tipo desconocido: %s (int32, int64, float o double)\n", optarg);
+					return 1;
+				}
+				break;
+			case 's': semilla = strtoull(optarg, NULL, 10); break;
+			case 't': hilos = atoi(optarg); break;
+			case 'v': opciones |= ARCHIVO_VERIFICAR; break;
+			case 'p': opciones |= ARCHIVO_PRECARGAR; break;
+			case 'c': comprobar = 1; break;
+			case 'm': presupuesto = (size_t)atol(optarg) << 20; break;
+			case 'f': repeticiones = atoi(optarg); break;
+			case 'D': soloDenso = 1; break;
+			default:
+				fprintf(stderr, "uso: %s -g N [-e tipo] [-s semilla] salida.mat | [-t hilos] [-v] [-p] [-m MiB] [-f vectores] [-D] A.mat B.mat C.mat | -c archivo.mat\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if(lado > 0){
+		if(optind >= argc){
+			fprintf(stderr, "falta el archivo de salida\n");
+			return 1;
+		}
+		return generarArchivo(argv[optind], lado, tipo, semilla) == 0 ? 0 : 1;
+	}
+	if(comprobar){
+		if(optind >= argc){
+			fprintf(stderr, "falta el archivo a revisar\n");
+			return 1;
+		}
+		inicio = tiempoWall();
+		if(abrirArchivoMatriz(argv[optind], ARCHIVO_VERIFICAR, &A) != 0){
+			return 1;
+		}
+		printf("%s: %d x %d %s, suma %016llx correcta (%.3f s)\n", argv[optind], A.datos.filas, A.datos.columnas,
+			nombresTiposArchivo[A.cabecera.tipo], (unsigned long long)A.cabecera.suma, tiempoWall() - inicio);
+		cerrarArchivoMatriz(&A);
+		return 0;
+	}
+	if(argc - optind < 3){
+		fprintf(stderr, "faltan los archivos A, B y C\n");
+		return 1;
+	}
+	if(hilos > 0){
+		fijarHilosGemm(hilos);
+	}
+
+	inicio = tiempoWall();
+	if(abrirArchivoMatriz(argv[optind], opciones, &A) != 0){
+		return 1;
+	}
+	if(abrirArchivoMatriz(argv[optind + 1], opciones, &B) != 0){
+		return 1;
+	}
+	tiempoCarga = tiempoWall() - inicio;
+	if(A.cabecera.tipo != B.cabecera.tipo || A.datos.columnas != B.datos.filas){
+		fprintf(stderr, "A (%d x %d %s) y B (%d x %d %s) no se pueden multiplicar\n",
+			A.datos.filas, A.datos.columnas, nombresTiposArchivo[A.cabecera.tipo],
+			B.datos.filas, B.datos.columnas, nombresTiposArchivo[B.cabecera.tipo]);
+		return 1;
+	}
+	if(crearArchivoMatriz(argv[optind + 2], A.datos.filas, B.datos.columnas, A.cabecera.tipo, &C) != 0){
+		return 1;
+	}
+
+	// el formato de A se elige una vez al cargar, no en cada producto
+	if(A.cabecera.tipo == ARCHIVO_INT32 && presupuesto == 0 && !soloDenso){
+		a = matrizArchivo(&A);
+		inicio = tiempoWall();
+		sondearDensidad(&a, MUESTRAS_DENSIDAD, semilla, &sondeo);
+		producto = elegirProductoDisperso(&sondeo);
+		if(producto == PRODUCTO_CSR){
+			csr = crearCsr(&a);
+		}
+		else if(producto == PRODUCTO_BCSR){
+			bcsr = crearBcsr(&a);
+		}
+		tiempoConversion = tiempoWall() - inicio;
+	}
+
+	inicio = tiempoWall();
+	if(presupuesto > 0){
+		if(gemmFueraDeMemoria(&A, &B, &C, presupuesto, &fuera) != 0){
+			return 1;
+		}
+	}
+	else if(producto != PRODUCTO_DENSO){
+		b = matrizArchivo(&B);
+		c = matrizArchivo(&C);
+		if(csr != NULL){
+			multiplicarCsr(csr, &b, &c, hilosGemm());
+		}
+		else{
+			multiplicarBcsr(bcsr, &b, &c, hilosGemm());
+		}
+	}
+	else{
+		multiplicarArchivos(&A, &B, &C);
+	}
+	tiempoProducto = tiempoWall() - inicio;
+	// los vectores de Freivalds no salen de -s: no los puede adivinar quien genero A y B
+	inicio = tiempoWall();
+	correcto = verificarProducto(&A, &B, &C, repeticiones, (uint64_t)time(NULL));
+	tiempoVerificacion = tiempoWall() - inicio;
+
+	inicio = tiempoWall();
+	if(cerrarArchivoMatriz(&C) != 0){
+		return 1;
+	}
+	tiempoGuardado = tiempoWall() - inicio;
+	cerrarArchivoMatriz(&A);
+	cerrarArchivoMatriz(&B);
+
+	printf("%d x %d x %d %s, %d hilos\n", A.datos.filas, B.datos.columnas, A.datos.columnas,
+		nombresTiposArchivo[A.cabecera.tipo], hilosGemm());
+	printf("cargar A y B:  %10.6f s\n", tiempoCarga);
+	if(A.cabecera.tipo == ARCHIVO_INT32 && presupuesto == 0 && !soloDenso){
+		printf("sondear A:     %10.6f s (densidad ~%.4f, bloques %.0f%% llenos: producto %s", tiempoConversion,
+			sondeo.densidad, 100 * sondeo.ocupacionBloques, nombresProductosDispersos[producto]);
+		if(csr != NULL){
+			printf(", %ld no ceros", csr->noCeros);
+		}
+		else if(bcsr != NULL){
+			printf(", %ld bloques, relleno %.2f", bcsr->bloques, rellenoBcsr(bcsr));
+		}
+		printf(")\n");
+	}
+	printf("multiplicar:   %10.6f s (%.2f GOP/s)\n", tiempoProducto,
+		2.0 * A.datos.filas * B.datos.columnas * A.datos.columnas / tiempoProducto * 1e-9);
+	printf("guardar C:     %10.6f s\n", tiempoGuardado);
+	if(presupuesto > 0){
+		printf("fuera de memoria: azulejos %d x %d x %d, %ld pasos, %.1f MiB de buffers\n", fuera.azulejos.filas,
+			fuera.azulejos.columnas, fuera.azulejos.profundidad, fuera.pasos, fuera.bytesReservados / 1048576.0);
+		printf("  leido %.1f MiB en %.3f s, escrito %.1f MiB en %.3f s (hilo de E/S)\n", fuera.bytesLeidos / 1048576.0,
+			fuera.tiempoLectura, fuera.bytesEscritos / 1048576.0, fuera.tiempoEscritura);
+		printf("  calculo %.3f s, esperando E/S %.3f s\n", fuera.tiempoCalculo, fuera.tiempoEspera);
+	}
+	if(A.cabecera.tipo == ARCHIVO_INT32 && (double)A.datos.filas * B.datos.columnas * A.datos.columnas <= UMBRAL_VERIFICACION_EXACTA){
+		printf("verificar:     %10.6f s (exacta: %s)\n", tiempoVerificacion, correcto ? "correcta" : "INCORRECTA");
+	}
+	else{
+		printf("verificar:     %10.6f s (Freivalds, %d vectores: %s, error < %g)\n", tiempoVerificacion,
+			repeticiones < 1 ? 1 : repeticiones, correcto ? "correcta" : "INCORRECTA", errorFreivalds(repeticiones));
+	}
+	liberarCsr(csr);
+	liberarBcsr(bcsr);
+	return correcto ? 0 : 1;
+}
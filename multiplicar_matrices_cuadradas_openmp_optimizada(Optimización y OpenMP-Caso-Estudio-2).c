@@ -7,6 +7,23 @@ de la columna en esta matriz
 
 Esto redujo el tiempo del proceso de multiplicacion considerablemente
 sin el uso de banderas de compilacion
+
+Por defecto el trabajo se reparte en azulejos 2D con robo de trabajo
+(planificador_azulejos.c): cada hilo de OpenMP toma azulejos de su cola y roba
+de las demas cuando termina. Con "estatico" como segundo argumento se usa el
+parallel for schedule(static) por filas, para comparar.
+
+Con static, dynamic, guided o tareas como segundo argumento se usa el motor
+por azulejos con acumuladores privados (openmp_azulejos.h) con ese reparto;
+el cuarto argumento es el trozo (chunk o grainsize).
+
+uso: ./programa N [robo|estatico|static|dynamic|guided|tareas] [hilos] [trozo] [-f k]
+
+Con -f k, despues de medir se verifica C con k vectores de Freivalds
+(verificacion.h); -f 0 la compara exacto con el producto ingenuo.
+
+El numero de hilos sale de argv[3]; si no se da, de OMP_NUM_THREADS, luego del
+archivo de autoajuste y por ultimo de omp_get_max_threads().
 */
 #include <stdlib.h>
 #include <string.h>
@@ -15,22 +32,42 @@ sin el uso de banderas de compilacion
 #include <unistd.h>
 #include <omp.h>
 
+#include "matriz.h"
+#include "nucleos_simd.h"
+#include "planificador_azulejos.h"
+#include "configuracion_maquina.h"
+#include "openmp_azulejos.h"
+#include "verificacion.h"
+
 // para compilar, incluir bandera -fopenmp
+// gcc -O2 -fopenmp "multiplicar_matrices_cuadradas_openmp_optimizada(Optimización y OpenMP-Caso-Estudio-2).c" matriz.c paginas_grandes.c pool_memoria.c nucleos_simd.c planificador_azulejos.c configuracion_maquina.c openmp_azulejos.c verificacion.c -lm
+// los kernels SIMD se eligen al arrancar (MATRIZ_ISA para forzar uno)
+// sin hilos ni OMP_NUM_THREADS se usan los del archivo de autoajuste si ya se corrio ./autoajuste en esta maquina
 
 // firmas de las funciones usadas
-void inicializarMatricesCuadradas(int **, int **, int);
-void multiplicarMatricesCuadradas(int **, int **, int **, int);
-void multiplicarMatricesCuadradas2(int **, int **, int **, int);
-void mostrarMatriz(int**, int);
-void liberarMemoriaMatriz(int **, int);
-int ** crearMatriz(int);
-int ** transponerMatriz(int **, int);
+void multiplicarMatricesCuadradas(const struct matriz *, const struct matriz *, struct matriz *);
+void multiplicarMatricesCuadradasRobo(const struct matriz *, const struct matriz *, struct matriz *);
+void multiplicarAzulejo(const struct azulejo *, void *);
+
+// operandos de la multiplicacion que comparten los azulejos
+struct datos_azulejos{
+	const struct matriz * matrizA;
+	const struct matriz * matrizB;
+	struct matriz * matrizResultado;
+	funcionProductoPunto productoPunto;
+};
 
 // funcion main
 int main(int argc, char *argv[]){
 
 	int tamanioMatriz;
 	int numeroHilos;
+	int repartoEstatico = 0;
+	int reparto = -1; // del motor por azulejos; -1 usa el robo de trabajo
+	int trozo = 0;
+	int repeticionesFreivalds = leerOpcionVerificacion(&argc, argv);
+	int correcto = 1;
+	struct configuracionMaquina ajustada;
 	
 	// definiciones para tiempos cpu
 	clock_t tiempo_inicio, tiempo_final;
@@ -45,17 +82,43 @@ int main(int argc, char *argv[]){
 	// verificacion del numero de variables y asignacion de variables 
 	// para tamaño de la matriz y el numero de hilos
 	// solo se verifica el numero de variables, no si estan en el rango aceptado
-	if (argc != 2){
+	if (argc < 2){
 		printf("No se paso un tamaño de matriz. Se fijara uno por defecto\n\n");
 		tamanioMatriz = 10;
-		numeroHilos = 4;
 	}
 	
-	if (argc == 2){
+	if (argc >= 2){
 		printf("argumento en argv[1]:	%s\n", argv[1]);
 		tamanioMatriz = atoi(argv[1]);
-		numeroHilos = 4;
 	}
+	
+	// hilos: argv[3], OMP_NUM_THREADS, el autoajuste de esta maquina o todos los nucleos
+	numeroHilos = omp_get_max_threads();
+	if (argc >= 4 && atoi(argv[3]) > 0){
+		numeroHilos = atoi(argv[3]);
+	}
+	else if (getenv("OMP_NUM_THREADS") == NULL && cargarConfiguracionMaquina(&ajustada) == 0 && ajustada.numeroHilos > 0){
+		numeroHilos = ajustada.numeroHilos;
+	}
+	
+	// "estatico" en argv[2] usa el reparto fijo por filas; static, dynamic,
+	// guided o tareas, el motor por azulejos
+	if (argc >= 3 && strcmp(argv[2], "estatico") == 0){
+		repartoEstatico = 1;
+	}
+	else if (argc >= 3 && strcmp(argv[2], "robo") != 0){
+		reparto = repartoOpenmpPorNombre(argv[2]);
+		if (reparto < 0){
+			fprintf(stderr, "reparto desconocido: %s\n", argv[2]);
+			return 1;
+		}
+	}
+	if (argc >= 5){
+		trozo = atoi(argv[4]);
+	}
+	printf("kernels SIMD: %s, hilos: %d, reparto: %s\n", nucleosActuales->nombre, numeroHilos,
+		repartoEstatico ? "estatico" : reparto >= 0 ? nombresRepartosOpenmp[reparto] : "robo");
+	
 	//inicializar generador de numeros aleatorios
 	srand(getpid());
 	
@@ -63,32 +126,40 @@ int main(int argc, char *argv[]){
 	omp_set_num_threads(numeroHilos);
 	
 	// declaracion e inicializacion de variables
-	int ** p_matrizA, ** p_matrizB, ** p_matrizResultado;
+	struct matriz * p_matrizA, * p_matrizB, * p_matrizResultado;
 	
 	// creacion de matrices
-	p_matrizA = crearMatriz(tamanioMatriz);
-	p_matrizB = crearMatriz(tamanioMatriz);
-	p_matrizResultado = crearMatriz(tamanioMatriz);
+	p_matrizA = crearMatriz(tamanioMatriz, tamanioMatriz);
+	p_matrizB = crearMatriz(tamanioMatriz, tamanioMatriz);
+	p_matrizResultado = crearMatriz(tamanioMatriz, tamanioMatriz);
 	
 
 	//llenar de 0s la matriz resultado
-	for (int i = 0; i < tamanioMatriz; i++) {
-		memset(p_matrizResultado[i], 0, tamanioMatriz * sizeof(int));
-	}
+	ponerCerosMatriz(p_matrizResultado);
 
 	
 	// inicializacion de matrices operandos
-	inicializarMatricesCuadradas(p_matrizA, p_matrizB, tamanioMatriz);
+	inicializarMatricesCuadradas(p_matrizA, p_matrizB);
 	
-	// trasposicion de la matriz B
-	p_matrizB = transponerMatriz(p_matrizB, tamanioMatriz);
+	// trasposicion de la matriz B (el motor por azulejos la usa sin transponer)
+	if(reparto < 0){
+		p_matrizB = transponerMatriz(p_matrizB);
+	}
 	
 	// inicio de los relojes para los tiempos de cpu y wall
 	clock_gettime(CLOCK_REALTIME, &begin);
 	tiempo_inicio = clock();
 
 	// multiplicacion de las matrices cuadradas
-	multiplicarMatricesCuadradas(p_matrizA, p_matrizB, p_matrizResultado, tamanioMatriz);
+	if(repartoEstatico){
+		multiplicarMatricesCuadradas(p_matrizA, p_matrizB, p_matrizResultado);
+	}
+	else if(reparto >= 0){
+		multiplicarOpenmpAzulejos(p_matrizA, p_matrizB, p_matrizResultado, numeroHilos, reparto, trozo);
+	}
+	else{
+		multiplicarMatricesCuadradasRobo(p_matrizA, p_matrizB, p_matrizResultado);
+	}
 
 	// medicion de los tiempos finales de los relojes para cpu y wall
 	tiempo_final = clock();
@@ -107,109 +178,72 @@ int main(int argc, char *argv[]){
 	// mostrar tiempos en pantalla
 	printf("\ntiempo transcurrido multiplicacion_matrices (CPU/WALL):	%f	%f\n", tiempo_transcurrido, elapsed);
 
-	// liberar memoria reservada para las matrices
-	liberarMemoriaMatriz(p_matrizA, tamanioMatriz);
-	liberarMemoriaMatriz(p_matrizB, tamanioMatriz);
-	liberarMemoriaMatriz(p_matrizResultado, tamanioMatriz);
-	
-	return 0;
-}
-
-
-// crear matrices cuadradas
-int ** crearMatriz(int tamanioMatriz){
-	int ** matriz = (int **)malloc(tamanioMatriz * sizeof(int *));
-	int i, j;
-	
-	if(matriz == NULL){
-		perror("No se pudo reservar memoria para los punteros de las columnas");
-		exit(1);
-	}
-	
-	for(i = 0; i < tamanioMatriz; i++){
-		matriz[i] = (int *)malloc(tamanioMatriz * sizeof(int));
-	
-		if(matriz[i] == NULL){
-			perror("No se pudo reservar memoria para los punteros de las filas");
-			
-			for(j = 0; j < i; j++){
-				free(matriz[j]);
-				}
-				free(matriz);
-				exit(1);
-			}
+	// se verifica con B de nuevo sin transponer, fuera de la parte medida
+	if(repeticionesFreivalds >= 0){
+		if(reparto < 0){
+			p_matrizB = transponerMatriz(p_matrizB);
 		}
-	
-	return matriz;
-}
+		correcto = mostrarVerificacion(p_matrizA, p_matrizB, p_matrizResultado, repeticionesFreivalds);
+	}
 
-// inicializar matrices cuadradas con numeros int random 
-void inicializarMatricesCuadradas(int ** p_matrizA, int ** p_matrizB, int tamanioMatriz){
-	int i, j, numeroA, numeroB;
+	// liberar memoria reservada para las matrices
+	liberarMemoriaMatriz(p_matrizA);
+	liberarMemoriaMatriz(p_matrizB);
+	liberarMemoriaMatriz(p_matrizResultado);
 	
-	for(i = 0; i < tamanioMatriz; i++){
-		for(j = 0; j < tamanioMatriz; j++){
-			numeroA = rand() % 10 + 1;
-			numeroB = rand() % 10 + 1;
-			p_matrizA[i][j] = numeroA;
-			p_matrizB[i][j] = numeroB;
-		}
-	}
+	return correcto ? 0 : 1;
 }
 
+
 // multiplicar las matrices cuadradas y generar una matriz resultado tambien cuadrada
-void multiplicarMatricesCuadradas(int ** p_matrizA, int ** p_matrizB, int ** p_matrizResultado, int tamanioMatriz){
-	int i, j, k, acumulado;
+void multiplicarMatricesCuadradas(const struct matriz * p_matrizA, const struct matriz * p_matrizB, struct matriz * p_matrizResultado){
+	int i, j, acumulado;
+	int tamanioMatriz = p_matrizA->filas;
+	funcionProductoPunto productoPunto = nucleosActuales->productoPunto;
 		
-	#pragma omp parallel for schedule(static) shared(acumulado, p_matrizA, p_matrizB, p_matrizResultado, tamanioMatriz) private(i, j, k)
+	// acumulado debe ser privado: cada hilo calcula sus propios productos punto
+	#pragma omp parallel for schedule(static) shared(p_matrizA, p_matrizB, p_matrizResultado, tamanioMatriz, productoPunto) private(i, j, acumulado)
 	for(i = 0; i < tamanioMatriz; i++){ // este bucle recorre las filas de la matriz multiplicando
 
-		//#pragma omp parallel for schedule(static) shared(i, acumulado, p_matrizA, p_matrizB, p_matrizResultado, tamanioMatriz) private( j, k)
 		for(j = 0; j < tamanioMatriz; j++){ // este bucle recorre los elementos de la fila
-			acumulado = 0;
-			//#pragma omp parallel for schedule(static) shared(i, j, acumulado, p_matrizA, p_matrizB, p_matrizResultado, tamanioMatriz) private( k)
-			for(k = 0; k < tamanioMatriz; k++){ // este bucle recorre los elementos de la columna
-
-				acumulado = acumulado + (p_matrizA[i][k] * p_matrizB[j][k]);
-			}
-			p_matrizResultado[i][j] = acumulado;
+			// producto punto vectorizado: recorre los elementos de la columna (fila de B transpuesta)
+			acumulado = productoPunto(FILA(p_matrizA, i), FILA(p_matrizB, j), tamanioMatriz);
+			ELEMENTO(p_matrizResultado, i, j) = acumulado;
 		}
 	}
 }
 
-
-// mostrar el contenido de una matriz cuadrada
-void mostrarMatriz(int ** p_matriz, int tamanioMatriz){
-	int i, j;
-	for(i = 0; i < tamanioMatriz; i++){
-		for(j = 0; j < tamanioMatriz; j++){
-			printf("%d ", p_matriz[i][j]);
-		}
-		printf("\n");
-	}
-	printf("\n\n");
-}
-
-
-// liberar memoria matriz
-void liberarMemoriaMatriz(int ** matriz, int tamanioMatriz){
-	int i;
-	for(i = 0; i < tamanioMatriz; i++){
-		free(matriz[i]);
-	}
-	free(matriz);
+// multiplicar por azulejos 2D; los hilos de OpenMP se roban azulejos entre si
+void multiplicarMatricesCuadradasRobo(const struct matriz * p_matrizA, const struct matriz * p_matrizB, struct matriz * p_matrizResultado){
+	int tamanioMatriz = p_matrizA->filas;
+	int numeroHilos = omp_get_max_threads();
+	int altoAzulejo, anchoAzulejo;
+	struct planificador * planificador;
+	struct datos_azulejos datos;
+	
+	datos.matrizA = p_matrizA;
+	datos.matrizB = p_matrizB;
+	datos.matrizResultado = p_matrizResultado;
+	datos.productoPunto = nucleosActuales->productoPunto;
+	
+	elegirTamanioAzulejo(tamanioMatriz, tamanioMatriz, numeroHilos, &altoAzulejo, &anchoAzulejo);
+	planificador = crearPlanificador(tamanioMatriz, tamanioMatriz, altoAzulejo, anchoAzulejo, numeroHilos);
+	
+	#pragma omp parallel num_threads(numeroHilos)
+	trabajarPlanificador(planificador, omp_get_thread_num(), multiplicarAzulejo, &datos);
+	
+	destruirPlanificador(planificador);
 }
 
-// transponer matriz
-int ** transponerMatriz(int ** matriz, int tamanioMatriz){
+// multiplicar un azulejo de la matriz resultado (B transpuesta)
+void multiplicarAzulejo(const struct azulejo * azulejo, void * contexto){
+	struct datos_azulejos * datos = (struct datos_azulejos *)contexto;
 	int i, j;
-	int ** matrizResultado = crearMatriz(tamanioMatriz);
+	int tamanioMatriz = datos->matrizA->filas;
 	
-	for(i = 0; i < tamanioMatriz; i++){
-		for(j = 0; j < tamanioMatriz; j++){
-			matrizResultado[i][j] = matriz[j][i];
+	for(i = azulejo->fila; i < azulejo->fila + azulejo->filas; i++){ // este bucle recorre las filas del azulejo
+		for(j = azulejo->columna; j < azulejo->columna + azulejo->columnas; j++){ // este bucle recorre los elementos de la fila
+			ELEMENTO(datos->matrizResultado, i, j) = datos->productoPunto(FILA(datos->matrizA, i), FILA(datos->matrizB, j), tamanioMatriz);
 		}
 	}
-	liberarMemoriaMatriz(matriz, tamanioMatriz);
-	return matrizResultado;
 }
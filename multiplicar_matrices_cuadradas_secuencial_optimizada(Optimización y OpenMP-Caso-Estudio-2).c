@@ -17,6 +17,15 @@
  	  adelante, y mientras mas grandes mas se nota.
  	  
  	  la otra optimizacion ayuda a reducir las operaciones de acceso a la matriz resultado
+ 	  
+ 	  La version actual usa el motor de paneles empaquetados (gemm_empaquetado.c):
+ 	  A y B se copian a paneles contiguos y un micro-kernel mantiene un azulejo
+ 	  de MR x NR de C en registros. Ya no hace falta transponer B.
+ 	  El kernel por bloques anterior queda disponible pasando "bloques" como
+ 	  segundo argumento, para comparar.
+ 	  
+ 	  Con -f k se verifica C al final con k vectores de Freivalds
+ 	  (verificacion.h); -f 0 lo compara exacto con el producto ingenuo.
  */
 #include <stdlib.h>
 #include <string.h>
@@ -25,23 +34,29 @@
 #include <unistd.h>
 #include <omp.h>
 
+#include "matriz.h"
+#include "gemm_empaquetado.h"
+#include "verificacion.h"
+
 // para compilar, incluir bandera -fopenmp
+// gcc -O3 -fopenmp "multiplicar_matrices_cuadradas_secuencial_optimizada(Optimización y OpenMP-Caso-Estudio-2).c" matriz.c paginas_grandes.c pool_memoria.c gemm_empaquetado.c nucleos_simd.c configuracion_maquina.c verificacion.c -lm
+// sin -march=native: los kernels SIMD se eligen al arrancar (MATRIZ_ISA para forzar uno)
+// los bloques mc/kc/nc salen del archivo de autoajuste si ya se corrio ./autoajuste en esta maquina
 
 // optimizacion -O
 // firmas de las funciones usadas
 
-void inicializarMatricesCuadradas(int **, int **, int);
-void multiplicarMatricesCuadradasOptimizada(int **, int **, int **, int);
-void mostrarMatriz(int**, int);
-void liberarMemoriaMatriz(int **, int);
-int ** crearMatriz(int);
-int ** transponerMatriz(int **, int);
+void multiplicarMatricesCuadradasOptimizada(const struct matriz *, const struct matriz *, struct matriz *);
+void multiplicarMatricesCuadradasBloques(const struct matriz *, const struct matriz *, struct matriz *);
 
 // funcion main
 int main(int argc, char *argv[]){
 
 	int tamanioMatriz;
 	int numeroHilos;
+	int usarBloques = 0;
+	int repeticionesFreivalds = leerOpcionVerificacion(&argc, argv);
+	int correcto = 1;
 	
 	// variables para calcular tiempo cpu
 	clock_t tiempo_inicio, tiempo_final;
@@ -53,46 +68,59 @@ int main(int argc, char *argv[]){
 	long nanoseconds;
 	double elapsed;
 	
-	if (argc != 2){
+	if (argc < 2){
 		printf("No se paso un tamaño de matriz. Se fijara uno por defecto\n\n");
 		tamanioMatriz = 10;
 		numeroHilos = 2;
 	}
 	
-	if (argc == 2){
+	if (argc >= 2){
 		printf("argumento en argv[1]:	%s\n", argv[1]);
 		tamanioMatriz = atoi(argv[1]);
 		numeroHilos = 2;
 	}
 	
+	// "bloques" en argv[2] usa el kernel por bloques con B transpuesta
+	if (argc >= 3 && strcmp(argv[2], "bloques") == 0){
+		usarBloques = 1;
+	}
+	
+	printf("kernels SIMD: %s, bloques mc %d kc %d nc %d\n", nucleosActuales->nombre,
+		configuracionGemmActual.mc, configuracionGemmActual.kc, configuracionGemmActual.nc);
+	
 	//inicializar generador de numeros aleatorios
 	srand(getpid());
 	
 	// declaracion e inicializacion de variables
-	int ** p_matrizA, ** p_matrizB, ** p_matrizResultado;
+	struct matriz * p_matrizA, * p_matrizB, * p_matrizResultado;
 
 	// crear matrices en memoria
-	p_matrizA = crearMatriz(tamanioMatriz);
-	p_matrizB = crearMatriz(tamanioMatriz);
-	p_matrizResultado = crearMatriz(tamanioMatriz);
+	p_matrizA = crearMatriz(tamanioMatriz, tamanioMatriz);
+	p_matrizB = crearMatriz(tamanioMatriz, tamanioMatriz);
+	p_matrizResultado = crearMatriz(tamanioMatriz, tamanioMatriz);
 	
 	// inicializar matriz resultado en 0
-	for (int i = 0; i < tamanioMatriz; i++) {
-		memset(p_matrizResultado[i], 0, tamanioMatriz * sizeof(int));
-	}
+	ponerCerosMatriz(p_matrizResultado);
 
 	// inicializar matrices A y B con valores aleatorios
-	inicializarMatricesCuadradas(p_matrizA, p_matrizB, tamanioMatriz);
+	inicializarMatricesCuadradas(p_matrizA, p_matrizB);
 	
-	// transponer matriz B
-	p_matrizB = transponerMatriz(p_matrizB, tamanioMatriz);
+	// transponer matriz B (solo para el kernel por bloques)
+	if(usarBloques){
+		p_matrizB = transponerMatriz(p_matrizB);
+	}
 	
 	// iniciar relojes para calcular tiempo cpu y wall
 	clock_gettime(CLOCK_REALTIME, &begin);
 	tiempo_inicio = clock();
 	
 	// calcular multiplicacion de matrices A y B
-	multiplicarMatricesCuadradasOptimizada(p_matrizA, p_matrizB, p_matrizResultado, tamanioMatriz);
+	if(usarBloques){
+		multiplicarMatricesCuadradasBloques(p_matrizA, p_matrizB, p_matrizResultado);
+	}
+	else{
+		multiplicarMatricesCuadradasOptimizada(p_matrizA, p_matrizB, p_matrizResultado);
+	}
 	
 	// detener relojes para obtener tiempos finales de cpu y wall
 	tiempo_final = clock();
@@ -109,58 +137,33 @@ int main(int argc, char *argv[]){
 	// mostrar resultados en pantalla
 	printf("\ntiempo transcurrido multiplicacion_matrices (CPU/WALL):	%f	%f\n", tiempo_transcurrido, elapsed);
 	
-	// liberar memoria de la matriz
-	liberarMemoriaMatriz(p_matrizA, tamanioMatriz);
-	liberarMemoriaMatriz(p_matrizB, tamanioMatriz);
-	liberarMemoriaMatriz(p_matrizResultado, tamanioMatriz);
-	return 0;
-}
-
-
-// crear matrices cuadradas
-int ** crearMatriz(int tamanioMatriz){
-	int ** matriz = (int **)malloc(tamanioMatriz * sizeof(int *));
-	int i, j;
-	
-	if(matriz == NULL){
-		perror("No se pudo reservar memoria para los punteros de las columnas");
-		exit(1);
-	}
-	
-	for(i = 0; i < tamanioMatriz; i++){
-		matriz[i] = (int *)malloc(tamanioMatriz * sizeof(int));
-	
-		if(matriz[i] == NULL){
-			perror("No se pudo reservar memoria para los punteros de las filas");
-			
-			for(j = 0; j < i; j++){
-				free(matriz[j]);
-				}
-				free(matriz);
-				exit(1);
-			}
+	// se verifica con B de nuevo sin transponer, fuera de la parte medida
+	if(repeticionesFreivalds >= 0){
+		if(usarBloques){
+			p_matrizB = transponerMatriz(p_matrizB);
 		}
+		correcto = mostrarVerificacion(p_matrizA, p_matrizB, p_matrizResultado, repeticionesFreivalds);
+	}
 	
-	return matriz;
+	// liberar memoria de la matriz
+	liberarMemoriaMatriz(p_matrizA);
+	liberarMemoriaMatriz(p_matrizB);
+	liberarMemoriaMatriz(p_matrizResultado);
+	return correcto ? 0 : 1;
 }
 
-// inicializar matrices cuadradas con numeros int random 
-void inicializarMatricesCuadradas(int ** p_matrizA, int ** p_matrizB, int tamanioMatriz){
-	int i, j, numeroA, numeroB;
-	
-	for(i = 0; i < tamanioMatriz; i++){
-		for(j = 0; j < tamanioMatriz; j++){
-			numeroA = rand() % 10 + 1;
-			numeroB = rand() % 10 + 1;
-			p_matrizA[i][j] = numeroA;
-			p_matrizB[i][j] = numeroB;
-		}
-	}
+
+// multiplicar las matrices cuadradas con paneles empaquetados y micro-kernel en registros
+void multiplicarMatricesCuadradasOptimizada(const struct matriz * p_matrizA, const struct matriz * p_matrizB, struct matriz * p_matrizResultado){
+	multiplicarMatricesEmpaquetada(p_matrizA, p_matrizB, p_matrizResultado);
 }
 
 // multiplicar las matrices cuadradas con blocking/tiling y transposicion de matriz B
-void multiplicarMatricesCuadradasOptimizada(int ** p_matrizA, int ** p_matrizB, int ** p_matrizResultado, int tamanioMatriz){
-	int i, j, k, acumulado;
+void multiplicarMatricesCuadradasBloques(const struct matriz * p_matrizA, const struct matriz * p_matrizB, struct matriz * p_matrizResultado){
+	int i, j, acumulado;
+	int tamanioMatriz = p_matrizA->filas;
+	const int * filaA, * filaB;
+	funcionProductoPunto productoPunto = nucleosActuales->productoPunto;
 	int lim_i, lim_j, lim_k;
 	const int BLOCK_SIZE = 64; // Tamaño de bloque para optimización de cache
     // Multiplicación por bloques para mejor uso de cache
@@ -173,51 +176,16 @@ void multiplicarMatricesCuadradasOptimizada(int ** p_matrizA, int ** p_matrizB,
                 int k_end = (lim_k + BLOCK_SIZE < tamanioMatriz) ? lim_k + BLOCK_SIZE : tamanioMatriz;
                 	
 		for(i = lim_i; i < i_end; i++){ // este bucle recorre las filas de la matriz multiplicando
+		    filaA = FILA(p_matrizA, i);
 		    for(j = lim_j; j < j_end; j++){ // este bucle recorre los elementos de la fila
-			acumulado = p_matrizResultado[i][j];
-			    for(k = lim_k; k < k_end; k++){ // este bucle recorre los elementos de la columna
-				acumulado += p_matrizA[i][k] * p_matrizB[j][k];
-			    }
-			    p_matrizResultado[i][j] = acumulado;
+			filaB = FILA(p_matrizB, j);
+			acumulado = ELEMENTO(p_matrizResultado, i, j);
+			    // producto punto vectorizado sobre k (recorre los elementos de la columna)
+			    acumulado += productoPunto(filaA + lim_k, filaB + lim_k, k_end - lim_k);
+			    ELEMENTO(p_matrizResultado, i, j) = acumulado;
 		    }
 	        }
             }
         }
     }
 }
-
-// mostrar el contenido de una matriz cuadrada
-void mostrarMatriz(int ** p_matriz, int tamanioMatriz){
-	int i, j;
-	for(i = 0; i < tamanioMatriz; i++){
-		for(j = 0; j < tamanioMatriz; j++){
-			printf("%d ", p_matriz[i][j]);
-		}
-		printf("\n");
-	}
-	printf("\n\n");
-}
-
-
-// liberar memoria reservada para una matriz
-void liberarMemoriaMatriz(int ** matriz, int tamanioMatriz){
-	int i;
-	for(i = 0; i < tamanioMatriz; i++){
-		free(matriz[i]);
-	}
-	free(matriz);
-}
-
-// transponer matriz
-int ** transponerMatriz(int ** matriz, int tamanioMatriz){
-	int i, j;
-	int ** matrizResultado = crearMatriz(tamanioMatriz);
-	
-	for(i = 0; i < tamanioMatriz; i++){
-		for(j = 0; j < tamanioMatriz; j++){
-			matrizResultado[i][j] = matriz[j][i];
-		}
-	}
-	liberarMemoriaMatriz(matriz, tamanioMatriz);
-	return matrizResultado;
-}
@@ -0,0 +1,282 @@
+// kernels SIMD int32 (escalar, SSE4.1, AVX2, AVX-512) y seleccion con cpuid
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "nucleos_simd.h"
+
+// copiar un azulejo MR x NR calculado a las mr x nr posiciones validas de C
+static void guardarAzulejo(const int * azulejo, int * c, int ldc, int mr, int nr, int acumular){
+	int i, j;
+	for(i = 0; i < mr; i++){
+		for(j = 0; j < nr; j++){
+			if(acumular){
+				c[(size_t)i * ldc + j] += azulejo[i * NR + j];
+			}
+			else{
+				c[(size_t)i * ldc + j] = azulejo[i * NR + j];
+			}
+		}
+	}
+}
+
+/* ---------------------------- escalar ---------------------------- */
+
+int productoPuntoEscalar(const int * x, const int * y, int n){
+	int k, acumulado = 0;
+	for(k = 0; k < n; k++){
+		acumulado += x[k] * y[k];
+	}
+	return acumulado;
+}
+
+// micro-kernel: azulejo MR x NR de C en registros, recorriendo kc
+// acumular = 0 sobrescribe C (primer panel de k), 1 suma sobre C
+void microKernelEscalar(int kc, const int * panelA, const int * panelB, int * c, int ldc, int mr, int nr, int acumular){
+	int azulejo[MR * NR] = {0};
+	int i, j, k;
+	const int * a, * b;
+
+	for(k = 0; k < kc; k++){
+		a = panelA + k * MR;
+		b = panelB + k * NR;
+		#pragma GCC unroll 6
+		for(i = 0; i < MR; i++){
+			#pragma GCC unroll 16
+			for(j = 0; j < NR; j++){
+				azulejo[i * NR + j] += a[i] * b[j];
+			}
+		}
+	}
+	guardarAzulejo(azulejo, c, ldc, mr, nr, acumular);
+}
+
+/* ---------------------------- SSE4.1 ----------------------------- */
+
+__attribute__((target("sse4.1")))
+static int productoPuntoSse41(const int * x, const int * y, int n){
+	__m128i suma0 = _mm_setzero_si128();
+	__m128i suma1 = _mm_setzero_si128();
+	int k = 0, total;
+
+	for(; k + 8 <= n; k += 8){
+		suma0 = _mm_add_epi32(suma0, _mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(x + k)), _mm_loadu_si128((const __m128i *)(y + k))));
+		suma1 = _mm_add_epi32(suma1, _mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(x + k + 4)), _mm_loadu_si128((const __m128i *)(y + k + 4))));
+	}
+	for(; k + 4 <= n; k += 4){
+		suma0 = _mm_add_epi32(suma0, _mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(x + k)), _mm_loadu_si128((const __m128i *)(y + k))));
+	}
+	suma0 = _mm_add_epi32(suma0, suma1);
+	suma0 = _mm_hadd_epi32(suma0, suma0);
+	suma0 = _mm_hadd_epi32(suma0, suma0);
+	total = _mm_cvtsi128_si32(suma0);
+	for(; k < n; k++){
+		total += x[k] * y[k];
+	}
+	return total;
+}
+
+__attribute__((target("sse4.1")))
+static void microKernelSse41(int kc, const int * panelA, const int * panelB, int * c, int ldc, int mr, int nr, int acumular){
+	__m128i acumulador[MR][4];
+	__m128i b[4], a;
+	int azulejo[MR * NR] __attribute__((aligned(64)));
+	int i, j, k;
+
+	#pragma GCC unroll 6
+	for(i = 0; i < MR; i++){
+		for(j = 0; j < 4; j++){
+			acumulador[i][j] = _mm_setzero_si128();
+		}
+	}
+	for(k = 0; k < kc; k++){
+		#pragma GCC unroll 4
+		for(j = 0; j < 4; j++){
+			b[j] = _mm_load_si128((const __m128i *)(panelB + k * NR + j * 4));
+		}
+		#pragma GCC unroll 6
+		for(i = 0; i < MR; i++){
+			a = _mm_set1_epi32(panelA[k * MR + i]);
+			#pragma GCC unroll 4
+			for(j = 0; j < 4; j++){
+				acumulador[i][j] = _mm_add_epi32(acumulador[i][j], _mm_mullo_epi32(a, b[j]));
+			}
+		}
+	}
+	for(i = 0; i < MR; i++){
+		for(j = 0; j < 4; j++){
+			_mm_store_si128((__m128i *)(azulejo + i * NR + j * 4), acumulador[i][j]);
+		}
+	}
+	guardarAzulejo(azulejo, c, ldc, mr, nr, acumular);
+}
+
+/* ----------------------------- AVX2 ------------------------------ */
+
+__attribute__((target("avx2")))
+static int productoPuntoAvx2(const int * x, const int * y, int n){
+	__m256i suma0 = _mm256_setzero_si256();
+	__m256i suma1 = _mm256_setzero_si256();
+	__m128i suma;
+	int k = 0, total;
+
+	for(; k + 16 <= n; k += 16){
+		suma0 = _mm256_add_epi32(suma0, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i *)(x + k)), _mm256_loadu_si256((const __m256i *)(y + k))));
+		suma1 = _mm256_add_epi32(suma1, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i *)(x + k + 8)), _mm256_loadu_si256((const __m256i *)(y + k + 8))));
+	}
+	for(; k + 8 <= n; k += 8){
+		suma0 = _mm256_add_epi32(suma0, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i *)(x + k)), _mm256_loadu_si256((const __m256i *)(y + k))));
+	}
+	suma0 = _mm256_add_epi32(suma0, suma1);
+	suma = _mm_add_epi32(_mm256_castsi256_si128(suma0), _mm256_extracti128_si256(suma0, 1));
+	suma = _mm_hadd_epi32(suma, suma);
+	suma = _mm_hadd_epi32(suma, suma);
+	total = _mm_cvtsi128_si32(suma);
+	for(; k < n; k++){
+		total += x[k] * y[k];
+	}
+	return total;
+}
+
+__attribute__((target("avx2")))
+static void microKernelAvx2(int kc, const int * panelA, const int * panelB, int * c, int ldc, int mr, int nr, int acumular){
+	__m256i acumulador[MR][2];
+	__m256i b0, b1, a;
+	int azulejo[MR * NR] __attribute__((aligned(64)));
+	int i, k;
+
+	#pragma GCC unroll 6
+	for(i = 0; i < MR; i++){
+		acumulador[i][0] = _mm256_setzero_si256();
+		acumulador[i][1] = _mm256_setzero_si256();
+	}
+	for(k = 0; k < kc; k++){
+		b0 = _mm256_load_si256((const __m256i *)(panelB + k * NR));
+		b1 = _mm256_load_si256((const __m256i *)(panelB + k * NR + 8));
+		#pragma GCC unroll 6
+		for(i = 0; i < MR; i++){
+			a = _mm256_set1_epi32(panelA[k * MR + i]);
+			acumulador[i][0] = _mm256_add_epi32(acumulador[i][0], _mm256_mullo_epi32(a, b0));
+			acumulador[i][1] = _mm256_add_epi32(acumulador[i][1], _mm256_mullo_epi32(a, b1));
+		}
+	}
+	for(i = 0; i < MR; i++){
+		_mm256_store_si256((__m256i *)(azulejo + i * NR), acumulador[i][0]);
+		_mm256_store_si256((__m256i *)(azulejo + i * NR + 8), acumulador[i][1]);
+	}
+	guardarAzulejo(azulejo, c, ldc, mr, nr, acumular);
+}
+
+/* ---------------------------- AVX-512 ---------------------------- */
+
+__attribute__((target("avx512f")))
+static int productoPuntoAvx512(const int * x, const int * y, int n){
+	__m512i suma0 = _mm512_setzero_si512();
+	__m512i suma1 = _mm512_setzero_si512();
+	__mmask16 mascara;
+	int k = 0;
+
+	for(; k + 32 <= n; k += 32){
+		suma0 = _mm512_add_epi32(suma0, _mm512_mullo_epi32(_mm512_loadu_si512(x + k), _mm512_loadu_si512(y + k)));
+		suma1 = _mm512_add_epi32(suma1, _mm512_mullo_epi32(_mm512_loadu_si512(x + k + 16), _mm512_loadu_si512(y + k + 16)));
+	}
+	for(; k + 16 <= n; k += 16){
+		suma0 = _mm512_add_epi32(suma0, _mm512_mullo_epi32(_mm512_loadu_si512(x + k), _mm512_loadu_si512(y + k)));
+	}
+	// el resto se hace con una carga enmascarada en lugar de un bucle escalar
+	if(k < n){
+		mascara = (__mmask16)((1u << (n - k)) - 1);
+		suma1 = _mm512_add_epi32(suma1, _mm512_mullo_epi32(_mm512_maskz_loadu_epi32(mascara, x + k), _mm512_maskz_loadu_epi32(mascara, y + k)));
+	}
+	return _mm512_reduce_add_epi32(_mm512_add_epi32(suma0, suma1));
+}
+
+__attribute__((target("avx512f")))
+static void microKernelAvx512(int kc, const int * panelA, const int * panelB, int * c, int ldc, int mr, int nr, int acumular){
+	__m512i acumulador[MR];
+	__m512i b, a;
+	int azulejo[MR * NR] __attribute__((aligned(64)));
+	int i, k;
+
+	#pragma GCC unroll 6
+	for(i = 0; i < MR; i++){
+		acumulador[i] = _mm512_setzero_si512();
+	}
+	for(k = 0; k < kc; k++){
+		b = _mm512_load_si512(panelB + k * NR);
+		#pragma GCC unroll 6
+		for(i = 0; i < MR; i++){
+			a = _mm512_set1_epi32(panelA[k * MR + i]);
+			acumulador[i] = _mm512_add_epi32(acumulador[i], _mm512_mullo_epi32(a, b));
+		}
+	}
+	for(i = 0; i < MR; i++){
+		_mm512_store_si512(azulejo + i * NR, acumulador[i]);
+	}
+	guardarAzulejo(azulejo, c, ldc, mr, nr, acumular);
+}
+
+/* --------------------------- seleccion --------------------------- */
+
+static const struct nucleosSimd tablaNucleos[] = {
+	{"escalar", productoPuntoEscalar, microKernelEscalar},
+	{"sse41", productoPuntoSse41, microKernelSse41},
+	{"avx2", productoPuntoAvx2, microKernelAvx2},
+	{"avx512", productoPuntoAvx512, microKernelAvx512},
+};
+
+#define NUM_NUCLEOS (int)(sizeof(tablaNucleos) / sizeof(tablaNucleos[0]))
+
+const struct nucleosSimd * nucleosActuales = &tablaNucleos[0];
+
+// consultar cpuid para saber si la variante i puede ejecutarse
+static int soportaNucleo(int i){
+	__builtin_cpu_init();
+	switch(i){
+		case 0: return 1;
+		case 1: return __builtin_cpu_supports("sse4.1");
+		case 2: return __builtin_cpu_supports("avx2");
+		case 3: return __builtin_cpu_supports("avx512f");
+	}
+	return 0;
+}
+
+// la mejor variante que soporta la CPU
+const struct nucleosSimd * detectarNucleosSimd(void){
+	int i;
+	for(i = NUM_NUCLEOS - 1; i > 0; i--){
+		if(soportaNucleo(i)){
+			return &tablaNucleos[i];
+		}
+	}
+	return &tablaNucleos[0];
+}
+
+// fijar una variante por nombre; devuelve -1 si no existe o la CPU no la soporta
+int forzarNucleosSimd(const char * nombre){
+	int i;
+	for(i = 0; i < NUM_NUCLEOS; i++){
+		if(strcmp(nombre, tablaNucleos[i].nombre) == 0){
+			if(!soportaNucleo(i)){
+				fprintf(stderr, "La CPU no soporta los kernels %s\n", nombre);
+				return -1;
+			}
+			nucleosActuales = &tablaNucleos[i];
+			return 0;
+		}
+	}
+	fprintf(stderr, "Kernels SIMD desconocidos: %s (escalar, sse41, avx2, avx512)\n", nombre);
+	return -1;
+}
+
+// se ejecuta al arrancar el programa, antes de main
+__attribute__((constructor))
+static void inicializarNucleosSimd(void){
+	const char * forzado = getenv("MATRIZ_ISA");
+
+	nucleosActuales = detectarNucleosSimd();
+	if(forzado != NULL && forzado[0] != '\0'){
+		forzarNucleosSimd(forzado);
+	}
+}
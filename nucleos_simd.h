@@ -0,0 +1,37 @@
+/*
+ Kernels SIMD int32 con seleccion en tiempo de ejecucion
+
+ Todas las variantes (escalar, SSE4.1, AVX2, AVX-512) se compilan en el mismo
+ binario con __attribute__((target(...))), asi que no hace falta -march=native
+ y el ejecutable corre en cualquier nodo x86-64. Al arrancar se consulta cpuid
+ y se elige la mejor variante disponible.
+
+ Para comparar, la variable de entorno MATRIZ_ISA (escalar, sse41, avx2, avx512)
+ o forzarNucleosSimd fijan una variante concreta, siempre que la CPU la soporte.
+*/
+#ifndef NUCLEOS_SIMD_H
+#define NUCLEOS_SIMD_H
+
+// dimensiones del azulejo de C que vive en registros en el micro-kernel
+#define MR 6
+#define NR 16
+
+typedef int (*funcionProductoPunto)(const int * x, const int * y, int n);
+typedef void (*funcionMicroKernel)(int kc, const int * panelA, const int * panelB, int * c, int ldc, int mr, int nr, int acumular);
+
+struct nucleosSimd{
+	const char * nombre;
+	funcionProductoPunto productoPunto;
+	funcionMicroKernel microKernel;
+};
+
+// variante en uso; se fija al arrancar el programa
+extern const struct nucleosSimd * nucleosActuales;
+
+const struct nucleosSimd * detectarNucleosSimd(void);
+int forzarNucleosSimd(const char * nombre);
+
+int productoPuntoEscalar(const int *, const int *, int);
+void microKernelEscalar(int, const int *, const int *, int *, int, int, int, int);
+
+#endif
@@ -0,0 +1,393 @@
+// matrices con paginas ubicadas por nodo NUMA (ver numa_matriz.h)
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <omp.h>
+
+#include "numa_matriz.h"
+#include "aleatorio_contador.h"
+#include "gemm_empaquetado.h"
+
+// modos de mbind (linux/mempolicy.h), sin depender de libnuma
+#define POLITICA_PREFERIDA 1
+#define POLITICA_INTERCALADA 3
+
+#define PAGINAS_POR_CONSULTA 4096
+
+const char * nombresPoliticasNuma[NUMERO_POLITICAS_NUMA] = {"un_hilo", "primer_toque", "por_filas", "intercalada"};
+
+static struct topologiaNuma topologia;
+static int topologiaLeida = 0;
+
+// "0-3,8-11" de cpulist
+static void leerListaCpus(const char * texto, int nodo){
+	const char * p = texto;
+	char * fin;
+	long desde, hasta, c;
+
+	while(*p != '\0' && *p != '\n'){
+		desde = strtol(p, &fin, 10);
+		if(fin == p){
+			break;
+		}
+		hasta = desde;
+		p = fin;
+		if(*p == '-'){
+			hasta = strtol(p + 1, &fin, 10);
+			p = fin;
+		}
+		for(c = desde; c <= hasta && c < MAX_CPUS_NUMA; c++){
+			topologia.nodoCpu[c] = nodo;
+		}
+		if(*p == ','){
+			p++;
+		}
+	}
+}
+
+const struct topologiaNuma * topologiaNuma(void){
+	const char * falso = getenv("MATRIZ_NUMA_FALSO");
+	char ruta[128], texto[4096];
+	FILE * archivo;
+	int nodo, c;
+
+	if(topologiaLeida){
+		return &topologia;
+	}
+	topologiaLeida = 1;
+	memset(&topologia, 0, sizeof(topologia));
+	topologia.numeroCpus = (int)sysconf(_SC_NPROCESSORS_CONF);
+	if(topologia.numeroCpus < 1){
+		topologia.numeroCpus = 1;
+	}
+	if(topologia.numeroCpus > MAX_CPUS_NUMA){
+		topologia.numeroCpus = MAX_CPUS_NUMA;
+	}
+
+	if(falso != NULL && atoi(falso) > 0){
+		topologia.falsa = 1;
+		topologia.nodos = atoi(falso) < MAX_NODOS_NUMA ? atoi(falso) : MAX_NODOS_NUMA;
+		for(c = 0; c < topologia.numeroCpus; c++){
+			topologia.nodoCpu[c] = (short)((long)c * topologia.nodos / topologia.numeroCpus);
+		}
+		return &topologia;
+	}
+
+	// sin /sys/devices/system/node (kernel sin NUMA) todo queda en el nodo 0
+	topologia.nodos = 1;
+	for(nodo = 0; nodo < MAX_NODOS_NUMA; nodo++){
+		snprintf(ruta, sizeof(ruta), "/sys/devices/system/node/node%d/cpulist", nodo);
+		archivo = fopen(ruta, "r");
+		if(archivo == NULL){
+			continue;
+		}
+		if(fgets(texto, sizeof(texto), archivo) != NULL){
+			leerListaCpus(texto, nodo);
+		}
+		fclose(archivo);
+		if(nodo + 1 > topologia.nodos){
+			topologia.nodos = nodo + 1;
+		}
+	}
+	return &topologia;
+}
+
+int politicaNumaPorNombre(const char * nombre){
+	int p;
+	for(p = 0; p < NUMERO_POLITICAS_NUMA; p++){
+		if(strcmp(nombre, nombresPoliticasNuma[p]) == 0){
+			return p;
+		}
+	}
+	return -1;
+}
+
+int nodoHiloNuma(int hilo, int numeroHilos){
+	const struct topologiaNuma * t = topologiaNuma();
+	int cpu;
+
+	if(t->falsa){
+		return (int)((long)hilo * t->nodos / numeroHilos);
+	}
+	cpu = sched_getcpu();
+	return cpu >= 0 && cpu < MAX_CPUS_NUMA ? t->nodoCpu[cpu] : 0;
+}
+
+// nodo de cada hilo del equipo de numeroHilos, medido desde los propios hilos
+static int nodosHilos(int numeroHilos, int * nodos){
+	int total = 1;
+
+	#pragma omp parallel num_threads(numeroHilos)
+	{
+		#pragma omp single
+		total = omp_get_num_threads();
+		nodos[omp_get_thread_num()] = nodoHiloNuma(omp_get_thread_num(), omp_get_num_threads());
+	}
+	return total;
+}
+
+static size_t tamanioPagina(void){
+	static size_t pagina = 0;
+	if(pagina == 0){
+		pagina = (size_t)sysconf(_SC_PAGESIZE);
+	}
+	return pagina;
+}
+
+// mbind sobre [inicio, fin) del mapa, redondeado a paginas; si el kernel no
+// lo permite se avisa una vez y la memoria queda con la politica por defecto
+static void ubicarRango(struct matrizNuma * matriz, size_t inicio, size_t fin, int modo, unsigned long mascara){
+	static int avisado = 0;
+	size_t pagina = tamanioPagina(), p;
+
+	inicio = inicio / pagina * pagina;
+	fin = (fin + pagina - 1) / pagina * pagina;
+	if(fin <= inicio){
+		return;
+	}
+	if(matriz->nodosPagina != NULL){
+		for(p = inicio / pagina; p < fin / pagina; p++){
+			if(modo == POLITICA_INTERCALADA){
+				matriz->nodosPagina[p] = (signed char)(p % topologiaNuma()->nodos);
+			}
+			else{
+				matriz->nodosPagina[p] = (signed char)__builtin_ctzl(mascara);
+			}
+		}
+		return;
+	}
+	if(syscall(SYS_mbind, (char *)matriz->mapa + inicio, fin - inicio, modo, &mascara, MAX_NODOS_NUMA + 1, 0) != 0 && !avisado){
+		avisado = 1;
+		perror("mbind (se sigue con la politica por defecto)");
+	}
+}
+
+struct matrizNuma * crearMatrizNuma(int filas, int columnas, enum politicaNuma politica, int numeroHilos){
+	const struct topologiaNuma * t = topologiaNuma();
+	struct matrizNuma * matriz = (struct matrizNuma *)calloc(1, sizeof(struct matrizNuma));
+	size_t pagina = tamanioPagina(), bytesFila;
+	int nodos[MAX_CPUS_NUMA];
+	int h, total, inicio, fin;
+
+	if(matriz == NULL){
+		perror("No se pudo reservar memoria para la matriz NUMA");
+		exit(1);
+	}
+	matriz->politica = politica;
+	matriz->matriz.filas = filas;
+	matriz->matriz.columnas = columnas;
+	matriz->matriz.ld = calcularLd(columnas);
+	matriz->matriz.propietaria = 0;
+	bytesFila = (size_t)matriz->matriz.ld * sizeof(int);
+	matriz->bytes = ((size_t)filas * bytesFila + pagina - 1) / pagina * pagina;
+	if(matriz->bytes == 0){
+		matriz->bytes = pagina;
+	}
+
+	// mmap no toca las paginas: cada una se ubica al escribirla por primera vez
+	matriz->mapa = mmap(NULL, matriz->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(matriz->mapa == MAP_FAILED){
+		perror("No se pudo reservar memoria para los datos de la matriz NUMA");
+		exit(1);
+	}
+	matriz->matriz.datos = (int *)matriz->mapa;
+	if(t->falsa){
+		matriz->nodosPagina = (signed char *)malloc(matriz->bytes / pagina);
+		if(matriz->nodosPagina == NULL){
+			perror("No se pudo reservar memoria para los nodos de las paginas");
+			exit(1);
+		}
+		memset(matriz->nodosPagina, -1, matriz->bytes / pagina);
+	}
+
+	if(politica == NUMA_INTERCALADA && t->nodos > 1){
+		ubicarRango(matriz, 0, matriz->bytes, POLITICA_INTERCALADA, t->nodos >= 64 ? ~0UL : (1UL << t->nodos) - 1);
+	}
+	else if(politica == NUMA_POR_FILAS){
+		total = nodosHilos(numeroHilos, nodos);
+		for(h = 0; h < total; h++){
+			tramoFilasEmpaquetada(filas, total, h, &inicio, &fin);
+			ubicarRango(matriz, (size_t)inicio * bytesFila, h + 1 == total ? matriz->bytes : (size_t)fin * bytesFila,
+				POLITICA_PREFERIDA, 1UL << nodos[h]);
+		}
+	}
+	return matriz;
+}
+
+void liberarMatrizNuma(struct matrizNuma * matriz){
+	if(matriz == NULL){
+		return;
+	}
+	munmap(matriz->mapa, matriz->bytes);
+	free(matriz->nodosPagina);
+	free(matriz);
+}
+
+// anotar el primer toque de las paginas de [inicio, fin) con topologia falsa;
+// en los bordes de los tramos dos hilos pueden tocar la misma pagina y gana el primero
+static void anotarPrimerToque(struct matrizNuma * matriz, size_t inicio, size_t fin, int nodo){
+	size_t pagina = tamanioPagina(), p;
+
+	if(matriz->nodosPagina == NULL || fin <= inicio){
+		return;
+	}
+	for(p = inicio / pagina; p <= (fin - 1) / pagina; p++){
+		__sync_bool_compare_and_swap(&matriz->nodosPagina[p], -1, (signed char)nodo);
+	}
+}
+
+void inicializarMatrizNuma(struct matrizNuma * matriz, int aleatoria, uint64_t semilla, int numeroHilos){
+	struct matriz * m = &matriz->matriz;
+	uint64_t clave = claveAleatoria(semilla);
+
+	// un_hilo reproduce la inicializacion de siempre: todo desde el hilo principal
+	if(matriz->politica == NUMA_UN_HILO){
+		numeroHilos = 1;
+	}
+	#pragma omp parallel num_threads(numeroHilos)
+	{
+		int hilo = omp_get_thread_num(), total = omp_get_num_threads();
+		int inicio, fin, i;
+		int * fila;
+
+		tramoFilasEmpaquetada(m->filas, total, hilo, &inicio, &fin);
+		for(i = inicio; i < fin; i++){
+			fila = FILA(m, i);
+			// mismos valores que inicializarMatrizAleatoria con la misma semilla
+			if(aleatoria){
+				llenarAleatorio(fila, m->columnas, clave, (uint64_t)i * m->columnas, 1, 10);
+			}
+			else{
+				memset(fila, 0, (size_t)m->columnas * sizeof(int));
+			}
+			// tambien el relleno, para que la pagina entera quede tocada
+			memset(fila + m->columnas, 0, (size_t)(m->ld - m->columnas) * sizeof(int));
+		}
+		if(fin > inicio){
+			anotarPrimerToque(matriz, (size_t)inicio * m->ld * sizeof(int), (size_t)fin * m->ld * sizeof(int),
+				nodoHiloNuma(hilo, total));
+		}
+	}
+}
+
+// nodo de cada pagina del mapa, -1 si no se sabe (sin tocar o sin move_pages)
+static void nodosPaginas(const struct matrizNuma * matriz, int * nodos){
+	size_t pagina = tamanioPagina(), paginas = matriz->bytes / pagina, p, q, cuantas;
+	void * direcciones[PAGINAS_POR_CONSULTA];
+
+	if(matriz->nodosPagina != NULL){
+		for(p = 0; p < paginas; p++){
+			nodos[p] = matriz->nodosPagina[p];
+		}
+		return;
+	}
+	if(topologiaNuma()->nodos == 1){
+		for(p = 0; p < paginas; p++){
+			nodos[p] = 0;
+		}
+		return;
+	}
+	// move_pages sin nodos destino solo informa donde esta cada pagina
+	for(p = 0; p < paginas; p += PAGINAS_POR_CONSULTA){
+		cuantas = paginas - p < PAGINAS_POR_CONSULTA ? paginas - p : PAGINAS_POR_CONSULTA;
+		for(q = 0; q < cuantas; q++){
+			direcciones[q] = (char *)matriz->mapa + (p + q) * pagina;
+		}
+		if(syscall(SYS_move_pages, 0, cuantas, direcciones, NULL, nodos + p, 0) != 0){
+			for(q = 0; q < cuantas; q++){
+				nodos[p + q] = -1;
+			}
+		}
+	}
+	for(p = 0; p < paginas; p++){
+		if(nodos[p] < 0 || nodos[p] >= MAX_NODOS_NUMA){
+			nodos[p] = -1;
+		}
+	}
+}
+
+static int * leerNodosPaginas(const struct matrizNuma * matriz){
+	int * nodos = (int *)malloc(matriz->bytes / tamanioPagina() * sizeof(int));
+	if(nodos == NULL){
+		perror("No se pudo reservar memoria para los nodos de las paginas");
+		exit(1);
+	}
+	nodosPaginas(matriz, nodos);
+	return nodos;
+}
+
+// sumar veces los bytes de [inicio, fin) segun el nodo de su pagina
+static void contarRango(const int * nodos, size_t inicio, size_t fin, int nodoHilo, double veces, struct traficoNuma * trafico){
+	size_t pagina = tamanioPagina(), corte, p;
+	double bytes;
+
+	while(inicio < fin){
+		p = inicio / pagina;
+		corte = (p + 1) * pagina < fin ? (p + 1) * pagina : fin;
+		bytes = (double)(corte - inicio) * veces;
+		if(nodos[p] < 0){
+			trafico->bytesSinUbicar += bytes;
+		}
+		else if(nodos[p] == nodoHilo){
+			trafico->bytesLocales += bytes;
+		}
+		else{
+			trafico->bytesRemotos += bytes;
+		}
+		inicio = corte;
+	}
+}
+
+// filas [inicio, fin) y columnas [0, columnas) de una matriz leidas veces
+static void contarFilas(const struct matrizNuma * matriz, const int * nodos, int inicio, int fin, int nodoHilo, double veces,
+		struct traficoNuma * trafico){
+	size_t bytesFila = (size_t)matriz->matriz.ld * sizeof(int);
+	int i;
+
+	for(i = inicio; i < fin; i++){
+		contarRango(nodos, i * bytesFila, i * bytesFila + (size_t)matriz->matriz.columnas * sizeof(int), nodoHilo, veces, trafico);
+	}
+}
+
+static void contarPaginas(const struct matrizNuma * matriz, const int * nodos, struct traficoNuma * trafico){
+	size_t p, paginas = matriz->bytes / tamanioPagina();
+	for(p = 0; p < paginas; p++){
+		if(nodos[p] >= 0){
+			trafico->paginasPorNodo[nodos[p]]++;
+		}
+	}
+}
+
+// el recorrido de gemmEmpaquetada: cada hilo empaqueta su tramo de filas de
+// A una vez por panel de columnas de B y lee y escribe su tramo de C una vez
+// por panel de k; B la empaqueta el hilo principal (hilo 0), una vez
+void traficoNumaGemm(const struct matrizNuma * A, const struct matrizNuma * B, const struct matrizNuma * C,
+		int numeroHilos, struct traficoNuma * trafico){
+	int m = A->matriz.filas, k = A->matriz.columnas, n = B->matriz.columnas;
+	int panelesN = (n + configuracionGemmActual.nc - 1) / configuracionGemmActual.nc;
+	int panelesK = (k + configuracionGemmActual.kc - 1) / configuracionGemmActual.kc;
+	int * nodosA = leerNodosPaginas(A), * nodosB = leerNodosPaginas(B), * nodosC = leerNodosPaginas(C);
+	int nodos[MAX_CPUS_NUMA];
+	int h, total, inicio, fin;
+
+	memset(trafico, 0, sizeof(*trafico));
+	total = nodosHilos(numeroHilos, nodos);
+	for(h = 0; h < total; h++){
+		tramoFilasEmpaquetada(m, total, h, &inicio, &fin);
+		contarFilas(A, nodosA, inicio, fin, nodos[h], panelesN, trafico);
+		contarFilas(C, nodosC, inicio, fin, nodos[h], 2.0 * panelesK, trafico);
+	}
+	contarFilas(B, nodosB, 0, k, nodos[0], 1, trafico);
+	contarPaginas(A, nodosA, trafico);
+	contarPaginas(B, nodosB, trafico);
+	contarPaginas(C, nodosC, trafico);
+
+	free(nodosA);
+	free(nodosB);
+	free(nodosC);
+}
@@ -0,0 +1,92 @@
+/*
+ Matrices ubicadas por nodo NUMA
+
+ Linux pone cada pagina en el nodo del hilo que la toca primero. Si un solo
+ hilo inicializa A y B (inicializarMatricesCuadradas), todas las paginas
+ quedan en su nodo y en un servidor de dos sockets los hilos del otro socket
+ leen todo por la interconexion. Aqui las matrices se reservan con mmap (sin
+ tocar) y se ubican con una politica:
+
+ 	primer_toque  no se fija nada; inicializarMatrizNuma toca en paralelo cada
+ 	              tramo de filas desde el hilo que lo calcula en
+ 	              gemmEmpaquetada (tramoFilasEmpaquetada)
+ 	por_filas     mbind de cada tramo de filas al nodo de su hilo: lo mismo
+ 	              que primer_toque pero sin depender de quien inicializa
+ 	intercalada   MPOL_INTERLEAVE: paginas repartidas por turnos entre todos
+ 	              los nodos, para datos que leen todos los hilos (B)
+ 	un_hilo       sin politica y con la inicializacion en un hilo: como hasta
+ 	              ahora, para comparar
+
+ Las politicas se aplican con la llamada al sistema mbind, sin depender de
+ libnuma. Para que primer_toque y por_filas sirvan, los hilos de OpenMP tienen
+ que quedarse en su CPU: OMP_PROC_BIND=close (o spread) y OMP_PLACES=cores.
+
+ traficoNumaGemm estima el trafico local y remoto de un producto con
+ gemmEmpaquetada: que bytes de A, B y C lee o escribe cada hilo (el mismo
+ recorrido del motor) y en que nodo esta cada pagina (move_pages), contra el
+ nodo de la CPU donde corre el hilo.
+
+ Topologia falsa: MATRIZ_NUMA_FALSO=N simula N nodos en una maquina de un solo
+ nodo (o sin NUMA). No se llama a mbind; el hilo h de T se considera en el
+ nodo h * N / T y el nodo de cada pagina se anota al ubicarla o al tocarla
+ primero, asi las politicas y el reporte se pueden probar en cualquier equipo.
+*/
+#ifndef NUMA_MATRIZ_H
+#define NUMA_MATRIZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "matriz.h"
+
+#define MAX_NODOS_NUMA 64
+#define MAX_CPUS_NUMA 4096
+
+enum politicaNuma{
+	NUMA_UN_HILO,
+	NUMA_PRIMER_TOQUE,
+	NUMA_POR_FILAS,
+	NUMA_INTERCALADA,
+	NUMERO_POLITICAS_NUMA
+};
+
+struct topologiaNuma{
+	int nodos;
+	int falsa; // 1 si viene de MATRIZ_NUMA_FALSO
+	int numeroCpus;
+	short nodoCpu[MAX_CPUS_NUMA];
+};
+
+struct matrizNuma{
+	struct matriz matriz; // vista para los motores; los datos son del mapa
+	void * mapa;
+	size_t bytes;
+	enum politicaNuma politica;
+	signed char * nodosPagina; // solo con topologia falsa: nodo de cada pagina, -1 sin tocar
+};
+
+struct traficoNuma{
+	double bytesLocales;
+	double bytesRemotos;
+	double bytesSinUbicar; // paginas que move_pages no pudo ubicar
+	double paginasPorNodo[MAX_NODOS_NUMA]; // de A, B y C juntas
+};
+
+extern const char * nombresPoliticasNuma[NUMERO_POLITICAS_NUMA];
+
+const struct topologiaNuma * topologiaNuma(void);
+int politicaNumaPorNombre(const char * nombre);
+int nodoHiloNuma(int hilo, int numeroHilos); // llamar desde el hilo, dentro de la region paralela
+
+// numeroHilos: los del producto, para repartir los tramos de por_filas
+struct matrizNuma * crearMatrizNuma(int filas, int columnas, enum politicaNuma politica, int numeroHilos);
+void liberarMatrizNuma(struct matrizNuma *);
+
+// valores de 1 a 10 (0 si aleatoria = 0) escritos por el hilo de cada tramo
+// de filas; los mismos que inicializarMatrizAleatoria con la misma semilla
+void inicializarMatrizNuma(struct matrizNuma *, int aleatoria, uint64_t semilla, int numeroHilos);
+
+void traficoNumaGemm(const struct matrizNuma * A, const struct matrizNuma * B, const struct matrizNuma * C,
+	int numeroHilos, struct traficoNuma * trafico);
+
+#endif
@@ -0,0 +1,141 @@
+// motor OpenMP por azulejos 2D con acumuladores privados y reparto elegible
+#include <string.h>
+#include <omp.h>
+
+#include "openmp_azulejos.h"
+
+const char * nombresRepartosOpenmp[NUMERO_REPARTOS_OPENMP] = {"static", "dynamic", "guided", "tareas"};
+
+static int minimo(int a, int b){
+	return a < b ? a : b;
+}
+
+int repartoOpenmpPorNombre(const char * nombre){
+	int r;
+	for(r = 0; r < NUMERO_REPARTOS_OPENMP; r++){
+		if(strcmp(nombre, nombresRepartosOpenmp[r]) == 0){
+			return r;
+		}
+	}
+	return -1;
+}
+
+#define FILAS_MICRO_OPENMP 4
+#define COLUMNAS_MICRO_OPENMP 32
+
+// el azulejo (bi, bj) de C; acumulado vive en la pila del hilo o la tarea y
+// los bordes que no llenan un micro-azulejo se suman elemento a elemento
+__attribute__((target_clones("arch=skylake-avx512", "avx2", "default")))
+static void multiplicarAzulejoOpenmp(const struct matriz * A, const struct matriz * B, struct matriz * C, int bi, int bj){
+	int acumulado[ALTO_AZULEJO_OPENMP][ANCHO_AZULEJO_OPENMP] __attribute__((aligned(64)));
+	int fila = bi * ALTO_AZULEJO_OPENMP, columna = bj * ANCHO_AZULEJO_OPENMP;
+	int alto = minimo(ALTO_AZULEJO_OPENMP, C->filas - fila), ancho = minimo(ANCHO_AZULEJO_OPENMP, C->columnas - columna);
+	int altoMicro = alto - alto % FILAS_MICRO_OPENMP, anchoMicro = ancho - ancho % COLUMNAS_MICRO_OPENMP;
+	int i, j, p, pc, finP;
+
+	memset(acumulado, 0, sizeof(acumulado));
+	for(pc = 0; pc < A->columnas; pc += PROFUNDIDAD_AZULEJO_OPENMP){
+		finP = minimo(pc + PROFUNDIDAD_AZULEJO_OPENMP, A->columnas);
+		// micro-azulejos de 4 x 32: las 8 sumas parciales quedan en registros
+		// mientras se recorre el bloque de B
+		for(i = 0; i < altoMicro; i += FILAS_MICRO_OPENMP){
+			const int * filasA[FILAS_MICRO_OPENMP];
+			int r;
+			for(r = 0; r < FILAS_MICRO_OPENMP; r++){
+				filasA[r] = FILA(A, fila + i + r);
+			}
+			for(j = 0; j < anchoMicro; j += COLUMNAS_MICRO_OPENMP){
+				int s[FILAS_MICRO_OPENMP][COLUMNAS_MICRO_OPENMP] __attribute__((aligned(64)));
+				int x;
+				for(r = 0; r < FILAS_MICRO_OPENMP; r++){
+					memcpy(s[r], &acumulado[i + r][j], sizeof(s[r]));
+				}
+				for(p = pc; p < finP; p++){
+					const int * filaB = FILA(B, p) + columna + j;
+					int a0 = filasA[0][p], a1 = filasA[1][p], a2 = filasA[2][p], a3 = filasA[3][p];
+					#pragma omp simd aligned(s : 64)
+					for(x = 0; x < COLUMNAS_MICRO_OPENMP; x++){
+						s[0][x] += a0 * filaB[x];
+						s[1][x] += a1 * filaB[x];
+						s[2][x] += a2 * filaB[x];
+						s[3][x] += a3 * filaB[x];
+					}
+				}
+				for(r = 0; r < FILAS_MICRO_OPENMP; r++){
+					memcpy(&acumulado[i + r][j], s[r], sizeof(s[r]));
+				}
+			}
+		}
+		for(i = 0; i < alto; i++){
+			const int * filaA = FILA(A, fila + i);
+			int * suma = acumulado[i];
+			// filas del borde enteras; en las demas solo las columnas del borde
+			int desde = i < altoMicro ? anchoMicro : 0;
+			for(p = pc; p < finP; p++){
+				const int * filaB = FILA(B, p) + columna;
+				int a = filaA[p];
+				#pragma omp simd
+				for(j = desde; j < ancho; j++){
+					suma[j] += a * filaB[j];
+				}
+			}
+		}
+	}
+	for(i = 0; i < alto; i++){
+		memcpy(FILA(C, fila + i) + columna, acumulado[i], (size_t)ancho * sizeof(int));
+	}
+}
+
+void multiplicarOpenmpAzulejos(const struct matriz * A, const struct matriz * B, struct matriz * C,
+		int numeroHilos, enum repartoOpenmp reparto, int trozo){
+	multiplicarOpenmpAzulejosConGanchos(A, B, C, numeroHilos, reparto, trozo, NULL);
+}
+
+void multiplicarOpenmpAzulejosConGanchos(const struct matriz * A, const struct matriz * B, struct matriz * C,
+		int numeroHilos, enum repartoOpenmp reparto, int trozo, const struct ganchosHilos * ganchos){
+	int filasAzulejos = (C->filas + ALTO_AZULEJO_OPENMP - 1) / ALTO_AZULEJO_OPENMP;
+	int columnasAzulejos = (C->columnas + ANCHO_AZULEJO_OPENMP - 1) / ANCHO_AZULEJO_OPENMP;
+	int bi, bj;
+
+	if(numeroHilos <= 0){
+		numeroHilos = omp_get_max_threads();
+	}
+	if(trozo < 0){
+		trozo = 0;
+	}
+
+	// azulejos por columnas: los consecutivos comparten el panel de B
+	if(reparto == REPARTO_TAREAS){
+		#pragma omp parallel num_threads(numeroHilos)
+		{
+			entrarGanchoHilo(ganchos);
+			// los demas hilos hacen tareas en la barrera del single
+			#pragma omp single
+			#pragma omp taskloop collapse(2) grainsize(trozo > 0 ? trozo : 1) private(bi)
+			for(bj = 0; bj < columnasAzulejos; bj++){
+				for(bi = 0; bi < filasAzulejos; bi++){
+					multiplicarAzulejoOpenmp(A, B, C, bi, bj);
+				}
+			}
+			salirGanchoHilo(ganchos);
+		}
+		return;
+	}
+
+	switch(reparto){
+		case REPARTO_DINAMICO: omp_set_schedule(omp_sched_dynamic, trozo); break;
+		case REPARTO_GUIADO: omp_set_schedule(omp_sched_guided, trozo); break;
+		default: omp_set_schedule(omp_sched_static, trozo); break;
+	}
+	#pragma omp parallel num_threads(numeroHilos) private(bi)
+	{
+		entrarGanchoHilo(ganchos);
+		#pragma omp for collapse(2) schedule(runtime) nowait
+		for(bj = 0; bj < columnasAzulejos; bj++){
+			for(bi = 0; bi < filasAzulejos; bi++){
+				multiplicarAzulejoOpenmp(A, B, C, bi, bj);
+			}
+		}
+		salirGanchoHilo(ganchos);
+	}
+}
@@ -0,0 +1,56 @@
+/*
+ Motor OpenMP por azulejos 2D con reparto elegible en tiempo de ejecucion
+
+ C se parte en azulejos de ALTO_AZULEJO_OPENMP x ANCHO_AZULEJO_OPENMP y cada
+ azulejo es una iteracion independiente: sus filas de A por un bloque de
+ PROFUNDIDAD_AZULEJO_OPENMP filas de B a la vez, sumando en un acumulador
+ privado en la pila de quien lo calcula (64 KiB; nada compartido entre
+ hilos), y el acumulador se copia a C al terminar. Dentro del azulejo cada
+ fila de B se multiplica por 4 filas de A a la vez. B no se transpone, y los
+ azulejos se recorren por columnas para que los consecutivos compartan el
+ panel de B.
+
+ Los azulejos se reparten con
+
+ 	static, dynamic, guided  parallel for collapse(2) sobre (columna, fila)
+ 	                          de azulejos con schedule(runtime) y
+ 	                          omp_set_schedule; trozo es el chunk (0 = el
+ 	                          de la implementacion)
+ 	tareas                   taskloop collapse(2) desde un solo hilo, con
+ 	                          grainsize(trozo)
+
+ para comparar las politicas en cada maquina. numeroHilos <= 0 usa
+ omp_get_max_threads(), es decir OMP_NUM_THREADS si esta definida.
+
+ multiplicarOpenmpAzulejosConGanchos llama a los ganchos (ganchos_hilos.h)
+ en cada hilo de la region: entrar antes de tomar azulejos y salir al acabar
+ los suyos (con tareas, cuando ya no quedan tareas por hacer).
+*/
+#ifndef OPENMP_AZULEJOS_H
+#define OPENMP_AZULEJOS_H
+
+#include "matriz.h"
+#include "ganchos_hilos.h"
+
+#define ALTO_AZULEJO_OPENMP 128
+#define ANCHO_AZULEJO_OPENMP 128
+#define PROFUNDIDAD_AZULEJO_OPENMP 128
+
+enum repartoOpenmp{
+	REPARTO_ESTATICO,
+	REPARTO_DINAMICO,
+	REPARTO_GUIADO,
+	REPARTO_TAREAS,
+	NUMERO_REPARTOS_OPENMP
+};
+
+extern const char * nombresRepartosOpenmp[NUMERO_REPARTOS_OPENMP];
+
+int repartoOpenmpPorNombre(const char * nombre); // -1 si no existe
+
+void multiplicarOpenmpAzulejos(const struct matriz * A, const struct matriz * B, struct matriz * C,
+	int numeroHilos, enum repartoOpenmp reparto, int trozo);
+void multiplicarOpenmpAzulejosConGanchos(const struct matriz * A, const struct matriz * B, struct matriz * C,
+	int numeroHilos, enum repartoOpenmp reparto, int trozo, const struct ganchosHilos * ganchos);
+
+#endif
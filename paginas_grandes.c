@@ -0,0 +1,191 @@
+// memoria en paginas grandes (THP o hugetlb) con degradacion al modo siguiente
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "paginas_grandes.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+#define DOS_MIB ((size_t)2 << 20)
+#define UN_GIB ((size_t)1 << 30)
+
+const char * nombresModosPaginas[NUMERO_MODOS_PAGINAS] = {"normales", "thp", "2m", "1g"};
+
+static enum modoPaginas modoMatrices = PAGINAS_NORMALES;
+static int prefallarMatrices = 0;
+// un aviso por modo que no se pudo usar
+static int avisado[NUMERO_MODOS_PAGINAS];
+
+__attribute__((constructor))
+static void leerPaginasMatrices(void){
+	const char * modo = getenv("MATRIZ_PAGINAS");
+	const char * prefallo = getenv("MATRIZ_PREFALLO");
+	if(modo != NULL && modoPaginasPorNombre(modo) >= 0){
+		modoMatrices = (enum modoPaginas)modoPaginasPorNombre(modo);
+	}
+	if(prefallo != NULL && atoi(prefallo) > 0){
+		prefallarMatrices = 1;
+	}
+}
+
+int modoPaginasPorNombre(const char * nombre){
+	int m;
+	for(m = 0; m < NUMERO_MODOS_PAGINAS; m++){
+		if(strcmp(nombre, nombresModosPaginas[m]) == 0){
+			return m;
+		}
+	}
+	return -1;
+}
+
+size_t tamanioPaginaModo(enum modoPaginas modo){
+	switch(modo){
+		case PAGINAS_THP:
+		case PAGINAS_2M: return DOS_MIB;
+		case PAGINAS_1G: return UN_GIB;
+		default: return (size_t)sysconf(_SC_PAGESIZE);
+	}
+}
+
+void fijarPaginasMatrices(enum modoPaginas modo, int prefallar){
+	modoMatrices = modo;
+	prefallarMatrices = prefallar;
+}
+
+enum modoPaginas paginasMatrices(void){
+	return modoMatrices;
+}
+
+int prefalloMatrices(void){
+	return prefallarMatrices;
+}
+
+static size_t redondear(size_t bytes, size_t pagina){
+	return bytes == 0 ? pagina : (bytes + pagina - 1) / pagina * pagina;
+}
+
+// MAP_HUGETLB falla en el mmap si el fondo no tiene paginas para todo el mapeo
+static void * mapearHugetlb(size_t bytes, int compartida, enum modoPaginas modo){
+	int banderas = (compartida ? MAP_SHARED : MAP_PRIVATE) | MAP_ANONYMOUS | MAP_HUGETLB
+		| (modo == PAGINAS_1G ? MAP_HUGE_1GB : MAP_HUGE_2MB);
+	void * mapa = mmap(NULL, redondear(bytes, tamanioPaginaModo(modo)), PROT_READ | PROT_WRITE, banderas, -1, 0);
+	return mapa == MAP_FAILED ? NULL : mapa;
+}
+
+// se mapean 2 MiB de mas y se recortan los bordes para que el inicio quede
+// alineado: solo las regiones alineadas pueden ir en paginas de 2 MiB
+static void * mapearThp(size_t bytes, int compartida){
+	size_t largo = redondear(bytes, DOS_MIB);
+	char * mapa = (char *)mmap(NULL, largo + DOS_MIB, PROT_READ | PROT_WRITE,
+		(compartida ? MAP_SHARED : MAP_PRIVATE) | MAP_ANONYMOUS, -1, 0);
+	char * alineado;
+
+	if(mapa == (char *)MAP_FAILED){
+		return NULL;
+	}
+	alineado = (char *)(((uintptr_t)mapa + DOS_MIB - 1) & ~(uintptr_t)(DOS_MIB - 1));
+	if(alineado > mapa){
+		munmap(mapa, alineado - mapa);
+	}
+	munmap(alineado + largo, mapa + DOS_MIB - alineado);
+	// EINVAL: kernel sin THP (o sin THP para memoria compartida)
+	if(madvise(alineado, largo, MADV_HUGEPAGE) != 0){
+		munmap(alineado, largo);
+		return NULL;
+	}
+	return alineado;
+}
+
+void * reservarPaginas(size_t bytes, int compartida, enum modoPaginas * obtenido){
+	enum modoPaginas modo = modoMatrices;
+	void * datos = NULL;
+
+	while(modo != PAGINAS_NORMALES){
+		datos = modo == PAGINAS_THP ? mapearThp(bytes, compartida) : mapearHugetlb(bytes, compartida, modo);
+		if(datos != NULL){
+			break;
+		}
+		if(!__sync_lock_test_and_set(&avisado[modo], 1)){
+			fprintf(stderr, "paginas %s no disponibles (%s), se usa %s\n", nombresModosPaginas[modo],
+				modo == PAGINAS_THP ? "el kernel no tiene THP" : "no hay paginas reservadas en vm.nr_hugepages",
+				nombresModosPaginas[modo - 1]);
+		}
+		modo = (enum modoPaginas)(modo - 1);
+	}
+	*obtenido = modo;
+	return datos;
+}
+
+void liberarPaginas(void * datos, size_t bytes, enum modoPaginas modo){
+	if(datos != NULL && modo != PAGINAS_NORMALES){
+		munmap(datos, redondear(bytes, tamanioPaginaModo(modo)));
+	}
+}
+
+// escribir cada pagina con su propio valor la asigna sin cambiar el contenido;
+// en paralelo para que cada hilo ponga el primer toque de su tramo
+void prefallarPaginas(void * datos, size_t bytes){
+	size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+	uintptr_t inicio = (uintptr_t)datos & ~(uintptr_t)(pagina - 1);
+	long p, paginas;
+
+	if(datos == NULL || bytes == 0){
+		return;
+	}
+	paginas = (long)(((uintptr_t)datos + bytes - inicio + pagina - 1) / pagina);
+	if(madvise((void *)inicio, (size_t)paginas * pagina, MADV_POPULATE_WRITE) == 0){
+		return;
+	}
+	#pragma omp parallel for schedule(static)
+	for(p = 0; p < paginas; p++){
+		volatile char * c = (volatile char *)(p == 0 ? (uintptr_t)datos : inicio + (size_t)p * pagina);
+		*c = *c;
+	}
+}
+
+long long bytesEnPaginasGrandes(const void * datos, long long * bytesMapeo){
+	FILE * archivo = fopen("/proc/self/smaps", "r");
+	char linea[512];
+	unsigned long desde, hasta;
+	long long kib, total = 0;
+	int dentro = 0;
+
+	*bytesMapeo = 0;
+	if(archivo == NULL){
+		return -1;
+	}
+	while(fgets(linea, sizeof(linea), archivo) != NULL){
+		// cabecera de un mapeo: "desde-hasta permisos ..."; los campos empiezan con mayuscula
+		if((linea[0] < 'A' || linea[0] > 'Z') && sscanf(linea, "%lx-%lx ", &desde, &hasta) == 2){
+			if(dentro){
+				break;
+			}
+			dentro = (uintptr_t)datos >= desde && (uintptr_t)datos < hasta;
+			if(dentro){
+				*bytesMapeo = (long long)(hasta - desde);
+			}
+			continue;
+		}
+		if(dentro && (sscanf(linea, "AnonHugePages: %lld kB", &kib) == 1 || sscanf(linea, "ShmemPmdMapped: %lld kB", &kib) == 1
+				|| sscanf(linea, "Shared_Hugetlb: %lld kB", &kib) == 1 || sscanf(linea, "Private_Hugetlb: %lld kB", &kib) == 1)){
+			total += kib * 1024;
+		}
+	}
+	fclose(archivo);
+	return total;
+}
@@ -0,0 +1,64 @@
+/*
+ Memoria de las matrices en paginas grandes
+
+ Con paginas de 4 KiB una matriz de 4096 x 4096 int ocupa 16384 paginas y los
+ recorridos por columnas (los kernels ingenuos) cambian de pagina en cada
+ elemento: la dTLB no alcanza y casi cada carga paga una caminata de la tabla
+ de paginas. Con paginas de 2 MiB la misma matriz son 32 entradas.
+
+ 	normales  posix_memalign (mmap compartido anonimo en el pool de procesos)
+ 	thp       mmap alineado a 2 MiB y madvise(MADV_HUGEPAGE): el kernel pone
+ 	          paginas grandes transparentes si puede (enabled = always o
+ 	          madvise; para el segmento compartido, shmem_enabled = advise)
+ 	2m, 1g    mmap con MAP_HUGETLB de ese tamanio, del fondo reservado por el
+ 	          administrador (vm.nr_hugepages, o
+ 	          /sys/kernel/mm/hugepages/hugepages-1048576kB/nr_hugepages)
+
+ Si el modo pedido no se puede (no hay paginas reservadas, el kernel no tiene
+ THP) se baja al siguiente, 1g -> 2m -> thp -> normales, y se avisa una sola
+ vez por stderr. reservarPaginas devuelve en obtenido el modo que se uso.
+
+ Prefallo: las paginas de un mmap se asignan al tocarlas por primera vez, y
+ con 4 KiB eso son miles de fallos de pagina dentro de la primera repeticion
+ medida. prefallarPaginas las toca al crear la matriz (MADV_POPULATE_WRITE,
+ o escribiendo en cada pagina en paralelo si el kernel es anterior a 5.14).
+
+ El modo de crearMatriz y crearMatrizTipada se fija con fijarPaginasMatrices o
+ con las variables de entorno MATRIZ_PAGINAS (normales, thp, 2m, 1g) y
+ MATRIZ_PREFALLO=1, asi todos los programas lo heredan sin cambios.
+*/
+#ifndef PAGINAS_GRANDES_H
+#define PAGINAS_GRANDES_H
+
+#include <stddef.h>
+
+enum modoPaginas{
+	PAGINAS_NORMALES,
+	PAGINAS_THP,
+	PAGINAS_2M,
+	PAGINAS_1G,
+	NUMERO_MODOS_PAGINAS
+};
+
+extern const char * nombresModosPaginas[NUMERO_MODOS_PAGINAS];
+
+int modoPaginasPorNombre(const char * nombre); // -1 si no existe
+size_t tamanioPaginaModo(enum modoPaginas);
+
+void fijarPaginasMatrices(enum modoPaginas, int prefallar);
+enum modoPaginas paginasMatrices(void);
+int prefalloMatrices(void);
+
+// bytes (redondeados a la pagina del modo) en el modo de paginasMatrices o el
+// siguiente que se pueda; compartida: MAP_SHARED, se hereda con fork. NULL si
+// el resultado es PAGINAS_NORMALES: quien llama reserva como siempre
+void * reservarPaginas(size_t bytes, int compartida, enum modoPaginas * obtenido);
+void liberarPaginas(void * datos, size_t bytes, enum modoPaginas);
+void prefallarPaginas(void * datos, size_t bytes);
+
+// bytes del mapeo que contiene datos respaldados por paginas grandes segun
+// /proc/self/smaps (THP o hugetlb), y en bytesMapeo el tamanio del mapeo (el
+// kernel junta mapeos vecinos iguales, p. ej. A, B y C); -1 si no se puede leer
+long long bytesEnPaginasGrandes(const void * datos, long long * bytesMapeo);
+
+#endif
@@ -0,0 +1,182 @@
+// planificador de azulejos 2D con colas por trabajador y robo de trabajo
+#include <stdlib.h>
+#include <stdio.h>
+#include <sched.h>
+
+#include "planificador_azulejos.h"
+
+// azulejos por trabajador que se buscan al elegir el tamanio automaticamente
+#define AZULEJOS_POR_TRABAJADOR 8
+#define LADO_MAXIMO_AZULEJO 128
+
+static int minimo(int a, int b){
+	return a < b ? a : b;
+}
+
+// elegir un azulejo cuadrado (potencia de 2) que de al menos
+// AZULEJOS_POR_TRABAJADOR azulejos a cada trabajador; con matrices muy
+// pequenias se baja hasta azulejos de 1 x 1
+void elegirTamanioAzulejo(int filas, int columnas, int numeroTrabajadores, int * altoAzulejo, int * anchoAzulejo){
+	int lado = LADO_MAXIMO_AZULEJO;
+	long objetivo = (long)numeroTrabajadores * AZULEJOS_POR_TRABAJADOR;
+
+	while(lado > 1 && (long)((filas + lado - 1) / lado) * ((columnas + lado - 1) / lado) < objetivo){
+		lado /= 2;
+	}
+	* altoAzulejo = lado;
+	* anchoAzulejo = lado;
+}
+
+// dividir C (filas x columnas) en azulejos y crear una cola por trabajador
+struct planificador * crearPlanificador(int filas, int columnas, int altoAzulejo, int anchoAzulejo, int numeroTrabajadores){
+	struct planificador * planificador = (struct planificador *)calloc(1, sizeof(struct planificador));
+	int filasAzulejos, columnasAzulejos, i, j, t;
+
+	if(planificador == NULL){
+		perror("No se pudo reservar memoria para el planificador");
+		exit(1);
+	}
+	if(numeroTrabajadores < 1){
+		numeroTrabajadores = 1;
+	}
+	filasAzulejos = filas > 0 ? (filas + altoAzulejo - 1) / altoAzulejo : 0;
+	columnasAzulejos = columnas > 0 ? (columnas + anchoAzulejo - 1) / anchoAzulejo : 0;
+
+	planificador->numeroAzulejos = filasAzulejos * columnasAzulejos;
+	planificador->numeroTrabajadores = numeroTrabajadores;
+	planificador->azulejos = (struct azulejo *)malloc((planificador->numeroAzulejos + 1) * sizeof(struct azulejo));
+	planificador->deques = (struct dequeAzulejos *)calloc(numeroTrabajadores, sizeof(struct dequeAzulejos));
+	if(planificador->azulejos == NULL || planificador->deques == NULL){
+		perror("No se pudo reservar memoria para los azulejos");
+		exit(1);
+	}
+
+	// orden por filas de azulejos: tramos contiguos comparten filas de A
+	for(i = 0; i < filasAzulejos; i++){
+		for(j = 0; j < columnasAzulejos; j++){
+			struct azulejo * azulejo = &planificador->azulejos[i * columnasAzulejos + j];
+			azulejo->fila = i * altoAzulejo;
+			azulejo->columna = j * anchoAzulejo;
+			azulejo->filas = minimo(altoAzulejo, filas - azulejo->fila);
+			azulejo->columnas = minimo(anchoAzulejo, columnas - azulejo->columna);
+		}
+	}
+
+	for(t = 0; t < numeroTrabajadores; t++){
+		pthread_mutex_init(&planificador->deques[t].candado, NULL);
+		planificador->deques[t].indices = (int *)malloc((planificador->numeroAzulejos + 1) * sizeof(int));
+		if(planificador->deques[t].indices == NULL){
+			perror("No se pudo reservar memoria para las colas de azulejos");
+			exit(1);
+		}
+	}
+	reiniciarPlanificador(planificador);
+	return planificador;
+}
+
+// volver a repartir todos los azulejos; se llama antes de cada multiplicacion
+void reiniciarPlanificador(struct planificador * planificador){
+	int t, i, desde, hasta;
+	int n = planificador->numeroAzulejos;
+	int trabajadores = planificador->numeroTrabajadores;
+
+	// tramos contiguos de tamanio casi igual (el resto se reparte de a uno)
+	for(t = 0; t < trabajadores; t++){
+		struct dequeAzulejos * deque = &planificador->deques[t];
+		desde = (int)((long)n * t / trabajadores);
+		hasta = (int)((long)n * (t + 1) / trabajadores);
+		for(i = desde; i < hasta; i++){
+			deque->indices[i - desde] = i;
+		}
+		deque->inicio = 0;
+		deque->fin = hasta - desde;
+		deque->ejecutados = 0;
+		deque->robados = 0;
+	}
+	__atomic_store_n(&planificador->restantes, n, __ATOMIC_RELEASE);
+}
+
+// sacar un azulejo del final de la cola propia; -1 si esta vacia
+static int sacarPropio(struct dequeAzulejos * deque){
+	int indice = -1;
+	pthread_mutex_lock(&deque->candado);
+	if(deque->fin > deque->inicio){
+		deque->fin--;
+		indice = deque->indices[deque->fin];
+	}
+	pthread_mutex_unlock(&deque->candado);
+	return indice;
+}
+
+// robar un azulejo del principio de la cola de otro trabajador; -1 si esta vacia
+static int robar(struct dequeAzulejos * deque){
+	int indice = -1;
+	pthread_mutex_lock(&deque->candado);
+	if(deque->fin > deque->inicio){
+		indice = deque->indices[deque->inicio];
+		deque->inicio++;
+	}
+	pthread_mutex_unlock(&deque->candado);
+	return indice;
+}
+
+// bucle de un trabajador: primero su cola, despues robar hasta que no quede nada
+void trabajarPlanificador(struct planificador * planificador, int trabajador, funcionAzulejo funcion, void * contexto){
+	struct dequeAzulejos * propia;
+	int indice, victima, intento;
+	unsigned int semilla = (unsigned int)trabajador * 2654435761u + 1;
+
+	if(trabajador < 0 || trabajador >= planificador->numeroTrabajadores){
+		return;
+	}
+	propia = &planificador->deques[trabajador];
+
+	while(__atomic_load_n(&planificador->restantes, __ATOMIC_ACQUIRE) > 0){
+		indice = sacarPropio(propia);
+
+		// cola propia vacia: recorrer a los demas empezando por uno al azar
+		if(indice < 0){
+			victima = rand_r(&semilla) % planificador->numeroTrabajadores;
+			for(intento = 0; intento < planificador->numeroTrabajadores && indice < 0; intento++){
+				if(victima != trabajador){
+					indice = robar(&planificador->deques[victima]);
+				}
+				victima = (victima + 1) % planificador->numeroTrabajadores;
+			}
+			if(indice < 0){
+				// los azulejos que faltan ya estan en ejecucion en otros hilos
+				if(__atomic_load_n(&planificador->restantes, __ATOMIC_ACQUIRE) == 0){
+					break;
+				}
+				sched_yield();
+				continue;
+			}
+			propia->robados++;
+		}
+
+		__atomic_sub_fetch(&planificador->restantes, 1, __ATOMIC_ACQ_REL);
+		funcion(&planificador->azulejos[indice], contexto);
+		propia->ejecutados++;
+	}
+}
+
+// azulejos ejecutados y robados por cada trabajador en la ultima multiplicacion
+void mostrarEstadisticasPlanificador(struct planificador * planificador){
+	int t;
+	printf("planificador: %d azulejos\n", planificador->numeroAzulejos);
+	for(t = 0; t < planificador->numeroTrabajadores; t++){
+		printf("\ttrabajador %d: %ld azulejos (%ld robados)\n", t,
+			planificador->deques[t].ejecutados, planificador->deques[t].robados);
+	}
+}
+
+void destruirPlanificador(struct planificador * planificador){
+	int t;
+	for(t = 0; t < planificador->numeroTrabajadores; t++){
+		pthread_mutex_destroy(&planificador->deques[t].candado);
+		free(planificador->deques[t].indices);
+	}
+	free(planificador->deques);
+	free(planificador->azulejos);
+	free(planificador);
+}
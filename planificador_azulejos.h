@@ -0,0 +1,55 @@
+/*
+ Planificador de azulejos 2D con robo de trabajo
+
+ La matriz resultado C se divide en azulejos (bloques de filas x columnas).
+ Cada trabajador recibe al inicio un tramo contiguo de azulejos en su propia
+ cola doble (deque): saca trabajo por el final de su cola y, cuando se queda
+ sin trabajo, roba por el principio de la cola de otro trabajador. Asi un
+ hilo demorado (p. ej. por otro proceso en el mismo nucleo) no deja a los
+ demas esperando, y el reparto funciona aunque N sea menor que el numero de
+ trabajadores.
+
+ Sirve tanto para el pool de pthreads como para OpenMP: cada trabajador solo
+ tiene que llamar a trabajarPlanificador con su indice (indiceHiloActual() u
+ omp_get_thread_num()).
+*/
+#ifndef PLANIFICADOR_AZULEJOS_H
+#define PLANIFICADOR_AZULEJOS_H
+
+#include <pthread.h>
+
+struct azulejo{
+	int fila;
+	int columna;
+	int filas;
+	int columnas;
+};
+
+typedef void (*funcionAzulejo)(const struct azulejo *, void * contexto);
+
+// cola doble de indices de azulejos de un trabajador
+struct dequeAzulejos{
+	pthread_mutex_t candado;
+	int * indices;
+	int inicio; // por aqui roban los demas
+	int fin; // por aqui saca el duenio
+	long ejecutados;
+	long robados;
+};
+
+struct planificador{
+	struct azulejo * azulejos;
+	int numeroAzulejos;
+	struct dequeAzulejos * deques;
+	int numeroTrabajadores;
+	int restantes; // azulejos que nadie ha tomado todavia (acceso atomico)
+};
+
+struct planificador * crearPlanificador(int filas, int columnas, int altoAzulejo, int anchoAzulejo, int numeroTrabajadores);
+void elegirTamanioAzulejo(int filas, int columnas, int numeroTrabajadores, int * altoAzulejo, int * anchoAzulejo);
+void reiniciarPlanificador(struct planificador *);
+void trabajarPlanificador(struct planificador *, int trabajador, funcionAzulejo, void * contexto);
+void mostrarEstadisticasPlanificador(struct planificador *);
+void destruirPlanificador(struct planificador *);
+
+#endif
@@ -0,0 +1,207 @@
+// pool persistente de hilos con cola de tareas y variables de condicion
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "pool_hilos.h"
+
+#define CAPACIDAD_INICIAL_COLA 64
+
+// indice del trabajador que ejecuta la tarea actual (-1 fuera del pool)
+static __thread int indiceHilo = -1;
+
+struct datos_trabajador{
+	struct pool_hilos * pool;
+	int indice;
+};
+
+static double tiempoActual(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// bucle de cada trabajador: dormir hasta que haya tareas, ejecutarlas y avisar
+static void * trabajador(void * parametros){
+	struct datos_trabajador * datos = (struct datos_trabajador *)parametros;
+	struct pool_hilos * pool = datos->pool;
+	struct tarea tarea;
+	double espera;
+
+	indiceHilo = datos->indice;
+	free(datos);
+
+	pthread_mutex_lock(&pool->candado);
+	while(1){
+		while(pool->encoladas == 0 && !pool->terminar){
+			pthread_cond_wait(&pool->hayTareas, &pool->candado);
+		}
+		if(pool->encoladas == 0 && pool->terminar){
+			break;
+		}
+
+		tarea = pool->cola[pool->inicio];
+		pool->inicio = (pool->inicio + 1) % pool->capacidad;
+		pool->encoladas--;
+
+		espera = tiempoActual() - tarea.instanteEncolada;
+		pool->estadisticas.tareasDespachadas++;
+		pool->estadisticas.esperaTotal += espera;
+		if(espera < pool->estadisticas.esperaMinima){
+			pool->estadisticas.esperaMinima = espera;
+		}
+		if(espera > pool->estadisticas.esperaMaxima){
+			pool->estadisticas.esperaMaxima = espera;
+		}
+		pthread_mutex_unlock(&pool->candado);
+
+		tarea.funcion(tarea.argumento);
+
+		pthread_mutex_lock(&pool->candado);
+		pool->pendientes--;
+		if(pool->pendientes == 0){
+			pthread_cond_broadcast(&pool->sinPendientes);
+		}
+	}
+	pthread_mutex_unlock(&pool->candado);
+	return NULL;
+}
+
+// crear el pool y arrancar numeroHilos trabajadores
+struct pool_hilos * crearPoolHilos(int numeroHilos){
+	struct pool_hilos * pool = (struct pool_hilos *)calloc(1, sizeof(struct pool_hilos));
+	struct datos_trabajador * datos;
+	int i, rc;
+
+	if(numeroHilos < 1){
+		numeroHilos = 1;
+	}
+	if(pool == NULL){
+		perror("No se pudo reservar memoria para el pool de hilos");
+		exit(1);
+	}
+	pool->hilos = (pthread_t *)malloc(numeroHilos * sizeof(pthread_t));
+	pool->cola = (struct tarea *)malloc(CAPACIDAD_INICIAL_COLA * sizeof(struct tarea));
+	if(pool->hilos == NULL || pool->cola == NULL){
+		perror("No se pudo reservar memoria para el pool de hilos");
+		exit(1);
+	}
+	pool->numeroHilos = numeroHilos;
+	pool->capacidad = CAPACIDAD_INICIAL_COLA;
+	pthread_mutex_init(&pool->candado, NULL);
+	pthread_cond_init(&pool->hayTareas, NULL);
+	pthread_cond_init(&pool->sinPendientes, NULL);
+	reiniciarEstadisticasPool(pool);
+
+	for(i = 0; i < numeroHilos; i++){
+		datos = (struct datos_trabajador *)malloc(sizeof(struct datos_trabajador));
+		if(datos == NULL){
+			perror("No se pudo reservar memoria para el pool de hilos");
+			exit(1);
+		}
+		datos->pool = pool;
+		datos->indice = i;
+		rc = pthread_create(&pool->hilos[i], NULL, trabajador, datos);
+		if(rc){
+			printf("ERROR; return code from pthread_create() is %d\n", rc);
+			exit(-1);
+		}
+	}
+	return pool;
+}
+
+// agregar una tarea al final de la cola y despertar a un trabajador
+void encolarTarea(struct pool_hilos * pool, funcionTarea funcion, void * argumento){
+	struct tarea * colaNueva;
+	int i;
+
+	pthread_mutex_lock(&pool->candado);
+	if(pool->encoladas == pool->capacidad){
+		colaNueva = (struct tarea *)malloc(2 * pool->capacidad * sizeof(struct tarea));
+		if(colaNueva == NULL){
+			perror("No se pudo ampliar la cola de tareas");
+			exit(1);
+		}
+		for(i = 0; i < pool->encoladas; i++){
+			colaNueva[i] = pool->cola[(pool->inicio + i) % pool->capacidad];
+		}
+		free(pool->cola);
+		pool->cola = colaNueva;
+		pool->capacidad *= 2;
+		pool->inicio = 0;
+	}
+	i = (pool->inicio + pool->encoladas) % pool->capacidad;
+	pool->cola[i].funcion = funcion;
+	pool->cola[i].argumento = argumento;
+	pool->cola[i].instanteEncolada = tiempoActual();
+	pool->encoladas++;
+	pool->pendientes++;
+	pthread_cond_signal(&pool->hayTareas);
+	pthread_mutex_unlock(&pool->candado);
+}
+
+// bloquear hasta que todas las tareas encoladas hayan terminado
+void esperarPoolHilos(struct pool_hilos * pool){
+	pthread_mutex_lock(&pool->candado);
+	while(pool->pendientes > 0){
+		pthread_cond_wait(&pool->sinPendientes, &pool->candado);
+	}
+	pthread_mutex_unlock(&pool->candado);
+}
+
+// terminar las tareas pendientes, detener los trabajadores y liberar el pool
+void destruirPoolHilos(struct pool_hilos * pool){
+	int i;
+
+	pthread_mutex_lock(&pool->candado);
+	pool->terminar = 1;
+	pthread_cond_broadcast(&pool->hayTareas);
+	pthread_mutex_unlock(&pool->candado);
+
+	for(i = 0; i < pool->numeroHilos; i++){
+		pthread_join(pool->hilos[i], NULL);
+	}
+
+	pthread_mutex_destroy(&pool->candado);
+	pthread_cond_destroy(&pool->hayTareas);
+	pthread_cond_destroy(&pool->sinPendientes);
+	free(pool->cola);
+	free(pool->hilos);
+	free(pool);
+}
+
+// indice (0..numeroHilos-1) del trabajador que llama; -1 fuera del pool
+int indiceHiloActual(void){
+	return indiceHilo;
+}
+
+struct estadisticasPool obtenerEstadisticasPool(struct pool_hilos * pool){
+	struct estadisticasPool copia;
+	pthread_mutex_lock(&pool->candado);
+	copia = pool->estadisticas;
+	pthread_mutex_unlock(&pool->candado);
+	return copia;
+}
+
+void reiniciarEstadisticasPool(struct pool_hilos * pool){
+	pthread_mutex_lock(&pool->candado);
+	pool->estadisticas.tareasDespachadas = 0;
+	pool->estadisticas.esperaTotal = 0.0;
+	pool->estadisticas.esperaMinima = 1e30;
+	pool->estadisticas.esperaMaxima = 0.0;
+	pthread_mutex_unlock(&pool->candado);
+}
+
+// mostrar el tiempo de espera + despacho de las tareas
+void mostrarEstadisticasPool(struct pool_hilos * pool){
+	struct estadisticasPool estadisticas = obtenerEstadisticasPool(pool);
+
+	if(estadisticas.tareasDespachadas == 0){
+		printf("pool de hilos: sin tareas despachadas\n");
+		return;
+	}
+	printf("pool de hilos (%d hilos): %ld tareas, espera+despacho promedio %.2f us, min %.2f us, max %.2f us\n",
+		pool->numeroHilos, estadisticas.tareasDespachadas,
+		estadisticas.esperaTotal / estadisticas.tareasDespachadas * 1e6,
+		estadisticas.esperaMinima * 1e6, estadisticas.esperaMaxima * 1e6);
+}
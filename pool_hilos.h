@@ -0,0 +1,61 @@
+/*
+ Pool persistente de hilos
+
+ Los hilos se crean una sola vez (crearPoolHilos) y reciben trabajo por una
+ cola FIFO protegida con un mutex. Mientras no hay tareas, los trabajadores
+ duermen en una variable de condicion, no giran.
+
+ Para cada tarea se mide el tiempo entre encolarTarea y el momento en que un
+ trabajador la empieza (espera + despacho). mostrarEstadisticasPool resume
+ esas mediciones.
+*/
+#ifndef POOL_HILOS_H
+#define POOL_HILOS_H
+
+#include <pthread.h>
+
+typedef void (*funcionTarea)(void *);
+
+struct tarea{
+	funcionTarea funcion;
+	void * argumento;
+	double instanteEncolada;
+};
+
+struct estadisticasPool{
+	long tareasDespachadas;
+	double esperaTotal; // segundos acumulados entre encolar y empezar
+	double esperaMinima;
+	double esperaMaxima;
+};
+
+struct pool_hilos{
+	pthread_t * hilos;
+	int numeroHilos;
+
+	// cola circular de tareas; crece al doble cuando se llena
+	struct tarea * cola;
+	int capacidad;
+	int inicio;
+	int encoladas;
+
+	int pendientes; // encoladas + en ejecucion
+	int terminar;
+
+	pthread_mutex_t candado;
+	pthread_cond_t hayTareas;
+	pthread_cond_t sinPendientes;
+
+	struct estadisticasPool estadisticas;
+};
+
+struct pool_hilos * crearPoolHilos(int numeroHilos);
+void encolarTarea(struct pool_hilos *, funcionTarea, void * argumento);
+void esperarPoolHilos(struct pool_hilos *);
+void destruirPoolHilos(struct pool_hilos *);
+int indiceHiloActual(void);
+struct estadisticasPool obtenerEstadisticasPool(struct pool_hilos *);
+void reiniciarEstadisticasPool(struct pool_hilos *);
+void mostrarEstadisticasPool(struct pool_hilos *);
+
+#endif
@@ -0,0 +1,245 @@
+// pool de bloques por clases de tamanio, seguro entre hilos
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "pool_memoria.h"
+#include "paginas_grandes.h"
+#include "matriz.h"
+
+// clases de 2^8 a 2^40 bytes, cuatro por potencia de dos; mas grandes van
+// directo al sistema
+#define BITS_CLASE_MINIMA 8
+#define BITS_CLASE_MAXIMA 40
+#define CLASES_POOL ((BITS_CLASE_MAXIMA - BITS_CLASE_MINIMA) * 4 + 1)
+
+// un bloque libre guarda el enlace de su lista en sus primeros bytes
+struct bloqueLibre{
+	struct bloqueLibre * siguiente;
+};
+
+size_t limitePoolMemoria = (size_t)LIMITE_POOL_MIB_DEFECTO << 20;
+
+static int activo = 0;
+static pthread_mutex_t candado = PTHREAD_MUTEX_INITIALIZER;
+static struct bloqueLibre * libres[NUMERO_MODOS_PAGINAS][CLASES_POOL];
+static struct estadisticasPoolMemoria estadisticas;
+// modo que se obtuvo la ultima vez que se pidio cada uno: si no hay paginas
+// de 2 MiB reservadas los pedidos de 2m buscan en las listas de thp
+static enum modoPaginas obtenidoPorModo[NUMERO_MODOS_PAGINAS] = {PAGINAS_NORMALES, PAGINAS_THP, PAGINAS_2M, PAGINAS_1G};
+
+__attribute__((constructor))
+static void leerPoolMemoria(void){
+	const char * pool = getenv("MATRIZ_POOL");
+	const char * limite = getenv("MATRIZ_POOL_MIB");
+	if(pool != NULL && atoi(pool) > 0){
+		activo = 1;
+	}
+	if(limite != NULL && atol(limite) >= 0){
+		limitePoolMemoria = (size_t)atol(limite) << 20;
+	}
+}
+
+// la clase mas chica que alcanza, o -1 si es demasiado grande
+static int claseBloque(size_t bytes){
+	int e;
+	size_t paso;
+
+	if(bytes <= (size_t)1 << BITS_CLASE_MINIMA){
+		return 0;
+	}
+	if(bytes > (size_t)1 << BITS_CLASE_MAXIMA){
+		return -1;
+	}
+	// 2^e < bytes <= 2^(e + 1), en pasos de 2^(e - 2)
+	e = 63 - __builtin_clzll((unsigned long long)(bytes - 1));
+	paso = (size_t)1 << (e - 2);
+	return (e - BITS_CLASE_MINIMA) * 4 + (int)((bytes - ((size_t)1 << e) + paso - 1) / paso);
+}
+
+static size_t bytesClase(int clase){
+	int e = BITS_CLASE_MINIMA + (clase - 1) / 4;
+	if(clase == 0){
+		return (size_t)1 << BITS_CLASE_MINIMA;
+	}
+	return ((size_t)1 << e) + (size_t)((clase - 1) % 4 + 1) * ((size_t)1 << (e - 2));
+}
+
+static void * reservarSistema(size_t bytes, int paginasGrandes, enum modoPaginas * modo){
+	void * bloque = paginasGrandes ? reservarPaginas(bytes, 0, modo) : NULL;
+
+	if(bloque == NULL){
+		*modo = PAGINAS_NORMALES;
+		// posix_memalign no acepta tamanio 0 de forma portable
+		if(posix_memalign(&bloque, ALINEACION_MATRIZ, bytes > 0 ? bytes : ALINEACION_MATRIZ) != 0){
+			perror("No se pudo reservar memoria para el bloque");
+			exit(1);
+		}
+	}
+	if(paginasGrandes && prefalloMatrices()){
+		prefallarPaginas(bloque, bytes);
+	}
+	return bloque;
+}
+
+static void liberarSistema(void * datos, size_t bytes, enum modoPaginas modo){
+	if(modo == PAGINAS_NORMALES){
+		free(datos);
+	}
+	else{
+		liberarPaginas(datos, bytes, modo);
+	}
+}
+
+static void sumarEnUso(size_t bytes){
+	estadisticas.bytesEnUso += bytes;
+	if(estadisticas.bytesEnUso > estadisticas.bytesPicoEnUso){
+		estadisticas.bytesPicoEnUso = estadisticas.bytesEnUso;
+	}
+	if(estadisticas.bytesReservados > estadisticas.bytesPicoReservados){
+		estadisticas.bytesPicoReservados = estadisticas.bytesReservados;
+	}
+}
+
+void activarPoolMemoria(int activar){
+	activo = activar;
+	if(!activar){
+		vaciarPoolMemoria();
+	}
+}
+
+int poolMemoriaActivo(void){
+	return activo;
+}
+
+void * tomarBloque(size_t bytes, int paginasGrandes, int * marca){
+	enum modoPaginas pedido = paginasGrandes ? paginasMatrices() : PAGINAS_NORMALES, modo;
+	int clase = activo ? claseBloque(bytes) : -1;
+	struct bloqueLibre * bloque;
+	size_t tamanio;
+	void * datos;
+
+	if(clase < 0){
+		datos = reservarSistema(bytes, paginasGrandes, &modo);
+		*marca = 1 + modo;
+		return datos;
+	}
+	tamanio = bytesClase(clase);
+
+	pthread_mutex_lock(&candado);
+	estadisticas.pedidos++;
+	modo = obtenidoPorModo[pedido];
+	bloque = libres[modo][clase];
+	if(bloque != NULL){
+		libres[modo][clase] = bloque->siguiente;
+		estadisticas.aciertos++;
+		estadisticas.bytesLibres -= tamanio;
+		sumarEnUso(tamanio);
+		pthread_mutex_unlock(&candado);
+		*marca = BLOQUE_DEL_POOL | (1 + modo);
+		return bloque;
+	}
+	pthread_mutex_unlock(&candado);
+
+	datos = reservarSistema(tamanio, paginasGrandes, &modo);
+	pthread_mutex_lock(&candado);
+	obtenidoPorModo[pedido] = modo;
+	estadisticas.reservasSistema++;
+	estadisticas.bytesReservados += tamanio;
+	sumarEnUso(tamanio);
+	pthread_mutex_unlock(&candado);
+	*marca = BLOQUE_DEL_POOL | (1 + modo);
+	return datos;
+}
+
+void devolverBloque(void * datos, size_t bytes, int marca){
+	enum modoPaginas modo = (enum modoPaginas)MODO_MARCA(marca);
+	struct bloqueLibre * bloque = (struct bloqueLibre *)datos;
+	int clase;
+	size_t tamanio;
+
+	if(datos == NULL){
+		return;
+	}
+	if(!(marca & BLOQUE_DEL_POOL)){
+		liberarSistema(datos, bytes, modo);
+		return;
+	}
+	clase = claseBloque(bytes);
+	tamanio = bytesClase(clase);
+
+	pthread_mutex_lock(&candado);
+	estadisticas.bytesEnUso -= tamanio;
+	if(activo && estadisticas.bytesLibres + tamanio <= limitePoolMemoria){
+		bloque->siguiente = libres[modo][clase];
+		libres[modo][clase] = bloque;
+		estadisticas.bytesLibres += tamanio;
+		pthread_mutex_unlock(&candado);
+		return;
+	}
+	estadisticas.bytesReservados -= tamanio;
+	estadisticas.liberacionesSistema++;
+	pthread_mutex_unlock(&candado);
+	liberarSistema(datos, tamanio, modo);
+}
+
+void vaciarPoolMemoria(void){
+	static struct bloqueLibre * propios[NUMERO_MODOS_PAGINAS][CLASES_POOL];
+	static pthread_mutex_t vaciando = PTHREAD_MUTEX_INITIALIZER;
+	struct bloqueLibre * bloque;
+	int modo, clase;
+	long liberados = 0;
+
+	// las listas se sacan bajo el candado y se liberan fuera de el
+	pthread_mutex_lock(&vaciando);
+	pthread_mutex_lock(&candado);
+	memcpy(propios, libres, sizeof(libres));
+	memset(libres, 0, sizeof(libres));
+	estadisticas.bytesReservados -= estadisticas.bytesLibres;
+	estadisticas.bytesLibres = 0;
+	pthread_mutex_unlock(&candado);
+
+	for(modo = 0; modo < NUMERO_MODOS_PAGINAS; modo++){
+		for(clase = 0; clase < CLASES_POOL; clase++){
+			while((bloque = propios[modo][clase]) != NULL){
+				propios[modo][clase] = bloque->siguiente;
+				liberarSistema(bloque, bytesClase(clase), (enum modoPaginas)modo);
+				liberados++;
+			}
+		}
+	}
+	pthread_mutex_lock(&candado);
+	estadisticas.liberacionesSistema += liberados;
+	pthread_mutex_unlock(&candado);
+	pthread_mutex_unlock(&vaciando);
+}
+
+struct estadisticasPoolMemoria obtenerEstadisticasPoolMemoria(void){
+	struct estadisticasPoolMemoria copia;
+	pthread_mutex_lock(&candado);
+	copia = estadisticas;
+	pthread_mutex_unlock(&candado);
+	return copia;
+}
+
+void reiniciarEstadisticasPoolMemoria(void){
+	pthread_mutex_lock(&candado);
+	estadisticas.pedidos = 0;
+	estadisticas.aciertos = 0;
+	estadisticas.reservasSistema = 0;
+	estadisticas.liberacionesSistema = 0;
+	estadisticas.bytesPicoEnUso = estadisticas.bytesEnUso;
+	estadisticas.bytesPicoReservados = estadisticas.bytesReservados;
+	pthread_mutex_unlock(&candado);
+}
+
+void mostrarEstadisticasPoolMemoria(void){
+	struct estadisticasPoolMemoria e = obtenerEstadisticasPoolMemoria();
+
+	printf("pool de memoria: %ld pedidos, %ld aciertos (%.1f%%), %ld reservas y %ld liberaciones al sistema\n",
+		e.pedidos, e.aciertos, e.pedidos > 0 ? 100.0 * e.aciertos / e.pedidos : 0.0, e.reservasSistema, e.liberacionesSistema);
+	printf("  en uso %.1f MiB (pico %.1f), reservado %.1f MiB (pico %.1f), libre %.1f MiB\n",
+		e.bytesEnUso / 1048576.0, e.bytesPicoEnUso / 1048576.0, e.bytesReservados / 1048576.0,
+		e.bytesPicoReservados / 1048576.0, e.bytesLibres / 1048576.0);
+}
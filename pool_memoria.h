@@ -0,0 +1,67 @@
+/*
+ Pool de bloques de memoria para matrices, paneles y espacios de trabajo
+
+ Cada gemm reserva y libera sus paneles empaquetados, Strassen su espacio de
+ trabajo, y un programa que multiplica miles de veces crea y libera
+ matrices todo el tiempo. Los bloques grandes salen de mmap: cada reserva es
+ una llamada al sistema y cada pagina un fallo de pagina al tocarla por
+ primera vez, y los medianos fragmentan el heap.
+
+ Con el pool activo los bloques se redondean a clases de tamanio (cuatro por
+ cada potencia de dos, desde 256 bytes: se desperdicia a lo sumo un 25%) y
+ al devolverlos quedan en una lista libre por clase y modo de paginas
+ (paginas_grandes.h). El siguiente pedido de esa clase se lleva el bloque ya
+ reservado y con las paginas ya tocadas. Todos los bloques empiezan
+ alineados a ALINEACION_MATRIZ.
+
+ 	- hilos: las listas y las estadisticas van bajo un mutex, que se toma
+ 	  por un tiempo constante; las reservas y liberaciones al sistema se
+ 	  hacen fuera de el. Se puede pedir y devolver desde cualquier hilo
+ 	- limite: si al devolver un bloque las listas pasan de limitePoolMemoria
+ 	  bytes, el bloque vuelve al sistema (MATRIZ_POOL_MIB, 1 GiB por defecto)
+ 	- marca: tomarBloque devuelve en marca 1 + el modo de paginas del
+ 	  bloque, mas BLOQUE_DEL_POOL si se redondeo a una clase; devolverBloque
+ 	  la necesita, asi se puede activar o apagar el pool en cualquier momento
+ 	  sin confundir bloques. El campo propietaria de las matrices es esta marca
+
+ Apagado (por defecto) tomarBloque reserva exactamente lo pedido como antes y
+ devolverBloque lo libera. Se activa con activarPoolMemoria o MATRIZ_POOL=1;
+ crearMatriz, crearMatrizTipada, los paneles de gemm, Strassen y las cadenas
+ lo usan sin cambios en quien los llama.
+*/
+#ifndef POOL_MEMORIA_H
+#define POOL_MEMORIA_H
+
+#include <stddef.h>
+
+#define BLOQUE_DEL_POOL 0x100
+#define MODO_MARCA(marca) (((marca) & 0xff) - 1)
+#define LIMITE_POOL_MIB_DEFECTO 1024
+
+struct estadisticasPoolMemoria{
+	long pedidos;
+	long aciertos; // pedidos servidos desde una lista libre
+	long reservasSistema;
+	long liberacionesSistema; // por el limite o al vaciar
+	size_t bytesEnUso; // entregados y no devueltos (tamanio de clase)
+	size_t bytesPicoEnUso;
+	size_t bytesLibres; // en las listas
+	size_t bytesReservados; // en uso + libres: lo que se pidio al sistema
+	size_t bytesPicoReservados;
+};
+
+extern size_t limitePoolMemoria;
+
+void activarPoolMemoria(int activo); // apagarlo vacia las listas
+int poolMemoriaActivo(void);
+
+// paginasGrandes: en el modo de paginasMatrices() (si no, paginas normales)
+void * tomarBloque(size_t bytes, int paginasGrandes, int * marca);
+void devolverBloque(void * datos, size_t bytes, int marca);
+void vaciarPoolMemoria(void); // los bloques libres vuelven al sistema
+
+struct estadisticasPoolMemoria obtenerEstadisticasPoolMemoria(void);
+void reiniciarEstadisticasPoolMemoria(void); // los contadores y los picos, no los bytes actuales
+void mostrarEstadisticasPoolMemoria(void);
+
+#endif
@@ -0,0 +1,338 @@
+// pool de procesos pre-creados sobre un solo segmento de memoria compartida
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "pool_procesos.h"
+
+// cada cuanto revisa el padre si algun trabajador murio mientras espera
+#define INTERVALO_VIGILANCIA_NS 100000000L
+// reemplazos que se intentan en una multiplicacion antes de darla por perdida
+// (un azulejo que siempre mata a quien lo calcula no se reintenta para siempre)
+#define MAX_REEMPLAZOS_MULTIPLICACION 4
+
+// los futex se comparten entre procesos: no se usa FUTEX_PRIVATE_FLAG
+static int esperarFutex(uint32_t * direccion, uint32_t valor, const struct timespec * limite){
+	return syscall(SYS_futex, direccion, FUTEX_WAIT, valor, limite, NULL, 0);
+}
+
+static void despertarFutex(uint32_t * direccion, int cuantos){
+	syscall(SYS_futex, direccion, FUTEX_WAKE, cuantos, NULL, NULL, 0);
+}
+
+static size_t bytesRegionMatrices(int tamanioMaximo){
+	return 3 * bytesMatriz(tamanioMaximo, tamanioMaximo);
+}
+
+// el bloque de control ocupa paginas completas para que las matrices queden alineadas
+static size_t bytesControl(){
+	size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+	return (sizeof(struct controlProcesos) + pagina - 1) / pagina * pagina;
+}
+
+// vista de A, B o C de tamanioMatriz x tamanioMatriz dentro del segmento;
+// el desplazamiento solo depende de tamanioMaximo, asi que es el mismo en el
+// padre y en los hijos
+struct matriz matrizPoolProcesos(struct pool_procesos * pool, int cual, int tamanioMatriz){
+	size_t desplazamiento = cual * bytesMatriz(pool->tamanioMaximo, pool->tamanioMaximo);
+	return envolverMatriz((int *)((char *)pool->datos + desplazamiento), tamanioMatriz, tamanioMatriz, calcularLd(tamanioMatriz));
+}
+
+// calcular el azulejo numero indiceAzulejo de la multiplicacion publicada;
+// escribe todo el azulejo de C, asi que rehacerlo no cambia el resultado
+static void hacerAzulejo(struct pool_procesos * pool, int indiceAzulejo, struct matriz * vistas){
+	struct controlProcesos * control = pool->control;
+	struct azulejo azulejo;
+	int fila = indiceAzulejo / control->columnasAzulejos;
+	int columna = indiceAzulejo % control->columnasAzulejos;
+
+	azulejo.fila = fila * control->altoAzulejo;
+	azulejo.columna = columna * control->anchoAzulejo;
+	azulejo.filas = control->tamanioMatriz - azulejo.fila < control->altoAzulejo ? control->tamanioMatriz - azulejo.fila : control->altoAzulejo;
+	azulejo.columnas = control->tamanioMatriz - azulejo.columna < control->anchoAzulejo ? control->tamanioMatriz - azulejo.columna : control->anchoAzulejo;
+	pool->funcion(&azulejo, vistas);
+}
+
+// tomar el proximo azulejo de la cola sin candados, o -1 si no quedan. Se
+// anuncia en azulejoEnCurso antes de tomarlo: si el proceso muere con un
+// azulejo tomado, el padre sabe cual era y su reemplazo lo rehace
+static int tomarAzulejo(struct controlProcesos * control, int indice){
+	uint32_t siguiente = __atomic_load_n(&control->siguienteAzulejo, __ATOMIC_RELAXED);
+
+	while(siguiente < (uint32_t)control->numeroAzulejos){
+		__atomic_store_n(&control->azulejoEnCurso[indice], (int32_t)siguiente, __ATOMIC_SEQ_CST);
+		if(__atomic_compare_exchange_n(&control->siguienteAzulejo, &siguiente, siguiente + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)){
+			return (int)siguiente;
+		}
+	}
+	__atomic_store_n(&control->azulejoEnCurso[indice], -1, __ATOMIC_RELEASE);
+	return -1;
+}
+
+// bucle de cada proceso trabajador: dormir en la generacion, vaciar la cola
+// de azulejos y anotarse en la barrera de terminados. Un reemplazo empieza
+// con la generacion anterior a la publicada para unirse a ella
+static void trabajadorProceso(struct pool_procesos * pool, int indice, uint32_t generacionVista){
+	struct controlProcesos * control = pool->control;
+	uint32_t generacion;
+	struct matriz vistas[3];
+	int siguiente;
+
+	while(1){
+		generacion = __atomic_load_n(&control->generacion, __ATOMIC_ACQUIRE);
+		if(generacion == generacionVista){
+			esperarFutex(&control->generacion, generacion, NULL);
+			continue;
+		}
+		generacionVista = generacion;
+		if(__atomic_load_n(&control->terminar, __ATOMIC_ACQUIRE)){
+			break;
+		}
+
+		vistas[MATRIZ_A] = matrizPoolProcesos(pool, MATRIZ_A, control->tamanioMatriz);
+		vistas[MATRIZ_B] = matrizPoolProcesos(pool, MATRIZ_B, control->tamanioMatriz);
+		vistas[MATRIZ_RESULTADO] = matrizPoolProcesos(pool, MATRIZ_RESULTADO, control->tamanioMatriz);
+
+		// un reemplazo rehace primero el azulejo que su antecesor dejo a medias
+		siguiente = __atomic_load_n(&control->azulejoEnCurso[indice], __ATOMIC_ACQUIRE);
+		if(siguiente >= 0){
+			hacerAzulejo(pool, siguiente, vistas);
+			control->azulejosPorProceso[indice]++;
+		}
+		while((siguiente = tomarAzulejo(control, indice)) >= 0){
+			hacerAzulejo(pool, siguiente, vistas);
+			control->azulejosPorProceso[indice]++;
+		}
+
+		// barrera: cada uno marca su generacion y despierta al padre, que
+		// revisa las marcas; asi un reemplazo nunca cuenta dos veces
+		__atomic_store_n(&control->generacionTerminada[indice], generacion, __ATOMIC_RELEASE);
+		__atomic_add_fetch(&control->terminados, 1, __ATOMIC_RELEASE);
+		despertarFutex(&control->terminados, 1);
+	}
+}
+
+// fork de un trabajador en el lugar indice; -1 si fork falla
+static int lanzarTrabajador(struct pool_procesos * pool, int indice, uint32_t generacionVista){
+	pid_t pid = fork();
+
+	if(pid == -1){
+		perror("fork");
+		pool->pids[indice] = -1;
+		return -1;
+	}
+	if(pid == 0){
+		trabajadorProceso(pool, indice, generacionVista);
+		_exit(0);
+	}
+	pool->pids[indice] = pid;
+	return 0;
+}
+
+// crear el segmento (una sola vez) y hacer fork de los trabajadores
+struct pool_procesos * crearPoolProcesos(int numeroProcesos, int tamanioMaximo, funcionAzulejo funcion){
+	struct pool_procesos * pool = (struct pool_procesos *)calloc(1, sizeof(struct pool_procesos));
+	void * segmento;
+	int i;
+
+	if(pool == NULL){
+		perror("No se pudo reservar memoria para el pool de procesos");
+		exit(1);
+	}
+	if(numeroProcesos < 1){
+		numeroProcesos = 1;
+	}
+	if(numeroProcesos > MAX_PROCESOS){
+		numeroProcesos = MAX_PROCESOS;
+	}
+	pool->numeroProcesos = numeroProcesos;
+	pool->tamanioMaximo = tamanioMaximo;
+	pool->funcion = funcion;
+	pool->bytesSegmento = bytesControl() + bytesRegionMatrices(tamanioMaximo);
+
+	// mapeo compartido anonimo: se hereda con fork y no tiene nombre que
+	// pueda chocar con otra corrida ni quedar huerfano si el programa termina mal
+	segmento = reservarPaginas(pool->bytesSegmento, 1, &pool->paginas);
+	if(segmento == NULL){
+		segmento = mmap(NULL, pool->bytesSegmento, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if(segmento == MAP_FAILED){
+			perror("No se pudo mapear la memoria compartida del pool");
+			exit(1);
+		}
+	}
+	if(prefalloMatrices()){
+		prefallarPaginas(segmento, pool->bytesSegmento);
+	}
+
+	pool->control = (struct controlProcesos *)segmento;
+	pool->datos = (int *)((char *)segmento + bytesControl());
+	memset(pool->control, 0, sizeof(struct controlProcesos));
+	pool->control->numeroProcesos = numeroProcesos;
+
+	pool->pids = (pid_t *)malloc(numeroProcesos * sizeof(pid_t));
+	if(pool->pids == NULL){
+		perror("No se pudo reservar memoria para el pool de procesos");
+		exit(1);
+	}
+	for(i = 0; i < numeroProcesos; i++){
+		if(lanzarTrabajador(pool, i, 0) != 0){
+			exit(1);
+		}
+	}
+	return pool;
+}
+
+// revisar sin bloquear si algun trabajador termino; recoge al primero que
+// encuentre y devuelve su lugar, o -1 si estan todos vivos
+static int trabajadorMuerto(struct pool_procesos * pool){
+	int i, estado;
+	for(i = 0; i < pool->numeroProcesos; i++){
+		if(pool->pids[i] > 0 && waitpid(pool->pids[i], &estado, WNOHANG) == pool->pids[i]){
+			fprintf(stderr, "el trabajador %d (pid %d) termino inesperadamente\n", i, (int)pool->pids[i]);
+			pool->pids[i] = -1;
+			return i;
+		}
+	}
+	return -1;
+}
+
+// 1 si todos los lugares marcaron la generacion
+static int generacionCompleta(struct pool_procesos * pool, uint32_t generacion){
+	int i;
+	for(i = 0; i < pool->numeroProcesos; i++){
+		if(__atomic_load_n(&pool->control->generacionTerminada[i], __ATOMIC_ACQUIRE) != generacion){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// el trabajador del lugar indice murio durante la generacion: si no habia
+// terminado su parte, un reemplazo se une a la generacion y rehace su
+// azulejo a medias; pasado el limite de reemplazos (o si fork falla) su parte
+// se abandona y la multiplicacion devuelve -1. 0 si la parte se recupero
+static int reemplazarDurante(struct pool_procesos * pool, int indice, uint32_t generacion, int * reemplazos){
+	struct controlProcesos * control = pool->control;
+
+	if(__atomic_load_n(&control->generacionTerminada[indice], __ATOMIC_ACQUIRE) == generacion){
+		pool->reemplazos++;
+		lanzarTrabajador(pool, indice, generacion);
+		return 0;
+	}
+	if(++*reemplazos <= MAX_REEMPLAZOS_MULTIPLICACION && lanzarTrabajador(pool, indice, generacion - 1) == 0){
+		pool->reemplazos++;
+		return 0;
+	}
+	fprintf(stderr, "se abandona la parte del trabajador %d en esta multiplicacion\n", indice);
+	__atomic_store_n(&control->azulejoEnCurso[indice], -1, __ATOMIC_RELAXED);
+	__atomic_store_n(&control->generacionTerminada[indice], generacion, __ATOMIC_RELEASE);
+	if(pool->pids[indice] > 0 || lanzarTrabajador(pool, indice, generacion) == 0){
+		pool->reemplazos++;
+	}
+	return -1;
+}
+
+// C = A * B con las matrices de tamanioMatriz x tamanioMatriz que ya estan en
+// el segmento; devuelve 0 si todos los azulejos se calcularon, -1 si no. El
+// pool sigue sirviendo despues de un -1
+int multiplicarPoolProcesos(struct pool_procesos * pool, int tamanioMatriz){
+	struct controlProcesos * control = pool->control;
+	struct timespec limite = {0, INTERVALO_VIGILANCIA_NS};
+	uint32_t terminados, generacion;
+	int i, alto, ancho, reemplazos = 0, resultado = 0;
+
+	if(tamanioMatriz > pool->tamanioMaximo){
+		fprintf(stderr, "el pool de procesos admite matrices de hasta %d x %d\n", pool->tamanioMaximo, pool->tamanioMaximo);
+		return -1;
+	}
+	// los que murieron entre multiplicaciones (o no se pudieron reemplazar)
+	// se lanzan de nuevo, dormidos en la generacion actual
+	while(trabajadorMuerto(pool) >= 0){
+	}
+	for(i = 0; i < pool->numeroProcesos; i++){
+		if(pool->pids[i] <= 0){
+			if(lanzarTrabajador(pool, i, __atomic_load_n(&control->generacion, __ATOMIC_RELAXED)) != 0){
+				return -1;
+			}
+			pool->reemplazos++;
+		}
+	}
+
+	elegirTamanioAzulejo(tamanioMatriz, tamanioMatriz, pool->numeroProcesos, &alto, &ancho);
+	control->tamanioMatriz = tamanioMatriz;
+	control->ld = calcularLd(tamanioMatriz);
+	control->altoAzulejo = alto;
+	control->anchoAzulejo = ancho;
+	control->columnasAzulejos = (tamanioMatriz + ancho - 1) / ancho;
+	control->numeroAzulejos = ((tamanioMatriz + alto - 1) / alto) * control->columnasAzulejos;
+	for(i = 0; i < pool->numeroProcesos; i++){
+		control->azulejosPorProceso[i] = 0;
+		control->azulejoEnCurso[i] = -1;
+	}
+	__atomic_store_n(&control->siguienteAzulejo, 0, __ATOMIC_RELAXED);
+
+	// publicar el trabajo: la generacion nueva se escribe despues de todo lo anterior
+	generacion = __atomic_add_fetch(&control->generacion, 1, __ATOMIC_RELEASE);
+	despertarFutex(&control->generacion, pool->numeroProcesos);
+
+	// terminados cambia cada vez que alguien marca su generacion: si se lee
+	// antes de revisar las marcas, la espera no puede perder un aviso
+	while(1){
+		terminados = __atomic_load_n(&control->terminados, __ATOMIC_ACQUIRE);
+		if(generacionCompleta(pool, generacion)){
+			break;
+		}
+		if(esperarFutex(&control->terminados, terminados, &limite) == -1 && errno == ETIMEDOUT){
+			while((i = trabajadorMuerto(pool)) >= 0){
+				if(reemplazarDurante(pool, i, generacion, &reemplazos) != 0){
+					resultado = -1;
+				}
+			}
+		}
+	}
+	return resultado;
+}
+
+// azulejos que calculo cada proceso en la ultima multiplicacion
+void mostrarEstadisticasPoolProcesos(struct pool_procesos * pool){
+	int i;
+	printf("pool de procesos (%d procesos): %d azulejos de %d x %d\n", pool->numeroProcesos,
+		pool->control->numeroAzulejos, pool->control->altoAzulejo, pool->control->anchoAzulejo);
+	for(i = 0; i < pool->numeroProcesos; i++){
+		printf("\tproceso %d: %ld azulejos\n", i, pool->control->azulejosPorProceso[i]);
+	}
+	if(pool->reemplazos > 0){
+		printf("\ttrabajadores reemplazados desde que se creo el pool: %d\n", pool->reemplazos);
+	}
+}
+
+// avisar a los trabajadores que terminen, recogerlos y liberar el segmento
+void destruirPoolProcesos(struct pool_procesos * pool){
+	int i;
+
+	__atomic_store_n(&pool->control->terminar, 1, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&pool->control->generacion, 1, __ATOMIC_RELEASE);
+	despertarFutex(&pool->control->generacion, pool->numeroProcesos);
+
+	for(i = 0; i < pool->numeroProcesos; i++){
+		if(pool->pids[i] > 0){
+			waitpid(pool->pids[i], NULL, 0);
+		}
+	}
+	if(pool->paginas != PAGINAS_NORMALES){
+		liberarPaginas(pool->control, pool->bytesSegmento, pool->paginas);
+	}
+	else{
+		munmap(pool->control, pool->bytesSegmento);
+	}
+	free(pool->pids);
+	free(pool);
+}
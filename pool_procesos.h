@@ -0,0 +1,87 @@
+/*
+ Pool de procesos sobre memoria compartida
+
+ crearPoolProcesos hace un solo mmap compartido anonimo con capacidad para
+ tres matrices de tamanioMaximo x tamanioMaximo y luego hace fork de los
+ trabajadores, que quedan dormidos en un futex. Cada multiplicacion:
+
+ 	- el padre publica el trabajo (tamanio y azulejos) en el bloque de control
+ 	  e incrementa la generacion, lo que despierta a los trabajadores
+ 	- cada trabajador toma azulejos de una cola sin candados (un contador
+ 	  atomico en la memoria compartida) hasta que se acaban
+ 	- el ultimo trabajador en terminar despierta al padre (barrera con futex)
+
+ El pool sirve para muchas multiplicaciones de cualquier tamanio hasta
+ tamanioMaximo sin volver a crear la memoria compartida.
+
+ Si un trabajador muere, el padre lo detecta mientras espera (cada
+ INTERVALO_VIGILANCIA_NS) y hace fork de un reemplazo en su lugar. Cada
+ trabajador anuncia en azulejoEnCurso el azulejo que va a tomar, asi el
+ reemplazo rehace el que quedo a medias, se une a la multiplicacion en curso
+ y el resultado sale completo. Como calcular un azulejo solo escribe ese
+ azulejo de C, rehacerlo no cambia nada. Si en una multiplicacion mueren mas
+ de MAX_REEMPLAZOS_MULTIPLICACION trabajadores (un azulejo que siempre
+ falla), o fork no puede, esa multiplicacion devuelve -1; el pool queda
+ completo para la siguiente. Los que mueren entre multiplicaciones se
+ reemplazan al empezar la proxima.
+
+ Con paginas grandes (paginas_grandes.h) el mmap lleva MAP_HUGETLB, o
+ madvise(MADV_HUGEPAGE) para thp; se hereda con fork igual. Con prefallo el
+ padre toca las paginas al crearlo, antes del fork.
+*/
+#ifndef POOL_PROCESOS_H
+#define POOL_PROCESOS_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "matriz.h"
+#include "planificador_azulejos.h"
+#include "paginas_grandes.h"
+
+#define MAX_PROCESOS 256
+
+// bloque de control al inicio de la memoria compartida
+struct controlProcesos{
+	uint32_t generacion; // futex: cambia cuando hay trabajo nuevo
+	uint32_t terminados; // futex: aumenta cada vez que un trabajador termina su parte
+	uint32_t siguienteAzulejo; // cola sin candados: proximo azulejo a tomar
+	int terminar;
+
+	int numeroProcesos;
+	int tamanioMatriz;
+	int ld;
+	int altoAzulejo;
+	int anchoAzulejo;
+	int columnasAzulejos;
+	int numeroAzulejos;
+
+	long azulejosPorProceso[MAX_PROCESOS];
+	int32_t azulejoEnCurso[MAX_PROCESOS]; // el que esta calculando cada uno, o -1
+	uint32_t generacionTerminada[MAX_PROCESOS]; // ultima generacion que termino cada uno
+};
+
+struct pool_procesos{
+	struct controlProcesos * control;
+	int * datos; // region de las tres matrices
+	size_t bytesSegmento;
+	enum modoPaginas paginas; // del segmento
+	int tamanioMaximo;
+	int numeroProcesos;
+	pid_t * pids; // -1 si el lugar quedo sin proceso
+	funcionAzulejo funcion;
+	int reemplazos; // trabajadores relanzados desde que se creo el pool
+};
+
+// matrices dentro del segmento compartido
+#define MATRIZ_A 0
+#define MATRIZ_B 1
+#define MATRIZ_RESULTADO 2
+
+struct pool_procesos * crearPoolProcesos(int numeroProcesos, int tamanioMaximo, funcionAzulejo funcion);
+struct matriz matrizPoolProcesos(struct pool_procesos *, int cual, int tamanioMatriz);
+int multiplicarPoolProcesos(struct pool_procesos *, int tamanioMatriz);
+void mostrarEstadisticasPoolProcesos(struct pool_procesos *);
+void destruirPoolProcesos(struct pool_procesos *);
+
+#endif
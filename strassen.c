@@ -0,0 +1,280 @@
+// multiplicacion Strassen-Winograd con espacio de trabajo reservado una vez
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <omp.h>
+
+#include "strassen.h"
+#include "gemm_empaquetado.h"
+#include "pool_memoria.h"
+
+#define PRODUCTOS 7
+
+int corteStrassen = CORTE_STRASSEN_DEFECTO;
+
+__attribute__((constructor))
+static void leerCorteStrassen(void){
+	const char * corte = getenv("MATRIZ_CORTE_STRASSEN");
+	if(corte != NULL && atoi(corte) > 0){
+		corteStrassen = atoi(corte);
+	}
+}
+
+static int corteActual(void){
+	return corteStrassen < CORTE_STRASSEN_MINIMO ? CORTE_STRASSEN_MINIMO : corteStrassen;
+}
+
+// enteros de una matriz lado x lado con su relleno de fila (multiplo de 16)
+static size_t elementosMatriz(int lado){
+	return (size_t)lado * calcularLd(lado);
+}
+
+static size_t elementosPaneles(int lado){
+	return (elementosPanelesEmpaquetada(lado, lado, lado) + 15) / 16 * 16;
+}
+
+// temporales X e Y de cada nivel de la recursion secuencial
+static size_t espacioSecuencial(int lado){
+	if(lado <= corteActual()){
+		return 0;
+	}
+	return 2 * elementosMatriz(lado / 2) + espacioSecuencial(lado / 2);
+}
+
+// tomar una matriz lado x lado del espacio de trabajo y avanzar el puntero
+static struct matriz tomarMatriz(int ** espacio, int lado){
+	struct matriz matriz = envolverMatriz(*espacio, lado, lado, calcularLd(lado));
+	*espacio += elementosMatriz(lado);
+	return matriz;
+}
+
+// cuadrantes 11, 12, 21 y 22 de una matriz de lado par
+static void cuadrantes(const struct matriz * matriz, struct matriz cuadrante[4]){
+	int h = matriz->filas / 2;
+	cuadrante[0] = vistaMatriz(matriz, 0, 0, h, h);
+	cuadrante[1] = vistaMatriz(matriz, 0, h, h, h);
+	cuadrante[2] = vistaMatriz(matriz, h, 0, h, h);
+	cuadrante[3] = vistaMatriz(matriz, h, h, h, h);
+}
+
+// sumas y restas en unsigned: el desbordamiento da el mismo resultado modulo
+// 2^32 que el producto clasico (y no es comportamiento indefinido)
+static void sumarFila(int * destino, const int * x, const int * y, int n){
+	int j;
+	for(j = 0; j < n; j++){
+		destino[j] = (int)((unsigned int)x[j] + (unsigned int)y[j]);
+	}
+}
+
+static void restarFila(int * destino, const int * x, const int * y, int n){
+	int j;
+	for(j = 0; j < n; j++){
+		destino[j] = (int)((unsigned int)x[j] - (unsigned int)y[j]);
+	}
+}
+
+static void sumarMatrices(struct matriz * destino, const struct matriz * x, const struct matriz * y){
+	int i;
+	for(i = 0; i < destino->filas; i++){
+		sumarFila(FILA(destino, i), FILA(x, i), FILA(y, i), destino->columnas);
+	}
+}
+
+static void restarMatrices(struct matriz * destino, const struct matriz * x, const struct matriz * y){
+	int i;
+	for(i = 0; i < destino->filas; i++){
+		restarFila(FILA(destino, i), FILA(x, i), FILA(y, i), destino->columnas);
+	}
+}
+
+// C = A * B en secuencial con el esquema de 22 pasos (dos temporales por
+// nivel); espacio tiene espacioSecuencial(lado) enteros y paneles los del
+// motor empaquetado para las hojas
+static void strassenSecuencial(const struct matriz * A, const struct matriz * B, struct matriz * C, int * espacio, int * paneles){
+	struct matriz a[4], b[4], c[4], X, Y;
+	int h;
+
+	if(A->filas <= corteActual()){
+		multiplicarMatricesEmpaquetadaConPaneles(A, B, C, paneles);
+		return;
+	}
+	h = A->filas / 2;
+	X = tomarMatriz(&espacio, h);
+	Y = tomarMatriz(&espacio, h);
+	cuadrantes(A, a);
+	cuadrantes(B, b);
+	cuadrantes(C, c);
+
+	restarMatrices(&X, &a[0], &a[2]); // S3 = A11 - A21
+	restarMatrices(&Y, &b[3], &b[1]); // T3 = B22 - B12
+	strassenSecuencial(&X, &Y, &c[2], espacio, paneles); // P7 = S3 T3 en C21
+	sumarMatrices(&X, &a[2], &a[3]); // S1 = A21 + A22
+	restarMatrices(&Y, &b[1], &b[0]); // T1 = B12 - B11
+	strassenSecuencial(&X, &Y, &c[3], espacio, paneles); // P5 = S1 T1 en C22
+	restarMatrices(&X, &X, &a[0]); // S2 = S1 - A11
+	restarMatrices(&Y, &b[3], &Y); // T2 = B22 - T1
+	strassenSecuencial(&X, &Y, &c[1], espacio, paneles); // P6 = S2 T2 en C12
+	restarMatrices(&X, &a[1], &X); // S4 = A12 - S2
+	strassenSecuencial(&X, &b[3], &c[0], espacio, paneles); // P3 = S4 B22 en C11
+	strassenSecuencial(&a[0], &b[0], &X, espacio, paneles); // P1 = A11 B11 en X
+	sumarMatrices(&c[1], &X, &c[1]); // U2 = P1 + P6
+	sumarMatrices(&c[2], &c[1], &c[2]); // U3 = U2 + P7
+	sumarMatrices(&c[1], &c[1], &c[3]); // U4 = U2 + P5
+	sumarMatrices(&c[3], &c[2], &c[3]); // U7 = U3 + P5 (C22 final)
+	sumarMatrices(&c[1], &c[1], &c[0]); // U5 = U4 + P3 (C12 final)
+	restarMatrices(&Y, &Y, &b[2]); // T4 = T2 - B21
+	strassenSecuencial(&a[3], &Y, &c[0], espacio, paneles); // P4 = A22 T4 en C11
+	restarMatrices(&c[2], &c[2], &c[0]); // U6 = U3 - P4 (C21 final)
+	strassenSecuencial(&a[1], &b[2], &c[0], espacio, paneles); // P2 = A12 B21 en C11
+	sumarMatrices(&c[0], &X, &c[0]); // U1 = P1 + P2 (C11 final)
+}
+
+// primer nivel: S1..S4 y T1..T4 en paralelo por filas, los 7 productos
+// repartidos entre los hilos y las sumas finales otra vez por filas
+static void strassenParalelo(const struct matriz * A, const struct matriz * B, struct matriz * C, int numeroHilos, int * espacio, int ladoHoja,
+		const struct ganchosHilos * ganchos){
+	struct matriz a[4], b[4], c[4], S[4], T[4], P1, P6, P7;
+	const struct matriz * izquierda[PRODUCTOS];
+	const struct matriz * derecha[PRODUCTOS];
+	struct matriz * salida[PRODUCTOS];
+	int * espacioProducto[PRODUCTOS];
+	int * panelesProducto[PRODUCTOS];
+	int h = A->filas / 2;
+	size_t porProducto = espacioSecuencial(h);
+	int i, p;
+
+	cuadrantes(A, a);
+	cuadrantes(B, b);
+	cuadrantes(C, c);
+	for(i = 0; i < 4; i++){
+		S[i] = tomarMatriz(&espacio, h);
+		T[i] = tomarMatriz(&espacio, h);
+	}
+	P1 = tomarMatriz(&espacio, h);
+	P6 = tomarMatriz(&espacio, h);
+	P7 = tomarMatriz(&espacio, h);
+	for(p = 0; p < PRODUCTOS; p++){
+		espacioProducto[p] = espacio;
+		espacio += porProducto;
+		panelesProducto[p] = espacio;
+		espacio += elementosPaneles(ladoHoja);
+	}
+
+	#pragma omp parallel num_threads(numeroHilos)
+	{
+		entrarGanchoHilo(ganchos);
+		#pragma omp for schedule(static) nowait
+		for(i = 0; i < h; i++){
+			sumarFila(FILA(&S[0], i), FILA(&a[2], i), FILA(&a[3], i), h); // S1 = A21 + A22
+			restarFila(FILA(&S[1], i), FILA(&S[0], i), FILA(&a[0], i), h); // S2 = S1 - A11
+			restarFila(FILA(&S[2], i), FILA(&a[0], i), FILA(&a[2], i), h); // S3 = A11 - A21
+			restarFila(FILA(&S[3], i), FILA(&a[1], i), FILA(&S[1], i), h); // S4 = A12 - S2
+			restarFila(FILA(&T[0], i), FILA(&b[1], i), FILA(&b[0], i), h); // T1 = B12 - B11
+			restarFila(FILA(&T[1], i), FILA(&b[3], i), FILA(&T[0], i), h); // T2 = B22 - T1
+			restarFila(FILA(&T[2], i), FILA(&b[3], i), FILA(&b[1], i), h); // T3 = B22 - B12
+			restarFila(FILA(&T[3], i), FILA(&T[1], i), FILA(&b[2], i), h); // T4 = T2 - B21
+		}
+		salirGanchoHilo(ganchos);
+	}
+
+	// P2..P5 van directo a los cuadrantes de C; P1, P6 y P7 a temporales
+	izquierda[0] = &a[0]; derecha[0] = &b[0]; salida[0] = &P1;   // P1 = A11 B11
+	izquierda[1] = &a[1]; derecha[1] = &b[2]; salida[1] = &c[0]; // P2 = A12 B21
+	izquierda[2] = &S[3]; derecha[2] = &b[3]; salida[2] = &c[1]; // P3 = S4 B22
+	izquierda[3] = &a[3]; derecha[3] = &T[3]; salida[3] = &c[2]; // P4 = A22 T4
+	izquierda[4] = &S[0]; derecha[4] = &T[0]; salida[4] = &c[3]; // P5 = S1 T1
+	izquierda[5] = &S[1]; derecha[5] = &T[1]; salida[5] = &P6;   // P6 = S2 T2
+	izquierda[6] = &S[2]; derecha[6] = &T[2]; salida[6] = &P7;   // P7 = S3 T3
+
+	#pragma omp parallel num_threads(numeroHilos < PRODUCTOS ? numeroHilos : PRODUCTOS)
+	{
+		entrarGanchoHilo(ganchos);
+		#pragma omp for schedule(dynamic, 1) nowait
+		for(p = 0; p < PRODUCTOS; p++){
+			strassenSecuencial(izquierda[p], derecha[p], salida[p], espacioProducto[p], panelesProducto[p]);
+		}
+		salirGanchoHilo(ganchos);
+	}
+
+	#pragma omp parallel num_threads(numeroHilos)
+	{
+		entrarGanchoHilo(ganchos);
+		#pragma omp for schedule(static) nowait
+		for(i = 0; i < h; i++){
+			sumarFila(FILA(&P6, i), FILA(&P1, i), FILA(&P6, i), h); // U2 = P1 + P6
+			sumarFila(FILA(&c[0], i), FILA(&P1, i), FILA(&c[0], i), h); // C11 = U1 = P1 + P2
+			sumarFila(FILA(&P7, i), FILA(&P6, i), FILA(&P7, i), h); // U3 = U2 + P7
+			sumarFila(FILA(&c[1], i), FILA(&c[1], i), FILA(&P6, i), h); // P3 + U2
+			sumarFila(FILA(&c[1], i), FILA(&c[1], i), FILA(&c[3], i), h); // C12 = U5 = U2 + P5 + P3
+			restarFila(FILA(&c[2], i), FILA(&P7, i), FILA(&c[2], i), h); // C21 = U6 = U3 - P4
+			sumarFila(FILA(&c[3], i), FILA(&P7, i), FILA(&c[3], i), h); // C22 = U7 = U3 + P5
+		}
+		salirGanchoHilo(ganchos);
+	}
+}
+
+// C = A * B con A y B de N x N
+void multiplicarMatricesStrassen(const struct matriz * A, const struct matriz * B, struct matriz * C, int numeroHilos){
+	multiplicarMatricesStrassenConGanchos(A, B, C, numeroHilos, NULL);
+}
+
+void multiplicarMatricesStrassenConGanchos(const struct matriz * A, const struct matriz * B, struct matriz * C, int numeroHilos,
+		const struct ganchosHilos * ganchos){
+	int n = A->filas;
+	int ladoHoja = n, niveles = 0, ladoRelleno, h, i, marca;
+	size_t elementos;
+	int * espacio, * siguiente;
+	struct matriz Ar, Br, Cr;
+	const struct matriz * operandoA = A, * operandoB = B;
+	struct matriz * resultado = C;
+
+	// por debajo del corte todo el producto va en el hilo que llama
+	if(n <= corteActual()){
+		entrarGanchoHilo(ganchos);
+		multiplicarMatricesEmpaquetada(A, B, C);
+		salirGanchoHilo(ganchos);
+		return;
+	}
+	if(numeroHilos < 1){
+		numeroHilos = 1;
+	}
+
+	// P = m * 2^d con m <= corte: asi cada nivel divide en mitades exactas
+	while(ladoHoja > corteActual()){
+		ladoHoja = (ladoHoja + 1) / 2;
+		niveles++;
+	}
+	ladoRelleno = ladoHoja << niveles;
+	h = ladoRelleno / 2;
+
+	elementos = 11 * elementosMatriz(h) + PRODUCTOS * (espacioSecuencial(h) + elementosPaneles(ladoHoja));
+	if(ladoRelleno != n){
+		elementos += 3 * elementosMatriz(ladoRelleno);
+	}
+	espacio = (int *)tomarBloque(elementos * sizeof(int), 0, &marca);
+	siguiente = espacio;
+
+	if(ladoRelleno != n){
+		Ar = tomarMatriz(&siguiente, ladoRelleno);
+		Br = tomarMatriz(&siguiente, ladoRelleno);
+		Cr = tomarMatriz(&siguiente, ladoRelleno);
+		ponerCerosMatriz(&Ar);
+		ponerCerosMatriz(&Br);
+		for(i = 0; i < n; i++){
+			memcpy(FILA(&Ar, i), FILA(A, i), n * sizeof(int));
+			memcpy(FILA(&Br, i), FILA(B, i), n * sizeof(int));
+		}
+		operandoA = &Ar;
+		operandoB = &Br;
+		resultado = &Cr;
+	}
+
+	strassenParalelo(operandoA, operandoB, resultado, numeroHilos, siguiente, ladoHoja, ganchos);
+
+	if(ladoRelleno != n){
+		for(i = 0; i < n; i++){
+			memcpy(FILA(C, i), FILA(&Cr, i), n * sizeof(int));
+		}
+	}
+	devolverBloque(espacio, elementos * sizeof(int), marca);
+}
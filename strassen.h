@@ -0,0 +1,44 @@
+/*
+ Multiplicacion Strassen-Winograd
+
+ C = A * B para matrices cuadradas con 7 productos y 15 sumas por nivel en
+ lugar de 8 productos. La recursion baja hasta que el lado es menor o igual a
+ corteStrassen y ahi usa el motor empaquetado (gemm_empaquetado.c).
+
+ 	- Tamanios que no se dividen hasta el corte: A y B se copian con relleno
+ 	  de ceros a P = m * 2^d (m <= corte, P - N < 2^d) y al final se copia la
+ 	  esquina N x N de vuelta.
+ 	- Memoria: todo el espacio de trabajo (temporales de cada nivel, paneles
+ 	  del motor empaquetado y copias con relleno) se reserva una vez por
+ 	  llamada; la recursion no hace malloc.
+ 	- Paralelismo: en el primer nivel los 7 productos se reparten entre los
+ 	  hilos de OpenMP, cada uno con su propio espacio de trabajo; debajo, cada
+ 	  producto sigue en secuencial con el esquema de 22 pasos que usa solo
+ 	  dos temporales (X e Y) por nivel.
+ 	- Exactitud: sumas y restas se hacen en unsigned, asi el resultado es
+ 	  exactamente A * B modulo 2^32, igual que el producto clasico con
+ 	  desbordamiento.
+
+ corteStrassen se puede cambiar en tiempo de ejecucion o con la variable de
+ entorno MATRIZ_CORTE_STRASSEN.
+
+ multiplicarMatricesStrassenConGanchos llama a los ganchos (ganchos_hilos.h)
+ en cada hilo de las tres regiones paralelas del primer nivel, o en el hilo
+ que llama si no se pasa del corte; las copias con relleno quedan afuera.
+*/
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include "matriz.h"
+#include "ganchos_hilos.h"
+
+#define CORTE_STRASSEN_DEFECTO 512
+#define CORTE_STRASSEN_MINIMO 16
+
+extern int corteStrassen;
+
+void multiplicarMatricesStrassen(const struct matriz *, const struct matriz *, struct matriz *, int numeroHilos);
+void multiplicarMatricesStrassenConGanchos(const struct matriz *, const struct matriz *, struct matriz *, int numeroHilos,
+	const struct ganchosHilos * ganchos);
+
+#endif
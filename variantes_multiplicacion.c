@@ -0,0 +1,351 @@
+// variantes de multiplicacion con una interfaz comun para el benchmark
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <omp.h>
+
+#include "variantes_multiplicacion.h"
+#include "gemm_empaquetado.h"
+#include "nucleos_simd.h"
+#include "planificador_azulejos.h"
+#include "pool_hilos.h"
+#include "pool_procesos.h"
+#include "strassen.h"
+#include "openmp_azulejos.h"
+
+#define LADO_BLOQUE 64
+
+// lo que una variante reutiliza entre repeticiones
+struct estadoVariante{
+	int numeroHilos;
+	struct matriz * transpuesta; // B transpuesta (se recalcula en cada multiplicacion)
+	struct planificador * planificador;
+	struct pool_hilos * poolHilos;
+	struct pool_procesos * poolProcesos;
+	struct matriz vistas[3]; // A, B transpuesta y C, indexadas con MATRIZ_A, MATRIZ_B, MATRIZ_RESULTADO
+};
+
+// registro donde acumulan los trabajadores; NULL si no se miden contadores
+static struct registroContadores * registroContadoresActual = NULL;
+
+void medirContadoresVariantes(struct registroContadores * registro){
+	registroContadoresActual = registro;
+}
+
+// grupos de los hilos de OpenMP de los motores con ganchos: cada hilo abre el
+// suyo al entrar a una region y acumula en su casilla del registro al salir
+struct medicionHilos{
+	struct registroContadores * registro;
+	struct grupoContadores grupos[MAX_TRABAJADORES_CONTADORES];
+	int abiertos[MAX_TRABAJADORES_CONTADORES];
+};
+
+static void entrarMidiendo(int hilo, void * contexto){
+	struct medicionHilos * medicion = (struct medicionHilos *)contexto;
+
+	medicion->abiertos[hilo] = hilo < medicion->registro->numeroTrabajadores && abrirContadores(&medicion->grupos[hilo], 0) == 0;
+	if(medicion->abiertos[hilo]){
+		iniciarContadores(&medicion->grupos[hilo]);
+	}
+}
+
+static void salirMidiendo(int hilo, void * contexto){
+	struct medicionHilos * medicion = (struct medicionHilos *)contexto;
+
+	if(medicion->abiertos[hilo]){
+		detenerContadores(&medicion->grupos[hilo], &medicion->registro->trabajadores[hilo]);
+		cerrarContadores(&medicion->grupos[hilo]);
+	}
+}
+
+static struct estadoVariante * crearEstado(const struct matriz * A, const struct matriz * B, int numeroHilos){
+	struct estadoVariante * estado = (struct estadoVariante *)calloc(1, sizeof(struct estadoVariante));
+	if(estado == NULL){
+		perror("No se pudo reservar memoria para la variante");
+		exit(1);
+	}
+	estado->numeroHilos = numeroHilos < 1 ? 1 : numeroHilos;
+	estado->transpuesta = crearMatriz(B->columnas, B->filas);
+	(void)A;
+	return estado;
+}
+
+static void * prepararSecuencial(const struct matriz * A, const struct matriz * B, int numeroHilos){
+	return crearEstado(A, B, numeroHilos);
+}
+
+static void liberarEstado(void * parametro){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+	if(estado->poolHilos != NULL){
+		destruirPoolHilos(estado->poolHilos);
+	}
+	if(estado->poolProcesos != NULL){
+		destruirPoolProcesos(estado->poolProcesos);
+	}
+	if(estado->planificador != NULL){
+		destruirPlanificador(estado->planificador);
+	}
+	liberarMemoriaMatriz(estado->transpuesta);
+	free(estado);
+}
+
+// azulejo de C con B transpuesta: vistas es un arreglo {A, B transpuesta, C}
+static void multiplicarAzulejoTranspuesta(const struct azulejo * azulejo, void * contexto){
+	struct matriz * vistas = (struct matriz *)contexto;
+	funcionProductoPunto productoPunto = nucleosActuales->productoPunto;
+	int profundidad = vistas[MATRIZ_A].columnas;
+	int i, j;
+
+	for(i = azulejo->fila; i < azulejo->fila + azulejo->filas; i++){
+		for(j = azulejo->columna; j < azulejo->columna + azulejo->columnas; j++){
+			ELEMENTO(&vistas[MATRIZ_RESULTADO], i, j) = productoPunto(FILA(&vistas[MATRIZ_A], i), FILA(&vistas[MATRIZ_B], j), profundidad);
+		}
+	}
+}
+
+static void fijarVistas(struct estadoVariante * estado, const struct matriz * A, struct matriz * C){
+	estado->vistas[MATRIZ_A] = *A;
+	estado->vistas[MATRIZ_B] = *estado->transpuesta;
+	estado->vistas[MATRIZ_RESULTADO] = *C;
+}
+
+/* secuenciales */
+
+// i-j-k sin transponer, como multiplicacion_matrices_cuadradas.c
+static void multiplicarIngenua(void * estado, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	int i, j, k, acumulado;
+	const int * filaA;
+	(void)estado;
+
+	for(i = 0; i < C->filas; i++){
+		filaA = FILA(A, i);
+		for(j = 0; j < C->columnas; j++){
+			acumulado = 0;
+			for(k = 0; k < A->columnas; k++){
+				acumulado += filaA[k] * ELEMENTO(B, k, j);
+			}
+			ELEMENTO(C, i, j) = acumulado;
+		}
+	}
+}
+
+// B transpuesta y un producto punto vectorizado por elemento
+static void multiplicarTranspuesta(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+	struct azulejo todo = {0, 0, C->filas, C->columnas};
+
+	transponerMatrizEn(B, estado->transpuesta);
+	fijarVistas(estado, A, C);
+	multiplicarAzulejoTranspuesta(&todo, estado->vistas);
+}
+
+// blocking de LADO_BLOQUE con B transpuesta, como el kernel "bloques" del secuencial
+static void multiplicarBloques(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+	funcionProductoPunto productoPunto = nucleosActuales->productoPunto;
+	const struct matriz * BT = estado->transpuesta;
+	int i, j, lim_i, lim_j, lim_k, fin_i, fin_j, fin_k;
+	int profundidad = A->columnas;
+
+	transponerMatrizEn(B, estado->transpuesta);
+	ponerCerosMatriz(C);
+	for(lim_i = 0; lim_i < C->filas; lim_i += LADO_BLOQUE){
+		fin_i = lim_i + LADO_BLOQUE < C->filas ? lim_i + LADO_BLOQUE : C->filas;
+		for(lim_j = 0; lim_j < C->columnas; lim_j += LADO_BLOQUE){
+			fin_j = lim_j + LADO_BLOQUE < C->columnas ? lim_j + LADO_BLOQUE : C->columnas;
+			for(lim_k = 0; lim_k < profundidad; lim_k += LADO_BLOQUE){
+				fin_k = lim_k + LADO_BLOQUE < profundidad ? lim_k + LADO_BLOQUE : profundidad;
+				for(i = lim_i; i < fin_i; i++){
+					for(j = lim_j; j < fin_j; j++){
+						ELEMENTO(C, i, j) += productoPunto(FILA(A, i) + lim_k, FILA(BT, j) + lim_k, fin_k - lim_k);
+					}
+				}
+			}
+		}
+	}
+}
+
+// paneles empaquetados con micro-kernel en registros
+static void multiplicarEmpaquetada(void * estado, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	(void)estado;
+	multiplicarMatricesEmpaquetada(A, B, C);
+}
+
+/* paralelas: todas usan el mismo azulejo con B transpuesta, asi solo cambia el
+   mecanismo de reparto (OpenMP, pool de hilos o pool de procesos) */
+
+static void * prepararPlanificador(const struct matriz * A, const struct matriz * B, int numeroHilos){
+	struct estadoVariante * estado = crearEstado(A, B, numeroHilos);
+	int alto, ancho;
+
+	elegirTamanioAzulejo(A->filas, B->columnas, estado->numeroHilos, &alto, &ancho);
+	estado->planificador = crearPlanificador(A->filas, B->columnas, alto, ancho, estado->numeroHilos);
+	return estado;
+}
+
+// recorrer el planificador como trabajador, con contadores si hay un registro activo
+static void trabajarMidiendo(struct estadoVariante * estado, int trabajador){
+	struct registroContadores * registro = registroContadoresActual;
+	struct grupoContadores grupo;
+	int medir = registro != NULL && trabajador >= 0 && trabajador < registro->numeroTrabajadores && abrirContadores(&grupo, 0) == 0;
+
+	if(medir){
+		iniciarContadores(&grupo);
+	}
+	trabajarPlanificador(estado->planificador, trabajador, multiplicarAzulejoTranspuesta, estado->vistas);
+	if(medir){
+		detenerContadores(&grupo, &registro->trabajadores[trabajador]);
+		cerrarContadores(&grupo);
+	}
+}
+
+static void multiplicarOpenmp(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+
+	transponerMatrizEn(B, estado->transpuesta);
+	fijarVistas(estado, A, C);
+	reiniciarPlanificador(estado->planificador);
+
+	#pragma omp parallel num_threads(estado->numeroHilos)
+	trabajarMidiendo(estado, omp_get_thread_num());
+}
+
+static void * prepararHilos(const struct matriz * A, const struct matriz * B, int numeroHilos){
+	struct estadoVariante * estado = (struct estadoVariante *)prepararPlanificador(A, B, numeroHilos);
+	estado->poolHilos = crearPoolHilos(estado->numeroHilos);
+	return estado;
+}
+
+// tarea de cada hilo del pool
+static void trabajarHilo(void * parametro){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+	trabajarMidiendo(estado, indiceHiloActual());
+}
+
+static void multiplicarHilos(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+	int i;
+
+	transponerMatrizEn(B, estado->transpuesta);
+	fijarVistas(estado, A, C);
+	reiniciarPlanificador(estado->planificador);
+	for(i = 0; i < estado->numeroHilos; i++){
+		encolarTarea(estado->poolHilos, trabajarHilo, estado);
+	}
+	esperarPoolHilos(estado->poolHilos);
+}
+
+// el pool de procesos solo ve su segmento: A se copia una vez al preparar;
+// B transpuesta se escribe y C se copia de vuelta en cada multiplicacion
+static void * prepararProcesos(const struct matriz * A, const struct matriz * B, int numeroHilos){
+	struct estadoVariante * estado = crearEstado(A, B, numeroHilos);
+	struct matriz segmentoA;
+	int i;
+
+	estado->poolProcesos = crearPoolProcesos(estado->numeroHilos, A->filas, multiplicarAzulejoTranspuesta);
+	segmentoA = matrizPoolProcesos(estado->poolProcesos, MATRIZ_A, A->filas);
+	for(i = 0; i < A->filas; i++){
+		memcpy(FILA(&segmentoA, i), FILA(A, i), A->columnas * sizeof(int));
+	}
+	return estado;
+}
+
+static void multiplicarProcesos(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+	struct matriz segmentoB = matrizPoolProcesos(estado->poolProcesos, MATRIZ_B, A->filas);
+	struct matriz segmentoC = matrizPoolProcesos(estado->poolProcesos, MATRIZ_RESULTADO, A->filas);
+	struct registroContadores * registro = registroContadoresActual;
+	struct grupoContadores grupos[MAX_PROCESOS];
+	int i, resultado, procesosMedidos = 0;
+
+	transponerMatrizEn(B, &segmentoB);
+
+	// los hijos no pueden abrir contadores en el padre: el padre los abre sobre su pid
+	if(registro != NULL){
+		while(procesosMedidos < estado->poolProcesos->numeroProcesos && procesosMedidos < registro->numeroTrabajadores
+				&& abrirContadores(&grupos[procesosMedidos], estado->poolProcesos->pids[procesosMedidos]) == 0){
+			iniciarContadores(&grupos[procesosMedidos]);
+			procesosMedidos++;
+		}
+	}
+	resultado = multiplicarPoolProcesos(estado->poolProcesos, A->filas);
+	for(i = 0; i < procesosMedidos; i++){
+		detenerContadores(&grupos[i], &registro->trabajadores[i]);
+		cerrarContadores(&grupos[i]);
+	}
+	if(resultado != 0){
+		fprintf(stderr, "el pool de procesos no completo la multiplicacion\n");
+		exit(1);
+	}
+	for(i = 0; i < C->filas; i++){
+		memcpy(FILA(C, i), FILA(&segmentoC, i), C->columnas * sizeof(int));
+	}
+}
+
+// motor de azulejos 2D con acumuladores privados (openmp_azulejos.c), una
+// variante por reparto para compararlos; sin transponer B. Con un registro
+// activo cada hilo de la region se mide con los ganchos
+static void multiplicarOmp(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C,
+		enum repartoOpenmp reparto, int trozo){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+	struct medicionHilos medicion;
+	struct ganchosHilos ganchos = {entrarMidiendo, salirMidiendo, &medicion};
+
+	medicion.registro = registroContadoresActual;
+	multiplicarOpenmpAzulejosConGanchos(A, B, C, estado->numeroHilos, reparto, trozo, medicion.registro != NULL ? &ganchos : NULL);
+}
+
+static void multiplicarOmpStatic(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	multiplicarOmp(parametro, A, B, C, REPARTO_ESTATICO, 0);
+}
+
+static void multiplicarOmpDynamic(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	multiplicarOmp(parametro, A, B, C, REPARTO_DINAMICO, 1);
+}
+
+static void multiplicarOmpGuided(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	multiplicarOmp(parametro, A, B, C, REPARTO_GUIADO, 1);
+}
+
+static void multiplicarOmpTareas(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	multiplicarOmp(parametro, A, B, C, REPARTO_TAREAS, 1);
+}
+
+// Strassen-Winograd: los 7 productos del primer nivel en paralelo con OpenMP;
+// con un registro activo se mide cada hilo de sus regiones
+static void multiplicarStrassen(void * parametro, const struct matriz * A, const struct matriz * B, struct matriz * C){
+	struct estadoVariante * estado = (struct estadoVariante *)parametro;
+	struct medicionHilos medicion;
+	struct ganchosHilos ganchos = {entrarMidiendo, salirMidiendo, &medicion};
+
+	medicion.registro = registroContadoresActual;
+	multiplicarMatricesStrassenConGanchos(A, B, C, estado->numeroHilos, medicion.registro != NULL ? &ganchos : NULL);
+}
+
+const struct variante variantesMultiplicacion[] = {
+	{"ingenua", 0, prepararSecuencial, multiplicarIngenua, liberarEstado},
+	{"transpuesta", 0, prepararSecuencial, multiplicarTranspuesta, liberarEstado},
+	{"bloques", 0, prepararSecuencial, multiplicarBloques, liberarEstado},
+	{"empaquetada", 0, prepararSecuencial, multiplicarEmpaquetada, liberarEstado},
+	{"openmp", 1, prepararPlanificador, multiplicarOpenmp, liberarEstado},
+	{"omp_static", 1, prepararSecuencial, multiplicarOmpStatic, liberarEstado},
+	{"omp_dynamic", 1, prepararSecuencial, multiplicarOmpDynamic, liberarEstado},
+	{"omp_guided", 1, prepararSecuencial, multiplicarOmpGuided, liberarEstado},
+	{"omp_tareas", 1, prepararSecuencial, multiplicarOmpTareas, liberarEstado},
+	{"hilos", 1, prepararHilos, multiplicarHilos, liberarEstado},
+	{"procesos", 1, prepararProcesos, multiplicarProcesos, liberarEstado},
+	{"strassen", 1, prepararSecuencial, multiplicarStrassen, liberarEstado},
+};
+
+const int numeroVariantesMultiplicacion = sizeof(variantesMultiplicacion) / sizeof(variantesMultiplicacion[0]);
+
+// NULL si no hay una variante con ese nombre
+const struct variante * buscarVariante(const char * nombre){
+	int i;
+	for(i = 0; i < numeroVariantesMultiplicacion; i++){
+		if(strcmp(variantesMultiplicacion[i].nombre, nombre) == 0){
+			return &variantesMultiplicacion[i];
+		}
+	}
+	return NULL;
+}
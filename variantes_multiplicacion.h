@@ -0,0 +1,43 @@
+/*
+ Registro de variantes de multiplicacion
+
+ Reune en un solo lugar los kernels de los distintos programas (ingenuo,
+ transpuesta, por bloques, paneles empaquetados, OpenMP con robo de
+ azulejos, OpenMP por azulejos con cada reparto (omp_static, omp_dynamic,
+ omp_guided, omp_tareas), pool de pthreads, pool de procesos y Strassen)
+ con una interfaz comun, para que el benchmark pueda enlazarlos todos y
+ medirlos igual:
+
+ 	estado = variante->preparar(A, B, numeroHilos);   // no se mide
+ 	variante->multiplicar(estado, A, B, C);            // se mide
+ 	variante->liberar(estado);
+
+ preparar crea lo que se reutiliza entre repeticiones (pools, planificador,
+ buffers). Lo que forma parte del algoritmo, como transponer B, se hace dentro
+ de multiplicar y entra en el tiempo.
+
+ Con medirContadoresVariantes(registro) cada trabajador de las variantes
+ paralelas (hilo de OpenMP, hilo del pool o proceso hijo) acumula sus
+ contadores de hardware en su casilla del registro; NULL deja de medir.
+*/
+#ifndef VARIANTES_MULTIPLICACION_H
+#define VARIANTES_MULTIPLICACION_H
+
+#include "matriz.h"
+#include "contadores_hardware.h"
+
+struct variante{
+	const char * nombre;
+	int paralela; // 1 si usa numeroHilos; las secuenciales se miden con 1 hilo
+	void * (*preparar)(const struct matriz * A, const struct matriz * B, int numeroHilos);
+	void (*multiplicar)(void * estado, const struct matriz * A, const struct matriz * B, struct matriz * C);
+	void (*liberar)(void * estado);
+};
+
+extern const struct variante variantesMultiplicacion[];
+extern const int numeroVariantesMultiplicacion;
+
+const struct variante * buscarVariante(const char * nombre);
+void medirContadoresVariantes(struct registroContadores *);
+
+#endif
@@ -0,0 +1,163 @@
+// verificacion de C = A * B: Freivalds y comparacion exacta con el producto ingenuo
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "verificacion.h"
+#include "aleatorio_contador.h"
+
+static uint32_t * reservarVectores(size_t elementos){
+	// + 1: con una dimension 0 malloc puede devolver NULL sin error
+	uint32_t * vectores = (uint32_t *)malloc((elementos + 1) * sizeof(uint32_t));
+	if(vectores == NULL){
+		perror("No se pudo reservar memoria para la verificacion");
+		exit(1);
+	}
+	return vectores;
+}
+
+// resultado[t][i] = sum_j M[i][j] * vectores[t][j] para los cuantos vectores,
+// cada uno de M->columnas elementos; cada fila de M se lee una vez para todos
+__attribute__((target_clones("arch=skylake-avx512", "avx2", "default")))
+static void productoVectores(const struct matriz * M, const uint32_t * vectores, int cuantos, uint32_t * resultado){
+	int i;
+
+	#pragma omp parallel for schedule(static) if((double)M->filas * M->columnas * cuantos > 1e6)
+	for(i = 0; i < M->filas; i++){
+		const uint32_t * fila = (const uint32_t *)FILA(M, i);
+		int t, j;
+		for(t = 0; t < cuantos; t++){
+			const uint32_t * v = vectores + (size_t)t * M->columnas;
+			uint32_t suma = 0;
+			#pragma omp simd reduction(+:suma)
+			for(j = 0; j < M->columnas; j++){
+				suma += fila[j] * v[j];
+			}
+			resultado[(size_t)t * M->filas + i] = suma;
+		}
+	}
+}
+
+int verificarFreivalds(const struct matriz * A, const struct matriz * B, const struct matriz * C, int repeticiones, uint64_t semilla){
+	int m = C->filas, n = C->columnas, k = A->columnas;
+	uint64_t clave = claveAleatoria(semilla);
+	uint32_t * r, * x, * y, * z;
+	size_t t, j;
+	int correcto = 1;
+
+	if(A->filas != m || B->filas != k || B->columnas != n){
+		return 0;
+	}
+	if(repeticiones < 1){
+		repeticiones = 1;
+	}
+	r = reservarVectores((size_t)repeticiones * n);
+	x = reservarVectores((size_t)repeticiones * k);
+	y = reservarVectores((size_t)repeticiones * m);
+	z = reservarVectores((size_t)repeticiones * m);
+
+	for(t = 0; t < (size_t)repeticiones; t++){
+		for(j = 0; j < (size_t)n; j++){
+			r[t * n + j] = (uint32_t)aleatorioContador(clave, t * n + j);
+		}
+	}
+	productoVectores(B, r, repeticiones, x); // x = B r
+	productoVectores(A, x, repeticiones, y); // y = A (B r)
+	productoVectores(C, r, repeticiones, z); // z = C r
+	for(t = 0; t < (size_t)repeticiones * m && correcto; t++){
+		correcto = y[t] == z[t];
+	}
+
+	free(r);
+	free(x);
+	free(y);
+	free(z);
+	return correcto;
+}
+
+// triple bucle en orden i, p, j con una fila de acumuladores por hilo
+int verificarExacta(const struct matriz * A, const struct matriz * B, const struct matriz * C){
+	int m = C->filas, n = C->columnas, k = A->columnas;
+	int correcto = 1;
+
+	if(A->filas != m || B->filas != k || B->columnas != n){
+		return 0;
+	}
+	#pragma omp parallel reduction(&&:correcto) if((double)m * n * k > 1e6)
+	{
+		uint32_t * fila = reservarVectores(n);
+		int i, j, p;
+
+		#pragma omp for schedule(static)
+		for(i = 0; i < m; i++){
+			const uint32_t * filaA = (const uint32_t *)FILA(A, i);
+			const uint32_t * filaC = (const uint32_t *)FILA(C, i);
+			for(j = 0; j < n; j++){
+				fila[j] = 0;
+			}
+			for(p = 0; p < k; p++){
+				const uint32_t * filaB = (const uint32_t *)FILA(B, p);
+				for(j = 0; j < n; j++){
+					fila[j] += filaA[p] * filaB[j];
+				}
+			}
+			for(j = 0; j < n; j++){
+				correcto = correcto && fila[j] == filaC[j];
+			}
+		}
+		free(fila);
+	}
+	return correcto;
+}
+
+int verificarMultiplicacion(const struct matriz * A, const struct matriz * B, const struct matriz * C, int repeticiones, uint64_t semilla){
+	if((double)C->filas * C->columnas * A->columnas <= UMBRAL_VERIFICACION_EXACTA){
+		return verificarExacta(A, B, C);
+	}
+	return verificarFreivalds(A, B, C, repeticiones, semilla);
+}
+
+double errorFreivalds(int repeticiones){
+	return ldexp(1.0, -(repeticiones < 1 ? 1 : repeticiones));
+}
+
+int leerOpcionVerificacion(int * argc, char ** argv){
+	int i, repeticiones = -1;
+
+	for(i = 1; i < *argc; i++){
+		if(strcmp(argv[i], "-f") == 0 && i + 1 < *argc){
+			repeticiones = atoi(argv[i + 1]);
+			if(repeticiones < 0){
+				repeticiones = 0;
+			}
+			// los argumentos posicionales que siguen se corren dos lugares
+			memmove(&argv[i], &argv[i + 2], (*argc - i - 1) * sizeof(char *));
+			*argc -= 2;
+			break;
+		}
+	}
+	return repeticiones;
+}
+
+int mostrarVerificacion(const struct matriz * A, const struct matriz * B, const struct matriz * C, int repeticiones){
+	struct timespec inicio, fin;
+	int exacta = repeticiones == 0 || (double)C->filas * C->columnas * A->columnas <= UMBRAL_VERIFICACION_EXACTA;
+	int correcto;
+
+	clock_gettime(CLOCK_MONOTONIC, &inicio);
+	correcto = exacta ? verificarExacta(A, B, C) :
+		verificarFreivalds(A, B, C, repeticiones, (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32));
+	clock_gettime(CLOCK_MONOTONIC, &fin);
+	if(exacta){
+		printf("verificacion exacta: %s", correcto ? "correcta" : "INCORRECTA");
+	}
+	else{
+		printf("verificacion Freivalds (%d vectores, error <= %.1e): %s", repeticiones,
+			errorFreivalds(repeticiones), correcto ? "correcta" : "INCORRECTA");
+	}
+	printf(" (%f s)\n", (fin.tv_sec - inicio.tv_sec) + (fin.tv_nsec - inicio.tv_nsec) * 1e-9);
+	return correcto;
+}
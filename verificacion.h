@@ -0,0 +1,54 @@
+/*
+ Verificacion barata de C = A * B (algoritmo de Freivalds)
+
+ Comparar C contra un producto de referencia cuesta otra multiplicacion
+ O(N^3). Freivalds elige un vector r al azar y compara C r con A (B r): tres
+ productos matriz por vector, O(N^2). Si C esta bien siempre coinciden; si
+ esta mal, coinciden con probabilidad a lo sumo 1/2, asi que con k vectores
+ independientes un C incorrecto pasa con probabilidad a lo sumo 2^-k.
+
+ Las cuentas son en aritmetica modular de 32 bits (uint32_t), la misma en que
+ desbordan los int de las variantes, asi que un C que desbordo igual que la
+ referencia no se marca como error. r tiene 32 bits aleatorios por elemento:
+ una diferencia impar en C pasa con probabilidad 2^-32 por vector; la cota
+ 1/2 es el peor caso, una diferencia de 2^31. Los k vectores se multiplican
+ juntos, leyendo cada fila de A, B y C una sola vez.
+
+ verificarExacta compara C con el producto ingenuo (triple bucle, en
+ paralelo por filas); verificarMultiplicacion la usa en los productos chicos,
+ donde cuesta menos que un milisegundo, y Freivalds en los demas.
+
+ Los programas de multiplicacion sueltos aceptan -f k en cualquier lugar de
+ la linea de comandos: despues de la parte medida verifican C con k vectores
+ (-f 0 compara exacto) y terminan con 1 si no es correcto.
+
+ Los motores por tipo (gemm_tipos.h) tienen su propio freivalds para float,
+ double, int32 con acumulador int64 e int64.
+*/
+#ifndef VERIFICACION_H
+#define VERIFICACION_H
+
+#include <stdint.h>
+
+#include "matriz.h"
+
+// M * N * K hasta el que verificarMultiplicacion compara exacto (256^3)
+#define UMBRAL_VERIFICACION_EXACTA (256.0 * 256 * 256)
+#define REPETICIONES_FREIVALDS 20
+
+// 1 si C = A * B; repeticiones vectores aleatorios de la semilla
+int verificarFreivalds(const struct matriz * A, const struct matriz * B, const struct matriz * C, int repeticiones, uint64_t semilla);
+int verificarExacta(const struct matriz * A, const struct matriz * B, const struct matriz * C);
+int verificarMultiplicacion(const struct matriz * A, const struct matriz * B, const struct matriz * C, int repeticiones, uint64_t semilla);
+
+// cota de la probabilidad de aceptar un C incorrecto: 2^-repeticiones
+double errorFreivalds(int repeticiones);
+
+// para los programas sueltos: saca "-f k" de argv (los argumentos posicionales
+// quedan en su lugar) y devuelve k, o -1 si no se pidio verificar
+int leerOpcionVerificacion(int * argc, char ** argv);
+// verificar C con k vectores (0: exacta), escribir el resultado y el tiempo;
+// 1 si C = A * B
+int mostrarVerificacion(const struct matriz * A, const struct matriz * B, const struct matriz * C, int repeticiones);
+
+#endif